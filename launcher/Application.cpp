@@ -43,10 +43,14 @@
 #include "Application.h"
 #include "BuildConfig.h"
 #include "TruckPackVersionManager.h"
+#include "modplatform/truckpack/TruckPackPrefetcher.h"
 
 #include "DataMigrationTask.h"
 #include "InstanceImportTask.h"
-#include "tasks/SequentialTask.h"
+#include "minecraft/MinecraftInstance.h"
+#include "minecraft/PackProfile.h"
+#include "modplatform/truckpack/TruckPackDeltaUpdateTask.h"
+#include "modplatform/truckpack/TruckPackFileStore.h"
 #include "java/JavaInstallList.h"
 #include "net/PasteUpload.h"
 #include "pathmatcher/MultiMatcher.h"
@@ -102,6 +106,7 @@
 #include <QNetworkAccessManager>
 #include <QStringList>
 #include <QStyleFactory>
+#include <QTimer>
 #include <QTranslator>
 #include <QWindow>
 
@@ -111,6 +116,9 @@
 #include <minecraft/auth/AccountList.h>
 #include "icons/IconList.h"
 #include "net/HttpMetaCache.h"
+#include "net/MetaCacheGCTask.h"
+#include "net/RequestTimings.h"
+#include "modplatform/helpers/HashCache.h"
 
 #include "java/JavaInstallList.h"
 
@@ -177,6 +185,12 @@ void appDebugOutput(QtMsgType type, const QMessageLogContext& context, const QSt
     fflush(stderr);
 }
 
+/** Metacache bases holding downloads that can always be fetched again, so they can be kept within a quota. */
+QStringList quotaBases()
+{
+    return { "general", "ATLauncherPacks", "FTBPacks", "TechnicPacks", "FlamePacks", "FlameMods", "ModrinthPacks", "ModrinthModpacks", "java" };
+}
+
 }  // namespace
 
 Application::Application(int& argc, char** argv) : QApplication(argc, argv)
@@ -211,7 +225,9 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
           { { "a", "profile" }, "Use the account specified by its profile name (only valid in combination with --launch)", "profile" },
           { "alive", "Write a small '" + liveCheckFile + "' file after the launcher starts" },
           { { "I", "import" }, "Import instance or resource from specified local path or URL", "url" },
-          { "show", "Opens the window for the specified instance (by instance ID)", "show" } });
+          { "show", "Opens the window for the specified instance (by instance ID)", "show" },
+          { "net-timings", "Write the timings of all network requests to a file on exit (CSV if it ends in '.csv', JSON otherwise)",
+            "file" } });
     // Has to be positional for some OS to handle that properly
     parser.addPositionalArgument("URL", "Import the resource(s) at the given URL(s) (same as -I / --import)", "[URL...]");
 
@@ -228,6 +244,10 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
 
     m_instanceIdToShowWindowOf = parser.value("show");
 
+    // relative to where we were started, not the data folder
+    if (parser.isSet("net-timings"))
+        m_netTimingsFile = QFileInfo(parser.value("net-timings")).absoluteFilePath();
+
     for (auto url : parser.values("import")) {
         m_urlsToImport.append(normalizeImportUrl(url));
     }
@@ -536,6 +556,7 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
         m_settings->registerSetting("NumberOfConcurrentTasks", 10);
         m_settings->registerSetting("NumberOfConcurrentDownloads", 6);
         m_settings->registerSetting("NumberOfManualRetries", 1);
+        m_settings->registerSetting("DownloadSegments", 4);
         m_settings->registerSetting("RequestTimeout", 60);
 
         QString defaultMonospace;
@@ -646,6 +667,18 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
         m_settings->registerSetting("ModDependenciesDisabled", false);
         m_settings->registerSetting("SkipModpackUpdatePrompt", false);
 
+        // Truck pack updates downloaded ahead of time, limited in KiB/s (0 is unlimited)
+        m_settings->registerSetting("TruckPackPrefetch", false);
+        m_settings->registerSetting("TruckPackPrefetchRate", 2048);
+        // Minutes between checks of the truck pack manifest, 0 only checks on startup
+        m_settings->registerSetting("TruckPackManifestPollInterval", 30);
+
+        // Disk space each kind of cached download may take up, in MiB (0 is unlimited).
+        // "CacheQuota<base>" overrides it for one metacache base, -1 uses "CacheQuota"
+        m_settings->registerSetting("CacheQuota", 4096);
+        for (auto& base : quotaBases())
+            m_settings->registerSetting("CacheQuota" + base, -1);
+
         // Minecraft offline player name
         m_settings->registerSetting("LastOfflinePlayerName", "");
 
@@ -849,10 +882,15 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
         m_metacache->addBase("FlameMods", QDir("cache/FlameMods").absolutePath());
         m_metacache->addBase("ModrinthPacks", QDir("cache/ModrinthPacks").absolutePath());
         m_metacache->addBase("ModrinthModpacks", QDir("cache/ModrinthModpacks").absolutePath());
+        m_metacache->addBase("TruckPackStore", QDir("cache/truckpack-store").absolutePath());
+        m_metacache->addBase("TruckPackPrestage", QDir("cache/truckpack-prestage").absolutePath());
         m_metacache->addBase("translations", QDir("translations").absolutePath());
         m_metacache->addBase("meta", QDir("meta").absolutePath());
         m_metacache->addBase("java", QDir("cache/java").absolutePath());
         m_metacache->Load();
+
+        m_hashCache.reset(new Hashing::HashCache("hashcache"));
+        m_hashCache->load();
         qDebug() << "<> Cache initialized.";
     }
 
@@ -875,8 +913,12 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
     // Initialize truck pack version manager
     {
         m_truckPackVersionManager.reset(new TruckPackVersionManager(this));
+        m_truckPackPrefetcher.reset(new TruckPack::Prefetcher(m_truckPackVersionManager.get()));
     }
 
+    // keep the download cache in check, once startup has calmed down
+    QTimer::singleShot(5 * 60 * 1000, this, &Application::collectCacheGarbage);
+
 #ifdef Q_OS_MACOS
     connect(this, &Application::clickedOnDock, [this]() { this->showMainWindow(); });
 #endif
@@ -886,6 +928,8 @@ Application::Application(int& argc, char** argv) : QApplication(argc, argv)
             // save any remaining instance state
             m_instances->saveNow();
         }
+        if (!m_netTimingsFile.isEmpty() && Net::TimingLog::instance()->exportTo(m_netTimingsFile))
+            qDebug() << "Wrote network request timings to" << m_netTimingsFile;
         if (logFile) {
             logFile->flush();
             logFile->close();
@@ -1330,45 +1374,128 @@ bool Application::updatesAreAllowed()
     return m_runningInstances == 0;
 }
 
-// Simple task for deleting an instance with progress feedback
-class InstanceDeletionTask : public Task {
-protected:
-    void executeTask() override {
-        setStatus(tr("Removing old instance..."));
-        setProgress(0, 100);
-        
-        if (!FS::deletePath(m_instancePath)) {
-            emitFailed(tr("Failed to completely delete the instance"));
-            return;
+void Application::updateTruckPack(QString instanceId, QString packUrl, QString packName, QString packVersion)
+{
+    qDebug() << "Application::updateTruckPack: Updating instance" << instanceId << "to version" << packVersion;
+
+    auto instance = instances()->getInstanceById(instanceId);
+    if (!instance) {
+        qWarning() << "Application::updateTruckPack: Instance not found:" << instanceId;
+        return;
+    }
+
+    QString oldCachePath = instance->getTruckPackCachePath();
+
+    // Try to only replace the files that changed first, keeping the instance (and everything the user added) in place
+    auto deltaTask = new TruckPack::DeltaUpdateTask(instance, QUrl(packUrl), packName, packVersion);
+    InstanceName inst_name(instance->name(), packVersion);
+    inst_name.setName(instance->name());
+    deltaTask->setName(inst_name);
+    deltaTask->setIcon(instance->iconKey());
+    deltaTask->setGroup(instances()->getInstanceGroup(instanceId));
+    auto wrappedDeltaTask = instances()->wrapInstanceTask(deltaTask);
+
+    connect(wrappedDeltaTask, &Task::succeeded, this, [this, instance, deltaTask, oldCachePath]() {
+        // the archive the instance was installed from is no longer needed, the saved pack index replaces it
+        bool archiveReplaced = !oldCachePath.isEmpty() && oldCachePath != deltaTask->cachePath();
+        if (archiveReplaced) {
+            qDebug() << "Application::updateTruckPack: Cleaning up old cache file:" << oldCachePath;
+            if (deltaTask->cachePath().isEmpty())
+                instance->settings()->set("TruckPackCachePath", "");
         }
-        
-        setProgress(100, 100);
-        emitSucceeded();
+        metacache()->cleanupOldTruckPackCache(archiveReplaced ? oldCachePath : QString());
+        collectStoreGarbage();
+        if (auto minecraftInstance = std::dynamic_pointer_cast<MinecraftInstance>(instance))
+            minecraftInstance->getPackProfile()->reload(Net::Mode::Offline);
+    });
+    connect(wrappedDeltaTask, &Task::failed, this, [this, deltaTask, instanceId, packUrl, packName, packVersion](QString reason) {
+        if (!deltaTask->shouldReinstall())
+            return;
+        qDebug() << "Application::updateTruckPack: Delta update not possible (" << reason << "), reinstalling the pack";
+        // let the progress dialog of the delta update close first
+        QTimer::singleShot(0, this, [this, instanceId, packUrl, packName, packVersion]() {
+            reinstallTruckPack(instanceId, packUrl, packName, packVersion);
+        });
+    });
+
+    if (m_mainWindow) {
+        ProgressDialog* progressDialog = new ProgressDialog(m_mainWindow);
+        progressDialog->setSkipButton(true, tr("Abort"));
+        progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+        progressDialog->setWindowFlags(progressDialog->windowFlags() | Qt::WindowStaysOnTopHint);
+        progressDialog->execWithTask(wrappedDeltaTask);
+    } else {
+        wrappedDeltaTask->start();
     }
+}
 
-public:
-    InstanceDeletionTask(QString instancePath) : Task(), m_instancePath(instancePath) {}
-    
-private:
-    QString m_instancePath;
-};
+QStringList Application::instanceRoots() const
+{
+    // read from disk, the instance list only catches up with freshly committed instances later
+    QStringList roots;
+    QDir instanceDir(m_settings->get("InstanceDir").toString());
+    for (auto& entry : instanceDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden))
+        roots.append(entry.absoluteFilePath());
+    // rollbacks still use the files of the previous pack version
+    QDir rollbackDir(instanceDir.absoluteFilePath(".rollback"));
+    for (auto& entry : rollbackDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden))
+        roots.append(entry.absoluteFilePath());
+    return roots;
+}
 
-void Application::updateTruckPack(QString instanceId, QString packUrl, QString packName, QString packVersion)
+void Application::collectCacheGarbage()
 {
-    qDebug() << "Application::updateTruckPack: Updating instance" << instanceId << "to version" << packVersion;
+    // and again every few hours, for launchers that stay open
+    QTimer::singleShot(6 * 60 * 60 * 1000, this, &Application::collectCacheGarbage);
+    if (m_cacheGCTask && m_cacheGCTask->isRunning())
+        return;
+
+    auto defaultQuota = m_settings->get("CacheQuota").toLongLong();
+    for (auto& base : quotaBases()) {
+        auto quota = m_settings->get("CacheQuota" + base).toLongLong();
+        m_metacache->setQuota(base, (quota < 0 ? defaultQuota : quota) * 1024 * 1024);
+    }
+
+    m_cacheGCTask.reset(new MetaCacheGCTask(m_metacache, instanceRoots()));
+    m_cacheGCTask->start();
+}
+
+void Application::collectStoreGarbage()
+{
+    // extracted files the old pack version shared with other instances may not be used by anything now
+    auto storeRoot = m_metacache->getBasePath("TruckPackStore");
+    if (storeRoot.isEmpty())
+        return;
+    // the running pass may have read the instances before the latest update, look again once it's done
+    if (m_storeGCTask && m_storeGCTask->isRunning()) {
+        m_storeGCPending = true;
+        return;
+    }
+
+    m_storeGCPending = false;
+    m_storeGCTask.reset(new TruckPack::StoreGCTask(storeRoot, instanceRoots()));
+    connect(m_storeGCTask.get(), &Task::finished, this, [this] {
+        if (m_storeGCPending)
+            collectStoreGarbage();
+    }, Qt::QueuedConnection);
+    m_storeGCTask->start();
+}
+
+void Application::reinstallTruckPack(QString instanceId, QString packUrl, QString packName, QString packVersion)
+{
+    qDebug() << "Application::reinstallTruckPack: Reinstalling instance" << instanceId << "with version" << packVersion;
     
     // Get the instance to preserve its settings
     auto instance = instances()->getInstanceById(instanceId);
     if (!instance) {
-        qWarning() << "Application::updateTruckPack: Instance not found:" << instanceId;
+        qWarning() << "Application::reinstallTruckPack: Instance not found:" << instanceId;
         return;
     }
     
-    // Store important instance info before deleting
+    // Store important instance info for the new version
     QString instanceGroup = instances()->getInstanceGroup(instanceId);
     QString instanceName = instance->name();
     QString iconKey = instance->iconKey();
-    QString instancePath = instance->instanceRoot();
     
     // Get the old version and cache path for cleanup
     QString oldVersion;
@@ -1383,21 +1510,15 @@ void Application::updateTruckPack(QString instanceId, QString packUrl, QString p
     int currentMaxMemAlloc = -1;
     if (instance->settings()->get("OverrideMemory").toBool()) {
         currentMaxMemAlloc = instance->settings()->get("MaxMemAlloc").toInt();
-        qDebug() << "Application::updateTruckPack: Preserving custom RAM:" << currentMaxMemAlloc << "MB";
+        qDebug() << "Application::reinstallTruckPack: Preserving custom RAM:" << currentMaxMemAlloc << "MB";
     }
     
-    qDebug() << "Application::updateTruckPack: Preserving - Name:" << instanceName 
+    qDebug() << "Application::reinstallTruckPack: Preserving - Name:" << instanceName 
              << "Group:" << instanceGroup << "Icon:" << iconKey << "Old version:" << oldVersion 
              << "Old cache path:" << oldCachePath;
     
-    // Create a sequential task to delete old instance then download new one
-    auto updateTask = new SequentialTask(tr("Updating %1").arg(instanceName));
-    
-    // Step 1: Delete old instance files
-    auto deletionTask = new InstanceDeletionTask(instancePath);
-    updateTask->addTask(Task::Ptr(deletionTask));
-    
-    // Step 2: Download and install new version
+    // The new version is built in a staging folder next to the old one, and only swapped in once it is complete.
+    // A failed download or extraction leaves the old instance untouched, and the old one is kept for a rollback.
     QMap<QString, QString> extraInfo;
     extraInfo["TruckPack"] = "true";
     extraInfo["TruckPackName"] = packName;
@@ -1416,48 +1537,29 @@ void Application::updateTruckPack(QString instanceId, QString packUrl, QString p
     importTask->setName(inst_name);
     importTask->setIcon(iconKey);
     importTask->setGroup(instanceGroup);
+    importTask->setReplace(instanceId);
     
     auto wrappedImportTask = instances()->wrapInstanceTask(importTask);
-    updateTask->addTask(Task::Ptr(wrappedImportTask));
     
     // Connect to cleanup old cache files after successful update
-    connect(updateTask, &Task::succeeded, this, [this, packName, oldVersion, oldCachePath]() {
+    connect(wrappedImportTask, &Task::succeeded, this, [this, packName, oldVersion, oldCachePath]() {
         if (!oldCachePath.isEmpty()) {
-            qDebug() << "Application::updateTruckPack: Cleaning up old cache file:" << oldCachePath;
-            metacache()->cleanupOldTruckPackCache(oldCachePath);
+            qDebug() << "Application::reinstallTruckPack: Cleaning up old cache file:" << oldCachePath;
         } else {
-            qDebug() << "Application::updateTruckPack: No cache path stored for old version" << oldVersion;
+            qDebug() << "Application::reinstallTruckPack: No cache path stored for old version" << oldVersion;
         }
+        metacache()->cleanupOldTruckPackCache(oldCachePath);
+        collectStoreGarbage();
     });
     
-    // Show progress dialog FIRST - before doing anything else
     if (m_mainWindow) {
         ProgressDialog* progressDialog = new ProgressDialog(m_mainWindow);
         progressDialog->setSkipButton(true, tr("Abort"));
         progressDialog->setAttribute(Qt::WA_DeleteOnClose);
         progressDialog->setWindowFlags(progressDialog->windowFlags() | Qt::WindowStaysOnTopHint);
-        
-        // Show and ensure the dialog is fully visible BEFORE any other operations
-        progressDialog->show();
-        progressDialog->raise();
-        progressDialog->activateWindow();
-        
-        // Force immediate processing of all pending events to render the dialog
-        QCoreApplication::processEvents(QEventLoop::AllEvents);
-        QCoreApplication::processEvents(QEventLoop::AllEvents);
-        
-        // Remove the instance from the group index metadata (fast, non-blocking)
-        QString cachedGroupId = instances()->getInstanceGroup(instanceId);
-        if (!cachedGroupId.isEmpty()) {
-            instances()->setInstanceGroup(instanceId, "");
-        }
-        
-        // Execute the task with the already-visible dialog
-        // The InstanceDeletionTask will handle the file deletion asynchronously
-        progressDialog->execWithTask(updateTask);
+        progressDialog->execWithTask(wrappedImportTask);
     } else {
-        instances()->deleteInstance(instanceId);
-        updateTask->start();
+        wrappedImportTask->start();
     }
 }
 
@@ -58,6 +58,10 @@ class SetupWizard;
 class GenericPageProvider;
 class QFile;
 class HttpMetaCache;
+class MetaCacheGCTask;
+namespace TruckPack {
+class StoreGCTask;
+}
 class SettingsObject;
 class InstanceList;
 class AccountList;
@@ -68,11 +72,19 @@ class BaseProfilerFactory;
 class BaseDetachedToolFactory;
 class TranslationsModel;
 class ITheme;
+
+namespace Hashing {
+class HashCache;
+}
 class MCEditTool;
 class ThemeManager;
 class IconTheme;
 class TruckPackVersionManager;
 
+namespace TruckPack {
+class Prefetcher;
+}
+
 namespace Meta {
 class Index;
 }
@@ -140,9 +152,12 @@ class Application : public QApplication {
 
     shared_qobject_ptr<HttpMetaCache> metacache();
 
+    std::shared_ptr<Hashing::HashCache> hashCache() { return m_hashCache; }
+
     shared_qobject_ptr<Meta::Index> metadataIndex();
 
     TruckPackVersionManager* truckPackVersionManager() { return m_truckPackVersionManager.get(); }
+    TruckPack::Prefetcher* truckPackPrefetcher() { return m_truckPackPrefetcher.get(); }
 
     void updateCapabilities();
 
@@ -222,6 +237,10 @@ class Application : public QApplication {
     bool handleDataMigration(const QString& currentData, const QString& oldData, const QString& name, const QString& configFile) const;
     bool createSetupWizard();
     void performMainStartupAction();
+    void reinstallTruckPack(QString instanceId, QString packUrl, QString packName, QString packVersion);
+    QStringList instanceRoots() const;
+    void collectCacheGarbage();
+    void collectStoreGarbage();
 
     // sets the fatal error message and m_status to Failed.
     void showFatalErrorMessage(const QString& title, const QString& content);
@@ -239,6 +258,10 @@ class Application : public QApplication {
     shared_qobject_ptr<AccountList> m_accounts;
 
     shared_qobject_ptr<HttpMetaCache> m_metacache;
+    shared_qobject_ptr<MetaCacheGCTask> m_cacheGCTask;
+    shared_qobject_ptr<TruckPack::StoreGCTask> m_storeGCTask;
+    bool m_storeGCPending = false;
+    std::shared_ptr<Hashing::HashCache> m_hashCache;
     shared_qobject_ptr<Meta::Index> m_metadataIndex;
 
     std::shared_ptr<SettingsObject> m_settings;
@@ -249,6 +272,7 @@ class Application : public QApplication {
     std::shared_ptr<GenericPageProvider> m_globalSettingsProvider;
     std::unique_ptr<MCEditTool> m_mcedit;
     std::unique_ptr<TruckPackVersionManager> m_truckPackVersionManager;
+    std::unique_ptr<TruckPack::Prefetcher> m_truckPackPrefetcher;
     QSet<QString> m_features;
     std::unique_ptr<ThemeManager> m_themeManager;
 
@@ -298,6 +322,7 @@ class Application : public QApplication {
     QString m_worldToJoin;
     QString m_profileToUse;
     bool m_liveCheck = false;
+    QString m_netTimingsFile;
     QList<QUrl> m_urlsToImport;
     QString m_instanceIdToShowWindowOf;
     std::unique_ptr<QFile> logFile;
@@ -100,13 +100,16 @@ namespace fs = ghc::filesystem;
 #if defined(Q_OS_LINUX)
 #include <errno.h>
 #include <fcntl.h> /* Definition of FICLONE* constants */
+#include <linux/falloc.h>
 #include <linux/fs.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #elif defined(Q_OS_MACOS)
+#include <fcntl.h>
 #include <sys/attr.h>
 #include <sys/clonefile.h>
 #elif defined(Q_OS_WIN)
+#include <io.h>
 // winbtrfs clone vs rundll32 shellbtrfs.dll,ReflinkCopy
 #include <fileapi.h>
 #include <stdio.h>
@@ -1654,6 +1657,48 @@ uintmax_t hardLinkCount(const QString& path)
     return count;
 }
 
+bool preallocate(QFileDevice& file, qint64 length)
+{
+    if (length <= 0 || file.handle() == -1)
+        return false;
+    qint64 from = file.pos();
+#if defined(Q_OS_LINUX)
+    // reserves the blocks without touching the file size, so whatever doesn't get written never shows up
+    if (fallocate(file.handle(), FALLOC_FL_KEEP_SIZE, from, length) == -1) {
+        qDebug() << "Failed to preallocate" << length << "bytes for" << file.fileName() << ":" << strerror(errno);
+        return false;
+    }
+    return true;
+#elif defined(Q_OS_MACOS)
+    // F_PREALLOCATE counts from the physical end of the file
+    fstore_t store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, from + length - file.size(), 0 };
+    if (store.fst_length <= 0)
+        return true;
+    if (fcntl(file.handle(), F_PREALLOCATE, &store) == -1) {
+        // a contiguous range is nice to have, not a must
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(file.handle(), F_PREALLOCATE, &store) == -1) {
+            qDebug() << "Failed to preallocate" << length << "bytes for" << file.fileName() << ":" << strerror(errno);
+            return false;
+        }
+    }
+    return true;
+#elif defined(Q_OS_WIN)
+    // the allocation size is independent from the end of the file as well
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = from + length;
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+    if (handle == INVALID_HANDLE_VALUE || !SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info))) {
+        qDebug() << "Failed to preallocate" << length << "bytes for" << file.fileName() << ":" << GetLastError();
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(from);
+    return false;
+#endif
+}
+
 #ifdef Q_OS_WIN
 // returns 8.3 file format from long path
 QString shortPathName(const QString& file)
@@ -43,6 +43,7 @@
 #include <system_error>
 
 #include <QDir>
+#include <QFileDevice>
 #include <QFlags>
 #include <QLocalServer>
 #include <QObject>
@@ -556,6 +557,14 @@ bool canLink(const QString& src, const QString& dst);
 
 uintmax_t hardLinkCount(const QString& path);
 
+/**
+ * @brief reserve disk space for the next \p length bytes written to \p file, from its current position
+ *
+ * Keeps big files from being scattered over the disk while they are written chunk by chunk. The file size
+ * doesn't change, unlike with QFileDevice::resize(). Best-effort: false if the platform or file system can't do it.
+ */
+bool preallocate(QFileDevice& file, qint64 length);
+
 #ifdef Q_OS_WIN
 QString getPathNameInLocal8bit(const QString& file);
 #endif
@@ -42,17 +42,20 @@
 #include "NullInstance.h"
 
 #include "QObjectPtr.h"
+#include "StreamingUnzip.h"
 #include "icons/IconList.h"
 #include "icons/IconUtils.h"
 
 #include "modplatform/flame/FlameInstanceCreationTask.h"
 #include "modplatform/modrinth/ModrinthInstanceCreationTask.h"
 #include "modplatform/technic/TechnicPackProcessor.h"
+#include "modplatform/truckpack/TruckPackFileStore.h"
+#include "modplatform/truckpack/TruckPackIndex.h"
 
 #include "settings/INISettingsObject.h"
 #include "tasks/Task.h"
 
-#include "net/ApiDownload.h"
+#include "net/SegmentedDownload.h"
 
 #include <QSettings>
 #include <QtConcurrentRun>
@@ -132,16 +135,21 @@ void InstanceImportTask::downloadFromUrl()
         qDebug() << "InstanceImportTask: Storing cache path for truck pack:" << m_pendingCachePath;
     }
 
-    auto filesNetJob = makeShared<NetJob>(tr("Modpack download"), APPLICATION->network());
-    filesNetJob->addNetAction(Net::ApiDownload::makeCached(m_sourceUrl, entry));
-
-    connect(filesNetJob.get(), &NetJob::succeeded, this, &InstanceImportTask::processZipPack);
-    connect(filesNetJob.get(), &NetJob::progress, this, &InstanceImportTask::setProgress);
-    connect(filesNetJob.get(), &NetJob::stepProgress, this, &InstanceImportTask::propagateStepProgress);
-    connect(filesNetJob.get(), &NetJob::failed, this, &InstanceImportTask::emitFailed);
-    connect(filesNetJob.get(), &NetJob::aborted, this, &InstanceImportTask::emitAborted);
-    m_task.reset(filesNetJob);
-    filesNetJob->start();
+    // large packs come in parallel segments, and an interrupted download continues where it stopped
+    auto segments = APPLICATION->settings()->get("DownloadSegments").toInt();
+    auto download = makeShared<Net::SegmentedDownload>(m_sourceUrl, entry, segments, APPLICATION->network());
+
+    // start extracting while the pack is still downloading, the central directory confirms the files afterwards
+    m_prefetched = std::make_shared<StreamingUnzip>(FS::PathCombine(m_stagingPath, ".pack-stream"));
+    download->setStreamValidator(StreamingUnzip::makeValidator(m_prefetched));
+
+    connect(download.get(), &Task::succeeded, this, &InstanceImportTask::processZipPack);
+    connect(download.get(), &Task::progress, this, &InstanceImportTask::setProgress);
+    connect(download.get(), &Task::stepProgress, this, &InstanceImportTask::propagateStepProgress);
+    connect(download.get(), &Task::failed, this, &InstanceImportTask::emitFailed);
+    connect(download.get(), &Task::aborted, this, &InstanceImportTask::emitAborted);
+    m_task.reset(download);
+    download->start();
 }
 
 QString InstanceImportTask::getRootFromZip(QuaZip* zip, const QString& root)
@@ -218,10 +226,17 @@ void InstanceImportTask::processZipPack()
         emitFailed(tr("Archive does not contain a recognized modpack type."));
         return;
     }
+    if (m_hasPendingTruckPackInfo && m_modpackType == ModpackType::MultiMC) {
+        // remember what the pack installed, so the next pack version can be applied as a delta
+        auto index = TruckPack::PackIndex::fromZip(packZip.get());
+        if (!index || !index->save(TruckPack::indexPathFor(m_stagingPath)))
+            qWarning() << "Could not save the truck pack index, the next update will compare files on disk";
+    }
     setStatus(tr("Extracting modpack"));
 
     // make sure we extract just the pack
     auto zipTask = makeShared<MMCZip::ExtractZipTask>(packZip, extractDir, root);
+    zipTask->setPrefetched(m_prefetched);
 
     auto progressStep = std::make_shared<TaskStepProgress>();
     connect(zipTask.get(), &Task::finished, this, [this, progressStep] {
@@ -255,6 +270,12 @@ void InstanceImportTask::extractFinished()
     setAbortable(false);
     QDir extractDir(m_stagingPath);
 
+    if (m_prefetched) {
+        // whatever is left there didn't match the archive
+        FS::deletePath(m_prefetched->outputDir());
+        m_prefetched.reset();
+    }
+
     qDebug() << "Fixing permissions for extracted pack files...";
     QDirIterator it(extractDir, QDirIterator::Subdirectories);
     while (it.hasNext()) {
@@ -280,6 +301,10 @@ void InstanceImportTask::extractFinished()
 
     switch (m_modpackType) {
         case ModpackType::MultiMC:
+            if (m_hasPendingTruckPackInfo) {
+                storeTruckPackFiles();
+                return;
+            }
             processMultiMC();
             return;
         case ModpackType::Technic:
@@ -355,6 +380,34 @@ void InstanceImportTask::processTechnic()
     packProcessor->run(m_globalSettings, name(), m_instIcon, m_stagingPath);
 }
 
+void InstanceImportTask::storeTruckPackFiles()
+{
+    auto index = TruckPack::PackIndex::load(TruckPack::indexPathFor(m_stagingPath));
+    auto storeRoot = APPLICATION->metacache()->getBasePath("TruckPackStore");
+    if (!index || storeRoot.isEmpty()) {
+        processMultiMC();
+        return;
+    }
+
+    QStringList shareable;
+    for (auto& entry : index->entries) {
+        if (TruckPack::FileStore::isShareable(entry.path))
+            shareable.append(entry.path);
+    }
+
+    auto storeTask = makeShared<TruckPack::StoreFilesTask>(storeRoot, m_stagingPath, m_stagingPath, shareable);
+    connect(storeTask.get(), &Task::finished, this, [this, task = storeTask.get()] {
+        // the files are in the instance either way, sharing them is only an optimization
+        if (!task->wasSuccessful())
+            qWarning() << "Could not move truck pack files into the shared store:" << task->failReason();
+        processMultiMC();
+    });
+    connect(storeTask.get(), &Task::status, this, &InstanceImportTask::setStatus);
+    connect(storeTask.get(), &Task::progress, this, &InstanceImportTask::setProgress);
+    m_task.reset(storeTask);
+    storeTask->start();
+}
+
 void InstanceImportTask::processMultiMC()
 {
     QString configPath = FS::PathCombine(m_stagingPath, "instance.cfg");
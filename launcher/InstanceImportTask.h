@@ -41,6 +41,7 @@
 #include "InstanceTask.h"
 
 class QuaZip;
+class StreamingUnzip;
 
 class InstanceImportTask : public InstanceTask {
     Q_OBJECT
@@ -62,6 +63,7 @@ class InstanceImportTask : public InstanceTask {
 
    private:
     void processMultiMC();
+    void storeTruckPackFiles();
     void processTechnic();
     void processFlame();
     void processModrinth();
@@ -75,6 +77,8 @@ class InstanceImportTask : public InstanceTask {
     QUrl m_sourceUrl;
     QString m_archivePath;
     Task::Ptr m_task;
+    // pack entries extracted while the archive downloads
+    std::shared_ptr<StreamingUnzip> m_prefetched;
     enum class ModpackType {
         Unknown,
         MultiMC,
@@ -61,6 +61,10 @@
 #include "NullInstance.h"
 #include "WatchLock.h"
 #include "minecraft/MinecraftInstance.h"
+#include "modplatform/truckpack/TruckPackDeltaUpdateTask.h"
+#include "modplatform/truckpack/TruckPackFileStore.h"
+#include "modplatform/truckpack/TruckPackIndex.h"
+#include "pathmatcher/IPathMatcher.h"
 #include "settings/INISettingsObject.h"
 
 #ifdef Q_OS_WIN32
@@ -69,6 +73,18 @@
 
 const static int GROUP_FILE_FORMAT_VERSION = 1;
 
+namespace {
+/** Matches exactly the given relative paths. */
+class PathSetMatcher : public IPathMatcher {
+   public:
+    explicit PathSetMatcher(QSet<QString> paths) : m_paths(std::move(paths)) {}
+    bool matches(const QString& string) const override { return m_paths.contains(string); }
+
+   private:
+    QSet<QString> m_paths;
+};
+}  // namespace
+
 InstanceList::InstanceList(SettingsObjectPtr settings, const QString& instDir, QObject* parent)
     : QAbstractListModel(parent), m_globalSettings(settings)
 {
@@ -404,6 +420,7 @@ void InstanceList::deleteInstance(const InstanceId& id)
     }
 
     qDebug() << "Will delete instance" << id;
+    FS::deletePath(rollbackPath(id));
     if (!FS::deletePath(inst->instanceRoot())) {
         qWarning() << "Deletion of instance" << id << "has not been completely successful ...";
         return;
@@ -923,6 +940,10 @@ class InstanceStaging : public Task {
                 // Apply truck pack info to the committed instance
                 m_parent->applyTruckPackInfo(m_child->name(), importTask->getPendingTruckPackName(), importTask->getPendingTruckPackVersion(), importTask->getPendingMaxMemAlloc(), importTask->getPendingCachePath());
             }
+            // Delta updates keep the instance and only need the new pack version recorded
+            if (auto deltaTask = dynamic_cast<TruckPack::DeltaUpdateTask*>(m_child.get())) {
+                m_parent->applyTruckPackInfo(m_child->name(), deltaTask->packName(), deltaTask->packVersion(), -1, deltaTask->cachePath());
+            }
             emitSucceeded();
             return;
         }
@@ -1012,7 +1033,13 @@ bool InstanceList::commitStagedInstance(const QString& path,
         WatchLock lock(m_watcher, m_instDir);
         QString destination = FS::PathCombine(m_instDir, instID);
 
-        if (should_override) {
+        if (should_override && commiting.shouldReplace()) {
+            if (!replaceInstanceFolder(instID, path)) {
+                qWarning() << "Failed to replace" << destination << "with" << path;
+                return false;
+            }
+            reloadInstance(instID);
+        } else if (should_override) {
             if (!FS::overrideFolder(destination, path)) {
                 qWarning() << "Failed to override" << path << "to" << destination;
                 return false;
@@ -1037,6 +1064,125 @@ bool InstanceList::commitStagedInstance(const QString& path,
     return true;
 }
 
+bool InstanceList::replaceInstanceFolder(const InstanceId& id, const QString& stagedPath)
+{
+    auto destination = FS::PathCombine(m_instDir, id);
+    auto snapshot = rollbackPath(id);
+
+    FS::deletePath(snapshot);
+    if (!FS::ensureFolderPathExists(QFileInfo(snapshot).absolutePath()))
+        return false;
+
+    // two renames within the instance folder: there is always a complete instance in one of the places
+    if (!QDir().rename(destination, snapshot))
+        return false;
+    if (!QDir().rename(stagedPath, destination)) {
+        QDir().rename(snapshot, destination);
+        return false;
+    }
+    return true;
+}
+
+void InstanceList::reloadInstance(const InstanceId& id)
+{
+    // the old object still holds the settings of the folder that was swapped out
+    for (int i = 0; i < m_instances.count(); i++) {
+        if (m_instances[i]->id() != id)
+            continue;
+        auto inst = loadInstance(id);
+        if (!inst)
+            return;
+        m_instances[i]->invalidate();
+        m_instances[i] = inst;
+        connect(inst.get(), &BaseInstance::propertiesChanged, this, &InstanceList::propertiesChanged);
+        emit dataChanged(index(i), index(i));
+        return;
+    }
+}
+
+QString InstanceList::rollbackPath(const InstanceId& id) const
+{
+    return FS::PathCombine(m_instDir, ".rollback", id);
+}
+
+bool InstanceList::hasRollback(const InstanceId& id) const
+{
+    return QFileInfo(FS::PathCombine(rollbackPath(id), "instance.cfg")).isFile();
+}
+
+bool InstanceList::snapshotInstance(const InstanceId& id)
+{
+    auto source = FS::PathCombine(m_instDir, id);
+    auto snapshot = rollbackPath(id);
+    auto partial = snapshot + ".part";
+
+    FS::deletePath(partial);
+    if (!FS::ensureFolderPathExists(partial))
+        return false;
+
+    bool snapshotted = false;
+    if (FS::canClone(source, partial)) {
+        FS::clone folderClone(source, partial);
+        snapshotted = folderClone();
+    } else {
+        // updates replace the pack's archives instead of writing into them, so only those can share their data with
+        // the live instance. Saves and configs are written in place, and get their own copy.
+        QSet<QString> linkable;
+        if (auto index = TruckPack::PackIndex::load(TruckPack::indexPathFor(source))) {
+            for (auto& entry : index->entries) {
+                if (TruckPack::FileStore::isShareable(entry.path) && QFileInfo(FS::PathCombine(source, entry.path)).isFile())
+                    linkable.insert(entry.path);
+            }
+        }
+        PathSetMatcher linked(linkable);
+
+        snapshotted = true;
+        if (!linkable.isEmpty()) {
+            FS::create_link folderLink(source, partial);
+            folderLink.linkRecursively(true).setMaxDepth(-1).useHardLinks(true).matcher(&linked).whitelist(true);
+            snapshotted = folderLink();
+        }
+        if (snapshotted) {
+            FS::copy folderCopy(source, partial);
+            folderCopy.matcher(&linked).whitelist(false);
+            snapshotted = folderCopy();
+        }
+    }
+    if (!snapshotted) {
+        qWarning() << "Could not snapshot instance" << id;
+        FS::deletePath(partial);
+        return false;
+    }
+
+    FS::deletePath(snapshot);
+    return QDir().rename(partial, snapshot);
+}
+
+bool InstanceList::rollbackInstance(const InstanceId& id)
+{
+    auto inst = getInstanceById(id);
+    if (!inst || inst->isRunning() || !hasRollback(id))
+        return false;
+
+    auto destination = FS::PathCombine(m_instDir, id);
+    auto snapshot = rollbackPath(id);
+    auto current = snapshot + ".old";
+    {
+        WatchLock lock(m_watcher, m_instDir);
+        FS::deletePath(current);
+        if (!QDir().rename(destination, current))
+            return false;
+        if (!QDir().rename(snapshot, destination)) {
+            QDir().rename(current, destination);
+            return false;
+        }
+        reloadInstance(id);
+    }
+    FS::deletePath(current);
+    qDebug() << "Instance" << id << "was rolled back";
+    return true;
+}
+
 bool InstanceList::destroyStagingPath(const QString& keyPath)
 {
     return FS::deletePath(keyPath);
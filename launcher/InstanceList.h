@@ -132,6 +132,25 @@ class InstanceList : public QAbstractListModel {
      */
     bool commitStagedInstance(const QString& keyPath, const InstanceName& instanceName, QString groupName, const InstanceTask&);
 
+    /**
+     * The previous version of an instance, kept by updates so they can be undone.
+     * Only one is kept per instance, the next update replaces it.
+     */
+    QString rollbackPath(const InstanceId& id) const;
+    bool hasRollback(const InstanceId& id) const;
+
+    /**
+     * Keep the current state of an instance as its rollback, before it is updated in place.
+     * The files are reflinked where the filesystem allows it. Otherwise only the pack's own archives (mods and the
+     * like, which updates replace instead of rewriting) are hardlinked, and everything else is copied: the game and
+     * the launcher write saves and configs in place, which would change a hardlinked rollback along with them.
+     * Safe to call from a worker thread.
+     */
+    bool snapshotInstance(const InstanceId& id);
+
+    /** Put the rollback of an instance back in its place, dropping the current state. */
+    bool rollbackInstance(const InstanceId& id);
+
     /**
      * Destroy a previously created staging area given by @keyPath - used when creation fails.
      * Used by instance manipulation tasks.
@@ -183,6 +202,8 @@ class InstanceList : public QAbstractListModel {
     void saveGroupList();
     QList<InstanceId> discoverInstances();
     InstancePtr loadInstance(const InstanceId& id);
+    void reloadInstance(const InstanceId& id);
+    bool replaceInstanceFolder(const InstanceId& id, const QString& stagedPath);
 
     void increaseGroupCount(const QString& group);
     void decreaseGroupCount(const QString& group);
@@ -51,6 +51,14 @@ class InstanceTask : public Task, public InstanceName {
 
     [[nodiscard]] QString originalInstanceID() const { return m_original_instance_id; };
 
+    /** Swap the staged instance in for the whole existing instance, keeping the old one as its rollback. */
+    void setReplace(const QString& instance_id_to_replace)
+    {
+        setOverride(true, instance_id_to_replace);
+        m_replace_existing = true;
+    }
+    [[nodiscard]] bool shouldReplace() const { return m_replace_existing; }
+
    protected:
     void setOverride(bool override, QString instance_id_to_override = {})
     {
@@ -66,6 +74,7 @@ class InstanceTask : public Task, public InstanceName {
     QString m_stagingPath;
 
     bool m_override_existing = false;
+    bool m_replace_existing = false;
     bool m_confirm_update = true;
 
     QString m_original_instance_id;
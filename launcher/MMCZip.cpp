@@ -43,10 +43,15 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QFileInfo>
+#include <QThread>
 #include <QUrl>
 
+#include <algorithm>
+#include <thread>
+
 #if defined(LAUNCHER_APPLICATION)
 #include <QtConcurrentRun>
+#include "StreamingUnzip.h"
 #endif
 
 namespace MMCZip {
@@ -268,32 +273,68 @@ bool findFilesInZip(QuaZip* zip, const QString& what, QStringList& result, const
 }
 
 // ours
-std::optional<QStringList> extractSubDir(QuaZip* zip, const QString& subdir, const QString& target)
+namespace {
+// below this, starting threads costs more than inflating on more cores saves
+constexpr qint64 PARALLEL_EXTRACT_MIN_SIZE = 4 * 1024 * 1024;
+// chunks per worker, so that a worker that got the large entries doesn't hold up the rest
+constexpr int CHUNKS_PER_WORKER = 4;
+
+bool fixPermissions(const QString& target_file_path)
 {
-    auto target_top_dir = QUrl::fromLocalFile(target);
+    auto fileInfo = QFileInfo(target_file_path);
+    if (fileInfo.isFile()) {
+        auto permissions = fileInfo.permissions();
+        auto maxPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser | QFileDevice::Permission::ExeUser |
+                             QFileDevice::Permission::ReadGroup | QFileDevice::Permission::ReadOther;
+        auto minPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser;
+
+        auto newPermisions = (permissions & maxPermisions) | minPermisions;
+        if (newPermisions != permissions)
+            return QFile::setPermissions(target_file_path, newPermisions);
+    } else if (fileInfo.isDir()) {
+        // Ensure the folder has the minimal required permissions
+        QFile::Permissions minimalPermissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner | QFile::ReadGroup |
+                                                QFile::ExeGroup | QFile::ReadOther | QFile::ExeOther;
+
+        QFile::Permissions currentPermissions = fileInfo.permissions();
+        if ((currentPermissions & minimalPermissions) != minimalPermissions)
+            return QFile::setPermissions(target_file_path, minimalPermissions);
+    }
+    return true;
+}
+}  // namespace
 
-    QStringList extracted;
+bool ParallelExtractor::fail(const QString& error)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_failed.exchange(true))
+        m_error = error;
+    return false;
+}
 
-    qDebug() << "Extracting subdir" << subdir << "from" << zip->getZipName() << "to" << target;
-    auto numEntries = zip->getEntriesCount();
-    if (numEntries < 0) {
-        qWarning() << "Failed to enumerate files in archive";
-        return std::nullopt;
-    } else if (numEntries == 0) {
-        qDebug() << "Extracting empty archives seems odd...";
-        return extracted;
-    } else if (!zip->goToFirstFile()) {
-        qWarning() << "Failed to seek to first file in zip";
-        return std::nullopt;
+bool ParallelExtractor::plan()
+{
+    auto target_top_dir = QUrl::fromLocalFile(m_target);
+
+    auto numEntries = m_zip->getEntriesCount();
+    if (numEntries < 0)
+        return fail(QObject::tr("Failed to enumerate files in archive"));
+    if (numEntries == 0) {
+        m_warnings.append(QObject::tr("Extracting empty archives seems odd..."));
+        return true;
     }
 
-    do {
-        QString file_name = zip->getCurrentFileName();
-        file_name = FS::RemoveInvalidPathChars(file_name);
-        if (!file_name.startsWith(subdir))
+    int index = 0;
+    bool more = m_zip->goToFirstFile();
+    if (!more)
+        return fail(QObject::tr("Failed to seek to first file in zip"));
+    for (; more; more = m_zip->goToNextFile(), index++) {
+        QString file_name = m_zip->getCurrentFileName();
+        auto sanitized_name = FS::RemoveInvalidPathChars(file_name);
+        if (!sanitized_name.startsWith(m_subdir))
             continue;
 
-        auto relative_file_name = QDir::fromNativeSeparators(file_name.mid(subdir.size()));
+        auto relative_file_name = QDir::fromNativeSeparators(sanitized_name.mid(m_subdir.size()));
         auto original_name = relative_file_name;
 
         // Fix subdirs/files ending with a / getting transformed into absolute paths
@@ -304,14 +345,14 @@ std::optional<QStringList> extractSubDir(QuaZip* zip, const QString& subdir, con
         QString sub_path;
         if (relative_file_name.contains('/') && !relative_file_name.endsWith('/')) {
             sub_path = relative_file_name.section('/', 0, -2) + '/';
-            FS::ensureFolderPathExists(FS::PathCombine(target, sub_path));
+            FS::ensureFolderPathExists(FS::PathCombine(m_target, sub_path));
 
             relative_file_name = relative_file_name.split('/').last();
         }
 
         QString target_file_path;
         if (relative_file_name.isEmpty()) {
-            target_file_path = target + '/';
+            target_file_path = m_target + '/';
         } else {
             target_file_path = FS::PathCombine(target_top_dir.toLocalFile(), sub_path, relative_file_name);
             if (relative_file_name.endsWith('/') && !target_file_path.endsWith('/'))
@@ -319,47 +360,153 @@ std::optional<QStringList> extractSubDir(QuaZip* zip, const QString& subdir, con
         }
 
         if (!target_top_dir.isParentOf(QUrl::fromLocalFile(target_file_path))) {
-            qWarning() << "Extracting" << relative_file_name << "was cancelled, because it was effectively outside of the target path"
-                       << target;
-            return std::nullopt;
+            return fail(QObject::tr("Extracting %1 was cancelled, because it was effectively outside of the target path %2")
+                            .arg(relative_file_name, m_target));
         }
 
-        if (!JlCompress::extractFile(zip, "", target_file_path)) {
-            qWarning() << "Failed to extract file" << original_name << "to" << target_file_path;
-            JlCompress::removeFile(extracted);
-            return std::nullopt;
-        }
+        QuaZipFileInfo64 info;
+        if (!m_zip->getCurrentFileInfo(&info))
+            return fail(QObject::tr("Failed to read the details of %1").arg(original_name));
+
+        Job job;
+        job.name = original_name;
+        job.target = target_file_path;
+        job.index = index;
+        job.compressedSize = static_cast<qint64>(info.compressedSize);
+        job.done = m_skip && m_skip(file_name, info, target_file_path);
+        if (job.done)
+            m_done++;
+        else
+            m_pending.push_back(static_cast<int>(m_jobs.size()));
+        m_jobs.push_back(job);
+    }
+    return true;
+}
+
+void ParallelExtractor::work(QuaZip* zip)
+{
+    // workers only take chunks further down the archive, so their handles only ever move forward
+    int position = -1;
+    while (!m_failed) {
+        int chunk = m_nextChunk++;
+        if (chunk >= static_cast<int>(m_chunks.size()))
+            return;
+
+        for (int i = m_chunks[chunk].first; i < m_chunks[chunk].second; i++) {
+            if (m_failed)
+                return;
+            if (m_canceled && m_canceled()) {
+                m_wasCanceled = true;
+                m_failed = true;
+                return;
+            }
 
-        extracted.append(target_file_path);
-        auto fileInfo = QFileInfo(target_file_path);
-        if (fileInfo.isFile()) {
-            auto permissions = fileInfo.permissions();
-            auto maxPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser | QFileDevice::Permission::ExeUser |
-                                 QFileDevice::Permission::ReadGroup | QFileDevice::Permission::ReadOther;
-            auto minPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser;
-
-            auto newPermisions = (permissions & maxPermisions) | minPermisions;
-            if (newPermisions != permissions) {
-                if (!QFile::setPermissions(target_file_path, newPermisions)) {
-                    qWarning() << (QObject::tr("Could not fix permissions for %1").arg(target_file_path));
+            auto& job = m_jobs[m_pending[i]];
+            if (position < 0 || position > job.index) {
+                if (!zip->goToFirstFile()) {
+                    fail(QObject::tr("Failed to seek to first file in zip"));
+                    return;
                 }
+                position = 0;
             }
-        } else if (fileInfo.isDir()) {
-            // Ensure the folder has the minimal required permissions
-            QFile::Permissions minimalPermissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner | QFile::ReadGroup |
-                                                    QFile::ExeGroup | QFile::ReadOther | QFile::ExeOther;
-
-            QFile::Permissions currentPermissions = fileInfo.permissions();
-            if ((currentPermissions & minimalPermissions) != minimalPermissions) {
-                if (!QFile::setPermissions(target_file_path, minimalPermissions)) {
-                    qWarning() << (QObject::tr("Could not fix permissions for %1").arg(target_file_path));
+            for (; position < job.index; position++) {
+                if (!zip->goToNextFile()) {
+                    fail(QObject::tr("Failed to seek to %1 in zip").arg(job.name));
+                    return;
                 }
             }
+
+            if (!JlCompress::extractFile(zip, "", job.target)) {
+                fail(QObject::tr("Failed to extract file %1 to %2").arg(job.name, job.target));
+                return;
+            }
+            job.done = true;
+            qDebug() << "Extracted file" << job.name << "to" << job.target;
+
+            bool fixed = fixPermissions(job.target);
+            int done = ++m_done;
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (!fixed)
+                m_warnings.append(QObject::tr("Could not fix permissions for %1").arg(job.target));
+            if (m_progress)
+                m_progress(job.name, done, static_cast<int>(m_jobs.size()));
         }
-        qDebug() << "Extracted file" << relative_file_name << "to" << target_file_path;
-    } while (zip->goToNextFile());
+    }
+}
+
+bool ParallelExtractor::operator()()
+{
+    if (!plan())
+        return false;
+
+    qint64 totalSize = 0;
+    for (auto i : m_pending)
+        totalSize += m_jobs[i].compressedSize;
+
+    int workers = 1;
+    auto zipName = m_zip->getZipName();
+    if (!zipName.isEmpty() && totalSize >= PARALLEL_EXTRACT_MIN_SIZE)
+        workers = std::clamp(QThread::idealThreadCount(), 1, static_cast<int>(m_pending.size()));
+
+    // contiguous chunks of about the same compressed size
+    qint64 chunkSize = std::max<qint64>(totalSize / (workers * CHUNKS_PER_WORKER), 1);
+    qint64 chunkFill = 0;
+    int chunkStart = 0;
+    for (int i = 0; i < static_cast<int>(m_pending.size()); i++) {
+        chunkFill += m_jobs[m_pending[i]].compressedSize;
+        if (chunkFill >= chunkSize || i + 1 == static_cast<int>(m_pending.size())) {
+            m_chunks.emplace_back(chunkStart, i + 1);
+            chunkStart = i + 1;
+            chunkFill = 0;
+        }
+    }
+
+    if (workers > 1)
+        qDebug() << "Extracting" << m_pending.size() << "files from" << zipName << "on" << workers << "threads";
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; i++) {
+        threads.emplace_back([this, zipName] {
+            QuaZip zip(zipName);
+            if (!zip.open(QuaZip::mdUnzip)) {
+                fail(QObject::tr("Could not open %1 for extraction").arg(zipName));
+                return;
+            }
+            work(&zip);
+        });
+    }
+    // the calling thread works too, with the handle it gave us
+    work(m_zip);
+    for (auto& thread : threads)
+        thread.join();
+
+    for (auto& job : m_jobs) {
+        if (job.done)
+            m_extracted.append(job.target);
+    }
+    if (m_wasCanceled)
+        return false;
+    if (m_failed) {
+        JlCompress::removeFile(m_extracted);
+        m_extracted.clear();
+        return false;
+    }
+    return true;
+}
 
-    return extracted;
+std::optional<QStringList> extractSubDir(QuaZip* zip, const QString& subdir, const QString& target)
+{
+    qDebug() << "Extracting subdir" << subdir << "from" << zip->getZipName() << "to" << target;
+
+    ParallelExtractor extract(zip, subdir, target);
+    bool extracted = extract();
+    for (auto& warning : extract.warnings())
+        qWarning() << warning;
+    if (!extracted) {
+        qWarning() << extract.error();
+        return std::nullopt;
+    }
+    return extract.extracted();
 }
 
 // ours
@@ -540,6 +687,7 @@ void ExtractZipTask::executeTask()
         emitFailed(tr("Unable to open supplied zip file."));
         return;
     }
+    m_canceled = false;
     m_zip_future = QtConcurrent::run(QThreadPool::globalInstance(), [this]() { return extractZip(); });
     connect(&m_zip_watcher, &QFutureWatcher<ZipResult>::finished, this, &ExtractZipTask::finish);
     m_zip_watcher.setFuture(m_zip_future);
@@ -548,100 +696,44 @@ void ExtractZipTask::executeTask()
 auto ExtractZipTask::extractZip() -> ZipResult
 {
     auto target = m_output_dir.absolutePath();
-    auto target_top_dir = QUrl::fromLocalFile(target);
-
-    QStringList extracted;
-
     qDebug() << "Extracting subdir" << m_subdirectory << "from" << m_input->getZipName() << "to" << target;
-    auto numEntries = m_input->getEntriesCount();
-    if (numEntries < 0) {
-        return ZipResult(tr("Failed to enumerate files in archive"));
-    }
-    if (numEntries == 0) {
-        logWarning(tr("Extracting empty archives seems odd..."));
-        return ZipResult();
-    }
-    if (!m_input->goToFirstFile()) {
-        return ZipResult(tr("Failed to seek to first file in zip"));
+
+    QHash<QString, StreamingUnzip::Entry> prefetched;
+    if (m_prefetched) {
+        prefetched = m_prefetched->entries();
+        qDebug() << prefetched.size() << "files were extracted during the download already";
     }
 
     setStatus("Extracting files...");
-    setProgress(0, numEntries);
-    do {
-        if (m_zip_future.isCanceled())
-            return ZipResult();
-        setProgress(m_progress + 1, m_progressTotal);
-        QString file_name = m_input->getCurrentFileName();
-        if (!file_name.startsWith(m_subdirectory))
-            continue;
-
-        auto relative_file_name = QDir::fromNativeSeparators(file_name.mid(m_subdirectory.size()));
-        auto original_name = relative_file_name;
-        setStatus("Unpacking: " + relative_file_name);
-
-        // Fix subdirs/files ending with a / getting transformed into absolute paths
-        if (relative_file_name.startsWith('/'))
-            relative_file_name = relative_file_name.mid(1);
-
-        // Fix weird "folders with a single file get squashed" thing
-        QString sub_path;
-        if (relative_file_name.contains('/') && !relative_file_name.endsWith('/')) {
-            sub_path = relative_file_name.section('/', 0, -2) + '/';
-            FS::ensureFolderPathExists(FS::PathCombine(target, sub_path));
-
-            relative_file_name = relative_file_name.split('/').last();
-        }
-
-        QString target_file_path;
-        if (relative_file_name.isEmpty()) {
-            target_file_path = target + '/';
-        } else {
-            target_file_path = FS::PathCombine(target_top_dir.toLocalFile(), sub_path, relative_file_name);
-            if (relative_file_name.endsWith('/') && !target_file_path.endsWith('/'))
-                target_file_path += '/';
-        }
-
-        if (!target_top_dir.isParentOf(QUrl::fromLocalFile(target_file_path))) {
-            return ZipResult(tr("Extracting %1 was cancelled, because it was effectively outside of the target path %2")
-                                 .arg(relative_file_name, target));
-        }
-
-        if (!JlCompress::extractFile(m_input.get(), "", target_file_path)) {
-            JlCompress::removeFile(extracted);
-            return ZipResult(tr("Failed to extract file %1 to %2").arg(original_name, target_file_path));
-        }
-
-        extracted.append(target_file_path);
-        auto fileInfo = QFileInfo(target_file_path);
-        if (fileInfo.isFile()) {
-            auto permissions = fileInfo.permissions();
-            auto maxPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser | QFileDevice::Permission::ExeUser |
-                                 QFileDevice::Permission::ReadGroup | QFileDevice::Permission::ReadOther;
-            auto minPermisions = QFileDevice::Permission::ReadUser | QFileDevice::Permission::WriteUser;
-
-            auto newPermisions = (permissions & maxPermisions) | minPermisions;
-            if (newPermisions != permissions) {
-                if (!QFile::setPermissions(target_file_path, newPermisions)) {
-                    logWarning(tr("Could not fix permissions for %1").arg(target_file_path));
-                }
-            }
-        } else if (fileInfo.isDir()) {
-            // Ensure the folder has the minimal required permissions
-            QFile::Permissions minimalPermissions = QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner | QFile::ReadGroup |
-                                                    QFile::ExeGroup | QFile::ReadOther | QFile::ExeOther;
-
-            QFile::Permissions currentPermissions = fileInfo.permissions();
-            if ((currentPermissions & minimalPermissions) != minimalPermissions) {
-                if (!QFile::setPermissions(target_file_path, minimalPermissions)) {
-                    logWarning(tr("Could not fix permissions for %1").arg(target_file_path));
-                }
+    ParallelExtractor extract(m_input.get(), m_subdirectory, target);
+    extract.cancelWhen([this] { return m_canceled.load(); });
+    extract.progress([this](const QString& name, int done, int total) {
+        setStatus("Unpacking: " + name);
+        setProgress(done, total);
+    });
+    if (!prefetched.isEmpty()) {
+        extract.skip([this, &prefetched](const QString& name, const QuaZipFileInfo64& info, const QString& target_file_path) {
+            auto entry = prefetched.constFind(name);
+            if (entry == prefetched.constEnd())
+                return false;
+            // only trust what was streamed if it matches the central directory
+            auto streamed = FS::PathCombine(m_prefetched->outputDir(), name);
+            if (info.crc == entry->crc32 && qint64(info.uncompressedSize) == entry->size) {
+                QFile::remove(target_file_path);
+                if (QFile::rename(streamed, target_file_path))
+                    return true;
             }
-        }
-
-        qDebug() << "Extracted file" << relative_file_name << "to" << target_file_path;
-    } while (m_input->goToNextFile());
+            QFile::remove(streamed);
+            return false;
+        });
+    }
 
-    return ZipResult();
+    bool extracted = extract();
+    for (auto& warning : extract.warnings())
+        logWarning(warning);
+    if (extract.wasCanceled() || extracted)
+        return ZipResult();
+    return ZipResult(extract.error());
 }
 
 void ExtractZipTask::finish()
@@ -658,6 +750,7 @@ void ExtractZipTask::finish()
 bool ExtractZipTask::abort()
 {
     if (m_zip_future.isRunning()) {
+        m_canceled = true;
         m_zip_future.cancel();
         // NOTE: Here we don't do `emitAborted()` because it will be done when `m_build_zip_future` actually cancels, which may not occur
         // immediately.
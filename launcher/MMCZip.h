@@ -45,12 +45,17 @@
 #include <QHash>
 #include <QSet>
 #include <QString>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
 
 #if defined(LAUNCHER_APPLICATION)
 #include "minecraft/mod/Mod.h"
+
+class StreamingUnzip;
 #endif
 #include "tasks/Task.h"
 
@@ -105,6 +110,85 @@ QString findFolderOfFileInZip(QuaZip* zip, const QString& what, const QStringLis
  */
 bool findFilesInZip(QuaZip* zip, const QString& what, QStringList& result, const QString& root = QString());
 
+/**
+ * Extracts the entries of an archive that are in a subdirectory, on several threads at once.
+ *
+ * The central directory is read once through the given handle, to work out where every entry goes. An entry that
+ * would end up outside of the target folder fails the extraction before anything is written. The entries are then
+ * split into chunks of about the same compressed size, which the workers take in turn, each with its own handle to
+ * the archive. Small archives, and archives that aren't files on disk, are extracted on the calling thread.
+ */
+class ParallelExtractor {
+   public:
+    /** Asked about every entry before it is extracted. Returning true means it was taken care of otherwise. */
+    using SkipFunction = std::function<bool(const QString& name, const QuaZipFileInfo64& info, const QString& target)>;
+    /** Called after every entry, from the worker threads, one at a time. */
+    using ProgressFunction = std::function<void(const QString& name, int done, int total)>;
+
+    ParallelExtractor(QuaZip* zip, QString subdir, QString target)
+        : m_zip(zip), m_subdir(std::move(subdir)), m_target(std::move(target))
+    {}
+
+    ParallelExtractor& skip(SkipFunction skip)
+    {
+        m_skip = std::move(skip);
+        return *this;
+    }
+    ParallelExtractor& progress(ProgressFunction progress)
+    {
+        m_progress = std::move(progress);
+        return *this;
+    }
+    /** Polled between entries. */
+    ParallelExtractor& cancelWhen(std::function<bool()> canceled)
+    {
+        m_canceled = std::move(canceled);
+        return *this;
+    }
+
+    bool operator()();
+
+    /** The target paths of all extracted entries, in archive order. Emptied again when the extraction failed. */
+    QStringList extracted() const { return m_extracted; }
+    QString error() const { return m_error; }
+    bool wasCanceled() const { return m_wasCanceled; }
+    QStringList warnings() const { return m_warnings; }
+
+   private:
+    struct Job {
+        QString name;
+        QString target;
+        int index = 0;
+        qint64 compressedSize = 0;
+        bool done = false;
+    };
+
+    bool plan();
+    void work(QuaZip* zip);
+    bool fail(const QString& error);
+
+   private:
+    QuaZip* m_zip;
+    QString m_subdir;
+    QString m_target;
+    SkipFunction m_skip;
+    ProgressFunction m_progress;
+    std::function<bool()> m_canceled;
+
+    std::vector<Job> m_jobs;
+    std::vector<std::pair<int, int>> m_chunks;  // [first, last) into m_pending
+    std::vector<int> m_pending;
+    std::atomic<int> m_nextChunk{ 0 };
+    std::atomic<int> m_done{ 0 };
+    std::atomic<bool> m_failed{ false };
+    std::atomic<bool> m_wasCanceled{ false };
+    std::mutex m_lock;
+
+    QStringList m_extracted;
+    QString m_error;
+    QStringList m_warnings;
+};
+
 /**
  * Extract a subdirectory from an archive
  */
@@ -220,6 +304,12 @@ class ExtractZipTask : public Task {
 
     using ZipResult = std::optional<QString>;
 
+    /**
+     * Entries that were already extracted while the archive downloaded. The ones that match the central
+     * directory are moved into place instead of being extracted again.
+     */
+    void setPrefetched(std::shared_ptr<StreamingUnzip> prefetched) { m_prefetched = std::move(prefetched); }
+
    protected:
     virtual void executeTask() override;
     bool abort() override;
@@ -231,9 +321,12 @@ class ExtractZipTask : public Task {
     std::shared_ptr<QuaZip> m_input;
     QDir m_output_dir;
     QString m_subdirectory;
+    std::shared_ptr<StreamingUnzip> m_prefetched;
 
     QFuture<ZipResult> m_zip_future;
     QFutureWatcher<ZipResult> m_zip_watcher;
+    // set on the GUI thread, polled by the extract workers
+    std::atomic<bool> m_canceled = false;
 };
 #endif
 }  // namespace MMCZip
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StampedFileCache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSet>
+
+#include "PSaveFile.h"
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+// the layout around the payloads
+constexpr quint32 FileVersion = 1;
+// entries of files that weren't looked up in a while are dropped when the cache is loaded
+constexpr qint64 MaxUnusedDays = 30;
+
+qint64 today()
+{
+    return QDateTime::currentSecsSinceEpoch() / (24 * 60 * 60);
+}
+
+quint64 inodeOf(const QString& path)
+{
+#if defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(path.utf16()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+    BY_HANDLE_FILE_INFORMATION info;
+    quint64 index = 0;
+    if (GetFileInformationByHandle(handle, &info))
+        index = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    CloseHandle(handle);
+    return index;
+#else
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0)
+        return 0;
+    return quint64(info.st_ino);
+#endif
+}
+}  // namespace
+
+StampedFileCache::StampedFileCache(QString cacheFile, Keying keying, quint32 magic, QString format)
+    : QObject(), m_cacheFile(std::move(cacheFile)), m_keying(keying), m_magic(magic), m_format(std::move(format))
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setTimerType(Qt::VeryCoarseTimer);
+
+    connect(&m_saveTimer, &QTimer::timeout, this, &StampedFileCache::saveNow);
+}
+
+StampedFileCache::~StampedFileCache()
+{
+    m_saveTimer.stop();
+    saveNow();
+}
+
+StampedFileCache::Stamp StampedFileCache::stampOf(const QFileInfo& file)
+{
+    if (!file.isFile())
+        return {};
+
+    Stamp stamp;
+    stamp.size = file.size();
+    stamp.modified = file.lastModified().toMSecsSinceEpoch();
+    stamp.inode = inodeOf(file.absoluteFilePath());
+    return stamp;
+}
+
+QString StampedFileCache::keyOf(const QFileInfo& file) const
+{
+    if (m_keying == Keying::AbsolutePath)
+        return file.absoluteFilePath();
+
+    auto name = file.fileName();
+    if (name.endsWith(".disabled"))
+        name.chop(9);
+    return name;
+}
+
+std::optional<QByteArray> StampedFileCache::lookupPayload(const QFileInfo& file)
+{
+    auto stamp = stampOf(file);
+
+    QMutexLocker locker(&m_lock);
+    auto it = m_entries.find(keyOf(file));
+    if (it == m_entries.end())
+        return {};
+    if (!stamp.isValid() || it->stamp != stamp) {
+        m_entries.erase(it);
+        m_dirty = true;
+        return {};
+    }
+    if (auto day = today(); it->lastUsed != day) {
+        it->lastUsed = day;
+        m_dirty = true;
+    }
+    return it->payload;
+}
+
+void StampedFileCache::storePayload(const QFileInfo& file, const QByteArray& payload)
+{
+    updatePayload(file, stampOf(file), [&payload](QByteArray& stored) { stored = payload; });
+}
+
+void StampedFileCache::updatePayload(const QFileInfo& file, const Stamp& stamp, const std::function<void(QByteArray&)>& update)
+{
+    if (!stamp.isValid())
+        return;
+
+    {
+        QMutexLocker locker(&m_lock);
+        auto& entry = m_entries[keyOf(file)];
+        if (entry.stamp != stamp) {
+            entry.stamp = stamp;
+            entry.payload.clear();
+        }
+        entry.lastUsed = today();
+        update(entry.payload);
+        m_dirty = true;
+    }
+
+    // stores usually come from worker threads, the timer belongs to ours
+    QMetaObject::invokeMethod(this, &StampedFileCache::saveEventually, Qt::QueuedConnection);
+}
+
+void StampedFileCache::retain(const QStringList& fileNames)
+{
+    QSet<QString> keep;
+    for (auto& name : fileNames)
+        keep.insert(keyOf(QFileInfo(name)));
+
+    {
+        QMutexLocker locker(&m_lock);
+        auto before = m_entries.size();
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (keep.contains(it.key()))
+                ++it;
+            else
+                it = m_entries.erase(it);
+        }
+        if (m_entries.size() == before)
+            return;
+        m_dirty = true;
+    }
+
+    QMetaObject::invokeMethod(this, &StampedFileCache::saveEventually, Qt::QueuedConnection);
+}
+
+int StampedFileCache::size() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_entries.size();
+}
+
+void StampedFileCache::load()
+{
+    QMutexLocker locker(&m_lock);
+    if (m_loaded)
+        return;
+    m_loaded = true;
+
+    QFile file(m_cacheFile);
+    if (m_cacheFile.isEmpty() || !file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0, version = 0;
+    QString format;
+    in >> magic >> version >> format;
+    if (in.status() != QDataStream::Ok || magic != m_magic || version != FileVersion || format != m_format) {
+        qDebug() << "Discarding the cache" << m_cacheFile;
+        return;
+    }
+
+    auto oldest = today() - MaxUnusedDays;
+    quint32 count = 0;
+    in >> count;
+    QHash<QString, Entry> entries;
+    for (quint32 i = 0; i < count; i++) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.stamp.size >> entry.stamp.modified >> entry.stamp.inode >> entry.lastUsed >> entry.payload;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "The cache" << m_cacheFile << "is damaged, starting over";
+            return;
+        }
+        if (entry.lastUsed >= oldest)
+            entries.insert(key, entry);
+    }
+    // entries stored before the file was read are newer
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        entries.insert(it.key(), it.value());
+    m_entries = std::move(entries);
+}
+
+void StampedFileCache::saveEventually()
+{
+    // reset the save timer
+    m_saveTimer.stop();
+    m_saveTimer.start(30000);
+}
+
+void StampedFileCache::saveNow()
+{
+    QMutexLocker locker(&m_lock);
+    if (m_cacheFile.isEmpty() || !m_dirty)
+        return;
+
+    PSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Error writing the cache" << m_cacheFile << ":" << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << m_magic << FileVersion << m_format;
+    out << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        out << it.key() << it->stamp.size << it->stamp.modified << it->stamp.inode << it->lastUsed << it->payload;
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Error writing the cache" << m_cacheFile << ":" << file.errorString();
+        return;
+    }
+    m_dirty = false;
+}
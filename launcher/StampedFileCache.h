@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <functional>
+#include <optional>
+
+/**
+ * Keeps something worked out from files in a single file on disk, for as long as the files stay the same.
+ *
+ * Every entry holds an opaque payload, subclasses decide what goes into it. An entry is only used while its file has the
+ * same size, modification time and inode (file index on Windows); anything else drops it. Folders are never cached.
+ * Entries that weren't used for a month are dropped when the cache is loaded.
+ *
+ * The entries are guarded by a lock, so subclasses may look them up and store them from worker threads. Saving is left
+ * to the thread the cache lives in.
+ */
+class StampedFileCache : public QObject {
+    Q_OBJECT
+   public:
+    struct Stamp {
+        qint64 size = -1;
+        qint64 modified = 0;  // in ms since the epoch
+        quint64 inode = 0;
+
+        bool isValid() const { return size >= 0; }
+        bool operator==(const Stamp& other) const { return size == other.size && modified == other.modified && inode == other.inode; }
+        bool operator!=(const Stamp& other) const { return !(*this == other); }
+    };
+
+    enum class Keying {
+        /** For caches shared by files from anywhere. */
+        AbsolutePath,
+        /** For caches of one folder. A '.disabled' suffix is left out, so toggling a file keeps its entry. */
+        FileName,
+    };
+
+    ~StampedFileCache() override;
+
+    /** What identifies the current version of a file, or an invalid stamp if it isn't one. */
+    static Stamp stampOf(const QFileInfo& file);
+
+    /** Forget every file that isn't in @fileNames anymore. */
+    void retain(const QStringList& fileNames);
+
+    int size() const;
+
+   public slots:
+    /** Reads the cache file, once. Can be called from any thread. */
+    void load();
+    void saveEventually();
+    void saveNow();
+
+   protected:
+    /**
+     * @magic tells the files of different caches apart. @format names how the payloads are encoded, a file written with
+     * another one is discarded.
+     */
+    StampedFileCache(QString cacheFile, Keying keying, quint32 magic, QString format);
+
+    std::optional<QByteArray> lookupPayload(const QFileInfo& file);
+    void storePayload(const QFileInfo& file, const QByteArray& payload);
+    /**
+     * Changes the payload of the version of @file described by @stamp, which was taken before the payload was worked out.
+     * @update gets an empty payload when nothing is kept for that version yet.
+     */
+    void updatePayload(const QFileInfo& file, const Stamp& stamp, const std::function<void(QByteArray&)>& update);
+
+   private:
+    struct Entry {
+        Stamp stamp;
+        qint64 lastUsed = 0;  // in days since the epoch
+        QByteArray payload;
+    };
+
+    QString keyOf(const QFileInfo& file) const;
+
+    QString m_cacheFile;
+    Keying m_keying;
+    quint32 m_magic;
+    QString m_format;
+
+    mutable QMutex m_lock;
+    bool m_loaded = false;
+    bool m_dirty = false;
+    QHash<QString, Entry> m_entries;
+    QTimer m_saveTimer;
+};
@@ -0,0 +1,463 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StreamingUnzip.h"
+
+#include <zlib.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QUrl>
+#include <QtConcurrentRun>
+#include <QtEndian>
+
+#include <functional>
+
+#include "FileSystem.h"
+#include "net/Validator.h"
+
+namespace {
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+const int LOCAL_HEADER_SIZE = 30;
+
+// how far the worker may fall behind the download before streaming gives up
+const qint64 MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+/** Parses a zip archive from the front, and writes out the entries as their data comes in. */
+class ZipStreamParser {
+   public:
+    using Extracted = std::function<void(const QString& name, StreamingUnzip::Entry entry)>;
+
+    ZipStreamParser(QString outputDir, Extracted extracted)
+        : m_outputDir(std::move(outputDir)), m_extracted(std::move(extracted)), m_inflated(256 * 1024, Qt::Uninitialized)
+    {}
+    ~ZipStreamParser() { closeEntry(); }
+
+    void reset()
+    {
+        closeEntry();
+        m_buffer.clear();
+        m_pos = 0;
+        m_state = State::Header;
+    }
+
+    void consume(const QByteArray& data)
+    {
+        if (m_state == State::Done || m_state == State::Stopped)
+            return;
+
+        m_buffer.append(data);
+        bool progressed = true;
+        while (progressed) {
+            switch (m_state) {
+                case State::Header:
+                    progressed = header();
+                    break;
+                case State::Data:
+                    progressed = entryData();
+                    break;
+                case State::Descriptor:
+                    progressed = descriptor();
+                    break;
+                default:
+                    progressed = false;
+            }
+        }
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+
+   private:
+    enum class State { Header, Data, Descriptor, Done, Stopped };
+
+    qint64 available() const { return m_buffer.size() - m_pos; }
+    const uchar* at(qint64 offset) const { return reinterpret_cast<const uchar*>(m_buffer.constData() + m_pos + offset); }
+    quint16 u16(qint64 offset) const { return qFromLittleEndian<quint16>(at(offset)); }
+    quint32 u32(qint64 offset) const { return qFromLittleEndian<quint32>(at(offset)); }
+    quint64 u64(qint64 offset) const { return qFromLittleEndian<quint64>(at(offset)); }
+
+    void stop(const QString& reason)
+    {
+        qDebug() << "StreamingUnzip: stopped at" << m_name << ":" << reason;
+        closeEntry();
+        if (m_output.fileName().size())
+            m_output.remove();
+        m_state = State::Stopped;
+    }
+
+    void closeEntry()
+    {
+        if (m_inflating) {
+            inflateEnd(&m_stream);
+            m_inflating = false;
+        }
+        m_output.close();
+    }
+
+    bool header()
+    {
+        if (available() < 4)
+            return false;
+        auto signature = u32(0);
+        if (signature == CENTRAL_HEADER_SIGNATURE || signature == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            // everything after this is the central directory, which the caller reads from the complete archive
+            m_state = State::Done;
+            return false;
+        }
+        if (signature != LOCAL_HEADER_SIGNATURE) {
+            stop(QString("unexpected signature %1").arg(signature, 8, 16, QChar('0')));
+            return false;
+        }
+        if (available() < LOCAL_HEADER_SIZE)
+            return false;
+        auto nameLength = u16(26);
+        auto extraLength = u16(28);
+        if (available() < LOCAL_HEADER_SIZE + nameLength + extraLength)
+            return false;
+
+        auto flags = u16(6);
+        m_method = u16(8);
+        m_expectedCrc = u32(14);
+        m_compressedSize = u32(18);
+        m_size = u32(22);
+        m_name = QString::fromUtf8(m_buffer.mid(m_pos + LOCAL_HEADER_SIZE, nameLength));
+
+        // zip64 sizes are in an extra field, in this order, for the header fields that are maxed out
+        m_zip64 = false;
+        qint64 extra = LOCAL_HEADER_SIZE + nameLength;
+        qint64 extraEnd = extra + extraLength;
+        while (extra + 4 <= extraEnd) {
+            auto id = u16(extra);
+            auto size = u16(extra + 2);
+            if (id == 0x0001) {
+                m_zip64 = true;
+                qint64 field = extra + 4;
+                if (m_size == 0xFFFFFFFF && field + 8 <= extra + 4 + size) {
+                    m_size = u64(field);
+                    field += 8;
+                }
+                if (m_compressedSize == 0xFFFFFFFF && field + 8 <= extra + 4 + size)
+                    m_compressedSize = u64(field);
+            }
+            extra += 4 + size;
+        }
+        m_pos += extraEnd;
+
+        m_hasDescriptor = flags & 8;
+        if (flags & 1) {
+            stop("encrypted entry");
+            return false;
+        }
+        if (m_method != 0 && m_method != Z_DEFLATED) {
+            stop(QString("unsupported compression method %1").arg(m_method));
+            return false;
+        }
+        if (m_hasDescriptor && m_method == 0) {
+            stop("stored entry without a known size");
+            return false;
+        }
+        if (m_hasDescriptor)
+            m_compressedSize = -1;
+
+        m_crc = crc32(0L, Z_NULL, 0);
+        m_consumed = 0;
+        m_written = 0;
+        m_output.setFileName({});
+        if (!m_name.endsWith('/')) {
+            auto target = FS::PathCombine(m_outputDir, m_name);
+            if (!QUrl::fromLocalFile(m_outputDir).isParentOf(QUrl::fromLocalFile(target))) {
+                stop("entry is outside of the output folder");
+                return false;
+            }
+            m_output.setFileName(target);
+            if (!FS::ensureFilePathExists(target) || !m_output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                stop("can't write " + target);
+                return false;
+            }
+        }
+        if (m_method == Z_DEFLATED) {
+            memset(&m_stream, 0, sizeof(m_stream));
+            if (inflateInit2(&m_stream, -MAX_WBITS) != Z_OK) {
+                stop("can't initialize zlib");
+                return false;
+            }
+            m_inflating = true;
+        }
+        m_state = State::Data;
+        return true;
+    }
+
+    bool write(const char* data, qint64 size)
+    {
+        m_crc = crc32(m_crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size));
+        m_written += size;
+        if (m_output.isOpen() && m_output.write(data, size) != size) {
+            stop("can't write " + m_output.fileName());
+            return false;
+        }
+        return true;
+    }
+
+    bool entryData()
+    {
+        if (m_method == 0) {
+            auto size = std::min(available(), m_compressedSize - m_consumed);
+            if (size > 0 && !write(m_buffer.constData() + m_pos, size))
+                return false;
+            m_pos += size;
+            m_consumed += size;
+            if (m_consumed == m_compressedSize)
+                return dataFinished();
+            return false;
+        }
+
+        auto size = available();
+        if (m_compressedSize >= 0)
+            size = std::min(size, m_compressedSize - m_consumed);
+        if (size <= 0)
+            return m_compressedSize >= 0 && m_consumed == m_compressedSize ? corruptDeflate() : false;
+
+        auto& out = m_inflated;
+        m_stream.next_in = reinterpret_cast<Bytef*>(m_buffer.data() + m_pos);
+        m_stream.avail_in = static_cast<uInt>(size);
+        int zerr = Z_OK;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef*>(out.data());
+            m_stream.avail_out = static_cast<uInt>(out.size());
+            zerr = inflate(&m_stream, Z_NO_FLUSH);
+            if (zerr != Z_OK && zerr != Z_STREAM_END && zerr != Z_BUF_ERROR) {
+                stop("corrupted deflate stream");
+                return false;
+            }
+            if (!write(out.constData(), out.size() - static_cast<qint64>(m_stream.avail_out)))
+                return false;
+        } while (zerr == Z_OK && (m_stream.avail_in > 0 || m_stream.avail_out == 0));
+
+        auto used = size - static_cast<qint64>(m_stream.avail_in);
+        m_pos += used;
+        m_consumed += used;
+        if (zerr == Z_STREAM_END)
+            return dataFinished();
+        return used > 0;
+    }
+
+    bool corruptDeflate()
+    {
+        stop("deflate stream doesn't end with the entry");
+        return false;
+    }
+
+    bool dataFinished()
+    {
+        if (m_inflating) {
+            inflateEnd(&m_stream);
+            m_inflating = false;
+        }
+        if (m_hasDescriptor) {
+            m_state = State::Descriptor;
+            return true;
+        }
+        finishEntry(m_expectedCrc, m_compressedSize, m_size);
+        return true;
+    }
+
+    bool descriptor()
+    {
+        if (available() < 4)
+            return false;
+        qint64 offset = u32(0) == DATA_DESCRIPTOR_SIGNATURE ? 4 : 0;
+        qint64 length = offset + (m_zip64 ? 20 : 12);
+        if (available() < length)
+            return false;
+
+        auto crc = u32(offset);
+        qint64 compressedSize = m_zip64 ? qint64(u64(offset + 4)) : u32(offset + 4);
+        qint64 size = m_zip64 ? qint64(u64(offset + 12)) : u32(offset + 8);
+        m_pos += length;
+        finishEntry(crc, compressedSize, size);
+        return true;
+    }
+
+    void finishEntry(quint32 crc, qint64 compressedSize, qint64 size)
+    {
+        m_output.close();
+        bool good = static_cast<quint32>(m_crc) == crc && m_written == size && m_consumed == compressedSize;
+        if (m_output.fileName().size()) {
+            if (good) {
+                m_extracted(m_name, { crc, size });
+            } else {
+                qDebug() << "StreamingUnzip: dropping" << m_name << "which doesn't match its header";
+                m_output.remove();
+            }
+        }
+        m_output.setFileName({});
+        m_state = State::Header;
+    }
+
+   private:
+    QString m_outputDir;
+    Extracted m_extracted;
+    QByteArray m_inflated;
+
+    QByteArray m_buffer;
+    qint64 m_pos = 0;
+    State m_state = State::Header;
+
+    // the current entry
+    QString m_name;
+    int m_method = 0;
+    bool m_hasDescriptor = false;
+    bool m_zip64 = false;
+    quint32 m_expectedCrc = 0;
+    qint64 m_compressedSize = 0;
+    qint64 m_size = 0;
+    qint64 m_consumed = 0;
+    qint64 m_written = 0;
+    uLong m_crc = 0;
+    QFile m_output;
+    z_stream m_stream;
+    bool m_inflating = false;
+};
+
+class StreamingUnzipValidator : public Net::Validator {
+   public:
+    explicit StreamingUnzipValidator(std::shared_ptr<StreamingUnzip> unzip) : m_unzip(std::move(unzip)) {}
+
+    bool init(QNetworkRequest&) override
+    {
+        m_unzip->restart();
+        return true;
+    }
+    bool write(QByteArray& data) override
+    {
+        m_unzip->feed(data);
+        return true;
+    }
+    bool abort() override
+    {
+        m_unzip->stop();
+        return true;
+    }
+    // the download itself is fine even if streaming didn't work out
+    bool validate(QNetworkReply&) override { return true; }
+
+   private:
+    std::shared_ptr<StreamingUnzip> m_unzip;
+};
+}  // namespace
+
+StreamingUnzip::StreamingUnzip(QString outputDir) : m_outputDir(std::move(outputDir)) {}
+
+StreamingUnzip::~StreamingUnzip()
+{
+    {
+        QMutexLocker locker(&m_lock);
+        m_cancelled = true;
+        m_wake.wakeAll();
+    }
+    m_worker.waitForFinished();
+}
+
+Net::Validator* StreamingUnzip::makeValidator(std::shared_ptr<StreamingUnzip> unzip)
+{
+    return new StreamingUnzipValidator(std::move(unzip));
+}
+
+void StreamingUnzip::restart()
+{
+    QMutexLocker locker(&m_lock);
+    m_queue.clear();
+    m_queuedBytes = 0;
+    m_generation++;
+    m_stopped = false;
+    m_entries.clear();
+    if (!m_workerActive) {
+        m_workerActive = true;
+        m_worker = QtConcurrent::run(QThreadPool::globalInstance(), [this] { run(); });
+    }
+    m_wake.wakeAll();
+}
+
+void StreamingUnzip::feed(const QByteArray& data)
+{
+    QMutexLocker locker(&m_lock);
+    if (m_stopped || !m_workerActive)
+        return;
+    if (m_queuedBytes + data.size() > MAX_QUEUED_BYTES) {
+        qDebug() << "StreamingUnzip: extraction can't keep up with the download, the rest is extracted afterwards";
+        m_queue.clear();
+        m_queuedBytes = 0;
+        m_stopped = true;
+    } else {
+        m_queue.enqueue(data);
+        m_queuedBytes += data.size();
+    }
+    m_wake.wakeAll();
+}
+
+void StreamingUnzip::stop()
+{
+    QMutexLocker locker(&m_lock);
+    m_stopped = true;
+    m_wake.wakeAll();
+}
+
+QHash<QString, StreamingUnzip::Entry> StreamingUnzip::entries()
+{
+    stop();
+    m_worker.waitForFinished();
+    QMutexLocker locker(&m_lock);
+    return m_entries;
+}
+
+void StreamingUnzip::run()
+{
+    QMutexLocker locker(&m_lock);
+    int generation = m_generation;
+    ZipStreamParser parser(m_outputDir, [this, &generation](const QString& name, Entry entry) {
+        QMutexLocker locker(&m_lock);
+        // a restart while this entry was written makes it meaningless
+        if (generation == m_generation)
+            m_entries.insert(name, entry);
+    });
+
+    while (true) {
+        while (m_queue.isEmpty() && !m_stopped && !m_cancelled && generation == m_generation)
+            m_wake.wait(&m_lock);
+        if (m_cancelled)
+            break;
+        if (generation != m_generation) {
+            generation = m_generation;
+            parser.reset();
+            continue;
+        }
+        if (m_queue.isEmpty())
+            break;
+
+        auto data = m_queue.dequeue();
+        m_queuedBytes -= data.size();
+        locker.unlock();
+        parser.consume(data);
+        locker.relock();
+    }
+    m_workerActive = false;
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QWaitCondition>
+
+#include <memory>
+
+namespace Net {
+class Validator;
+}
+
+/**
+ * Extracts a zip archive while it is still being downloaded.
+ *
+ * The bytes are handed over in order, from the start of the archive, and a worker thread inflates every entry
+ * into the output folder as soon as its local file header and data came in. Nothing is trusted until the
+ * central directory is available: entries() only tells which files were extracted and what their CRC-32 and
+ * size were, and the caller compares that against the central directory of the complete archive.
+ *
+ * Streaming is best-effort. Anything it can't handle (encrypted entries, unknown compression methods, stored
+ * entries without a known size, the worker falling too far behind) just stops it, and whatever wasn't extracted
+ * yet has to come from the complete archive.
+ */
+class StreamingUnzip {
+   public:
+    struct Entry {
+        quint32 crc32 = 0;
+        qint64 size = 0;
+    };
+
+    explicit StreamingUnzip(QString outputDir);
+    ~StreamingUnzip();
+
+    /** The transfer starts over: forget everything that was fed so far. */
+    void restart();
+    /** Hand over the next bytes of the archive. Never blocks on the worker. */
+    void feed(const QByteArray& data);
+    /** Stop taking data, e.g. because the download failed or was cancelled. */
+    void stop();
+
+    /**
+     * Wait for the worker to process what it was fed, and return the entries it extracted, by their name in the
+     * archive. Files are at outputDir() + '/' + name.
+     */
+    QHash<QString, Entry> entries();
+
+    QString outputDir() const { return m_outputDir; }
+
+    /** A validator for Net requests that feeds the downloaded bytes into \p unzip. */
+    static Net::Validator* makeValidator(std::shared_ptr<StreamingUnzip> unzip);
+
+   private:
+    void run();
+
+   private:
+    QString m_outputDir;
+
+    QMutex m_lock;
+    QWaitCondition m_wake;
+    QQueue<QByteArray> m_queue;
+    qint64 m_queuedBytes = 0;
+    int m_generation = 0;
+    bool m_stopped = false;
+    bool m_cancelled = false;
+    bool m_workerActive = false;
+    QHash<QString, Entry> m_entries;
+
+    QFuture<void> m_worker;
+};
@@ -22,22 +22,98 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QDebug>
+#include <QFile>
+
+#include <functional>
 
 #include "Application.h"
+#include "FileSystem.h"
 #include "net/ApiDownload.h"
+#include "net/Validator.h"
+
+namespace {
+const char* CACHE_BASE = "general";
+const char* CACHE_PATH = "truckpack/pack_version.txt";
+
+// fails the download of a manifest that can't be read, so it never replaces the cached one
+class ManifestValidator : public Net::Validator {
+   public:
+    explicit ManifestValidator(std::function<bool(const QByteArray&)> parse) : m_parse(std::move(parse)) {}
+
+    bool init(QNetworkRequest&) override
+    {
+        m_data.clear();
+        return true;
+    }
+    bool write(QByteArray& data) override
+    {
+        m_data.append(data);
+        return true;
+    }
+    bool abort() override
+    {
+        m_data.clear();
+        return true;
+    }
+    bool validate(QNetworkReply&) override { return m_parse(m_data); }
+
+   private:
+    std::function<bool(const QByteArray&)> m_parse;
+    QByteArray m_data;
+};
+}  // namespace
 
 TruckPackVersionManager::TruckPackVersionManager(QObject* parent) : QObject(parent)
 {
-    m_downloadedData = std::make_shared<QByteArray>();
+    connect(&m_pollTimer, &QTimer::timeout, this, &TruckPackVersionManager::fetchVersionInfo);
+
+    // launch checks use whatever we knew last, until the server had a chance to answer
+    loadCachedVersionInfo();
+}
+
+bool TruckPackVersionManager::loadCachedVersionInfo()
+{
+    // stale or not, a manifest from the last session beats no manifest at all
+    QFile file(FS::PathCombine(APPLICATION->metacache()->getBasePath(CACHE_BASE), CACHE_PATH));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    if (!parseVersionJson(file.readAll()))
+        return false;
+
+    qDebug() << "TruckPackVersionManager: Loaded cached version info";
+    m_loaded = true;
+    emit versionInfoLoaded();
+    return true;
 }
 
 void TruckPackVersionManager::fetchVersionInfo()
 {
+    auto interval = APPLICATION->settings()->get("TruckPackManifestPollInterval").toInt();
+    if (interval > 0)
+        m_pollTimer.start(interval * 60 * 1000);
+    else
+        m_pollTimer.stop();
+
+    if (m_downloadJob && m_downloadJob->isRunning())
+        return;
+
     qDebug() << "TruckPackVersionManager: Fetching truck pack version info from" << VERSION_URL;
 
+    m_cacheEntry = APPLICATION->metacache()->resolveEntry(CACHE_BASE, CACHE_PATH);
+    // always ask the server; it answers with 304 Not Modified when our copy is still current
+    m_cacheEntry->setStale(true);
+
     m_downloadJob.reset(new NetJob("TruckPackVersionFetch", APPLICATION->network()));
-    auto download = Net::ApiDownload::makeByteArray(QUrl(VERSION_URL), m_downloadedData);
-    m_downloadJob->addNetAction(download);
+    m_downloadJob->setAskRetry(false);
+    auto dl = Net::ApiDownload::makeCached(QUrl(VERSION_URL), m_cacheEntry);
+    // only runs for a new body, a 304 keeps the version info that is already loaded
+    dl->addValidator(new ManifestValidator([this](const QByteArray& data) {
+        if (!parseVersionJson(data))
+            return false;
+        m_loaded = true;
+        return true;
+    }));
+    m_downloadJob->addNetAction(dl);
 
     connect(m_downloadJob.get(), &NetJob::succeeded, this, &TruckPackVersionManager::onDownloadSucceeded);
     connect(m_downloadJob.get(), &NetJob::failed, this, &TruckPackVersionManager::onDownloadFailed);
@@ -48,31 +124,35 @@ void TruckPackVersionManager::fetchVersionInfo()
 void TruckPackVersionManager::onDownloadSucceeded()
 {
     qDebug() << "TruckPackVersionManager: Download succeeded";
-    parseVersionJson(*m_downloadedData);
-    m_loaded = true;
+    // the cached copy was current, but couldn't be read when we started
+    if (!m_loaded) {
+        if (!loadCachedVersionInfo())
+            onDownloadFailed(tr("The truck pack version info is invalid"));
+        return;
+    }
     emit versionInfoLoaded();
 }
 
 void TruckPackVersionManager::onDownloadFailed(QString reason)
 {
+    // the cached version info, if any, stays in use
     qWarning() << "TruckPackVersionManager: Failed to download version info:" << reason;
-    m_loaded = false;
     emit versionInfoFailed(reason);
 }
 
-void TruckPackVersionManager::parseVersionJson(const QByteArray& data)
+bool TruckPackVersionManager::parseVersionJson(const QByteArray& data)
 {
     QJsonParseError parseError;
     QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
 
     if (parseError.error != QJsonParseError::NoError) {
         qWarning() << "TruckPackVersionManager: JSON parse error:" << parseError.errorString();
-        return;
+        return false;
     }
 
     if (!doc.isObject()) {
         qWarning() << "TruckPackVersionManager: JSON root is not an object";
-        return;
+        return false;
     }
 
     QJsonObject root = doc.object();
@@ -104,6 +184,7 @@ void TruckPackVersionManager::parseVersionJson(const QByteArray& data)
     }
 
     qDebug() << "TruckPackVersionManager: Loaded" << m_packVersions.size() << "truck packs";
+    return true;
 }
 
 bool TruckPackVersionManager::isPackOutdated(const QString& instanceName, const QString& currentVersion) const
@@ -23,8 +23,10 @@
 #include <QMap>
 #include <QList>
 #include <QJsonObject>
+#include <QTimer>
 #include <memory>
 
+#include "net/HttpMetaCache.h"
 #include "net/NetJob.h"
 
 struct TruckPackInfo {
@@ -41,7 +43,10 @@ class TruckPackVersionManager : public QObject {
     explicit TruckPackVersionManager(QObject* parent = nullptr);
     ~TruckPackVersionManager() = default;
 
-    // Fetch the latest version information from the server
+    // Load the version information saved by the last fetch, if there is any
+    bool loadCachedVersionInfo();
+
+    // Revalidate the version information with the server, and keep doing so every "TruckPackManifestPollInterval" minutes
     void fetchVersionInfo();
 
     // Check if an instance has an outdated truck pack
@@ -71,12 +76,13 @@ class TruckPackVersionManager : public QObject {
     void onDownloadFailed(QString reason);
 
    private:
-    void parseVersionJson(const QByteArray& data);
+    bool parseVersionJson(const QByteArray& data);
 
     QMap<QString, TruckPackInfo> m_packVersions;
     QString m_defaultPackName;
     NetJob::Ptr m_downloadJob;
-    std::shared_ptr<QByteArray> m_downloadedData;
+    MetaEntryPtr m_cacheEntry;
+    QTimer m_pollTimer;
     bool m_loaded = false;
 
     static constexpr const char* VERSION_URL = "https://philoop.net/mc/pack_version.txt";
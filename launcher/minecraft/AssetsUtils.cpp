@@ -309,6 +309,8 @@ QString AssetObject::getRelPath()
 NetJob::Ptr AssetsIndex::getDownloadJob()
 {
     auto job = makeShared<NetJob>(QObject::tr("Assets for %1").arg(id), APPLICATION->network());
+    // only ever needed to launch the game
+    job->setPriority(Net::Priority::Launch);
     for (auto& object : objects.values()) {
         auto dl = object.getDownloadAction();
         if (dl) {
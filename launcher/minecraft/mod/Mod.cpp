@@ -241,9 +241,6 @@ void Mod::finishResolvingWithDetails(ModDetails&& details)
     m_local_details = std::move(details);
     if (metadata)
         setMetadata(std::move(metadata));
-    if (!iconPath().isEmpty()) {
-        m_packImageCacheKey.wasReadAttempt = false;
-    }
 }
 
 auto Mod::provider() const -> std::optional<QString>
@@ -306,10 +303,21 @@ QPixmap Mod::setIcon(QImage new_image) const
 
     m_packImageCacheKey.key = PixmapCache::insert(pixmap);
     m_packImageCacheKey.wasEverUsed = true;
-    m_packImageCacheKey.wasReadAttempt = true;
     return pixmap;
 }
 
+QImage Mod::iconThumbnail() const
+{
+    QMutexLocker locker(&m_data_lock);
+    return m_icon_thumbnail;
+}
+
+void Mod::setIconThumbnail(QImage thumbnail)
+{
+    QMutexLocker locker(&m_data_lock);
+    m_icon_thumbnail = std::move(thumbnail);
+}
+
 QPixmap Mod::icon(QSize size, Qt::AspectRatioMode mode) const
 {
     auto pixmap_transform = [&size, &mode](QPixmap pixmap) {
@@ -323,21 +331,17 @@ QPixmap Mod::icon(QSize size, Qt::AspectRatioMode mode) const
         return pixmap_transform(cached_image);
     }
 
-    // No valid image we can get
-    if ((!m_packImageCacheKey.wasEverUsed && m_packImageCacheKey.wasReadAttempt) || iconPath().isEmpty())
+    // No valid image we can get.
+    // The parse task reads the icon along with the rest of the mod, drawing the list never opens the mod file.
+    auto thumbnail = iconThumbnail();
+    if (thumbnail.isNull())
         return {};
 
     if (m_packImageCacheKey.wasEverUsed) {
         qDebug() << "Mod" << name() << "Had it's icon evicted from the cache. reloading...";
         PixmapCache::markCacheMissByEviciton();
     }
-    // Image got evicted from the cache or an attempt to load it has not been made. load it and retry.
-    m_packImageCacheKey.wasReadAttempt = true;
-    if (ModUtils::loadIconFile(*this, &cached_image)) {
-        return pixmap_transform(cached_image);
-    }
-    // Image failed to load
-    return {};
+    return pixmap_transform(setIcon(thumbnail));
 }
 
 bool Mod::valid() const
@@ -83,6 +83,10 @@ class Mod : public Resource {
     [[nodiscard]] QPixmap icon(QSize size, Qt::AspectRatioMode mode = Qt::AspectRatioMode::IgnoreAspectRatio) const;
     /** Thread-safe. */
     QPixmap setIcon(QImage new_image) const;
+    /** The icon as it was read by the parse task or kept in the ModDetailsCache, if any. Thread-safe. */
+    QImage iconThumbnail() const;
+    /** Thread-safe, and doesn't need the GUI thread either. */
+    void setIconThumbnail(QImage thumbnail);
 
     auto metadata() -> std::shared_ptr<Metadata::ModStruct>;
     auto metadata() const -> const std::shared_ptr<Metadata::ModStruct>;
@@ -108,10 +112,10 @@ class Mod : public Resource {
     ModDetails m_local_details;
 
     mutable QMutex m_data_lock;
+    QImage m_icon_thumbnail;
 
     struct {
         QPixmapCache::Key key;
         bool wasEverUsed = false;
-        bool wasReadAttempt = false;
     } mutable m_packImageCacheKey;
 };
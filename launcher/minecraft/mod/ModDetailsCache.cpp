@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ModDetailsCache.h"
+
+#include <QDataStream>
+
+#include "BuildConfig.h"
+
+namespace {
+constexpr quint32 IndexMagic = 0x4D444358;  // "MDCX"
+
+void writeDetails(QDataStream& out, const ModDetails& details)
+{
+    out << details.mod_id << details.name << details.version << details.mcversion << details.homeurl << details.description
+        << details.authors << details.issue_tracker << details.icon_file;
+    out << quint32(details.licenses.size());
+    for (auto& license : details.licenses)
+        out << license.name << license.id << license.url << license.description;
+}
+
+void readDetails(QDataStream& in, ModDetails& details)
+{
+    in >> details.mod_id >> details.name >> details.version >> details.mcversion >> details.homeurl >> details.description >>
+        details.authors >> details.issue_tracker >> details.icon_file;
+    quint32 licenses = 0;
+    in >> licenses;
+    for (quint32 i = 0; i < licenses && in.status() == QDataStream::Ok; i++) {
+        ModLicense license;
+        in >> license.name >> license.id >> license.url >> license.description;
+        details.licenses.append(license);
+    }
+}
+}  // namespace
+
+ModDetailsCache::ModDetailsCache(QString indexFile)
+    : StampedFileCache(std::move(indexFile), Keying::FileName, IndexMagic, "1/" + BuildConfig.printableVersionString())
+{}
+
+std::optional<ModDetailsCache::Entry> ModDetailsCache::lookup(const QFileInfo& file)
+{
+    auto payload = lookupPayload(file);
+    if (!payload)
+        return {};
+
+    Entry entry;
+    QDataStream in(*payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    readDetails(in, entry.details);
+    in >> entry.icon;
+    if (in.status() != QDataStream::Ok)
+        return {};  // damaged, parse the mod again
+    return entry;
+}
+
+void ModDetailsCache::store(const QFileInfo& file, const ModDetails& details, const QImage& icon)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    // only what the parse tasks found out, the metadata always comes from the mod's index file
+    writeDetails(out, details);
+    out << icon;
+    storePayload(file, payload);
+}
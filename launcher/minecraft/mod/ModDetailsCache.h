@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFileInfo>
+#include <QImage>
+
+#include <optional>
+
+#include "ModDetails.h"
+#include "StampedFileCache.h"
+
+/**
+ * Remembers what the parse tasks found out about the mods of one folder, so unchanged mods don't have to be parsed again.
+ *
+ * Besides the ModDetails, every entry keeps the icon thumbnail of the mod. The cache is dropped by other builds of the
+ * launcher, which may read mods differently. Parse tasks look up and store entries from their worker threads.
+ */
+class ModDetailsCache : public StampedFileCache {
+    Q_OBJECT
+   public:
+    struct Entry {
+        ModDetails details;
+        QImage icon;
+    };
+
+    explicit ModDetailsCache(QString indexFile);
+
+    std::optional<Entry> lookup(const QFileInfo& file);
+    void store(const QFileInfo& file, const ModDetails& details, const QImage& icon);
+};
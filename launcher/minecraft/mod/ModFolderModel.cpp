@@ -50,6 +50,7 @@
 #include <QUuid>
 
 #include "Application.h"
+#include "BaseInstance.h"
 
 #include "Json.h"
 #include "minecraft/mod/MetadataHandler.h"
@@ -76,6 +77,9 @@ ModFolderModel::ModFolderModel(const QString& dir, BaseInstance* instance, bool
                               QHeaderView::Interactive, QHeaderView::Interactive, QHeaderView::Interactive };
     m_columnsHideable = { false, true, false, true, true, true, true, true, true, true, true };
     m_columnsHiddenByDefault = { false, false, false, false, false, false, false, true, true, true, true };
+
+    if (instance)
+        m_details_cache = std::make_shared<ModDetailsCache>(FS::PathCombine(instance->instanceRoot(), m_dir.dirName() + ".cache"));
 }
 
 QVariant ModFolderModel::data(const QModelIndex& index, int role) const
@@ -238,7 +242,9 @@ int ModFolderModel::columnCount(const QModelIndex& parent) const
 Task* ModFolderModel::createUpdateTask()
 {
     auto index_dir = indexDir();
-    auto task = new ModFolderLoadTask(dir(), index_dir, m_is_indexed, m_first_folder_load);
+    auto task = new ModFolderLoadTask(dir(), index_dir, m_is_indexed, m_first_folder_load, m_details_cache);
+    task->setPreviousSnapshots(m_snapshot, m_index_snapshot);
+    task->setMetadataCache(m_metadata_cache);
     m_first_folder_load = false;
     return task;
 }
@@ -358,6 +364,9 @@ void ModFolderModel::onUpdateSucceeded()
     QSet<QString> current_set(m_resources_index.keys().toSet());
     QSet<QString> new_set(new_mods.keys().toSet());
 #endif
+    new_set.unite(QSet<QString>(update_results->unchanged).intersect(current_set));
+    m_snapshot = update_results->snapshot;
+    m_index_snapshot = update_results->index_snapshot;
 
     applyUpdates(current_set, new_set, new_mods);
 }
@@ -368,8 +377,6 @@ void ModFolderModel::onParseSucceeded(int ticket, QString mod_id)
     if (iter == m_active_parse_tasks.constEnd())
         return;
 
-    int row = m_resources_index[mod_id];
-
     auto parse_task = *iter;
     auto cast_task = static_cast<LocalModParseTask*>(parse_task.get());
 
@@ -378,10 +385,12 @@ void ModFolderModel::onParseSucceeded(int ticket, QString mod_id)
     auto resource = find(mod_id);
 
     auto result = cast_task->result();
-    if (result && resource)
+    if (result && resource) {
         resource->finishResolvingWithDetails(std::move(result->details));
-
-    emit dataChanged(index(row), index(row, columnCount(QModelIndex()) - 1));
+        resource->setIconThumbnail(result->icon);
+        if (m_details_cache && resource->type() != ResourceType::FOLDER)
+            m_details_cache->store(resource->fileinfo(), resource->details(), result->icon);
+    }
 }
 
 static const FlameAPI flameAPI;
@@ -45,6 +45,7 @@
 #include <QString>
 
 #include "Mod.h"
+#include "ModDetailsCache.h"
 #include "ResourceFolderModel.h"
 
 #include "minecraft/mod/tasks/LocalModParseTask.h"
@@ -116,4 +117,8 @@ class ModFolderModel : public ResourceFolderModel {
    protected:
     bool m_is_indexed;
     bool m_first_folder_load = true;
+    /// kept in the instance folder, not in the mods folder itself, so it doesn't show up as a mod
+    std::shared_ptr<ModDetailsCache> m_details_cache;
+    FolderSnapshot m_index_snapshot;
+    std::shared_ptr<ModFolderLoadTask::MetadataCache> m_metadata_cache = std::make_shared<ModFolderLoadTask::MetadataCache>();
 };
@@ -9,6 +9,7 @@
 #include <QMenu>
 #include <QMimeData>
 #include <QStyle>
+#include <QThread>
 #include <QThreadPool>
 #include <QUrl>
 
@@ -23,6 +24,17 @@
 #include "tasks/Task.h"
 #include "ui/dialogs/CustomMessageBox.h"
 
+namespace {
+class LambdaRunnable : public QRunnable {
+   public:
+    explicit LambdaRunnable(std::function<void()> function) : m_function(std::move(function)) {}
+    void run() override { m_function(); }
+
+   private:
+    std::function<void()> m_function;
+};
+}  // namespace
+
 ResourceFolderModel::ResourceFolderModel(QDir dir, BaseInstance* instance, QObject* parent, bool create_dir)
     : QAbstractListModel(parent), m_dir(dir), m_instance(instance), m_watcher(this)
 {
@@ -34,14 +46,26 @@ ResourceFolderModel::ResourceFolderModel(QDir dir, BaseInstance* instance, QObje
     m_dir.setSorting(QDir::Name | QDir::IgnoreCase | QDir::LocaleAware);
 
     connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ResourceFolderModel::directoryChanged);
-    connect(&m_helper_thread_task, &ConcurrentTask::finished, this, [this] { m_helper_thread_task.clear(); });
+
+    // parsing is CPU bound, more workers than cores would only take turns
+    m_max_parse_workers = QThread::idealThreadCount();
     if (APPLICATION_DYN) {  // in tests the application macro doesn't work
-        m_helper_thread_task.setMaxConcurrent(APPLICATION->settings()->get("NumberOfConcurrentTasks").toInt());
+        m_max_parse_workers = std::min(m_max_parse_workers, APPLICATION->settings()->get("NumberOfConcurrentTasks").toInt());
     }
+    m_max_parse_workers = std::max(m_max_parse_workers, 1);
+
+    m_parse_delivery.setSingleShot(true);
+    m_parse_delivery.setInterval(50);
+    connect(&m_parse_delivery, &QTimer::timeout, this, &ResourceFolderModel::deliverParseResults);
 }
 
 ResourceFolderModel::~ResourceFolderModel()
 {
+    {
+        QMutexLocker locker(&m_parse_lock);
+        m_parse_stopped = true;
+        m_parse_queue.clear();
+    }
     while (!QThreadPool::globalInstance()->waitForDone(100))
         QCoreApplication::processEvents();
 }
@@ -275,26 +299,127 @@ void ResourceFolderModel::resolveResource(Resource::Ptr res)
 
     res->setResolving(true, ticket);
     m_active_parse_tasks.insert(ticket, task);
+    m_parse_backlog.append({ ticket, res->internal_id(), task, res });
 
-    connect(
-        task.get(), &Task::succeeded, this, [this, ticket, res] { onParseSucceeded(ticket, res->internal_id()); },
-        Qt::ConnectionType::QueuedConnection);
-    connect(
-        task.get(), &Task::failed, this, [this, ticket, res] { onParseFailed(ticket, res->internal_id()); },
-        Qt::ConnectionType::QueuedConnection);
-    connect(
-        task.get(), &Task::finished, this,
-        [this, ticket] {
-            m_active_parse_tasks.remove(ticket);
-            emit parseFinished();
-        },
-        Qt::ConnectionType::QueuedConnection);
+    // wait for the rest of an update to come in, so the views get a chance to prioritize before the first chunks go out
+    if (!m_parse_scheduled) {
+        m_parse_scheduled = true;
+        QMetaObject::invokeMethod(this, &ResourceFolderModel::scheduleParsing, Qt::QueuedConnection);
+    }
+}
 
-    m_helper_thread_task.addTask(task);
+void ResourceFolderModel::prioritizeParsing(const QModelIndexList& indexes)
+{
+    // go through them backwards, so they end up in the order they were given in
+    for (auto it = indexes.crbegin(); it != indexes.crend(); ++it) {
+        if (!validateIndex(*it))
+            continue;
+        auto const& resource = m_resources.at(it->row());
+        if (!resource->isResolving())
+            continue;
+        auto ticket = resource->resolutionTicket();
+        auto job = std::find_if(m_parse_backlog.begin(), m_parse_backlog.end(), [ticket](const ParseJob& j) { return j.ticket == ticket; });
+        if (job != m_parse_backlog.end())
+            m_parse_backlog.move(static_cast<int>(job - m_parse_backlog.begin()), 0);
+    }
+}
 
-    if (!m_helper_thread_task.isRunning()) {
-        QThreadPool::globalInstance()->start(&m_helper_thread_task);
+void ResourceFolderModel::scheduleParsing()
+{
+    m_parse_scheduled = false;
+
+    QMutexLocker locker(&m_parse_lock);
+    if (m_parse_stopped)
+        return;
+
+    // keep the queue short, so whatever gets prioritized later doesn't wait behind everything else
+    auto const max_queued = m_max_parse_workers * ParseChunkSize * 2;
+    while (m_parse_queue.size() < max_queued && !m_parse_backlog.isEmpty()) {
+        auto job = m_parse_backlog.takeFirst();
+        if (job.task->getState() == Task::State::AbortedByUser) {
+            m_active_parse_tasks.remove(job.ticket);
+            continue;
+        }
+        m_parse_queue.enqueue(job);
     }
+
+    auto wanted_workers = std::min<qsizetype>(m_max_parse_workers, (m_parse_queue.size() + ParseChunkSize - 1) / ParseChunkSize);
+    for (; m_parse_workers < wanted_workers; m_parse_workers++)
+        QThreadPool::globalInstance()->start(new LambdaRunnable([this] { runParseWorker(); }));
+}
+
+void ResourceFolderModel::runParseWorker()
+{
+    // idle workers take the next chunk off the shared queue, so a few slow resources don't hold the others back
+    QList<ParseJob> chunk;
+    while (true) {
+        chunk.clear();
+        {
+            QMutexLocker locker(&m_parse_lock);
+            if (m_parse_queue.isEmpty()) {
+                m_parse_workers--;
+                return;
+            }
+            while (chunk.size() < ParseChunkSize && !m_parse_queue.isEmpty())
+                chunk.append(m_parse_queue.dequeue());
+        }
+
+        QList<ParseResult> results;
+        for (auto& job : chunk) {
+            job.task->start();
+            results.append({ job.ticket, job.resource_id, job.task->getState() });
+        }
+
+        QMutexLocker locker(&m_parse_lock);
+        m_parse_results.append(results);
+        if (!m_parse_delivery_requested && !m_parse_stopped) {
+            m_parse_delivery_requested = true;
+            QMetaObject::invokeMethod(this, [this] { m_parse_delivery.start(); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void ResourceFolderModel::deliverParseResults()
+{
+    QList<ParseResult> results;
+    {
+        QMutexLocker locker(&m_parse_lock);
+        if (m_parse_stopped)
+            return;
+        results.swap(m_parse_results);
+        m_parse_delivery_requested = false;
+    }
+
+    QStringList succeeded;
+    for (auto const& result : results) {
+        if (result.state == Task::State::Succeeded) {
+            onParseSucceeded(result.ticket, result.resource_id);
+            succeeded.append(result.resource_id);
+        } else if (result.state == Task::State::Failed) {
+            onParseFailed(result.ticket, result.resource_id);
+        }
+        m_active_parse_tasks.remove(result.ticket);
+    }
+
+    // one update per run of neighbouring rows, instead of one per resource
+    QList<int> rows;
+    for (auto const& resource_id : succeeded) {
+        auto row = m_resources_index.constFind(resource_id);
+        if (row != m_resources_index.constEnd())
+            rows.append(row.value());
+    }
+    std::sort(rows.begin(), rows.end());
+    for (int i = 0; i < rows.size();) {
+        int last = i;
+        while (last + 1 < rows.size() && rows[last + 1] <= rows[last] + 1)
+            last++;
+        emit dataChanged(index(rows[i], 0), index(rows[last], columnCount(QModelIndex()) - 1));
+        i = last + 1;
+    }
+
+    if (!results.isEmpty())
+        emit parseFinished();
+    scheduleParsing();
 }
 
 void ResourceFolderModel::onUpdateSucceeded()
@@ -313,23 +438,23 @@ void ResourceFolderModel::onUpdateSucceeded()
     QSet<QString> current_set(m_resources_index.keys().toSet());
     QSet<QString> new_set(new_resources.keys().toSet());
 #endif
+    // unchanged entries we don't have, like ones that failed to parse, stay out
+    new_set.unite(QSet<QString>(update_results->unchanged).intersect(current_set));
+    m_snapshot = update_results->snapshot;
 
     applyUpdates(current_set, new_set, new_resources);
 }
 
-void ResourceFolderModel::onParseSucceeded(int ticket, QString resource_id)
+void ResourceFolderModel::onParseSucceeded([[maybe_unused]] int ticket, [[maybe_unused]] QString resource_id)
 {
-    auto iter = m_active_parse_tasks.constFind(ticket);
-    if (iter == m_active_parse_tasks.constEnd() || !m_resources_index.contains(resource_id))
-        return;
-
-    int row = m_resources_index[resource_id];
-    emit dataChanged(index(row), index(row, columnCount(QModelIndex()) - 1));
+    // the resource parsed itself already, deliverParseResults() lets the views know
 }
 
 Task* ResourceFolderModel::createUpdateTask()
 {
-    return new BasicFolderLoadTask(m_dir);
+    auto task = new BasicFolderLoadTask(m_dir);
+    task->setPreviousSnapshot(m_snapshot);
+    return task;
 }
 
 bool ResourceFolderModel::hasPendingParseTasks() const
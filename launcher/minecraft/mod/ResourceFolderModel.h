@@ -6,11 +6,14 @@
 #include <QFileSystemWatcher>
 #include <QHeaderView>
 #include <QMutex>
+#include <QQueue>
 #include <QSet>
 #include <QSortFilterProxyModel>
+#include <QTimer>
 #include <QTreeView>
 
 #include "Resource.h"
+#include "minecraft/mod/tasks/FolderSnapshot.h"
 
 #include "BaseInstance.h"
 
@@ -75,9 +78,12 @@ class ResourceFolderModel : public QAbstractListModel {
     /** Creates a new update task and start it. Returns false if no update was done, like when an update is already underway. */
     virtual bool update();
 
-    /** Creates a new parse task, if needed, for 'res' and start it.*/
+    /** Creates a new parse task, if needed, for 'res' and queues it.*/
     virtual void resolveResource(Resource::Ptr res);
 
+    /** Moves the parse tasks of the given resources ahead of all others still waiting, like the rows currently on screen. */
+    void prioritizeParsing(const QModelIndexList& indexes);
+
     [[nodiscard]] qsizetype size() const { return m_resources.size(); }
     [[nodiscard]] bool empty() const { return size() == 0; }
     [[nodiscard]] Resource& at(int index) { return *m_resources.at(index); }
@@ -165,7 +171,7 @@ class ResourceFolderModel : public QAbstractListModel {
     /** Standard implementation of the model update logic.
      *
      *  It uses set operations to find differences between the current state and the updated state,
-     *  to act only on those disparities.
+     *  to act only on those disparities. IDs in 'new_set' without an entry in 'new_resources' are kept as they are.
      *
      *  The implementation is at the end of this header.
      */
@@ -188,6 +194,7 @@ class ResourceFolderModel : public QAbstractListModel {
      *
      *  This is just a simple reference implementation. You probably want to override it with your own logic in a subclass
      *  if the resource is complex and has more stuff to parse.
+     *  Results arrive in batches, and dataChanged() is emitted once for the whole batch afterwards.
      */
     virtual void onParseSucceeded(int ticket, QString resource_id);
     virtual void onParseFailed(int ticket, QString resource_id);
@@ -210,15 +217,52 @@ class ResourceFolderModel : public QAbstractListModel {
 
     Task::Ptr m_current_update_task = nullptr;
     bool m_scheduled_update = false;
+    // what the folder looked like at the last update, so the next one only has to load what changed since
+    FolderSnapshot m_snapshot;
 
     QList<Resource::Ptr> m_resources;
 
     // Represents the relationship between a resource's internal ID and it's row position on the model.
     QMap<QString, int> m_resources_index;
 
-    ConcurrentTask m_helper_thread_task;
     QMap<int, Task::Ptr> m_active_parse_tasks;
     std::atomic<int> m_next_resolution_ticket = 0;
+
+   private:
+    struct ParseJob {
+        int ticket;
+        QString resource_id;
+        Task::Ptr task;
+        Resource::Ptr resource;  // some parse tasks work on the resource itself, it has to outlive them
+    };
+    struct ParseResult {
+        int ticket;
+        QString resource_id;
+        Task::State state;
+    };
+
+    void scheduleParsing();
+    void runParseWorker();
+    void deliverParseResults();
+
+    // how many parse tasks a worker takes off the queue at once
+    static constexpr int ParseChunkSize = 8;
+
+    // parse tasks that weren't handed to the workers yet, most wanted first
+    QList<ParseJob> m_parse_backlog;
+    bool m_parse_scheduled = false;
+    int m_max_parse_workers = 1;
+
+    // shared with the workers, which run on the global thread pool
+    QMutex m_parse_lock;
+    QQueue<ParseJob> m_parse_queue;  // bounded, refilled from the backlog as results come in
+    QList<ParseResult> m_parse_results;
+    int m_parse_workers = 0;
+    bool m_parse_delivery_requested = false;
+    bool m_parse_stopped = false;
+
+    // collects results for a bit, so a big folder doesn't update the views once per resource
+    QTimer m_parse_delivery;
 };
 
 /* A macro to define useful functions to handle Resource* -> T* more easily on derived classes */
@@ -266,10 +310,16 @@ void ResourceFolderModel::applyUpdates(QSet<QString>& current_set, QSet<QString>
             Q_ASSERT(row_it != m_resources_index.constEnd());
             auto row = row_it.value();
 
-            auto& new_resource = new_resources[kept];
+            auto new_it = new_resources.find(kept);
+            if (new_it == new_resources.end()) {
+                // unchanged since the last update, nothing was loaded for it
+                continue;
+            }
+            auto& new_resource = new_it.value();
             auto const& current_resource = m_resources.at(row);
 
-            if (new_resource->dateTimeChanged() == current_resource->dateTimeChanged()) {
+            if (new_resource->dateTimeChanged() == current_resource->dateTimeChanged() &&
+                new_resource->fileinfo().size() == current_resource->fileinfo().size()) {
                 // no significant change, ignore...
                 continue;
             }
@@ -42,6 +42,7 @@
 #include <QStyle>
 
 #include "Application.h"
+#include "FileSystem.h"
 #include "Version.h"
 
 #include "minecraft/mod/Resource.h"
@@ -57,6 +58,16 @@ ResourcePackFolderModel::ResourcePackFolderModel(const QString& dir, BaseInstanc
                               QHeaderView::Interactive, QHeaderView::Interactive, QHeaderView::Interactive };
     m_columnsHideable = { false, true, false, true, true, true };
     m_columnsHiddenByDefault = { false, false, false, false, false, false };
+
+    if (instance) {
+        m_thumbnail_cache = std::make_shared<ThumbnailCache>(FS::PathCombine(instance->instanceRoot(), m_dir.dirName() + ".thumbs"));
+        connect(this, &ResourceFolderModel::updateFinished, this, [this] {
+            QStringList files;
+            for (auto& resource : m_resources)
+                files.append(resource->fileinfo().fileName());
+            m_thumbnail_cache->retain(files);
+        });
+    }
 }
 
 QVariant ResourcePackFolderModel::data(const QModelIndex& index, int role) const
@@ -187,10 +198,12 @@ int ResourcePackFolderModel::columnCount(const QModelIndex& parent) const
 
 Task* ResourcePackFolderModel::createUpdateTask()
 {
-    return new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<ResourcePack>(entry); });
+    auto task = new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<ResourcePack>(entry); });
+    task->setPreviousSnapshot(m_snapshot);
+    return task;
 }
 
 Task* ResourcePackFolderModel::createParseTask(Resource& resource)
 {
-    return new LocalResourcePackParseTask(m_next_resolution_ticket, static_cast<ResourcePack&>(resource));
+    return new LocalResourcePackParseTask(m_next_resolution_ticket, static_cast<ResourcePack&>(resource), m_thumbnail_cache);
 }
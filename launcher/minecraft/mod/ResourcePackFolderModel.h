@@ -3,6 +3,7 @@
 #include "ResourceFolderModel.h"
 
 #include "ResourcePack.h"
+#include "ThumbnailCache.h"
 
 class ResourcePackFolderModel : public ResourceFolderModel {
     Q_OBJECT
@@ -22,4 +23,8 @@ class ResourcePackFolderModel : public ResourceFolderModel {
     [[nodiscard]] Task* createParseTask(Resource&) override;
 
     RESOURCE_HELPERS(ResourcePack)
+
+   protected:
+    /// kept in the instance folder, not in the packs folder itself, so it doesn't show up as a pack
+    std::shared_ptr<ThumbnailCache> m_thumbnail_cache;
 };
@@ -15,7 +15,9 @@ class ShaderPackFolderModel : public ResourceFolderModel {
 
     [[nodiscard]] Task* createUpdateTask() override
     {
-        return new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<ShaderPack>(entry); });
+        auto task = new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<ShaderPack>(entry); });
+        task->setPreviousSnapshot(m_snapshot);
+        return task;
     }
 
     [[nodiscard]] Task* createParseTask(Resource& resource) override
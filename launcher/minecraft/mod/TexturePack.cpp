@@ -36,41 +36,63 @@ void TexturePack::setDescription(QString new_description)
 
 void TexturePack::setImage(QImage new_image) const
 {
-    QMutexLocker locker(&m_data_lock);
-
     Q_ASSERT(!new_image.isNull());
 
-    if (m_pack_image_cache_key.key.isValid())
-        PixmapCache::remove(m_pack_image_cache_key.key);
+    // scale the image to avoid flooding the pixmapcache, the pixmap itself is made once the image gets drawn
+    auto thumbnail = new_image.scaled({ 64, 64 }, Qt::AspectRatioMode::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
 
-    // scale the image to avoid flooding the pixmapcache
-    auto pixmap =
-        QPixmap::fromImage(new_image.scaled({ 64, 64 }, Qt::AspectRatioMode::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+    QPixmapCache::Key old_key;
+    {
+        QMutexLocker locker(&m_data_lock);
+        m_image_thumbnail = std::move(thumbnail);
+        old_key = m_pack_image_cache_key.key;
+        m_pack_image_cache_key.key = {};
+    }
+    // not under the lock, the cache blocks on the GUI thread, which may be waiting for the lock in image()
+    if (old_key.isValid())
+        PixmapCache::remove(old_key);
+}
 
-    m_pack_image_cache_key.key = PixmapCache::insert(pixmap);
-    m_pack_image_cache_key.was_ever_used = true;
+QImage TexturePack::imageThumbnail() const
+{
+    QMutexLocker locker(&m_data_lock);
+    return m_image_thumbnail;
 }
 
 QPixmap TexturePack::image(QSize size, Qt::AspectRatioMode mode) const
 {
-    QPixmap cached_image;
-    if (PixmapCache::find(m_pack_image_cache_key.key, &cached_image)) {
+    auto pixmap_transform = [&size, &mode](QPixmap pixmap) {
         if (size.isNull())
-            return cached_image;
-        return cached_image.scaled(size, mode, Qt::SmoothTransformation);
-    }
+            return pixmap;
+        return pixmap.scaled(size, mode, Qt::SmoothTransformation);
+    };
+
+    QPixmap cached_image;
+    if (PixmapCache::find(m_pack_image_cache_key.key, &cached_image))
+        return pixmap_transform(cached_image);
 
     // No valid image we can get
-    if (!m_pack_image_cache_key.was_ever_used) {
+    auto thumbnail = imageThumbnail();
+    if (thumbnail.isNull())
         return {};
-    } else {
+
+    if (m_pack_image_cache_key.was_ever_used) {
         qDebug() << "Texture Pack" << name() << "Had it's image evicted from the cache. reloading...";
         PixmapCache::markCacheMissByEviciton();
     }
 
-    // Imaged got evicted from the cache. Re-process it and retry.
-    TexturePackUtils::processPackPNG(*this);
-    return image(size);
+    // the thumbnail is all we need, there's no reason to open the pack again
+    cached_image = QPixmap::fromImage(thumbnail);
+    auto key = PixmapCache::insert(cached_image);
+    // This can happen if the pixmap is too big to fit in the cache :c
+    if (!key.isValid())
+        qWarning() << "Could not insert a image cache entry! Ignoring it.";
+    {
+        QMutexLocker locker(&m_data_lock);
+        m_pack_image_cache_key.key = key;
+        m_pack_image_cache_key.was_ever_used = true;
+    }
+    return pixmap_transform(cached_image);
 }
 
 bool TexturePack::valid() const
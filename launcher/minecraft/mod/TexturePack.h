@@ -47,6 +47,8 @@ class TexturePack : public Resource {
 
     /** Thread-safe. */
     void setImage(QImage new_image) const;
+    /** The image as set by the parse task, already scaled down. Null if the pack has none. Thread-safe. */
+    QImage imageThumbnail() const;
 
     bool valid() const override;
 
@@ -66,4 +68,8 @@ class TexturePack : public Resource {
         QPixmapCache::Key key;
         bool was_ever_used = false;
     } mutable m_pack_image_cache_key;
+
+    /** The scaled down image, turned into a QPixmap only once it gets drawn, and again whenever it gets evicted.
+     */
+    mutable QImage m_image_thumbnail;
 };
@@ -36,6 +36,7 @@
 #include <QCoreApplication>
 
 #include "Application.h"
+#include "FileSystem.h"
 
 #include "TexturePackFolderModel.h"
 
@@ -50,16 +51,28 @@ TexturePackFolderModel::TexturePackFolderModel(const QString& dir, BaseInstance*
     m_column_resize_modes = { QHeaderView::Interactive, QHeaderView::Interactive, QHeaderView::Stretch, QHeaderView::Interactive,
                               QHeaderView::Interactive };
     m_columnsHideable = { false, true, false, true, true };
+
+    if (instance) {
+        m_thumbnail_cache = std::make_shared<ThumbnailCache>(FS::PathCombine(instance->instanceRoot(), m_dir.dirName() + ".thumbs"));
+        connect(this, &ResourceFolderModel::updateFinished, this, [this] {
+            QStringList files;
+            for (auto& resource : m_resources)
+                files.append(resource->fileinfo().fileName());
+            m_thumbnail_cache->retain(files);
+        });
+    }
 }
 
 Task* TexturePackFolderModel::createUpdateTask()
 {
-    return new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<TexturePack>(entry); });
+    auto task = new BasicFolderLoadTask(m_dir, [](QFileInfo const& entry) { return makeShared<TexturePack>(entry); });
+    task->setPreviousSnapshot(m_snapshot);
+    return task;
 }
 
 Task* TexturePackFolderModel::createParseTask(Resource& resource)
 {
-    return new LocalTexturePackParseTask(m_next_resolution_ticket, static_cast<TexturePack&>(resource));
+    return new LocalTexturePackParseTask(m_next_resolution_ticket, static_cast<TexturePack&>(resource), m_thumbnail_cache);
 }
 
 QVariant TexturePackFolderModel::data(const QModelIndex& index, int role) const
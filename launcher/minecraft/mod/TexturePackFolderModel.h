@@ -39,6 +39,7 @@
 #include "ResourceFolderModel.h"
 
 #include "TexturePack.h"
+#include "ThumbnailCache.h"
 
 class TexturePackFolderModel : public ResourceFolderModel {
     Q_OBJECT
@@ -60,4 +61,8 @@ class TexturePackFolderModel : public ResourceFolderModel {
     [[nodiscard]] Task* createParseTask(Resource&) override;
 
     RESOURCE_HELPERS(TexturePack)
+
+   protected:
+    /// kept in the instance folder, not in the packs folder itself, so it doesn't show up as a pack
+    std::shared_ptr<ThumbnailCache> m_thumbnail_cache;
 };
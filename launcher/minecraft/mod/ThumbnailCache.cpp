@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ThumbnailCache.h"
+
+#include <QBuffer>
+
+namespace {
+constexpr quint32 CacheMagic = 0x54484D42;  // "THMB"
+}  // namespace
+
+ThumbnailCache::ThumbnailCache(QString cacheFile) : StampedFileCache(std::move(cacheFile), Keying::FileName, CacheMagic, "PNG") {}
+
+std::optional<QImage> ThumbnailCache::lookup(const QFileInfo& file)
+{
+    auto png = lookupPayload(file);
+    if (!png)
+        return {};
+    if (png->isEmpty())
+        return QImage();
+    auto image = QImage::fromData(*png, "PNG");
+    if (image.isNull())
+        return {};  // damaged, read the icon again
+    return image;
+}
+
+void ThumbnailCache::store(const QFileInfo& file, const QImage& thumbnail)
+{
+    QByteArray png;
+    if (!thumbnail.isNull()) {
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        if (!thumbnail.save(&buffer, "PNG"))
+            return;
+    }
+    storePayload(file, png);
+}
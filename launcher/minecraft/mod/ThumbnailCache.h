@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFileInfo>
+#include <QImage>
+
+#include <optional>
+
+#include "StampedFileCache.h"
+
+/**
+ * Keeps the icon thumbnails of the packs in one folder on disk, so showing the list doesn't mean reading and scaling
+ * every pack.png again each session.
+ *
+ * Thumbnails are kept as PNG and only decoded when they are looked up. A pack without an icon gets an entry as well,
+ * with a null image.
+ */
+class ThumbnailCache : public StampedFileCache {
+    Q_OBJECT
+   public:
+    explicit ThumbnailCache(QString cacheFile);
+
+    /** The thumbnail stored for this version of @file, which is a null image when the file has no icon. */
+    std::optional<QImage> lookup(const QFileInfo& file);
+    void store(const QFileInfo& file, const QImage& thumbnail);
+};
@@ -3,6 +3,7 @@
 #include <QDir>
 #include <QMap>
 #include <QObject>
+#include <QSet>
 #include <QThread>
 
 #include <memory>
@@ -10,6 +11,7 @@
 #include "Application.h"
 #include "FileSystem.h"
 #include "minecraft/mod/Resource.h"
+#include "minecraft/mod/tasks/FolderSnapshot.h"
 
 #include "tasks/Task.h"
 
@@ -19,7 +21,11 @@ class BasicFolderLoadTask : public Task {
     Q_OBJECT
    public:
     struct Result {
+        // only the resources that are new or changed since the previous snapshot
         QMap<QString, Resource::Ptr> resources;
+        // IDs of the resources that are still the same as in the previous snapshot
+        QSet<QString> unchanged;
+        FolderSnapshot snapshot;
     };
     using ResultPtr = std::shared_ptr<Result>;
 
@@ -34,6 +40,9 @@ class BasicFolderLoadTask : public Task {
         : Task(false), m_dir(dir), m_result(new Result), m_create_func(std::move(create_function)), m_thread_to_spawn_into(thread())
     {}
 
+    /** Entries that didn't change since 'snapshot' was taken end up in Result::unchanged instead of being loaded again. */
+    void setPreviousSnapshot(FolderSnapshot snapshot) { m_previous_snapshot = std::move(snapshot); }
+
     [[nodiscard]] bool canAbort() const override { return true; }
     bool abort() override
     {
@@ -57,6 +66,11 @@ class BasicFolderLoadTask : public Task {
                 FS::move(filePath, newFilePath);
                 entry = QFileInfo(newFilePath);
             }
+            m_result->snapshot.insert(entry);
+            if (m_previous_snapshot.unchanged(entry)) {
+                m_result->unchanged.insert(entry.fileName());
+                continue;
+            }
             auto resource = m_create_func(entry);
             resource->moveToThread(m_thread_to_spawn_into);
             m_result->resources.insert(resource->internal_id(), resource);
@@ -70,6 +84,7 @@ class BasicFolderLoadTask : public Task {
 
    private:
     QDir m_dir;
+    FolderSnapshot m_previous_snapshot;
     ResultPtr m_result;
 
     std::atomic<bool> m_aborted = false;
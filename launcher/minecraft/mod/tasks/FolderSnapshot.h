@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+/** The size and modification time of each entry of a folder, as of the last time it was loaded.
+ *
+ *  Load tasks compare against the snapshot of the previous load, so entries that didn't change
+ *  since are neither rebuilt nor replaced in the model.
+ */
+class FolderSnapshot {
+   public:
+    void insert(const QFileInfo& entry) { m_entries.insert(entry.fileName(), stampOf(entry)); }
+
+    /** Whether 'entry' is still the same as when the snapshot was taken. */
+    [[nodiscard]] bool unchanged(const QFileInfo& entry) const
+    {
+        auto it = m_entries.constFind(entry.fileName());
+        return it != m_entries.constEnd() && *it == stampOf(entry);
+    }
+
+    [[nodiscard]] bool isEmpty() const { return m_entries.isEmpty(); }
+    [[nodiscard]] qsizetype size() const { return m_entries.size(); }
+
+    bool operator==(const FolderSnapshot& other) const { return m_entries == other.m_entries; }
+    bool operator!=(const FolderSnapshot& other) const { return !(*this == other); }
+
+   private:
+    using Stamp = QPair<qint64, qint64>;
+
+    // the size of a folder means nothing, its modification time moves whenever entries are added to or removed from it
+    static Stamp stampOf(const QFileInfo& entry) { return { entry.isDir() ? 0 : entry.size(), entry.lastModified().toMSecsSinceEpoch() }; }
+
+    QHash<QString, Stamp> m_entries;
+};
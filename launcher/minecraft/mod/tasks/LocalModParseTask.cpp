@@ -16,6 +16,8 @@
 #include "minecraft/mod/ModDetails.h"
 #include "settings/INIFile.h"
 
+#include "ZipProbe.h"
+
 static QRegularExpression newlineRegex("\r\n|\n|\r");
 
 namespace ModUtils {
@@ -466,137 +468,103 @@ bool process(Mod& mod, ProcessingLevel level)
     }
 }
 
-bool processZIP(Mod& mod, [[maybe_unused]] ProcessingLevel level)
-{
-    ModDetails details;
-
-    QuaZip zip(mod.fileinfo().filePath());
-    if (!zip.open(QuaZip::mdUnzip))
-        return false;
-
-    QuaZipFile file(&zip);
-
-    if (zip.setCurrentFile("META-INF/mods.toml") || zip.setCurrentFile("META-INF/neoforge.mods.toml")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            zip.close();
-            return false;
-        }
+namespace {
+// the metadata files we know, in the order they are preferred in
+const QStringList metadataFiles = { "META-INF/mods.toml", "META-INF/neoforge.mods.toml", "mcmod.info",
+                                    "quilt.mod.json",     "fabric.mod.json",             "forgeversion.properties" };
 
-        details = ReadMCModTOML(file.readAll());
-        file.close();
-
-        // to replace ${file.jarVersion} with the actual version, as needed
-        if (details.version == "${file.jarVersion}") {
-            if (zip.setCurrentFile("META-INF/MANIFEST.MF")) {
-                if (!file.open(QIODevice::ReadOnly)) {
-                    zip.close();
-                    return false;
-                }
-
-                // quick and dirty line-by-line parser
-                auto manifestLines = QString(file.readAll()).split(newlineRegex);
-                QString manifestVersion = "";
-                for (auto& line : manifestLines) {
-                    if (line.startsWith("Implementation-Version: ", Qt::CaseInsensitive)) {
-                        manifestVersion = line.remove("Implementation-Version: ", Qt::CaseInsensitive);
-                        break;
-                    }
-                }
-
-                // some mods use ${projectversion} in their build.gradle, causing this mess to show up in MANIFEST.MF
-                // also keep with forge's behavior of setting the version to "NONE" if none is found
-                if (manifestVersion.contains("task ':jar' property 'archiveVersion'") || manifestVersion == "") {
-                    manifestVersion = "NONE";
-                }
-
-                details.version = manifestVersion;
-
-                file.close();
-            }
-        }
-
-        zip.close();
-        mod.setDetails(details);
+bool isNilMetadata(const QString& name)
+{
+    // nilmods can shade nilloader to be able to run as a standalone agent - which includes nilloader's own meta file
+    return name.endsWith(".nilmod.css") && name != "nilloader.nilmod.css";
+}
 
-        return true;
-    } else if (zip.setCurrentFile("mcmod.info")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            zip.close();
-            return false;
-        }
+bool isMetadata(const QString& name)
+{
+    return metadataFiles.contains(name) || name == "META-INF/MANIFEST.MF" || isNilMetadata(name);
+}
 
-        details = ReadMCModInfo(file.readAll());
-        file.close();
-        zip.close();
+/** Finds the metadata file that describes the mod, if any. */
+QString classify(const ZipProbe& zip)
+{
+    for (auto& name : metadataFiles) {
+        if (zip.contains(name))
+            return name;
+    }
+    // nilloader uses the filename of the metadata file for the modid, so we can't know the exact filename
+    // thankfully, there is a good file to use as a canary so we don't look for nil meta all the time
+    if (zip.contains("META-INF/nil/mappings.json"))
+        return zip.find(isNilMetadata);
+    return {};
+}
 
-        mod.setDetails(details);
-        return true;
-    } else if (zip.setCurrentFile("quilt.mod.json")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            zip.close();
-            return false;
+QString readManifestVersion(const QByteArray& manifest)
+{
+    // quick and dirty line-by-line parser
+    auto manifestLines = QString(manifest).split(newlineRegex);
+    QString manifestVersion = "";
+    for (auto& line : manifestLines) {
+        if (line.startsWith("Implementation-Version: ", Qt::CaseInsensitive)) {
+            manifestVersion = line.remove("Implementation-Version: ", Qt::CaseInsensitive);
+            break;
         }
+    }
 
-        details = ReadQuiltModInfo(file.readAll());
-        file.close();
-        zip.close();
-
-        mod.setDetails(details);
-        return true;
-    } else if (zip.setCurrentFile("fabric.mod.json")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            zip.close();
-            return false;
-        }
+    // some mods use ${projectversion} in their build.gradle, causing this mess to show up in MANIFEST.MF
+    // also keep with forge's behavior of setting the version to "NONE" if none is found
+    if (manifestVersion.contains("task ':jar' property 'archiveVersion'") || manifestVersion == "") {
+        manifestVersion = "NONE";
+    }
+    return manifestVersion;
+}
+}  // namespace
 
-        details = ReadFabricModInfo(file.readAll());
-        file.close();
-        zip.close();
+bool processZIP(Mod& mod, ProcessingLevel level)
+{
+    ZipProbe zip(mod.fileinfo().filePath());
+    if (!zip.open(isMetadata))
+        return false;
 
-        mod.setDetails(details);
-        return true;
-    } else if (zip.setCurrentFile("forgeversion.properties")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            zip.close();
-            return false;
-        }
+    auto metadataFile = classify(zip);
+    if (metadataFile.isEmpty())
+        return false;  // no valid mod found in archive
 
-        details = ReadForgeInfo(file.readAll());
-        file.close();
-        zip.close();
+    auto contents = zip.read(metadataFile);
+    if (!contents)
+        return false;
 
-        mod.setDetails(details);
-        return true;
-    } else if (zip.setCurrentFile("META-INF/nil/mappings.json")) {
-        // nilloader uses the filename of the metadata file for the modid, so we can't know the exact filename
-        // thankfully, there is a good file to use as a canary so we don't look for nil meta all the time
-
-        QString foundNilMeta;
-        for (auto& fname : zip.getFileNameList()) {
-            // nilmods can shade nilloader to be able to run as a standalone agent - which includes nilloader's own meta file
-            if (fname.endsWith(".nilmod.css") && fname != "nilloader.nilmod.css") {
-                foundNilMeta = fname;
-                break;
-            }
-        }
+    ModDetails details;
+    if (metadataFile.endsWith("mods.toml")) {
+        details = ReadMCModTOML(*contents);
 
-        if (zip.setCurrentFile(foundNilMeta)) {
-            if (!file.open(QIODevice::ReadOnly)) {
-                zip.close();
+        // to replace ${file.jarVersion} with the actual version, as needed
+        if (details.version == "${file.jarVersion}" && zip.contains("META-INF/MANIFEST.MF")) {
+            auto manifest = zip.read("META-INF/MANIFEST.MF");
+            if (!manifest)
                 return false;
-            }
-
-            details = ReadNilModInfo(file.readAll(), foundNilMeta);
-            file.close();
-            zip.close();
-
-            mod.setDetails(details);
-            return true;
+            details.version = readManifestVersion(*manifest);
         }
+    } else if (metadataFile == "mcmod.info") {
+        details = ReadMCModInfo(*contents);
+    } else if (metadataFile == "quilt.mod.json") {
+        details = ReadQuiltModInfo(*contents);
+    } else if (metadataFile == "fabric.mod.json") {
+        details = ReadFabricModInfo(*contents);
+    } else if (metadataFile == "forgeversion.properties") {
+        details = ReadForgeInfo(*contents);
+    } else {
+        details = ReadNilModInfo(*contents, metadataFile);
     }
+    mod.setDetails(details);
 
-    zip.close();
-    return false;  // no valid mod found in archive
+    // the archive is open and indexed already, so the icon comes cheap now
+    if (level == ProcessingLevel::Full && !mod.iconPath().isEmpty()) {
+        QImage icon;
+        if (auto data = zip.read(mod.iconPath()); data && decodeIcon(mod, *data, &icon))
+            mod.setIconThumbnail(icon);
+    }
+
+    return true;
 }
 
 bool processFolder(Mod& mod, [[maybe_unused]] ProcessingLevel level)
@@ -654,19 +622,19 @@ bool validate(QFileInfo file)
     return ModUtils::process(mod, ProcessingLevel::BasicInfoOnly) && mod.valid();
 }
 
-bool processIconPNG(const Mod& mod, QByteArray&& raw_data, QPixmap* pixmap)
+bool decodeIcon(const Mod& mod, const QByteArray& data, QImage* image)
 {
-    auto img = QImage::fromData(raw_data);
-    if (!img.isNull()) {
-        *pixmap = mod.setIcon(img);
-    } else {
-        qWarning() << "Failed to parse mod logo:" << mod.iconPath() << "from" << mod.name();
+    auto img = QImage::fromData(data);
+    if (img.isNull()) {
+        qWarning() << "Mod at" << mod.fileinfo().filePath() << "does not have a valid icon: invalid png image";
         return false;
     }
+    // the list never draws them any bigger, see Mod::setIcon()
+    *image = img.scaled({ 64, 64 }, Qt::AspectRatioMode::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
     return true;
 }
 
-bool loadIconFile(const Mod& mod, QPixmap* pixmap)
+bool readIconFile(const Mod& mod, QImage* image)
 {
     if (mod.iconPath().isEmpty()) {
         qWarning() << "No Iconfile set, be sure to parse the mod first";
@@ -678,53 +646,38 @@ bool loadIconFile(const Mod& mod, QPixmap* pixmap)
         return false;
     };
 
+    QByteArray data;
     switch (mod.type()) {
         case ResourceType::FOLDER: {
             QFileInfo icon_info(FS::PathCombine(mod.fileinfo().filePath(), mod.iconPath()));
-            if (icon_info.exists() && icon_info.isFile()) {
-                QFile icon(icon_info.filePath());
-                if (!icon.open(QIODevice::ReadOnly)) {
-                    return png_invalid("failed  to open file " + icon_info.filePath());
-                }
-                auto data = icon.readAll();
-
-                bool icon_result = ModUtils::processIconPNG(mod, std::move(data), pixmap);
+            if (!icon_info.exists() || !icon_info.isFile())
+                return png_invalid("file '" + icon_info.filePath() + "' does not exists or is not a file");
 
-                icon.close();
-
-                if (!icon_result) {
-                    return png_invalid("invalid png image");  // icon invalid
-                }
-                return true;
+            QFile icon(icon_info.filePath());
+            if (!icon.open(QIODevice::ReadOnly)) {
+                return png_invalid("failed  to open file " + icon_info.filePath());
             }
-            return png_invalid("file '" + icon_info.filePath() + "' does not exists or is not a file");
+            data = icon.readAll();
+            break;
         }
         case ResourceType::ZIPFILE: {
             QuaZip zip(mod.fileinfo().filePath());
             if (!zip.open(QuaZip::mdUnzip))
                 return png_invalid("failed to open '" + mod.fileinfo().filePath() + "' as a zip archive");
 
-            QuaZipFile file(&zip);
-
-            if (zip.setCurrentFile(mod.iconPath())) {
-                if (!file.open(QIODevice::ReadOnly)) {
-                    qCritical() << "Failed to open file in zip.";
-                    zip.close();
-                    return png_invalid("Failed to open '" + mod.iconPath() + "' in zip archive");
-                }
-
-                auto data = file.readAll();
-
-                bool icon_result = ModUtils::processIconPNG(mod, std::move(data), pixmap);
+            if (!zip.setCurrentFile(mod.iconPath()))
+                return png_invalid("Failed to set '" + mod.iconPath() +
+                                   "' as current file in zip archive");  // could not set icon as current file.
 
-                file.close();
-                if (!icon_result) {
-                    return png_invalid("invalid png image");  // icon png invalid
-                }
-                return true;
+            QuaZipFile file(&zip);
+            if (!file.open(QIODevice::ReadOnly)) {
+                qCritical() << "Failed to open file in zip.";
+                zip.close();
+                return png_invalid("Failed to open '" + mod.iconPath() + "' in zip archive");
             }
-            return png_invalid("Failed to set '" + mod.iconPath() +
-                               "' as current file in zip archive");  // could not set icon as current file.
+            data = file.readAll();
+            file.close();
+            break;
         }
         case ResourceType::LITEMOD: {
             return png_invalid("litemods do not have icons");  // can lightmods even have icons?
@@ -732,6 +685,8 @@ bool loadIconFile(const Mod& mod, QPixmap* pixmap)
         default:
             return png_invalid("Invalid type for mod, can not load icon.");
     }
+
+    return decodeIcon(mod, data, image);
 }
 
 }  // namespace ModUtils
@@ -752,6 +707,10 @@ void LocalModParseTask::executeTask()
     ModUtils::process(mod, ModUtils::ProcessingLevel::Full);
 
     m_result->details = mod.details();
+    // read the icon while we are at it, instead of opening the file again when the list draws it
+    m_result->icon = mod.iconThumbnail();
+    if (!m_aborted && m_result->icon.isNull() && mod.type() == ResourceType::FOLDER && !mod.iconPath().isEmpty())
+        ModUtils::readIconFile(mod, &m_result->icon);
 
     if (m_aborted)
         emitAborted();
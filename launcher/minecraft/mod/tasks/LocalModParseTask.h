@@ -26,8 +26,10 @@ bool processLitemod(Mod& mod, ProcessingLevel level = ProcessingLevel::Full);
 /** Checks whether a file is valid as a mod or not. */
 bool validate(QFileInfo file);
 
-bool processIconPNG(const Mod& mod, QByteArray&& raw_data, QPixmap* pixmap);
-bool loadIconFile(const Mod& mod, QPixmap* pixmap);
+/** Decodes icon data of a mod, scaled down to what the mod list shows. */
+bool decodeIcon(const Mod& mod, const QByteArray& data, QImage* image);
+/** Reads the icon of a parsed mod, scaled down to what the mod list shows. Safe to use outside the GUI thread. */
+bool readIconFile(const Mod& mod, QImage* image);
 }  // namespace ModUtils
 
 class LocalModParseTask : public Task {
@@ -35,6 +37,7 @@ class LocalModParseTask : public Task {
    public:
     struct Result {
         ModDetails details;
+        QImage icon;
     };
     using ResultPtr = std::shared_ptr<Result>;
     ResultPtr result() const { return m_result; }
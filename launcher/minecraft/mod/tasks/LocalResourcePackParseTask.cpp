@@ -22,9 +22,10 @@
 #include "Json.h"
 
 #include <quazip/quazip.h>
-#include <quazip/quazipdir.h>
 #include <quazip/quazipfile.h>
 
+#include "ZipProbe.h"
+
 #include <QCryptographicHash>
 
 namespace ResourcePackUtils {
@@ -108,43 +109,29 @@ bool processZIP(ResourcePack& pack, ProcessingLevel level)
 {
     Q_ASSERT(pack.type() == ResourceType::ZIPFILE);
 
-    QuaZip zip(pack.fileinfo().filePath());
-    if (!zip.open(QuaZip::mdUnzip))
+    ZipProbe zip(pack.fileinfo().filePath());
+    auto wanted = [level](const QString& name) {
+        return name == "pack.mcmeta" || (name == "pack.png" && level == ProcessingLevel::Full);
+    };
+    if (!zip.open(wanted))
         return false;  // can't open zip file
 
-    QuaZipFile file(&zip);
-
     auto mcmeta_invalid = [&pack]() {
         qWarning() << "Resource pack at" << pack.fileinfo().filePath() << "does not have a valid pack.mcmeta";
         return false;  // the mcmeta is not optional
     };
 
-    if (zip.setCurrentFile("pack.mcmeta")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            qCritical() << "Failed to open file in zip.";
-            zip.close();
-            return mcmeta_invalid();
-        }
-
-        auto data = file.readAll();
-
-        bool mcmeta_result = ResourcePackUtils::processMCMeta(pack, std::move(data));
-
-        file.close();
-        if (!mcmeta_result) {
-            return mcmeta_invalid();  // mcmeta invalid
-        }
-    } else {
-        return mcmeta_invalid();  // could not set pack.mcmeta as current file.
-    }
+    auto mcmeta = zip.read("pack.mcmeta");
+    if (!mcmeta)
+        return mcmeta_invalid();  // pack.mcmeta is missing or unreadable
+    if (!ResourcePackUtils::processMCMeta(pack, std::move(*mcmeta)))
+        return mcmeta_invalid();  // mcmeta invalid
 
-    QuaZipDir zipDir(&zip);
-    if (!zipDir.exists("/assets")) {
+    if (!zip.hasDirectory("assets")) {
         return false;  // assets dir does not exists at zip root
     }
 
     if (level == ProcessingLevel::BasicInfoOnly) {
-        zip.close();
         return true;  // only need basic info already checked
     }
 
@@ -153,28 +140,12 @@ bool processZIP(ResourcePack& pack, ProcessingLevel level)
         return true;  // the png is optional
     };
 
-    if (zip.setCurrentFile("pack.png")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            qCritical() << "Failed to open file in zip.";
-            zip.close();
-            return png_invalid();
-        }
-
-        auto data = file.readAll();
-
-        bool pack_png_result = ResourcePackUtils::processPackPNG(pack, std::move(data));
+    auto png = zip.read("pack.png");
+    if (!png)
+        return png_invalid();  // pack.png is missing or unreadable
+    if (!ResourcePackUtils::processPackPNG(pack, std::move(*png)))
+        return png_invalid();  // pack.png invalid
 
-        file.close();
-        zip.close();
-        if (!pack_png_result) {
-            return png_invalid();  // pack.png invalid
-        }
-    } else {
-        zip.close();
-        return png_invalid();  // could not set pack.mcmeta as current file.
-    }
-
-    zip.close();
     return true;
 }
 
@@ -358,7 +329,9 @@ bool validate(QFileInfo file)
 
 }  // namespace ResourcePackUtils
 
-LocalResourcePackParseTask::LocalResourcePackParseTask(int token, ResourcePack& rp) : Task(false), m_token(token), m_resource_pack(rp) {}
+LocalResourcePackParseTask::LocalResourcePackParseTask(int token, ResourcePack& rp, std::shared_ptr<ThumbnailCache> thumbnails)
+    : Task(false), m_token(token), m_resource_pack(rp), m_thumbnails(std::move(thumbnails))
+{}
 
 bool LocalResourcePackParseTask::abort()
 {
@@ -368,11 +341,24 @@ bool LocalResourcePackParseTask::abort()
 
 void LocalResourcePackParseTask::executeTask()
 {
-    if (!ResourcePackUtils::process(m_resource_pack)) {
+    // a thumbnail from an earlier session spares reading and scaling the pack.png again
+    std::optional<QImage> thumbnail;
+    if (m_thumbnails) {
+        m_thumbnails->load();
+        thumbnail = m_thumbnails->lookup(m_resource_pack.fileinfo());
+    }
+
+    auto level = thumbnail ? ResourcePackUtils::ProcessingLevel::BasicInfoOnly : ResourcePackUtils::ProcessingLevel::Full;
+    if (!ResourcePackUtils::process(m_resource_pack, level)) {
         emitFailed("this is not a resource pack");
         return;
     }
 
+    if (thumbnail && !thumbnail->isNull())
+        m_resource_pack.setImage(*thumbnail);
+    else if (!thumbnail && m_thumbnails)
+        m_thumbnails->store(m_resource_pack.fileinfo(), m_resource_pack.imageThumbnail());
+
     if (m_aborted)
         emitAborted();
     else
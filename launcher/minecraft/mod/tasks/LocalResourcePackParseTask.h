@@ -21,7 +21,10 @@
 #include <QDebug>
 #include <QObject>
 
+#include <memory>
+
 #include "minecraft/mod/ResourcePack.h"
+#include "minecraft/mod/ThumbnailCache.h"
 
 #include "tasks/Task.h"
 
@@ -48,7 +51,7 @@ bool validate(QFileInfo file);
 class LocalResourcePackParseTask : public Task {
     Q_OBJECT
    public:
-    LocalResourcePackParseTask(int token, ResourcePack& rp);
+    LocalResourcePackParseTask(int token, ResourcePack& rp, std::shared_ptr<ThumbnailCache> thumbnails = nullptr);
 
     [[nodiscard]] bool canAbort() const override { return true; }
     bool abort() override;
@@ -61,6 +64,7 @@ class LocalResourcePackParseTask : public Task {
     int m_token;
 
     ResourcePack& m_resource_pack;
+    std::shared_ptr<ThumbnailCache> m_thumbnails;
 
     bool m_aborted = false;
 };
@@ -24,6 +24,8 @@
 #include <quazip/quazip.h>
 #include <quazip/quazipfile.h>
 
+#include "ZipProbe.h"
+
 #include <QCryptographicHash>
 
 namespace TexturePackUtils {
@@ -91,54 +93,29 @@ bool processZIP(TexturePack& pack, ProcessingLevel level)
 {
     Q_ASSERT(pack.type() == ResourceType::ZIPFILE);
 
-    QuaZip zip(pack.fileinfo().filePath());
-    if (!zip.open(QuaZip::mdUnzip))
+    ZipProbe zip(pack.fileinfo().filePath());
+    auto wanted = [level](const QString& name) {
+        return name == "pack.txt" || (name == "pack.png" && level == ProcessingLevel::Full);
+    };
+    if (!zip.open(wanted))
         return false;
 
-    QuaZipFile file(&zip);
-
-    if (zip.setCurrentFile("pack.txt")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            qCritical() << "Failed to open file in zip.";
-            zip.close();
-            return false;
-        }
-
-        auto data = file.readAll();
-
-        bool packTXT_result = TexturePackUtils::processPackTXT(pack, std::move(data));
-
-        file.close();
-        if (!packTXT_result) {
+    if (zip.contains("pack.txt")) {
+        auto data = zip.read("pack.txt");
+        if (!data || !TexturePackUtils::processPackTXT(pack, std::move(*data)))
             return false;
-        }
     }
 
     if (level == ProcessingLevel::BasicInfoOnly) {
-        zip.close();
         return true;
     }
 
-    if (zip.setCurrentFile("pack.png")) {
-        if (!file.open(QIODevice::ReadOnly)) {
-            qCritical() << "Failed to open file in zip.";
-            zip.close();
+    if (zip.contains("pack.png")) {
+        auto data = zip.read("pack.png");
+        if (!data || !TexturePackUtils::processPackPNG(pack, std::move(*data)))
             return false;
-        }
-
-        auto data = file.readAll();
-
-        bool packPNG_result = TexturePackUtils::processPackPNG(pack, std::move(data));
-
-        file.close();
-        zip.close();
-        if (!packPNG_result) {
-            return false;
-        }
     }
 
-    zip.close();
-
     return true;
 }
 
@@ -230,7 +207,9 @@ bool validate(QFileInfo file)
 
 }  // namespace TexturePackUtils
 
-LocalTexturePackParseTask::LocalTexturePackParseTask(int token, TexturePack& rp) : Task(false), m_token(token), m_texture_pack(rp) {}
+LocalTexturePackParseTask::LocalTexturePackParseTask(int token, TexturePack& rp, std::shared_ptr<ThumbnailCache> thumbnails)
+    : Task(false), m_token(token), m_texture_pack(rp), m_thumbnails(std::move(thumbnails))
+{}
 
 bool LocalTexturePackParseTask::abort()
 {
@@ -240,11 +219,24 @@ bool LocalTexturePackParseTask::abort()
 
 void LocalTexturePackParseTask::executeTask()
 {
-    if (!TexturePackUtils::process(m_texture_pack)) {
+    // a thumbnail from an earlier session spares reading and scaling the pack.png again
+    std::optional<QImage> thumbnail;
+    if (m_thumbnails) {
+        m_thumbnails->load();
+        thumbnail = m_thumbnails->lookup(m_texture_pack.fileinfo());
+    }
+
+    auto level = thumbnail ? TexturePackUtils::ProcessingLevel::BasicInfoOnly : TexturePackUtils::ProcessingLevel::Full;
+    if (!TexturePackUtils::process(m_texture_pack, level)) {
         emitFailed("this is not a texture pack");
         return;
     }
 
+    if (thumbnail && !thumbnail->isNull())
+        m_texture_pack.setImage(*thumbnail);
+    else if (!thumbnail && m_thumbnails)
+        m_thumbnails->store(m_texture_pack.fileinfo(), m_texture_pack.imageThumbnail());
+
     if (m_aborted)
         emitAborted();
     else
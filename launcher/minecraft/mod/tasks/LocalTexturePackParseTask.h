@@ -22,7 +22,10 @@
 #include <QDebug>
 #include <QObject>
 
+#include <memory>
+
 #include "minecraft/mod/TexturePack.h"
+#include "minecraft/mod/ThumbnailCache.h"
 
 #include "tasks/Task.h"
 
@@ -48,7 +51,7 @@ bool validate(QFileInfo file);
 class LocalTexturePackParseTask : public Task {
     Q_OBJECT
    public:
-    LocalTexturePackParseTask(int token, TexturePack& rp);
+    LocalTexturePackParseTask(int token, TexturePack& rp, std::shared_ptr<ThumbnailCache> thumbnails = nullptr);
 
     [[nodiscard]] bool canAbort() const override { return true; }
     bool abort() override;
@@ -61,6 +64,7 @@ class LocalTexturePackParseTask : public Task {
     int m_token;
 
     TexturePack& m_texture_pack;
+    std::shared_ptr<ThumbnailCache> m_thumbnails;
 
     bool m_aborted = false;
 };
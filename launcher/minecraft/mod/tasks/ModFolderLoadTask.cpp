@@ -42,12 +42,17 @@
 
 #include <QThread>
 
-ModFolderLoadTask::ModFolderLoadTask(QDir mods_dir, QDir index_dir, bool is_indexed, bool clean_orphan)
+ModFolderLoadTask::ModFolderLoadTask(QDir mods_dir,
+                                     QDir index_dir,
+                                     bool is_indexed,
+                                     bool clean_orphan,
+                                     std::shared_ptr<ModDetailsCache> details_cache)
     : Task(false)
     , m_mods_dir(mods_dir)
     , m_index_dir(index_dir)
     , m_is_indexed(is_indexed)
     , m_clean_orphan(clean_orphan)
+    , m_details_cache(std::move(details_cache))
     , m_result(new Result())
     , m_thread_to_spawn_into(thread())
 {}
@@ -62,6 +67,10 @@ void ModFolderLoadTask::executeTask()
         getFromMetadata();
     }
 
+    // metadata can change what any mod looks like, so only an untouched index lets mods count as unchanged
+    bool index_unchanged = m_result->index_snapshot == m_previous_index_snapshot;
+    QStringList files, unchanged;
+
     // Read JAR files that don't have metadata
     m_mods_dir.refresh();
     for (auto entry : m_mods_dir.entryInfoList()) {
@@ -74,6 +83,12 @@ void ModFolderLoadTask::executeTask()
             FS::move(filePath, newFilePath);
             entry = QFileInfo(newFilePath);
         }
+        m_result->snapshot.insert(entry);
+        if (entry.isFile())
+            files.append(entry.fileName());
+        if (index_unchanged && m_previous_snapshot.unchanged(entry))
+            unchanged.append(entry.fileName());
+
         Mod* mod(new Mod(entry));
 
         if (mod->enabled()) {
@@ -117,6 +132,15 @@ void ModFolderLoadTask::executeTask()
         }
     }
 
+    // mods that didn't change are left to the model as they are, after they had their say in matching up with metadata above
+    for (auto const& id : unchanged) {
+        if (m_result->mods.remove(id))
+            m_result->unchanged.insert(id);
+    }
+
+    if (m_details_cache)
+        getFromCache(files);
+
     for (auto mod : m_result->mods)
         mod->moveToThread(m_thread_to_spawn_into);
 
@@ -129,8 +153,18 @@ void ModFolderLoadTask::executeTask()
 void ModFolderLoadTask::getFromMetadata()
 {
     m_index_dir.refresh();
-    for (auto entry : m_index_dir.entryList(QDir::Files)) {
-        auto metadata = Metadata::get(m_index_dir, entry);
+    for (auto const& entry_info : m_index_dir.entryInfoList(QDir::Files)) {
+        auto entry = entry_info.fileName();
+        m_result->index_snapshot.insert(entry_info);
+
+        Metadata::ModStruct metadata;
+        if (m_metadata_cache && m_previous_index_snapshot.unchanged(entry_info) && m_metadata_cache->contains(entry)) {
+            metadata = m_metadata_cache->value(entry);
+        } else {
+            metadata = Metadata::get(m_index_dir, entry);
+            if (m_metadata_cache)
+                m_metadata_cache->insert(entry, metadata);
+        }
 
         if (!metadata.isValid()) {
             continue;
@@ -141,3 +175,20 @@ void ModFolderLoadTask::getFromMetadata()
         m_result->mods[mod->internal_id()].reset(std::move(mod));
     }
 }
+
+void ModFolderLoadTask::getFromCache(const QStringList& files)
+{
+    m_details_cache->load();
+
+    for (auto mod : m_result->mods) {
+        if (mod->type() == ResourceType::FOLDER || !mod->fileinfo().isFile())
+            continue;
+
+        auto entry = m_details_cache->lookup(mod->fileinfo());
+        if (!entry)
+            continue;
+        mod->finishResolvingWithDetails(std::move(entry->details));
+        mod->setIconThumbnail(entry->icon);
+    }
+    m_details_cache->retain(files);
+}
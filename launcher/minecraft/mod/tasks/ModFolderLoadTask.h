@@ -37,24 +37,50 @@
 #pragma once
 
 #include <QDir>
+#include <QHash>
 #include <QMap>
 #include <QObject>
 #include <QRunnable>
+#include <QSet>
 #include <memory>
+#include "minecraft/mod/MetadataHandler.h"
 #include "minecraft/mod/Mod.h"
+#include "minecraft/mod/ModDetailsCache.h"
+#include "minecraft/mod/tasks/FolderSnapshot.h"
 #include "tasks/Task.h"
 
 class ModFolderLoadTask : public Task {
     Q_OBJECT
    public:
     struct Result {
+        // only the mods that are new or changed since the previous snapshots
         QMap<QString, Mod::Ptr> mods;
+        // IDs of the mods that are still the same as in the previous snapshots
+        QSet<QString> unchanged;
+        FolderSnapshot snapshot;
+        FolderSnapshot index_snapshot;
     };
+    using MetadataCache = QHash<QString, Metadata::ModStruct>;
     using ResultPtr = std::shared_ptr<Result>;
     ResultPtr result() const { return m_result; }
 
    public:
-    ModFolderLoadTask(QDir mods_dir, QDir index_dir, bool is_indexed, bool clean_orphan = false);
+    /** Mods that are in @details_cache come out resolved already, and don't need a parse task. */
+    ModFolderLoadTask(QDir mods_dir,
+                      QDir index_dir,
+                      bool is_indexed,
+                      bool clean_orphan = false,
+                      std::shared_ptr<ModDetailsCache> details_cache = nullptr);
+
+    /** Mods that didn't change since the snapshots were taken end up in Result::unchanged instead of being loaded again.
+     *  Any change to the index counts for all mods, since their metadata could have changed. */
+    void setPreviousSnapshots(FolderSnapshot snapshot, FolderSnapshot index_snapshot)
+    {
+        m_previous_snapshot = std::move(snapshot);
+        m_previous_index_snapshot = std::move(index_snapshot);
+    }
+    /** Keeps the parsed index files around between loads, so only the ones that changed are read again. */
+    void setMetadataCache(std::shared_ptr<MetadataCache> cache) { m_metadata_cache = std::move(cache); }
 
     [[nodiscard]] bool canAbort() const override { return true; }
     bool abort() override
@@ -67,11 +93,15 @@ class ModFolderLoadTask : public Task {
 
    private:
     void getFromMetadata();
+    void getFromCache(const QStringList& files);
 
    private:
     QDir m_mods_dir, m_index_dir;
     bool m_is_indexed;
     bool m_clean_orphan;
+    std::shared_ptr<ModDetailsCache> m_details_cache;
+    FolderSnapshot m_previous_snapshot, m_previous_index_snapshot;
+    std::shared_ptr<MetadataCache> m_metadata_cache;
     ResultPtr m_result;
 
     std::atomic<bool> m_aborted = false;
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ZipProbe.h"
+
+#include <quazip/quazipfile.h>
+
+#include <QDebug>
+
+ZipProbe::ZipProbe(const QString& path) : m_zip(path) {}
+
+bool ZipProbe::open(const Filter& prefetch)
+{
+    if (!m_zip.open(QuaZip::mdUnzip))
+        return false;
+
+    for (bool more = m_zip.goToFirstFile(); more; more = m_zip.goToNextFile()) {
+        QuaZipFileInfo64 info;
+        if (!m_zip.getCurrentFileInfo(&info) || info.name.isEmpty())
+            continue;
+
+        auto name = info.name;
+        auto slash = name.indexOf('/');
+        if (slash > 0)
+            m_directories.insert(name.left(slash));
+        if (name.endsWith('/'))
+            continue;
+
+        m_entries.insert(name);
+        m_names.append(name);
+
+        if (prefetch && info.uncompressedSize <= MaxPrefetchSize && prefetch(name)) {
+            QByteArray data;
+            if (readCurrent(&data))
+                m_prefetched.insert(name, data);
+        }
+    }
+
+    // QuaZip reports the end of the directory as success, anything else means we didn't get through it
+    if (m_zip.getZipError() != UNZ_OK) {
+        qWarning() << "Failed to read the central directory of" << m_zip.getZipName() << ":" << m_zip.getZipError();
+        m_zip.close();
+        return false;
+    }
+    return true;
+}
+
+void ZipProbe::close()
+{
+    if (m_zip.isOpen())
+        m_zip.close();
+    m_prefetched.clear();
+}
+
+QString ZipProbe::find(const Filter& filter) const
+{
+    for (auto& name : m_names) {
+        if (filter(name))
+            return name;
+    }
+    return {};
+}
+
+std::optional<QByteArray> ZipProbe::read(const QString& name)
+{
+    if (!m_entries.contains(name))
+        return {};
+    auto prefetched = m_prefetched.constFind(name);
+    if (prefetched != m_prefetched.constEnd())
+        return *prefetched;
+
+    // the walk in open() already taught QuaZip where everything is, so this doesn't scan the directory again
+    if (!m_zip.isOpen() || !m_zip.setCurrentFile(name))
+        return {};
+    QByteArray data;
+    if (!readCurrent(&data))
+        return {};
+    return data;
+}
+
+bool ZipProbe::readCurrent(QByteArray* data)
+{
+    QuaZipFile file(&m_zip);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open" << m_zip.getCurrentFileName() << "in" << m_zip.getZipName();
+        return false;
+    }
+    *data = file.readAll();
+    file.close();
+    return file.getZipError() == UNZ_OK;
+}
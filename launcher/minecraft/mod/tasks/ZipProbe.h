@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <quazip/quazip.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <optional>
+
+/**
+ * Looks into a zip archive for metadata files, walking its central directory only once.
+ *
+ * Every QuaZip::setCurrentFile() miss is a linear scan over the central directory, which adds up when probing
+ * a jar with tens of thousands of entries for half a dozen files that are mostly not there. open() walks the
+ * directory once into a name index, so lookups are hash hits, and reads the small entries the caller asks for
+ * on the way, so the usual metadata files never need another pass.
+ */
+class ZipProbe {
+   public:
+    using Filter = std::function<bool(const QString&)>;
+
+    explicit ZipProbe(const QString& path);
+
+    /** Opens and indexes the archive, keeping the contents of the entries that pass \p prefetch. */
+    bool open(const Filter& prefetch = nullptr);
+    void close();
+
+    bool contains(const QString& name) const { return m_entries.contains(name); }
+    /** Whether the archive has anything below the top-level directory \p dir. */
+    bool hasDirectory(const QString& dir) const { return m_directories.contains(dir); }
+    /** The first entry in archive order whose name passes \p filter, or an empty string. */
+    QString find(const Filter& filter) const;
+
+    /** The contents of an entry; std::nullopt if it doesn't exist or can't be read. */
+    std::optional<QByteArray> read(const QString& name);
+
+   private:
+    bool readCurrent(QByteArray* data);
+
+   private:
+    // entries bigger than this are read when asked for instead, metadata files are nowhere near it
+    static constexpr qint64 MaxPrefetchSize = 4 * 1024 * 1024;
+
+    QuaZip m_zip;
+    QStringList m_names;
+    QSet<QString> m_entries;
+    QSet<QString> m_directories;
+    QHash<QString, QByteArray> m_prefetched;
+};
@@ -21,6 +21,7 @@ void LibrariesTask::executeTask()
     auto profile = components->getProfile();
 
     NetJob::Ptr job{ new NetJob(tr("Libraries for instance %1").arg(inst->name()), APPLICATION->network()) };
+    job->setPriority(Net::Priority::Launch);
     downloadJob.reset(job);
 
     auto metacache = APPLICATION->metacache();
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <QHash>
 #include <QList>
 #include <memory>
+#include <optional>
 #include "modplatform/ModIndex.h"
 #include "modplatform/ResourceAPI.h"
 #include "modplatform/helpers/NetworkResourceAPI.h"
@@ -20,6 +22,55 @@ class FlameAPI : public NetworkResourceAPI {
                                                                 QList<ModPlatform::ModLoaderType> instanceLoaders,
                                                                 ModPlatform::ModLoaderTypes fallback);
 
+    /**
+     * Picks the newest of \p candidates for an instance: the loaders of the instance come first, then the \p fallback
+     * loaders, then candidates that don't name a loader.
+     * \p loadersOf lists the loaders of a candidate, \p isNewer tells whether one candidate is newer than another.
+     */
+    template <typename T, typename LoadersOf, typename IsNewer>
+    static std::optional<T> selectLatest(const QList<T>& candidates,
+                                         QList<ModPlatform::ModLoaderType> instanceLoaders,
+                                         ModPlatform::ModLoaderTypes fallback,
+                                         LoadersOf loadersOf,
+                                         IsNewer isNewer)
+    {
+        static const auto noLoader = ModPlatform::ModLoaderType(0);
+        QHash<ModPlatform::ModLoaderType, T> bestMatch;
+        auto checkCandidate = [&bestMatch, &isNewer](const T& candidate, ModPlatform::ModLoaderType loader) {
+            auto best = bestMatch.constFind(loader);
+            if (best == bestMatch.constEnd() || isNewer(candidate, *best))
+                bestMatch[loader] = candidate;
+        };
+        for (auto& candidate : candidates) {
+            auto loaders = loadersOf(candidate);
+            if (loaders.isEmpty()) {
+                checkCandidate(candidate, noLoader);
+            } else {
+                for (auto loader : loaders) {
+                    checkCandidate(candidate, loader);
+                }
+            }
+        }
+        // edge case: mod has installed for forge but the instance is fabric => fabric version will be prioritizated on update
+        auto currentLoaders = instanceLoaders + ModPlatform::modLoaderTypesToList(fallback);
+        currentLoaders.append(noLoader);  // add a fallback in case the versions do not define a loader
+
+        for (auto loader : currentLoaders) {
+            auto bestForLoader = bestMatch.constFind(loader);
+            if (bestForLoader == bestMatch.constEnd())
+                continue;
+            // awkward case where the mod has only two loaders and one of them is not specified
+            if (loader != noLoader && bestMatch.contains(noLoader) && bestMatch.size() == 2) {
+                auto bestForNoLoader = bestMatch.value(noLoader);
+                if (isNewer(bestForNoLoader, *bestForLoader)) {
+                    return bestForNoLoader;
+                }
+            }
+            return *bestForLoader;
+        }
+        return {};
+    }
+
     Task::Ptr getProjects(QStringList addonIds, std::shared_ptr<QByteArray> response) const override;
     Task::Ptr matchFingerprints(const QList<uint>& fingerprints, std::shared_ptr<QByteArray> response);
     Task::Ptr getFiles(const QStringList& fileIds, std::shared_ptr<QByteArray> response) const;
@@ -52,6 +103,7 @@ class FlameAPI : public NetworkResourceAPI {
         }
     }
 
+   public:
     static int getMappedModLoader(ModPlatform::ModLoaderType loaders)
     {
         // https://docs.curseforge.com/?http#tocS_ModLoaderType
@@ -72,6 +124,27 @@ class FlameAPI : public NetworkResourceAPI {
         return 0;
     }
 
+    /** The inverse of getMappedModLoader(), no loader for the IDs we don't know. */
+    static ModPlatform::ModLoaderType getModLoaderFromMapped(int loader)
+    {
+        switch (loader) {
+            case 1:
+                return ModPlatform::Forge;
+            case 2:
+                return ModPlatform::Cauldron;
+            case 3:
+                return ModPlatform::LiteLoader;
+            case 4:
+                return ModPlatform::Fabric;
+            case 5:
+                return ModPlatform::Quilt;
+            case 6:
+                return ModPlatform::NeoForge;
+        }
+        return ModPlatform::ModLoaderType(0);
+    }
+
+   private:
     static const QStringList getModLoaderStrings(const ModPlatform::ModLoaderTypes types)
     {
         QStringList l;
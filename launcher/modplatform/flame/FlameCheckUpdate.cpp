@@ -13,141 +13,303 @@
 #include "minecraft/mod/ModFolderModel.h"
 #include "minecraft/mod/tasks/GetModDependenciesTask.h"
 
+#include "modplatform/helpers/ExpiringCache.h"
 #include "net/ApiDownload.h"
+#include "tasks/ConcurrentTask.h"
 
 static FlameAPI api;
 
+// projects change with every file uploaded to them, files and their changelogs never do
+static ModPlatform::ExpiringCache<FlameCheckUpdate::ProjectInfo> s_projects(10 * 60);
+static ModPlatform::ExpiringCache<QList<ModPlatform::IndexedVersion>> s_version_lists(10 * 60);
+static ModPlatform::ExpiringCache<ModPlatform::IndexedVersion> s_files(60 * 60);
+static ModPlatform::ExpiringCache<QString> s_changelogs(60 * 60);
+
+namespace {
+std::optional<QJsonDocument> parseResponse(const QByteArray& response)
+{
+    QJsonParseError parse_error{};
+    QJsonDocument doc = QJsonDocument::fromJson(response, &parse_error);
+    if (parse_error.error != QJsonParseError::NoError) {
+        qWarning() << "Error while parsing JSON response from FlameCheckUpdate at " << parse_error.offset
+                   << " reason: " << parse_error.errorString();
+        qWarning() << response;
+        return {};
+    }
+    return doc;
+}
+}  // namespace
+
+FlameCheckUpdate::ProjectInfo FlameCheckUpdate::loadProjectInfo(QJsonObject obj)
+{
+    ModPlatform::IndexedPack pack;
+    FlameMod::loadIndexedPack(pack, obj);
+
+    ProjectInfo project;
+    project.project_id = pack.addonId.toString();
+    project.website_url = pack.websiteUrl;
+    for (auto file_value : Json::ensureArray(obj, "latestFilesIndexes")) {
+        auto file_obj = Json::ensureObject(file_value);
+        project.latest_files.append({ Json::ensureString(file_obj, "gameVersion"), Json::ensureInteger(file_obj, "fileId"),
+                                      FlameAPI::getModLoaderFromMapped(Json::ensureInteger(file_obj, "modLoader", 0)) });
+    }
+    return project;
+}
+
+std::optional<int> FlameCheckUpdate::latestFileId(const ProjectInfo& project,
+                                                  const QString& game_version,
+                                                  QList<ModPlatform::ModLoaderType> instance_loaders,
+                                                  ModPlatform::ModLoaderTypes mod_loaders)
+{
+    QList<LatestFile> files;
+    for (auto& file : project.latest_files) {
+        if (file.game_version == game_version)
+            files.append(file);
+    }
+    // file IDs only ever go up, so the highest one is the newest file
+    auto latest = FlameAPI::selectLatest(
+        files, instance_loaders, mod_loaders, [](const LatestFile& file) { return ModPlatform::modLoaderTypesToList(file.loader); },
+        [](const LatestFile& file, const LatestFile& other) { return file.file_id > other.file_id; });
+    if (!latest)
+        return {};
+    return latest->file_id;
+}
+
 bool FlameCheckUpdate::abort()
 {
     m_was_aborted = true;
-    if (m_net_job)
-        return m_net_job->abort();
+    if (m_job)
+        return m_job->abort();
     return true;
 }
 
-ModPlatform::IndexedPack FlameCheckUpdate::getProjectInfo(ModPlatform::IndexedVersion& ver_info)
+void FlameCheckUpdate::startJob(Task::Ptr job)
 {
-    ModPlatform::IndexedPack pack;
+    connect(job.get(), &Task::aborted, this, &FlameCheckUpdate::emitAborted);
+    m_job = job;
+    job->start();
+}
+
+QString FlameCheckUpdate::versionListKey(const QString& project_id) const
+{
+    return QString("%1@%2").arg(project_id, m_game_versions.empty() ? QString() : m_game_versions.front().toString());
+}
+
+/* Check for update:
+ * - Get the projects of all mods at once, they list their newest files
+ * - Get all the newest files at once, and compare their hashes with the current ones
+ * - If not equal, there's updates, so get their changelogs and add them to the list
+ * */
+void FlameCheckUpdate::executeTask()
+{
+    setStatus(tr("Preparing mods for CurseForge..."));
+    setProgress(0, 5);
 
-    QEventLoop loop;
+    getProjects();
+}
 
-    auto get_project_job = new NetJob("Flame::GetProjectJob", APPLICATION->network());
+void FlameCheckUpdate::getProjects()
+{
+    QStringList missing;
+    for (auto* mod : m_mods) {
+        auto project_id = mod->metadata()->project_id.toString();
+        if (m_projects.contains(project_id) || missing.contains(project_id))
+            continue;
+        if (auto project = s_projects.get(project_id))
+            m_projects.insert(project_id, *project);
+        else
+            missing.append(project_id);
+    }
+    if (missing.isEmpty()) {
+        selectLatestFiles();
+        return;
+    }
 
+    setStatus(tr("Getting API response from CurseForge for %n mod(s)...", "", missing.size()));
     auto response = std::make_shared<QByteArray>();
-    auto url = QString("https://api.curseforge.com/v1/mods/%1").arg(ver_info.addonId.toString());
-    auto dl = Net::ApiDownload::makeByteArray(url, response);
-    get_project_job->addNetAction(dl);
-
-    QObject::connect(get_project_job, &NetJob::succeeded, [response, &pack]() {
-        QJsonParseError parse_error{};
-        QJsonDocument doc = QJsonDocument::fromJson(*response, &parse_error);
-        if (parse_error.error != QJsonParseError::NoError) {
-            qWarning() << "Error while parsing JSON response from FlameCheckUpdate at " << parse_error.offset
-                       << " reason: " << parse_error.errorString();
-            qWarning() << *response;
+    auto job = api.getProjects(missing, response);
+    connect(job.get(), &Task::succeeded, this, [this, response] {
+        if (m_was_aborted)
+            return;
+        auto doc = parseResponse(*response);
+        if (!doc) {
+            emitFailed(tr("Could not read the response from CurseForge."));
             return;
         }
 
-        try {
-            auto doc_obj = Json::requireObject(doc);
-            auto data_obj = Json::requireObject(doc_obj, "data");
-            FlameMod::loadIndexedPack(pack, data_obj);
-        } catch (Json::JsonException& e) {
-            qWarning() << e.cause();
-            qDebug() << doc;
+        for (auto project_value : Json::ensureArray(doc->object(), "data")) {
+            auto project_obj = Json::ensureObject(project_value);
+            try {
+                auto project = loadProjectInfo(project_obj);
+                m_projects.insert(project.project_id, project);
+                s_projects.insert(project.project_id, project);
+            } catch (Json::JsonException& e) {
+                qWarning() << e.cause();
+                qDebug() << project_obj;
+            }
         }
+        selectLatestFiles();
     });
+    connect(job.get(), &Task::failed, this, &FlameCheckUpdate::emitFailed);
+    startJob(job);
+}
 
-    connect(get_project_job, &NetJob::failed, this, &FlameCheckUpdate::emitFailed);
-    QObject::connect(get_project_job, &NetJob::finished, [&loop, get_project_job] {
-        get_project_job->deleteLater();
-        loop.quit();
-    });
+void FlameCheckUpdate::selectLatestFiles()
+{
+    setProgress(1, 5);
 
-    get_project_job->start();
-    loop.exec();
+    auto game_version = m_game_versions.empty() ? QString() : m_game_versions.front().toString();
+    QList<ModPlatform::IndexedPack> to_list;
+    for (auto* mod : m_mods) {
+        auto project_id = mod->metadata()->project_id.toString();
+        if (auto project = m_projects.constFind(project_id); project != m_projects.constEnd()) {
+            if (auto file_id = latestFileId(*project, game_version, m_loaders_list, mod->loaders())) {
+                m_latest_files.insert(mod, QString::number(*file_id));
+                continue;
+            }
+        }
+
+        // nothing fitting among the newest files, so look through all files of the project
+        auto key = versionListKey(project_id);
+        if (m_version_lists.contains(key))
+            continue;
+        if (auto versions = s_version_lists.get(key)) {
+            m_version_lists.insert(key, *versions);
+            continue;
+        }
+        m_version_lists.insert(key, {});
+
+        ModPlatform::IndexedPack pack;
+        pack.addonId = mod->metadata()->project_id;
+        pack.name = mod->name();
+        to_list.append(pack);
+    }
 
-    return pack;
+    if (to_list.isEmpty())
+        getFiles();
+    else
+        getVersionLists(to_list);
 }
 
-ModPlatform::IndexedVersion FlameCheckUpdate::getFileInfo(int addonId, int fileId)
+void FlameCheckUpdate::getVersionLists(const QList<ModPlatform::IndexedPack>& projects)
 {
-    ModPlatform::IndexedVersion ver;
+    setStatus(tr("Getting the versions of %n mod(s) from CurseForge...", "", projects.size()));
+
+    auto job = makeShared<ConcurrentTask>("Flame::GetVersionLists", APPLICATION->settings()->get("NumberOfConcurrentTasks").toInt());
+    for (auto& pack : projects) {
+        ResourceAPI::VersionSearchCallbacks callbacks;
+        callbacks.on_succeed = [this](QJsonDocument& doc, ModPlatform::IndexedPack pack) {
+            QList<ModPlatform::IndexedVersion> versions;
+            try {
+                for (auto file_value : Json::requireArray(doc.object(), "data")) {
+                    auto file_obj = Json::requireObject(file_value);
+                    versions.append(FlameMod::loadIndexedPackVersion(file_obj));
+                }
+            } catch (Json::JsonException& e) {
+                qWarning() << e.cause();
+                return;
+            }
+            auto key = versionListKey(pack.addonId.toString());
+            m_version_lists.insert(key, versions);
+            s_version_lists.insert(key, versions);
+        };
+        // a mod without versions just isn't updated, same as when nothing fits
+        callbacks.on_fail = [pack](QString const& reason, int) {
+            qWarning() << "Could not get the versions of" << pack.name << "from CurseForge:" << reason;
+        };
+
+        if (auto task = api.getProjectVersions({ pack, m_game_versions }, std::move(callbacks)))
+            job->addTask(task);
+    }
 
-    QEventLoop loop;
+    connect(job.get(), &Task::finished, this, [this] {
+        if (!m_was_aborted)
+            getFiles();
+    });
+    startJob(job);
+}
+
+void FlameCheckUpdate::getFiles()
+{
+    setStatus(tr("Getting file information from CurseForge..."));
+    setProgress(2, 5);
 
-    auto get_file_info_job = new NetJob("Flame::GetFileInfoJob", APPLICATION->network());
+    QStringList missing;
+    auto want = [this, &missing](const QString& file_id) {
+        if (m_files.contains(file_id) || missing.contains(file_id))
+            return;
+        if (auto file = s_files.get(file_id))
+            m_files.insert(file_id, *file);
+        else
+            missing.append(file_id);
+    };
+
+    for (auto* mod : m_mods) {
+        if (!m_latest_files.contains(mod)) {
+            auto versions = m_version_lists.value(versionListKey(mod->metadata()->project_id.toString()));
+            auto latest_ver = api.getLatestVersion(versions, m_loaders_list, mod->loaders());
+            if (latest_ver.has_value() && latest_ver->fileId.isValid()) {
+                auto file_id = latest_ver->fileId.toString();
+                m_files.insert(file_id, latest_ver.value());
+                m_latest_files.insert(mod, file_id);
+            }
+        }
+        if (m_latest_files.contains(mod))
+            want(m_latest_files.value(mod));
+        // the old version is shown with the update, the mod itself doesn't always know it
+        if (mod->version().isEmpty() && mod->status() != ModStatus::NotInstalled)
+            want(mod->metadata()->file_id.toString());
+    }
+    if (missing.isEmpty()) {
+        checkFiles();
+        return;
+    }
 
     auto response = std::make_shared<QByteArray>();
-    auto url = QString("https://api.curseforge.com/v1/mods/%1/files/%2").arg(QString::number(addonId), QString::number(fileId));
-    auto dl = Net::ApiDownload::makeByteArray(url, response);
-    get_file_info_job->addNetAction(dl);
-
-    QObject::connect(get_file_info_job, &NetJob::succeeded, [response, &ver]() {
-        QJsonParseError parse_error{};
-        QJsonDocument doc = QJsonDocument::fromJson(*response, &parse_error);
-        if (parse_error.error != QJsonParseError::NoError) {
-            qWarning() << "Error while parsing JSON response from FlameCheckUpdate at " << parse_error.offset
-                       << " reason: " << parse_error.errorString();
-            qWarning() << *response;
+    auto job = api.getFiles(missing, response);
+    connect(job.get(), &Task::succeeded, this, [this, response] {
+        if (m_was_aborted)
+            return;
+        auto doc = parseResponse(*response);
+        if (!doc) {
+            emitFailed(tr("Could not read the response from CurseForge."));
             return;
         }
 
-        try {
-            auto doc_obj = Json::requireObject(doc);
-            auto data_obj = Json::requireObject(doc_obj, "data");
-            ver = FlameMod::loadIndexedPackVersion(data_obj);
-        } catch (Json::JsonException& e) {
-            qWarning() << e.cause();
-            qDebug() << doc;
+        for (auto file_value : Json::ensureArray(doc->object(), "data")) {
+            auto file_obj = Json::ensureObject(file_value);
+            try {
+                auto file = FlameMod::loadIndexedPackVersion(file_obj);
+                auto file_id = file.fileId.toString();
+                m_files.insert(file_id, file);
+                s_files.insert(file_id, file);
+            } catch (Json::JsonException& e) {
+                qWarning() << e.cause();
+                qDebug() << file_obj;
+            }
         }
+        checkFiles();
     });
-    connect(get_file_info_job, &NetJob::failed, this, &FlameCheckUpdate::emitFailed);
-    QObject::connect(get_file_info_job, &NetJob::finished, [&loop, get_file_info_job] {
-        get_file_info_job->deleteLater();
-        loop.quit();
-    });
-
-    get_file_info_job->start();
-    loop.exec();
-
-    return ver;
+    connect(job.get(), &Task::failed, this, &FlameCheckUpdate::emitFailed);
+    startJob(job);
 }
 
-/* Check for update:
- * - Get latest version available
- * - Compare hash of the latest version with the current hash
- * - If equal, no updates, else, there's updates, so add to the list
- * */
-void FlameCheckUpdate::executeTask()
+void FlameCheckUpdate::checkFiles()
 {
-    setStatus(tr("Preparing mods for CurseForge..."));
+    setStatus(tr("Parsing the API responses from CurseForge..."));
+    setProgress(3, 5);
 
-    int i = 0;
     for (auto* mod : m_mods) {
-        setStatus(tr("Getting API response from CurseForge for '%1'...").arg(mod->name()));
-        setProgress(i++, m_mods.size());
-
-        auto latest_vers = api.getLatestVersions({ { mod->metadata()->project_id.toString() }, m_game_versions });
-
-        // Check if we were aborted while getting the latest version
-        if (m_was_aborted) {
-            aborted();
-            return;
-        }
-        auto latest_ver = api.getLatestVersion(latest_vers, m_loaders_list, mod->loaders());
-
-        setStatus(tr("Parsing the API response from CurseForge for '%1'...").arg(mod->name()));
-
-        if (!latest_ver.has_value() || !latest_ver->addonId.isValid()) {
+        auto latest_ver = m_files.constFind(m_latest_files.value(mod));
+        if (latest_ver == m_files.constEnd() || !latest_ver->addonId.isValid()) {
             emit checkFailed(mod, tr("No valid version found for this mod. It's probably unavailable for the current game "
                                      "version / mod loader."));
             continue;
         }
 
         if (latest_ver->downloadUrl.isEmpty() && latest_ver->fileId != mod->metadata()->file_id) {
-            auto pack = getProjectInfo(latest_ver.value());
-            auto recover_url = QString("%1/download/%2").arg(pack.websiteUrl, latest_ver->fileId.toString());
+            auto project = m_projects.value(mod->metadata()->project_id.toString());
+            auto recover_url = QString("%1/download/%2").arg(project.website_url, latest_ver->fileId.toString());
             emit checkFailed(mod, tr("Mod has a new update available, but is not downloadable using CurseForge."), recover_url);
 
             continue;
@@ -165,18 +327,74 @@ void FlameCheckUpdate::executeTask()
         pack->provider = ModPlatform::ResourceProvider::FLAME;
         if (!latest_ver->hash.isEmpty() && (mod->metadata()->hash != latest_ver->hash || mod->status() == ModStatus::NotInstalled)) {
             auto old_version = mod->version();
-            if (old_version.isEmpty() && mod->status() != ModStatus::NotInstalled) {
-                auto current_ver = getFileInfo(latest_ver->addonId.toInt(), mod->metadata()->file_id.toInt());
-                old_version = current_ver.version;
-            }
+            if (old_version.isEmpty() && mod->status() != ModStatus::NotInstalled)
+                old_version = m_files.value(mod->metadata()->file_id.toString()).version;
 
-            auto download_task = makeShared<ResourceDownloadTask>(pack, latest_ver.value(), m_mods_folder);
-            m_updatable.emplace_back(pack->name, mod->metadata()->hash, old_version, latest_ver->version, latest_ver->version_type,
-                                     api.getModFileChangelog(latest_ver->addonId.toInt(), latest_ver->fileId.toInt()),
-                                     ModPlatform::ResourceProvider::FLAME, download_task, mod->enabled());
+            m_pending.append({ pack, latest_ver.value(), old_version, mod->metadata()->hash, mod->enabled() });
         }
         m_deps.append(std::make_shared<GetModDependenciesTask::PackDependency>(pack, latest_ver.value()));
     }
 
+    getChangelogs();
+}
+
+void FlameCheckUpdate::getChangelogs()
+{
+    setProgress(4, 5);
+
+    auto job = makeShared<NetJob>("Flame::FileChangelogs", APPLICATION->network());
+    // a missing changelog is no reason to give up on the update
+    job->setAskRetry(false);
+
+    QHash<QString, std::shared_ptr<QByteArray>> responses;
+    for (auto& update : m_pending) {
+        auto file_id = update.version.fileId.toString();
+        if (m_changelogs.contains(file_id) || responses.contains(file_id))
+            continue;
+        if (auto changelog = s_changelogs.get(file_id)) {
+            m_changelogs.insert(file_id, *changelog);
+            continue;
+        }
+
+        auto response = std::make_shared<QByteArray>();
+        responses.insert(file_id, response);
+        job->addNetAction(Net::ApiDownload::makeByteArray(
+            QString("https://api.curseforge.com/v1/mods/%1/files/%2/changelog").arg(update.version.addonId.toString(), file_id), response));
+    }
+    if (responses.isEmpty()) {
+        finishCheck();
+        return;
+    }
+
+    setStatus(tr("Getting the changelogs of %n update(s) from CurseForge...", "", responses.size()));
+    connect(job.get(), &Task::finished, this, [this, responses] {
+        if (m_was_aborted)
+            return;
+        for (auto it = responses.constBegin(); it != responses.constEnd(); ++it) {
+            if (it.value()->isEmpty())
+                continue;
+            auto doc = parseResponse(*it.value());
+            if (!doc)
+                continue;
+            auto changelog = Json::ensureString(doc->object(), "data");
+            m_changelogs.insert(it.key(), changelog);
+            s_changelogs.insert(it.key(), changelog);
+        }
+        finishCheck();
+    });
+    startJob(job);
+}
+
+void FlameCheckUpdate::finishCheck()
+{
+    setProgress(5, 5);
+
+    for (auto& update : m_pending) {
+        auto download_task = makeShared<ResourceDownloadTask>(update.pack, update.version, m_mods_folder);
+        m_updatable.emplace_back(update.pack->name, update.old_hash, update.old_version, update.version.version, update.version.version_type,
+                                 m_changelogs.value(update.version.fileId.toString()), ModPlatform::ResourceProvider::FLAME, download_task,
+                                 update.enabled);
+    }
+
     emitSucceeded();
 }
@@ -1,8 +1,18 @@
 #pragma once
 
+#include <QJsonObject>
+
+#include <optional>
+
 #include "modplatform/CheckUpdateTask.h"
 #include "net/NetJob.h"
 
+/**
+ * Looks for updates of CurseForge mods without waiting on one request per mod.
+ *
+ * Projects and files are fetched with the bulk endpoints, and whatever can't be had in bulk (full version lists,
+ * changelogs) is fetched in parallel. Responses are kept for a while, so checking again in the same session is free.
+ */
 class FlameCheckUpdate : public CheckUpdateTask {
     Q_OBJECT
 
@@ -14,6 +24,29 @@ class FlameCheckUpdate : public CheckUpdateTask {
         : CheckUpdateTask(mods, mcVersions, loadersList, mods_folder)
     {}
 
+    /** The newest file of a project for one game version and mod loader, as listed with the project. */
+    struct LatestFile {
+        QString game_version;
+        int file_id = 0;
+        ModPlatform::ModLoaderType loader;
+    };
+    struct ProjectInfo {
+        QString project_id;
+        QString website_url;
+        QList<LatestFile> latest_files;
+    };
+
+    /** Reads a project of the bulk projects response. @throw Json::JsonException */
+    static ProjectInfo loadProjectInfo(QJsonObject obj);
+    /**
+     * Picks the newest file with FlameAPI::selectLatest(), just from the files listed with the project.
+     * nullopt if none of them fits, then the full version list has to be looked through.
+     */
+    static std::optional<int> latestFileId(const ProjectInfo& project,
+                                           const QString& game_version,
+                                           QList<ModPlatform::ModLoaderType> instance_loaders,
+                                           ModPlatform::ModLoaderTypes mod_loaders);
+
    public slots:
     bool abort() override;
 
@@ -21,10 +54,37 @@ class FlameCheckUpdate : public CheckUpdateTask {
     void executeTask() override;
 
    private:
-    ModPlatform::IndexedPack getProjectInfo(ModPlatform::IndexedVersion& ver_info);
-    ModPlatform::IndexedVersion getFileInfo(int addonId, int fileId);
+    struct PendingUpdate {
+        std::shared_ptr<ModPlatform::IndexedPack> pack;
+        ModPlatform::IndexedVersion version;
+        QString old_version;
+        QString old_hash;
+        bool enabled;
+    };
+
+    void getProjects();
+    void selectLatestFiles();
+    void getVersionLists(const QList<ModPlatform::IndexedPack>& projects);
+    void getFiles();
+    void checkFiles();
+    void getChangelogs();
+    void finishCheck();
 
-    NetJob* m_net_job = nullptr;
+    void startJob(Task::Ptr job);
+    QString versionListKey(const QString& project_id) const;
 
+    Task::Ptr m_job;
     bool m_was_aborted = false;
+
+    /// by project ID
+    QHash<QString, ProjectInfo> m_projects;
+    /// all files of a project for the game version, for projects that don't list a newest file that fits
+    QHash<QString, QList<ModPlatform::IndexedVersion>> m_version_lists;
+    /// by file ID
+    QHash<QString, ModPlatform::IndexedVersion> m_files;
+    /// the ID of the newest file for each mod
+    QHash<Mod*, QString> m_latest_files;
+    /// by file ID
+    QHash<QString, QString> m_changelogs;
+    QList<PendingUpdate> m_pending;
 };
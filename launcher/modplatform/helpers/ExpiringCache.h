@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+
+#include <functional>
+#include <optional>
+
+namespace ModPlatform {
+
+/**
+ * Keeps API results around for a limited time, so asking again in the same session doesn't go over the network.
+ *
+ * Meant for the GUI thread, nothing here is locked. Expired entries are dropped when they're looked up.
+ */
+template <typename T>
+class ExpiringCache {
+   public:
+    /** @clock returns milliseconds since the epoch, and only needs to be given by tests. */
+    explicit ExpiringCache(qint64 lifetimeSecs, std::function<qint64()> clock = {})
+        : m_lifetime(lifetimeSecs * 1000), m_clock(std::move(clock))
+    {
+        if (!m_clock)
+            m_clock = [] { return QDateTime::currentMSecsSinceEpoch(); };
+    }
+
+    std::optional<T> get(const QString& key)
+    {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+            return {};
+        if (m_clock() - it->stored > m_lifetime) {
+            m_entries.erase(it);
+            return {};
+        }
+        return it->value;
+    }
+
+    void insert(const QString& key, T value) { m_entries.insert(key, { m_clock(), std::move(value) }); }
+    void clear() { m_entries.clear(); }
+
+   private:
+    struct Entry {
+        qint64 stored;  // in ms since the epoch
+        T value;
+    };
+
+    qint64 m_lifetime;
+    std::function<qint64()> m_clock;
+    QHash<QString, Entry> m_entries;
+};
+
+}  // namespace ModPlatform
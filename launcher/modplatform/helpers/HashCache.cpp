@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "HashCache.h"
+
+#include <QDataStream>
+#include <QHash>
+
+namespace Hashing {
+
+namespace {
+constexpr quint32 CacheMagic = 0x48534843;  // "HSHC"
+
+// by algorithm name
+using Digests = QHash<QString, QString>;
+
+Digests readDigests(const QByteArray& payload)
+{
+    Digests digests;
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    in >> digests;
+    return digests;
+}
+
+QByteArray writeDigests(const Digests& digests)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << digests;
+    return payload;
+}
+}  // namespace
+
+HashCache::HashCache(QString indexFile) : StampedFileCache(std::move(indexFile), Keying::AbsolutePath, CacheMagic, "1") {}
+
+std::optional<QString> HashCache::lookup(const QString& path, Algorithm algorithm)
+{
+    auto payload = lookupPayload(QFileInfo(path));
+    if (!payload)
+        return {};
+    auto digest = readDigests(*payload).value(algorithmToString(algorithm));
+    if (digest.isEmpty())
+        return {};
+    return digest;
+}
+
+void HashCache::store(const QString& path, const Stamp& stamp, Algorithm algorithm, const QString& digest)
+{
+    if (digest.isEmpty() || algorithm == Algorithm::Unknown)
+        return;
+
+    updatePayload(QFileInfo(path), stamp, [algorithm, &digest](QByteArray& payload) {
+        auto digests = readDigests(payload);
+        digests.insert(algorithmToString(algorithm), digest);
+        payload = writeDigests(digests);
+    });
+}
+
+}  // namespace Hashing
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+
+#include <optional>
+
+#include "HashUtils.h"
+#include "StampedFileCache.h"
+
+namespace Hashing {
+
+/**
+ * Remembers the digests computed for files, so they aren't read again as long as they stay the same.
+ *
+ * Entries are keyed by absolute path, and every algorithm computed for a version of a file is kept in its entry.
+ * Hashes are computed on worker threads, which look up and store digests directly.
+ */
+class HashCache : public StampedFileCache {
+    Q_OBJECT
+   public:
+    explicit HashCache(QString indexFile);
+
+    std::optional<QString> lookup(const QString& path, Algorithm algorithm);
+    /** Remember @digest for the version of the file described by @stamp, taken before it was hashed. */
+    void store(const QString& path, const Stamp& stamp, Algorithm algorithm, const QString& digest);
+};
+
+}  // namespace Hashing
@@ -7,6 +7,9 @@
 
 #include <MurmurHash2.h>
 
+#include "Application.h"
+#include "HashCache.h"
+
 namespace Hashing {
 
 Hasher::Ptr createHasher(QString file_path, ModPlatform::ResourceProvider provider)
@@ -28,18 +31,20 @@ Hasher::Ptr createHasher(QString file_path, QString type)
     return makeShared<Hasher>(file_path, type);
 }
 
-class QIODeviceReader : public Murmur2::Reader {
-   public:
-    QIODeviceReader(QIODevice* device) : m_device(device) {}
-    virtual ~QIODeviceReader() = default;
-    virtual int read(char* s, int n) { return m_device->read(s, n); }
-    virtual bool eof() { return m_device->atEnd(); }
-    virtual void goToBeginning() { m_device->seek(0); }
-    virtual void close() { m_device->close(); }
-
-   private:
-    QIODevice* m_device;
-};
+// CurseForge's fingerprint skips whitespace, and the number of bytes hashed seeds it, so the whole file has to be at
+// hand before hashing starts. Files are mapped rather than read twice.
+static uint32_t murmur2(QIODevice* device)
+{
+    if (auto file = qobject_cast<QFileDevice*>(device); file && file->size() > 0) {
+        if (auto data = file->map(0, file->size())) {
+            auto result = Murmur2::hashWithoutWhitespace(reinterpret_cast<const char*>(data), file->size());
+            file->unmap(data);
+            return result;
+        }
+    }
+    auto data = device->readAll();
+    return Murmur2::hashWithoutWhitespace(data.constData(), data.size());
+}
 
 QString algorithmToString(Algorithm type)
 {
@@ -102,9 +107,7 @@ QString hash(QIODevice* device, Algorithm type)
             alg = QCryptographicHash::Algorithm::Sha512;
             break;
         case Algorithm::Murmur2: {  // CF-specific
-            auto should_filter_out = [](char c) { return (c == 9 || c == 10 || c == 13 || c == 32); };
-            auto reader = std::make_unique<QIODeviceReader>(device);
-            auto result = QString::number(Murmur2::hash(reader.get(), 4 * MiB, should_filter_out));
+            auto result = QString::number(murmur2(device));
             device->close();
             return result;
         }
@@ -125,8 +128,24 @@ QString hash(QIODevice* device, Algorithm type)
 
 QString hash(QString fileName, Algorithm type)
 {
+    std::shared_ptr<HashCache> cache;
+    if (auto app = APPLICATION_DYN)
+        cache = app->hashCache();
+    if (!cache) {
+        QFile file(fileName);
+        return hash(&file, type);
+    }
+
+    if (auto cached = cache->lookup(fileName, type))
+        return *cached;
+
+    // if the file changes while it's read, the result belongs to neither version
+    auto stamp = HashCache::stampOf(fileName);
     QFile file(fileName);
-    return hash(&file, type);
+    auto result = hash(&file, type);
+    if (!result.isEmpty() && HashCache::stampOf(fileName) == stamp)
+        cache->store(fileName, stamp, type, result);
+    return result;
 }
 
 QString hash(QByteArray data, Algorithm type)
@@ -9,12 +9,16 @@
 #include "ResourceDownloadTask.h"
 
 #include "modplatform/ModIndex.h"
+#include "modplatform/helpers/ExpiringCache.h"
 #include "modplatform/helpers/HashUtils.h"
 
 #include "tasks/ConcurrentTask.h"
 
 static ModrinthAPI api;
 
+// the latest version of a mod changes with every release, so it isn't kept for long
+static ModPlatform::ExpiringCache<QJsonObject> s_latest_versions(10 * 60);
+
 ModrinthCheckUpdate::ModrinthCheckUpdate(QList<Mod*>& mods,
                                          std::list<Version>& mcVersions,
                                          QList<ModPlatform::ModLoaderType> loadersList,
@@ -63,21 +67,16 @@ void ModrinthCheckUpdate::executeTask()
     hashing_task->start();
 }
 
-void ModrinthCheckUpdate::checkVersionsResponse(std::shared_ptr<QByteArray> response,
-                                                ModPlatform::ModLoaderTypes loader,
-                                                bool forceModLoaderCheck)
+QString ModrinthCheckUpdate::cacheKey(const QString& hash, ModPlatform::ModLoaderTypes loader) const
 {
-    QJsonParseError parse_error{};
-    QJsonDocument doc = QJsonDocument::fromJson(*response, &parse_error);
-    if (parse_error.error != QJsonParseError::NoError) {
-        qWarning() << "Error while parsing JSON response from ModrinthCheckUpdate at " << parse_error.offset
-                   << " reason: " << parse_error.errorString();
-        qWarning() << *response;
-
-        emitFailed(parse_error.errorString());
-        return;
-    }
+    QStringList game_versions;
+    for (auto& version : m_game_versions)
+        game_versions.append(version.toString());
+    return QString("%1:%2:%3:%4").arg(m_hash_type, hash, QString::number(static_cast<int>(loader)), game_versions.join(','));
+}
 
+void ModrinthCheckUpdate::checkVersionsResponse(const QJsonObject& versions, ModPlatform::ModLoaderTypes loader, bool forceModLoaderCheck)
+{
     setStatus(tr("Parsing the API response from Modrinth..."));
     setProgress(m_next_loader_idx * 2, 9);
 
@@ -86,7 +85,7 @@ void ModrinthCheckUpdate::checkVersionsResponse(std::shared_ptr<QByteArray> resp
             if (forceModLoaderCheck && !(m_mappings[hash]->loaders() & loader)) {
                 continue;
             }
-            auto project_obj = doc[hash].toObject();
+            auto project_obj = versions.value(hash).toObject();
 
             // If the returned project is empty, but we have Modrinth metadata,
             // it means this specific version is not available
@@ -156,7 +155,6 @@ void ModrinthCheckUpdate::checkVersionsResponse(std::shared_ptr<QByteArray> resp
 
 void ModrinthCheckUpdate::getUpdateModsForLoader(ModPlatform::ModLoaderTypes loader, bool forceModLoaderCheck)
 {
-    auto response = std::make_shared<QByteArray>();
     QStringList hashes;
     if (forceModLoaderCheck) {
         for (auto hash : m_mappings.keys()) {
@@ -167,10 +165,43 @@ void ModrinthCheckUpdate::getUpdateModsForLoader(ModPlatform::ModLoaderTypes loa
     } else {
         hashes = m_mappings.keys();
     }
-    auto job = api.latestVersions(hashes, m_hash_type, m_game_versions, loader, response);
 
-    connect(job.get(), &Task::succeeded, this,
-            [this, response, loader, forceModLoaderCheck] { checkVersionsResponse(response, loader, forceModLoaderCheck); });
+    // only ask for what wasn't looked up recently, an empty object means there was no version
+    QJsonObject versions;
+    QStringList missing;
+    for (auto& hash : hashes) {
+        if (auto version = s_latest_versions.get(cacheKey(hash, loader)))
+            versions.insert(hash, *version);
+        else
+            missing.append(hash);
+    }
+    if (missing.isEmpty()) {
+        checkVersionsResponse(versions, loader, forceModLoaderCheck);
+        return;
+    }
+
+    auto response = std::make_shared<QByteArray>();
+    auto job = api.latestVersions(missing, m_hash_type, m_game_versions, loader, response);
+
+    connect(job.get(), &Task::succeeded, this, [this, response, versions, missing, loader, forceModLoaderCheck]() mutable {
+        QJsonParseError parse_error{};
+        QJsonDocument doc = QJsonDocument::fromJson(*response, &parse_error);
+        if (parse_error.error != QJsonParseError::NoError) {
+            qWarning() << "Error while parsing JSON response from ModrinthCheckUpdate at " << parse_error.offset
+                       << " reason: " << parse_error.errorString();
+            qWarning() << *response;
+
+            emitFailed(parse_error.errorString());
+            return;
+        }
+
+        for (auto& hash : missing) {
+            auto version = doc[hash].toObject();
+            s_latest_versions.insert(cacheKey(hash, loader), version);
+            versions.insert(hash, version);
+        }
+        checkVersionsResponse(versions, loader, forceModLoaderCheck);
+    });
 
     connect(job.get(), &Task::failed, this, &ModrinthCheckUpdate::checkNextLoader);
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <QJsonObject>
+
 #include "modplatform/CheckUpdateTask.h"
 
 class ModrinthCheckUpdate : public CheckUpdateTask {
@@ -17,9 +19,12 @@ class ModrinthCheckUpdate : public CheckUpdateTask {
    protected slots:
     void executeTask() override;
     void getUpdateModsForLoader(ModPlatform::ModLoaderTypes loader, bool forceModLoaderCheck = false);
-    void checkVersionsResponse(std::shared_ptr<QByteArray> response, ModPlatform::ModLoaderTypes loader, bool forceModLoaderCheck = false);
+    void checkVersionsResponse(const QJsonObject& versions, ModPlatform::ModLoaderTypes loader, bool forceModLoaderCheck = false);
     void checkNextLoader();
 
+   private:
+    QString cacheKey(const QString& hash, ModPlatform::ModLoaderTypes loader) const;
+
    private:
     Task::Ptr m_job = nullptr;
     QHash<QString, Mod*> m_mappings;
@@ -0,0 +1,619 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TruckPackDeltaUpdateTask.h"
+
+#include <quazip/JlCompress.h>
+#include <quazip/quazip.h>
+#include <zlib.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QSet>
+#include <QtConcurrentRun>
+#include <QtEndian>
+
+#include "Application.h"
+#include "FileSystem.h"
+#include "InstanceList.h"
+#include "StringUtils.h"
+#include "settings/INIFile.h"
+
+#include "TruckPackFileStore.h"
+#include "TruckPackPrefetcher.h"
+
+#include "net/ApiDownload.h"
+#include "net/RawHeaderProxy.h"
+
+namespace TruckPack {
+
+namespace {
+// EOCD (22) + max comment (65535) + zip64 locator (20) + zip64 EOCD (56), rounded up
+constexpr qint64 TAIL_SIZE = 128 * 1024;
+// ranges closer than this are fetched as one, trading a few wasted bytes for fewer round-trips
+constexpr qint64 RANGE_MERGE_GAP = 1024 * 1024;
+
+constexpr quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr int LOCAL_HEADER_SIZE = 30;
+
+// settings the pack must never overwrite in an existing instance
+const QStringList s_preservedSettings = { "name",      "iconKey",       "notes",           "totalTimePlayed",    "lastTimePlayed", "lastLaunchTime",
+                                          "TruckPack", "TruckPackName", "TruckPackVersion", "TruckPackCachePath", "OverrideMemory" };
+
+Net::Download::Ptr makeRangeDownload(const QUrl& url, std::shared_ptr<QByteArray> output, const QByteArray& range)
+{
+    auto dl = Net::ApiDownload::makeByteArray(url, output);
+    dl->addHeaderProxy(new Net::RawHeaderProxy({ { "Range", "bytes=" + range } }));
+    return dl;
+}
+
+std::optional<QString> inflateEntry(QFile& source, const PackEntry& entry, const QString& target)
+{
+    QByteArray header = source.read(LOCAL_HEADER_SIZE);
+    if (header.size() != LOCAL_HEADER_SIZE ||
+        qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(header.constData())) != LOCAL_HEADER_SIGNATURE)
+        return QObject::tr("Malformed local header for %1").arg(entry.path);
+
+    auto nameLength = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(header.constData() + 26));
+    auto extraLength = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(header.constData() + 28));
+    if (!source.seek(source.pos() + nameLength + extraLength))
+        return QObject::tr("Truncated data for %1").arg(entry.path);
+
+    if (entry.flags & 1)
+        return QObject::tr("%1 is encrypted").arg(entry.path);
+    if (entry.method != 0 && entry.method != Z_DEFLATED)
+        return QObject::tr("%1 uses an unsupported compression method (%2)").arg(entry.path).arg(entry.method);
+
+    if (!FS::ensureFilePathExists(target))
+        return QObject::tr("Could not create the folder for %1").arg(target);
+    QFile output(target);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return QObject::tr("Could not open %1 for writing").arg(target);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (entry.method == Z_DEFLATED && inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+        return QObject::tr("Could not initialize zlib");
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    qint64 remaining = entry.compressedSize;
+    QByteArray in(256 * 1024, Qt::Uninitialized);
+    QByteArray out(256 * 1024, Qt::Uninitialized);
+    std::optional<QString> error;
+    int zerr = Z_OK;
+
+    while (remaining > 0 && !error && zerr != Z_STREAM_END) {
+        auto read = source.read(in.data(), std::min<qint64>(in.size(), remaining));
+        if (read <= 0) {
+            error = QObject::tr("Truncated data for %1").arg(entry.path);
+            break;
+        }
+        remaining -= read;
+
+        if (entry.method == 0) {
+            crc = crc32(crc, reinterpret_cast<const Bytef*>(in.constData()), static_cast<uInt>(read));
+            if (output.write(in.constData(), read) != read)
+                error = QObject::tr("Failed writing %1").arg(target);
+            continue;
+        }
+
+        strm.next_in = reinterpret_cast<Bytef*>(in.data());
+        strm.avail_in = static_cast<uInt>(read);
+        do {
+            strm.next_out = reinterpret_cast<Bytef*>(out.data());
+            strm.avail_out = static_cast<uInt>(out.size());
+            zerr = inflate(&strm, Z_NO_FLUSH);
+            if (zerr != Z_OK && zerr != Z_STREAM_END) {
+                error = QObject::tr("Corrupted data for %1").arg(entry.path);
+                break;
+            }
+            auto produced = out.size() - static_cast<qint64>(strm.avail_out);
+            crc = crc32(crc, reinterpret_cast<const Bytef*>(out.constData()), static_cast<uInt>(produced));
+            if (output.write(out.constData(), produced) != produced) {
+                error = QObject::tr("Failed writing %1").arg(target);
+                break;
+            }
+        } while (strm.avail_out == 0 && zerr != Z_STREAM_END);
+    }
+    if (entry.method == Z_DEFLATED)
+        inflateEnd(&strm);
+    output.close();
+
+    if (!error && static_cast<quint32>(crc) != entry.crc32)
+        error = QObject::tr("Checksum mismatch for %1").arg(entry.path);
+    if (error)
+        output.remove();
+    return error;
+}
+}  // namespace
+
+DeltaUpdateTask::DeltaUpdateTask(InstancePtr instance, QUrl packUrl, QString packName, QString packVersion)
+    : m_instance(std::move(instance)), m_packUrl(std::move(packUrl)), m_packName(std::move(packName)), m_packVersion(std::move(packVersion))
+{
+    // the workers can run more than once per update (a broken pre-stage falls back to downloading), connect only once
+    connect(&m_diffWatcher, &QFutureWatcher<PackDiff>::finished, this, &DeltaUpdateTask::diffFinished);
+    connect(&m_extractWatcher, &QFutureWatcher<ExtractResult>::finished, this, &DeltaUpdateTask::extractFinished);
+    connect(&m_snapshotWatcher, &QFutureWatcher<bool>::finished, this, &DeltaUpdateTask::snapshotFinished);
+}
+
+bool DeltaUpdateTask::abort()
+{
+    if (!canAbort())
+        return false;
+
+    if (m_job)
+        m_job->abort();
+    m_canceled = true;
+    if (m_working) {
+        // NOTE: emitAborted() happens once the worker actually stops
+        setAbortable(false);
+        return true;
+    }
+    return Task::abort();
+}
+
+void DeltaUpdateTask::executeTask()
+{
+    setAbortable(true);
+    m_canceled = false;
+    setStatus(tr("Checking which files changed in %1").arg(m_packName));
+
+    auto installed = PackIndex::load(indexPathFor(m_instance->instanceRoot()));
+    if (!installed) {
+        // instances installed before indexes were saved: the archive they came from may still be cached
+        auto cachedArchive = m_instance->getTruckPackCachePath();
+        if (!cachedArchive.isEmpty() && QFileInfo::exists(cachedArchive)) {
+            QuaZip zip(cachedArchive);
+            if (zip.open(QuaZip::mdUnzip))
+                installed = PackIndex::fromZip(&zip);
+        }
+    }
+    if (installed) {
+        m_installed = *installed;
+    } else {
+        qDebug() << "DeltaUpdateTask: no index for the installed pack, comparing against the files on disk only";
+    }
+
+    // the new version may already be extracted in the background
+    auto prestage = Prestage::pathFor(m_packName, m_packVersion);
+    if (Prestage::isComplete(prestage)) {
+        if (auto target = PackIndex::load(Prestage::indexPath(prestage))) {
+            qDebug() << "DeltaUpdateTask: using the pre-staged files in" << prestage;
+            m_prestagePath = prestage;
+            m_target = *target;
+            startDiff();
+            return;
+        }
+    }
+
+    fetchTail();
+}
+
+void DeltaUpdateTask::fetchTail()
+{
+    m_tail = std::make_shared<QByteArray>();
+    auto dl = makeRangeDownload(m_packUrl, m_tail, "-" + QByteArray::number(TAIL_SIZE));
+    m_rangeValidator = new Net::ByteRangeValidator(TAIL_SIZE);
+    dl->addValidator(m_rangeValidator);
+
+    m_job.reset(new NetJob(tr("Truck pack index download"), APPLICATION->network()));
+    m_job->setAskRetry(false);
+    m_job->addNetAction(dl);
+
+    connect(m_job.get(), &NetJob::succeeded, this, [this] {
+        auto location = locateCentralDirectory(*m_tail, m_rangeValidator->firstByte());
+        if (!location) {
+            emitFailed(tr("The pack archive at %1 is not a valid zip file.").arg(m_packUrl.toString()));
+            return;
+        }
+        auto tailStart = m_rangeValidator->firstByte();
+        if (location->offset >= tailStart && location->offset + location->size <= tailStart + m_tail->size()) {
+            m_centralDirectory = std::make_shared<QByteArray>(m_tail->mid(location->offset - tailStart, location->size));
+            auto entries = parseCentralDirectory(*m_centralDirectory, *location);
+            if (!entries) {
+                emitFailed(tr("The pack archive has a corrupted central directory."));
+                return;
+            }
+            targetIndexReady(*entries);
+        } else {
+            fetchCentralDirectory(*location);
+        }
+    });
+    connect(m_job.get(), &NetJob::failed, this, [this, dl](QString reason) {
+        auto status = dl->replyStatusCode();
+        if (status == 200 || status == 416) {
+            qDebug() << "DeltaUpdateTask: server doesn't do range requests, falling back to the whole archive";
+            downloadWholeArchive();
+            return;
+        }
+        emitFailed(reason);
+    });
+    connect(m_job.get(), &NetJob::aborted, this, &DeltaUpdateTask::emitAborted);
+    m_job->start();
+}
+
+void DeltaUpdateTask::fetchCentralDirectory(const CentralDirectoryLocation& location)
+{
+    m_centralDirectory = std::make_shared<QByteArray>();
+    auto range = QByteArray::number(location.offset) + '-' + QByteArray::number(location.offset + location.size - 1);
+    auto dl = makeRangeDownload(m_packUrl, m_centralDirectory, range);
+    dl->addValidator(new Net::ByteRangeValidator(location.size));
+
+    m_job.reset(new NetJob(tr("Truck pack index download"), APPLICATION->network()));
+    m_job->setAskRetry(false);
+    m_job->addNetAction(dl);
+
+    connect(m_job.get(), &NetJob::succeeded, this, [this, location] {
+        auto entries = parseCentralDirectory(*m_centralDirectory, location);
+        if (!entries) {
+            emitFailed(tr("The pack archive has a corrupted central directory."));
+            return;
+        }
+        targetIndexReady(*entries);
+    });
+    connect(m_job.get(), &NetJob::failed, this, &DeltaUpdateTask::emitFailed);
+    connect(m_job.get(), &NetJob::aborted, this, &DeltaUpdateTask::emitAborted);
+    m_job->start();
+}
+
+void DeltaUpdateTask::targetIndexReady(const QList<PackEntry>& archiveEntries)
+{
+    auto target = PackIndex::fromEntries(archiveEntries);
+    if (!target) {
+        failReinstall(tr("This pack can't be updated in place."));
+        return;
+    }
+    m_target = *target;
+    startDiff();
+}
+
+void DeltaUpdateTask::startDiff()
+{
+    setStatus(tr("Comparing installed files against %1 %2").arg(m_packName, m_packVersion));
+    m_working = true;
+    m_diffFuture = QtConcurrent::run(QThreadPool::globalInstance(), computeDiff, m_installed, m_target, m_instance->instanceRoot());
+    m_diffWatcher.setFuture(m_diffFuture);
+}
+
+void DeltaUpdateTask::diffFinished()
+{
+    m_working = false;
+    if (!isRunning())
+        return;
+    // the diff can't be interrupted, an abort requested meanwhile is picked up here
+    if (m_canceled) {
+        emitAborted();
+        return;
+    }
+    m_diff = m_diffFuture.result();
+    qDebug() << "DeltaUpdateTask:" << m_diff.changed.size() << "changed," << m_diff.removed.size() << "removed,"
+             << m_diff.unchangedCount << "unchanged files," << m_diff.changedBytes() << "bytes to fetch";
+
+    if (!m_prestagePath.isEmpty()) {
+        takePrestagedFiles();
+        return;
+    }
+    if (!m_cachePath.isEmpty()) {
+        // we already have the whole archive, just pick the changed entries out of it
+        wholeArchiveDownloaded();
+        return;
+    }
+    downloadChangedRanges();
+}
+
+void DeltaUpdateTask::takePrestagedFiles()
+{
+    setStatus(tr("Moving pre-staged files"));
+    auto files = Prestage::filesPath(m_prestagePath);
+    QStringList taken;
+    for (auto& entry : m_diff.changed) {
+        auto source = FS::PathCombine(files, entry.path);
+        auto target = FS::PathCombine(m_stagingPath, entry.path);
+        FS::ensureFilePathExists(target);
+        QFile::remove(target);
+        if (!QFile::rename(source, target)) {
+            // someone cleaned up the pre-stage, download the changes like we would have anyway
+            qWarning() << "DeltaUpdateTask: pre-staged" << entry.path << "is missing, downloading the changes instead";
+            // put back what was already taken, the staging folder has to start out empty again
+            for (auto& path : taken) {
+                auto staged = FS::PathCombine(m_stagingPath, path);
+                if (!QFile::rename(staged, FS::PathCombine(files, path)))
+                    QFile::remove(staged);
+            }
+            FS::deletePath(m_prestagePath);
+            m_prestagePath.clear();
+            fetchTail();
+            return;
+        }
+        taken.append(entry.path);
+    }
+    snapshotInstance();
+}
+
+void DeltaUpdateTask::downloadChangedRanges()
+{
+    // merge the byte spans of changed entries into as few requests as reasonable
+    QList<PackEntry> ordered = m_diff.changed;
+    std::sort(ordered.begin(), ordered.end(), [](const PackEntry& a, const PackEntry& b) { return a.localHeaderOffset < b.localHeaderOffset; });
+    m_ranges.clear();
+    for (auto& entry : ordered) {
+        if (!m_ranges.isEmpty() && entry.localHeaderOffset - m_ranges.last().last <= RANGE_MERGE_GAP) {
+            m_ranges.last().last = std::max(m_ranges.last().last, entry.nextHeaderOffset - 1);
+        } else {
+            m_ranges.append({ entry.localHeaderOffset, entry.nextHeaderOffset - 1, {} });
+        }
+    }
+
+    if (m_ranges.isEmpty()) {
+        // nothing to download, but removing files still changes the instance and needs a rollback point
+        snapshotInstance();
+        return;
+    }
+
+    setStatus(tr("Downloading %1 changed files (%2)")
+                  .arg(m_diff.changed.size())
+                  .arg(StringUtils::humanReadableFileSize(m_diff.changedBytes())));
+
+    auto deltaDir = FS::PathCombine(m_stagingPath, ".delta");
+    m_job.reset(new NetJob(tr("Truck pack update download"), APPLICATION->network()));
+    for (int i = 0; i < m_ranges.size(); i++) {
+        auto& range = m_ranges[i];
+        range.path = FS::PathCombine(deltaDir, QString("range-%1.bin").arg(i));
+        auto dl = Net::ApiDownload::makeFile(m_packUrl, range.path);
+        dl->addHeaderProxy(
+            new Net::RawHeaderProxy({ { "Range", "bytes=" + QByteArray::number(range.first) + '-' + QByteArray::number(range.last) } }));
+        dl->addValidator(new Net::ByteRangeValidator(range.last - range.first + 1));
+        m_job->addNetAction(dl);
+    }
+
+    connect(m_job.get(), &NetJob::succeeded, this, [this] {
+        setStatus(tr("Extracting changed files"));
+        auto ranges = m_ranges;
+        auto changed = m_diff.changed;
+        auto staging = m_stagingPath;
+        m_working = true;
+        m_extractFuture = QtConcurrent::run(QThreadPool::globalInstance(), [this, ranges, changed, staging]() -> ExtractResult {
+            auto stagingUrl = QUrl::fromLocalFile(staging);
+            for (auto& entry : changed) {
+                if (m_canceled)
+                    return { true, {} };
+                auto range = std::find_if(ranges.begin(), ranges.end(), [&entry](const ByteRange& r) {
+                    return r.first <= entry.localHeaderOffset && entry.localHeaderOffset <= r.last;
+                });
+                if (range == ranges.end())
+                    return { false, tr("No downloaded data for %1").arg(entry.path) };
+
+                auto target = FS::PathCombine(staging, entry.path);
+                if (!stagingUrl.isParentOf(QUrl::fromLocalFile(target)))
+                    return { false, tr("%1 is outside of the instance folder").arg(entry.path) };
+
+                QFile source(range->path);
+                if (!source.open(QIODevice::ReadOnly) || !source.seek(entry.localHeaderOffset - range->first))
+                    return { false, tr("Could not read the downloaded data for %1").arg(entry.path) };
+                if (auto error = inflateEntry(source, entry, target))
+                    return { false, error };
+            }
+            return {};
+        });
+        m_extractWatcher.setFuture(m_extractFuture);
+    });
+    connect(m_job.get(), &NetJob::failed, this, &DeltaUpdateTask::emitFailed);
+    connect(m_job.get(), &NetJob::aborted, this, &DeltaUpdateTask::emitAborted);
+    connect(m_job.get(), &NetJob::progress, this, &DeltaUpdateTask::setProgress);
+    connect(m_job.get(), &NetJob::stepProgress, this, &DeltaUpdateTask::propagateStepProgress);
+    m_job->start();
+}
+
+void DeltaUpdateTask::downloadWholeArchive()
+{
+    setStatus(tr("Downloading modpack:\n%1").arg(m_packUrl.toString()));
+
+    const QString path(m_packUrl.host() + '/' + m_packUrl.path());
+    auto entry = APPLICATION->metacache()->resolveEntry("general", path);
+    entry->setStale(true);
+    m_cachePath = entry->getFullPath();
+
+    m_job.reset(new NetJob(tr("Modpack download"), APPLICATION->network()));
+    m_job->addNetAction(Net::ApiDownload::makeCached(m_packUrl, entry, Net::Download::Option::Resumable));
+
+    connect(m_job.get(), &NetJob::succeeded, this, [this] {
+        QuaZip zip(m_cachePath);
+        if (!zip.open(QuaZip::mdUnzip)) {
+            emitFailed(tr("Unable to open supplied modpack zip file."));
+            return;
+        }
+        auto target = PackIndex::fromZip(&zip);
+        if (!target) {
+            failReinstall(tr("This pack can't be updated in place."));
+            return;
+        }
+        m_target = *target;
+        startDiff();
+    });
+    connect(m_job.get(), &NetJob::failed, this, &DeltaUpdateTask::emitFailed);
+    connect(m_job.get(), &NetJob::aborted, this, &DeltaUpdateTask::emitAborted);
+    connect(m_job.get(), &NetJob::progress, this, &DeltaUpdateTask::setProgress);
+    connect(m_job.get(), &NetJob::stepProgress, this, &DeltaUpdateTask::propagateStepProgress);
+    m_job->start();
+}
+
+void DeltaUpdateTask::wholeArchiveDownloaded()
+{
+    setStatus(tr("Extracting changed files"));
+
+    QSet<QString> wanted;
+    for (auto& entry : m_diff.changed)
+        wanted.insert(m_target.root + entry.path);
+
+    auto archive = m_cachePath;
+    auto staging = m_stagingPath;
+    auto root = m_target.root;
+    m_working = true;
+    m_extractFuture = QtConcurrent::run(QThreadPool::globalInstance(), [this, wanted, archive, staging, root]() -> ExtractResult {
+        QuaZip zip(archive);
+        if (!zip.open(QuaZip::mdUnzip))
+            return { false, tr("Unable to open supplied modpack zip file.") };
+
+        // one pass over the central directory instead of a lookup per changed file
+        auto stagingUrl = QUrl::fromLocalFile(staging);
+        for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
+            if (m_canceled)
+                return { true, {} };
+            auto name = zip.getCurrentFileName();
+            if (!wanted.contains(name))
+                continue;
+
+            auto target = FS::PathCombine(staging, name.mid(root.size()));
+            if (!stagingUrl.isParentOf(QUrl::fromLocalFile(target)))
+                return { false, tr("%1 is outside of the instance folder").arg(name) };
+            FS::ensureFilePathExists(target);
+            if (!JlCompress::extractFile(&zip, "", target))
+                return { false, tr("Failed to extract file %1 to %2").arg(name, target) };
+        }
+        return {};
+    });
+    m_extractWatcher.setFuture(m_extractFuture);
+}
+
+void DeltaUpdateTask::extractFinished()
+{
+    m_working = false;
+    if (!isRunning())
+        return;
+    // only a worker that went through every file may get the update committed
+    auto result = m_extractFuture.isCanceled() ? ExtractResult{ true, {} } : m_extractFuture.result();
+    if (result.canceled) {
+        emitAborted();
+        return;
+    }
+    if (result.error) {
+        emitFailed(*result.error);
+        return;
+    }
+    snapshotInstance();
+}
+
+void DeltaUpdateTask::snapshotInstance()
+{
+    // past this point we are touching the live instance, keep its current state around for a rollback
+    setAbortable(false);
+    setStatus(tr("Saving the current state of %1").arg(m_instance->name()));
+
+    auto instances = APPLICATION->instances();
+    auto id = m_instance->id();
+    m_snapshotFuture = QtConcurrent::run(QThreadPool::globalInstance(), [instances, id] { return instances->snapshotInstance(id); });
+    m_snapshotWatcher.setFuture(m_snapshotFuture);
+}
+
+void DeltaUpdateTask::snapshotFinished()
+{
+    if (!m_snapshotFuture.result())
+        logWarning(tr("The previous version could not be kept, this update can't be rolled back."));
+    storeChangedFiles();
+}
+
+void DeltaUpdateTask::storeChangedFiles()
+{
+    FS::deletePath(FS::PathCombine(m_stagingPath, ".delta"));
+
+    // unlink the outdated files first: they may be links into the file store, which must not be overwritten in place
+    QStringList shareable;
+    for (auto& entry : m_diff.changed) {
+        if (entry.path == "instance.cfg")
+            continue;
+        QFile::remove(FS::PathCombine(m_instance->instanceRoot(), entry.path));
+        if (FileStore::isShareable(entry.path))
+            shareable.append(entry.path);
+    }
+
+    auto storeRoot = APPLICATION->metacache()->getBasePath("TruckPackStore");
+    if (storeRoot.isEmpty() || shareable.isEmpty()) {
+        finishUpdate();
+        return;
+    }
+
+    auto storeTask = makeShared<StoreFilesTask>(storeRoot, m_stagingPath, m_instance->instanceRoot(), shareable);
+    connect(storeTask.get(), &Task::finished, this, [this, task = storeTask.get()] {
+        // files that couldn't be stored were still moved into the instance
+        if (!task->wasSuccessful())
+            qWarning() << "DeltaUpdateTask: could not move pack files into the shared store:" << task->failReason();
+        finishUpdate();
+    });
+    connect(storeTask.get(), &Task::status, this, &DeltaUpdateTask::setStatus);
+    connect(storeTask.get(), &Task::progress, this, &DeltaUpdateTask::setProgress);
+    m_storeTask.reset(storeTask);
+    storeTask->start();
+}
+
+void DeltaUpdateTask::finishUpdate()
+{
+
+    // merge the pack's new instance.cfg into the existing settings instead of replacing them
+    auto stagedConfig = FS::PathCombine(m_stagingPath, "instance.cfg");
+    if (QFileInfo::exists(stagedConfig)) {
+        INIFile packConfig;
+        if (packConfig.loadFile(stagedConfig)) {
+            auto settings = m_instance->settings();
+            // memory set by the user wins over the pack's recommendation
+            bool userMemory = settings->get("OverrideMemory").toBool();
+            for (auto it = packConfig.constBegin(); it != packConfig.constEnd(); ++it) {
+                if (s_preservedSettings.contains(it.key()))
+                    continue;
+                if (userMemory && it.key().endsWith("MemAlloc"))
+                    continue;
+                if (settings->contains(it.key()))
+                    settings->set(it.key(), it.value());
+            }
+        }
+        QFile::remove(stagedConfig);
+    }
+
+    bool removeFailed = false;
+    for (auto& path : m_diff.removed) {
+        auto file = FS::PathCombine(m_instance->instanceRoot(), path);
+        qDebug() << "DeltaUpdateTask: removing" << file;
+        if (!QFile::remove(file)) {
+            qWarning() << "DeltaUpdateTask: could not remove" << file;
+            removeFailed = true;
+        }
+    }
+    if (removeFailed)
+        logWarning(tr("Some files from the previous pack version could not be removed."));
+
+    // the committed index is copied over the live one, which may be shared with the rollback
+    QFile::remove(indexPathFor(m_instance->instanceRoot()));
+    if (!m_target.save(indexPathFor(m_stagingPath))) {
+        emitFailed(tr("Failed to save the pack index."));
+        return;
+    }
+
+    // its files were moved out, the pre-stage can't serve another update
+    if (!m_prestagePath.isEmpty())
+        FS::deletePath(m_prestagePath);
+
+    setOverride(true, m_instance->id());
+    emitSucceeded();
+}
+
+void DeltaUpdateTask::failReinstall(const QString& reason)
+{
+    m_shouldReinstall = true;
+    emitFailed(reason);
+}
+
+}  // namespace TruckPack
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QUrl>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "BaseInstance.h"
+#include "InstanceTask.h"
+#include "net/ByteRangeValidator.h"
+#include "net/NetJob.h"
+
+#include "TruckPackIndex.h"
+
+namespace TruckPack {
+
+/**
+ * Updates an installed truck pack instance to a new pack version by only replacing what changed.
+ *
+ * The central directory of the new pack is fetched with HTTP range requests and compared against the
+ * instance's saved pack index (or the files on disk). Only the changed entries are downloaded and inflated
+ * into the staging folder, which is then committed over the existing instance. Files the old pack version
+ * owned but the new one doesn't are removed; everything else (user data, unchanged mods) stays in place.
+ *
+ * If the server doesn't support range requests, the whole archive is downloaded once and only the changed
+ * entries are extracted from it.
+ */
+class DeltaUpdateTask : public InstanceTask {
+    Q_OBJECT
+   public:
+    DeltaUpdateTask(InstancePtr instance, QUrl packUrl, QString packName, QString packVersion);
+    ~DeltaUpdateTask() override = default;
+
+    bool abort() override;
+
+    QString packName() const { return m_packName; }
+    QString packVersion() const { return m_packVersion; }
+    /** Path of the downloaded archive, if the full-archive fallback was used. */
+    QString cachePath() const { return m_cachePath; }
+
+    /** Whether this pack can't be delta updated at all, and must be reinstalled from scratch instead. */
+    bool shouldReinstall() const { return m_shouldReinstall; }
+
+   protected:
+    void executeTask() override;
+
+   private:
+    void fetchTail();
+    void fetchCentralDirectory(const CentralDirectoryLocation& location);
+    void targetIndexReady(const QList<PackEntry>& archiveEntries);
+    void startDiff();
+    void diffFinished();
+    void downloadChangedRanges();
+    void takePrestagedFiles();
+    void extractFinished();
+    void snapshotInstance();
+    void snapshotFinished();
+    void storeChangedFiles();
+    void finishUpdate();
+
+    void downloadWholeArchive();
+    void wholeArchiveDownloaded();
+
+    void failReinstall(const QString& reason);
+
+    struct ByteRange {
+        qint64 first = 0;
+        qint64 last = 0;  // inclusive
+        QString path;
+    };
+    struct ExtractResult {
+        bool canceled = false;
+        std::optional<QString> error;
+    };
+
+   private:
+    InstancePtr m_instance;
+    QUrl m_packUrl;
+    QString m_packName;
+    QString m_packVersion;
+    QString m_cachePath;
+    QString m_prestagePath;
+    bool m_shouldReinstall = false;
+
+    PackIndex m_installed;
+    PackIndex m_target;
+    PackDiff m_diff;
+    QList<ByteRange> m_ranges;
+
+    std::shared_ptr<QByteArray> m_tail;
+    std::shared_ptr<QByteArray> m_centralDirectory;
+    Net::ByteRangeValidator* m_rangeValidator = nullptr;
+
+    NetJob::Ptr m_job;
+    Task::Ptr m_storeTask;
+    QFuture<PackDiff> m_diffFuture;
+    QFutureWatcher<PackDiff> m_diffWatcher;
+    // a diff or extract worker holds this and the staging folder, aborting has to wait for it to stop
+    bool m_working = false;
+    // set on the GUI thread, polled by the extract workers and checked once the diff is done
+    std::atomic<bool> m_canceled = false;
+    QFuture<ExtractResult> m_extractFuture;
+    QFutureWatcher<ExtractResult> m_extractWatcher;
+    QFuture<bool> m_snapshotFuture;
+    QFutureWatcher<bool> m_snapshotWatcher;
+};
+
+}  // namespace TruckPack
@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TruckPackFileStore.h"
+
+#include <QDebug>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <filesystem>
+
+#include "FileSystem.h"
+#include "Json.h"
+#include "StringUtils.h"
+#include "modplatform/helpers/HashUtils.h"
+
+namespace fs = std::filesystem;
+
+namespace TruckPack {
+
+namespace {
+const QStringList s_shareableSuffixes = { "jar", "zip", "litemod" };
+
+QString refsPathFor(const QString& instanceRoot)
+{
+    return FS::PathCombine(instanceRoot, "truckpack", "store.json");
+}
+}  // namespace
+
+StoreRefs StoreRefs::load(const QString& instanceRoot)
+{
+    StoreRefs refs;
+    auto path = refsPathFor(instanceRoot);
+    if (!QFileInfo::exists(path))
+        return refs;
+
+    try {
+        auto root = Json::requireObject(Json::requireDocument(path, "truck pack store references"), "truck pack store references");
+        auto files = Json::requireObject(root, "files");
+        for (auto it = files.constBegin(); it != files.constEnd(); ++it)
+            refs.files.insert(it.key(), Json::requireString(it.value()));
+    } catch (const Json::JsonException& e) {
+        qWarning() << "Failed to read truck pack store references" << path << ":" << e.cause();
+    }
+    return refs;
+}
+
+bool StoreRefs::save(const QString& instanceRoot) const
+{
+    QJsonObject files;
+    for (auto it = this->files.constBegin(); it != this->files.constEnd(); ++it)
+        files.insert(it.key(), it.value());
+
+    QJsonObject root;
+    root.insert("formatVersion", 1);
+    root.insert("files", files);
+
+    auto path = refsPathFor(instanceRoot);
+    try {
+        FS::ensureFilePathExists(path);
+        Json::write(root, path);
+    } catch (const Exception& e) {
+        qWarning() << "Failed to write truck pack store references" << path << ":" << e.cause();
+        return false;
+    }
+    return true;
+}
+
+FileStore::FileStore(QString root) : m_root(std::move(root)) {}
+
+bool FileStore::isShareable(const QString& relativePath)
+{
+    return s_shareableSuffixes.contains(QFileInfo(relativePath).suffix().toLower());
+}
+
+QString FileStore::objectPath(const QString& hash) const
+{
+    return FS::PathCombine(m_root, hash.left(2), hash);
+}
+
+bool FileStore::linkObject(const QString& object, const QString& target) const
+{
+    FS::ensureFilePathExists(target);
+
+    std::error_code err;
+    if (FS::canClone(object, target) && FS::clone_file(object, target, err))
+        return true;
+
+    err.clear();
+    fs::create_hard_link(StringUtils::toStdString(object), StringUtils::toStdString(target), err);
+    return !err;
+}
+
+std::optional<QString> FileStore::adopt(const QString& file, const QString& target)
+{
+    auto keepFile = [&file, &target]() -> std::optional<QString> {
+        if (file != target) {
+            QFile::remove(target);
+            FS::move(file, target);
+        }
+        return std::nullopt;
+    };
+
+    auto hash = Hashing::hash(file, Hashing::Algorithm::Sha1);
+    if (hash.isEmpty())
+        return keepFile();
+
+    auto object = objectPath(hash);
+    if (!QFileInfo::exists(object)) {
+        FS::ensureFilePathExists(object);
+        // stage the object under a temporary name, so a crash can't leave a truncated object behind
+        auto incoming = object + ".part";
+        QFile::remove(incoming);
+        if (!linkObject(file, incoming)) {
+            qDebug() << "TruckPack::FileStore: can't link" << file << "into the store, keeping a private copy";
+            return keepFile();
+        }
+        if (!QFile::rename(incoming, object)) {
+            QFile::remove(incoming);
+            return keepFile();
+        }
+    }
+
+    // link next to the target first, and only replace it once that worked
+    auto linked = target + ".tpstore";
+    QFile::remove(linked);
+    if (!linkObject(object, linked))
+        return keepFile();
+
+    QFile::remove(target);
+    if (!QFile::rename(linked, target)) {
+        QFile::remove(linked);
+        return keepFile();
+    }
+    if (file != target)
+        QFile::remove(file);
+    return hash;
+}
+
+int FileStore::collectGarbage(const QStringList& instanceRoots) const
+{
+    if (!QFileInfo::exists(m_root))
+        return 0;
+
+    // an object is referenced by every instance file that was materialized from it and wasn't replaced since
+    QHash<QString, int> refCounts;
+    for (auto& instanceRoot : instanceRoots) {
+        auto refs = StoreRefs::load(instanceRoot);
+        for (auto it = refs.files.constBegin(); it != refs.files.constEnd(); ++it) {
+            QFileInfo instanceFile(FS::PathCombine(instanceRoot, it.key()));
+            QFileInfo object(objectPath(it.value()));
+            if (instanceFile.isFile() && object.exists() && instanceFile.size() == object.size())
+                refCounts[it.value()]++;
+        }
+    }
+
+    int removed = 0;
+    QDirIterator it(m_root, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        auto path = it.next();
+        auto name = it.fileInfo().fileName();
+        if (refCounts.value(name) > 0)
+            continue;
+        if (QFile::remove(path)) {
+            removed++;
+        } else {
+            qWarning() << "TruckPack::FileStore: failed to remove unused object" << path;
+        }
+    }
+    qDebug() << "TruckPack::FileStore: removed" << removed << "unused objects," << refCounts.size() << "still in use";
+    return removed;
+}
+
+StoreFilesTask::StoreFilesTask(QString storeRoot, QString sourceRoot, QString targetRoot, QStringList paths)
+    : m_storeRoot(std::move(storeRoot))
+    , m_sourceRoot(std::move(sourceRoot))
+    , m_targetRoot(std::move(targetRoot))
+    , m_paths(std::move(paths))
+{
+    connect(&m_watcher, &QFutureWatcher<StoreResult>::finished, this, &StoreFilesTask::storeFinished);
+}
+
+bool StoreFilesTask::abort()
+{
+    if (m_storing) {
+        m_canceled = true;
+        // NOTE: emitAborted() happens once the worker actually stops
+        return true;
+    }
+    return Task::abort();
+}
+
+void StoreFilesTask::executeTask()
+{
+    setStatus(tr("Sharing pack files between instances"));
+
+    m_storing = true;
+    m_canceled = false;
+    m_future = QtConcurrent::run(QThreadPool::globalInstance(), [this]() -> StoreResult {
+        FileStore store(m_storeRoot);
+        auto refs = StoreRefs::load(m_targetRoot);
+        int done = 0;
+        for (auto& path : m_paths) {
+            if (m_canceled)
+                return { true, refs };
+            refs.files.remove(path);
+            if (auto hash = store.adopt(FS::PathCombine(m_sourceRoot, path), FS::PathCombine(m_targetRoot, path)))
+                refs.files.insert(path, *hash);
+            QMetaObject::invokeMethod(this, [this, done = ++done] { setProgress(done, m_paths.size()); }, Qt::QueuedConnection);
+        }
+        return { false, refs };
+    });
+    m_watcher.setFuture(m_future);
+}
+
+void StoreFilesTask::storeFinished()
+{
+    m_storing = false;
+    if (m_future.isCanceled()) {
+        emitAborted();
+        return;
+    }
+    // the files adopted before a cancel are backed by the store all the same, so their references are saved either way
+    auto result = m_future.result();
+    qDebug() << "TruckPack::StoreFilesTask:" << result.refs.files.size() << "files of" << m_targetRoot << "are backed by the store";
+    if (!result.refs.save(m_targetRoot))
+        logWarning(tr("Could not save which files are shared with other instances."));
+    if (result.canceled) {
+        emitAborted();
+        return;
+    }
+    emitSucceeded();
+}
+
+StoreGCTask::StoreGCTask(QString storeRoot, QStringList instanceRoots)
+    : m_storeRoot(std::move(storeRoot)), m_instanceRoots(std::move(instanceRoots))
+{
+    connect(&m_watcher, &QFutureWatcher<int>::finished, this, &StoreGCTask::emitSucceeded);
+}
+
+void StoreGCTask::executeTask()
+{
+    setStatus(tr("Removing pack files no instance uses anymore"));
+
+    m_future = QtConcurrent::run(QThreadPool::globalInstance(), [storeRoot = m_storeRoot, instanceRoots = m_instanceRoots] {
+        // pooled threads get reused, so the priority has to go back to what it was
+        auto thread = QThread::currentThread();
+        auto priority = thread->priority();
+        if (priority == QThread::InheritPriority)
+            priority = QThread::NormalPriority;
+        thread->setPriority(QThread::IdlePriority);
+
+        auto removed = FileStore(storeRoot).collectGarbage(instanceRoots);
+
+        thread->setPriority(priority);
+        return removed;
+    });
+    m_watcher.setFuture(m_future);
+}
+
+}  // namespace TruckPack
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <optional>
+
+#include "tasks/Task.h"
+
+namespace TruckPack {
+
+/**
+ * Which store objects the files of an instance were materialized from.
+ *
+ * Saved inside each instance, so the references go away together with the instance folder.
+ */
+struct StoreRefs {
+    QHash<QString, QString> files;  // path relative to the instance -> object hash
+
+    static StoreRefs load(const QString& instanceRoot);
+    bool save(const QString& instanceRoot) const;
+};
+
+/**
+ * Content-addressed store for the large files truck packs ship (mods, resource packs, libraries).
+ *
+ * Each distinct file is kept once, named after its SHA-1. Instances get a reflink of the object where the
+ * filesystem supports it, a hard link otherwise, and keep their own copy if neither is possible (e.g. the
+ * store lives on a different drive). Objects are only removed by collectGarbage() once no instance
+ * references them anymore.
+ *
+ * Only archives are shared: they get replaced by updates, not edited in place, so a hard link never ends
+ * up modifying the copy another instance uses.
+ */
+class FileStore {
+   public:
+    explicit FileStore(QString root);
+
+    /** Whether a pack file at this instance-relative path may be shared through the store. */
+    static bool isShareable(const QString& relativePath);
+
+    QString objectPath(const QString& hash) const;
+
+    /**
+     * Put \p file into the store and replace \p target with a link to the stored object.
+     *
+     * \p file and \p target may be the same path. If the file can't be linked to the store, it is moved to
+     * \p target unchanged and nullopt is returned.
+     *
+     * \return the hash of the stored object
+     */
+    std::optional<QString> adopt(const QString& file, const QString& target);
+
+    /**
+     * Remove objects that none of the given instances reference anymore.
+     *
+     * \return how many objects were removed
+     */
+    int collectGarbage(const QStringList& instanceRoots) const;
+
+   private:
+    bool linkObject(const QString& object, const QString& target) const;
+
+   private:
+    QString m_root;
+};
+
+/** Moves the shareable files of a truck pack instance into the store, off the main thread. */
+class StoreFilesTask : public Task {
+    Q_OBJECT
+   public:
+    /**
+     * \param sourceRoot where the files currently are (e.g. a staging folder)
+     * \param targetRoot where the linked files should end up, and whose store references get updated
+     * \param paths the files to store, relative to both roots
+     */
+    StoreFilesTask(QString storeRoot, QString sourceRoot, QString targetRoot, QStringList paths);
+
+    bool canAbort() const override { return true; }
+    bool abort() override;
+
+   protected:
+    void executeTask() override;
+
+   private:
+    void storeFinished();
+
+   private:
+    QString m_storeRoot;
+    QString m_sourceRoot;
+    QString m_targetRoot;
+    QStringList m_paths;
+
+    struct StoreResult {
+        bool canceled = false;
+        StoreRefs refs;
+    };
+    bool m_storing = false;
+    // set on the GUI thread, polled by the worker
+    std::atomic<bool> m_canceled = false;
+    QFuture<StoreResult> m_future;
+    QFutureWatcher<StoreResult> m_watcher;
+};
+
+/** Removes the store objects none of the given instances use anymore, on a low priority worker thread. */
+class StoreGCTask : public Task {
+    Q_OBJECT
+   public:
+    StoreGCTask(QString storeRoot, QStringList instanceRoots);
+
+   protected:
+    void executeTask() override;
+
+   private:
+    QString m_storeRoot;
+    QStringList m_instanceRoots;
+
+    QFuture<int> m_future;
+    QFutureWatcher<int> m_watcher;
+};
+
+}  // namespace TruckPack
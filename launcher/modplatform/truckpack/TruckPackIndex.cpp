@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TruckPackIndex.h"
+
+#include <quazip/quazip.h>
+#include <zlib.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <algorithm>
+
+#include "FileSystem.h"
+#include "Json.h"
+
+namespace TruckPack {
+
+namespace {
+constexpr quint32 EOCD_SIGNATURE = 0x06054b50;
+constexpr quint32 ZIP64_EOCD_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr quint32 ZIP64_EOCD_SIGNATURE = 0x06064b50;
+constexpr quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+
+constexpr int EOCD_SIZE = 22;
+constexpr int ZIP64_EOCD_LOCATOR_SIZE = 20;
+constexpr int ZIP64_EOCD_SIZE = 56;
+constexpr int CENTRAL_HEADER_SIZE = 46;
+
+template <typename T>
+T readLE(const QByteArray& data, qint64 pos)
+{
+    return qFromLittleEndian<T>(reinterpret_cast<const uchar*>(data.constData() + pos));
+}
+
+bool isSafeRelativePath(const QString& path)
+{
+    if (path.isEmpty() || path.startsWith('/') || path.contains('\\') || QFileInfo(path).isAbsolute())
+        return false;
+    const auto parts = path.split('/');
+    return std::none_of(parts.begin(), parts.end(), [](const QString& part) { return part == ".."; });
+}
+}  // namespace
+
+std::optional<CentralDirectoryLocation> locateCentralDirectory(const QByteArray& tail, qint64 tailOffset)
+{
+    // the record sits at the very end, followed only by a comment of at most 64KiB
+    qint64 eocd = -1;
+    for (qint64 pos = tail.size() - EOCD_SIZE; pos >= 0; pos--) {
+        if (readLE<quint32>(tail, pos) == EOCD_SIGNATURE && pos + EOCD_SIZE + readLE<quint16>(tail, pos + 20) <= tail.size()) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        qWarning() << "Could not find the end of central directory record";
+        return std::nullopt;
+    }
+
+    CentralDirectoryLocation location;
+    location.entryCount = readLE<quint16>(tail, eocd + 10);
+    location.size = readLE<quint32>(tail, eocd + 12);
+    location.offset = readLE<quint32>(tail, eocd + 16);
+
+    bool needsZip64 = location.entryCount == 0xFFFF || location.size == 0xFFFFFFFF || location.offset == 0xFFFFFFFF;
+    qint64 locator = eocd - ZIP64_EOCD_LOCATOR_SIZE;
+    if (locator >= 0 && readLE<quint32>(tail, locator) == ZIP64_EOCD_LOCATOR_SIGNATURE) {
+        auto record = static_cast<qint64>(readLE<quint64>(tail, locator + 8)) - tailOffset;
+        if (record < 0 || record + ZIP64_EOCD_SIZE > tail.size() || readLE<quint32>(tail, record) != ZIP64_EOCD_SIGNATURE) {
+            qWarning() << "The zip64 end of central directory record is outside of the fetched data";
+            return std::nullopt;
+        }
+        location.entryCount = static_cast<qint64>(readLE<quint64>(tail, record + 32));
+        location.size = static_cast<qint64>(readLE<quint64>(tail, record + 40));
+        location.offset = static_cast<qint64>(readLE<quint64>(tail, record + 48));
+    } else if (needsZip64) {
+        qWarning() << "Archive needs zip64 records but doesn't have them";
+        return std::nullopt;
+    }
+
+    return location;
+}
+
+std::optional<QList<PackEntry>> parseCentralDirectory(const QByteArray& data, const CentralDirectoryLocation& location)
+{
+    QList<PackEntry> entries;
+    entries.reserve(location.entryCount);
+
+    qint64 pos = 0;
+    for (qint64 i = 0; i < location.entryCount; i++) {
+        if (pos + CENTRAL_HEADER_SIZE > data.size() || readLE<quint32>(data, pos) != CENTRAL_HEADER_SIGNATURE) {
+            qWarning() << "Malformed central directory header at" << pos;
+            return std::nullopt;
+        }
+
+        PackEntry entry;
+        entry.flags = readLE<quint16>(data, pos + 8);
+        entry.method = readLE<quint16>(data, pos + 10);
+        entry.crc32 = readLE<quint32>(data, pos + 16);
+        entry.compressedSize = readLE<quint32>(data, pos + 20);
+        entry.size = readLE<quint32>(data, pos + 24);
+        auto nameLength = readLE<quint16>(data, pos + 28);
+        auto extraLength = readLE<quint16>(data, pos + 30);
+        auto commentLength = readLE<quint16>(data, pos + 32);
+        entry.localHeaderOffset = readLE<quint32>(data, pos + 42);
+
+        qint64 nameStart = pos + CENTRAL_HEADER_SIZE;
+        qint64 extraStart = nameStart + nameLength;
+        qint64 next = extraStart + extraLength + commentLength;
+        if (next > data.size()) {
+            qWarning() << "Truncated central directory entry at" << pos;
+            return std::nullopt;
+        }
+
+        auto rawName = data.mid(nameStart, nameLength);
+        // bit 11: name is UTF-8. Everything else is supposedly CP437, which nobody actually uses for packs.
+        entry.path = (entry.flags & (1 << 11)) ? QString::fromUtf8(rawName) : QString::fromLocal8Bit(rawName);
+
+        // zip64 extended information replaces the fields that overflowed, in this order
+        for (qint64 extra = extraStart; extra + 4 <= extraStart + extraLength;) {
+            auto id = readLE<quint16>(data, extra);
+            auto size = readLE<quint16>(data, extra + 2);
+            if (id == 0x0001) {
+                qint64 field = extra + 4;
+                auto readField = [&](qint64& target) {
+                    if (field + 8 <= extra + 4 + size) {
+                        target = static_cast<qint64>(readLE<quint64>(data, field));
+                        field += 8;
+                    }
+                };
+                if (entry.size == 0xFFFFFFFF)
+                    readField(entry.size);
+                if (entry.compressedSize == 0xFFFFFFFF)
+                    readField(entry.compressedSize);
+                if (entry.localHeaderOffset == 0xFFFFFFFF)
+                    readField(entry.localHeaderOffset);
+            }
+            extra += 4 + size;
+        }
+
+        entries.append(entry);
+        pos = next;
+    }
+
+    // an entry's data ends where the next entry begins, which is what we need to fetch it alone
+    QList<PackEntry*> byOffset;
+    for (auto& entry : entries)
+        byOffset.append(&entry);
+    std::sort(byOffset.begin(), byOffset.end(), [](auto* a, auto* b) { return a->localHeaderOffset < b->localHeaderOffset; });
+    for (int i = 0; i < byOffset.size(); i++)
+        byOffset[i]->nextHeaderOffset = i + 1 < byOffset.size() ? byOffset[i + 1]->localHeaderOffset : location.offset;
+
+    return entries;
+}
+
+std::optional<PackIndex> PackIndex::fromEntries(const QList<PackEntry>& archiveEntries)
+{
+    PackIndex index;
+
+    // the pack root is wherever the shallowest instance.cfg is
+    int rootDepth = -1;
+    bool foundConfig = false;
+    for (auto& entry : archiveEntries) {
+        if (entry.path != "instance.cfg" && !entry.path.endsWith("/instance.cfg"))
+            continue;
+        int depth = entry.path.count('/');
+        if (!foundConfig || depth < rootDepth) {
+            foundConfig = true;
+            rootDepth = depth;
+            index.root = entry.path.chopped(QString("instance.cfg").size());
+        }
+    }
+    if (!foundConfig) {
+        qWarning() << "Archive is not a MultiMC-style pack, it has no instance.cfg";
+        return std::nullopt;
+    }
+
+    for (auto entry : archiveEntries) {
+        if (entry.path.endsWith('/') || !entry.path.startsWith(index.root))
+            continue;
+        entry.path = entry.path.mid(index.root.size());
+        if (!isSafeRelativePath(entry.path)) {
+            qWarning() << "Refusing pack with an entry outside of the instance:" << entry.path;
+            return std::nullopt;
+        }
+        index.entries.insert(entry.path, entry);
+    }
+    return index;
+}
+
+std::optional<PackIndex> PackIndex::fromZip(QuaZip* zip)
+{
+    QList<PackEntry> entries;
+    for (auto& info : zip->getFileInfoList64()) {
+        PackEntry entry;
+        entry.path = info.name;
+        entry.crc32 = info.crc;
+        entry.size = info.uncompressedSize;
+        entry.compressedSize = info.compressedSize;
+        entry.method = info.method;
+        entry.flags = info.flags;
+        entries.append(entry);
+    }
+    return fromEntries(entries);
+}
+
+std::optional<PackIndex> PackIndex::load(const QString& path)
+{
+    if (!QFileInfo::exists(path))
+        return std::nullopt;
+
+    try {
+        auto root = Json::requireObject(Json::requireDocument(path, "truck pack index"), "truck pack index");
+        if (Json::requireInteger(root, "formatVersion") != 1) {
+            qWarning() << "Unsupported truck pack index version in" << path;
+            return std::nullopt;
+        }
+
+        PackIndex index;
+        index.root = Json::ensureString(root, "root");
+        for (auto value : Json::requireArray(root, "files")) {
+            auto obj = Json::requireObject(value);
+            PackEntry entry;
+            entry.path = Json::requireString(obj, "path");
+            entry.crc32 = static_cast<quint32>(Json::requireDouble(obj, "crc32"));
+            entry.size = static_cast<qint64>(Json::requireDouble(obj, "size"));
+            if (!isSafeRelativePath(entry.path))
+                continue;
+            index.entries.insert(entry.path, entry);
+        }
+        return index;
+    } catch (const Json::JsonException& e) {
+        qWarning() << "Failed to read truck pack index" << path << ":" << e.cause();
+        return std::nullopt;
+    }
+}
+
+bool PackIndex::save(const QString& path) const
+{
+    QJsonArray files;
+    for (auto& entry : entries) {
+        QJsonObject obj;
+        obj.insert("path", entry.path);
+        obj.insert("crc32", static_cast<double>(entry.crc32));
+        obj.insert("size", static_cast<double>(entry.size));
+        files.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("formatVersion", 1);
+    root.insert("root", this->root);
+    root.insert("files", files);
+
+    try {
+        FS::ensureFilePathExists(path);
+        Json::write(root, path);
+    } catch (const Exception& e) {
+        qWarning() << "Failed to write truck pack index" << path << ":" << e.cause();
+        return false;
+    }
+    return true;
+}
+
+qint64 PackDiff::changedBytes() const
+{
+    qint64 total = 0;
+    for (auto& entry : changed)
+        total += entry.compressedSize;
+    return total;
+}
+
+PackDiff computeDiff(const PackIndex& installed, const PackIndex& target, const QString& instanceRoot)
+{
+    PackDiff diff;
+
+    for (auto& entry : target.entries) {
+        // the launcher rewrites instance.cfg all the time, so only the pack's own version of it matters
+        if (entry.path == "instance.cfg") {
+            auto old = installed.entries.constFind(entry.path);
+            if (old != installed.entries.constEnd() && old->sameContentAs(entry))
+                diff.unchangedCount++;
+            else
+                diff.changed.append(entry);
+            continue;
+        }
+
+        QFileInfo local(FS::PathCombine(instanceRoot, entry.path));
+        if (!local.isFile() || local.size() != entry.size) {
+            diff.changed.append(entry);
+            continue;
+        }
+
+        auto old = installed.entries.constFind(entry.path);
+        if (old != installed.entries.constEnd() && old->sameContentAs(entry)) {
+            diff.unchangedCount++;
+            continue;
+        }
+
+        auto crc = fileCrc32(local.absoluteFilePath());
+        if (crc && *crc == entry.crc32)
+            diff.unchangedCount++;
+        else
+            diff.changed.append(entry);
+    }
+
+    for (auto& entry : installed.entries) {
+        if (!target.entries.contains(entry.path) && QFileInfo::exists(FS::PathCombine(instanceRoot, entry.path)))
+            diff.removed.append(entry.path);
+    }
+
+    return diff;
+}
+
+QString indexPathFor(const QString& instanceRoot)
+{
+    return FS::PathCombine(instanceRoot, "truckpack", "index.json");
+}
+
+std::optional<quint32> fileCrc32(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    qint64 read;
+    while ((read = file.read(buffer.data(), buffer.size())) > 0)
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(buffer.constData()), static_cast<uInt>(read));
+    if (read < 0)
+        return std::nullopt;
+    return static_cast<quint32>(crc);
+}
+
+}  // namespace TruckPack
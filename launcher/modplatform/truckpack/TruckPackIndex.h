@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+class QuaZip;
+
+namespace TruckPack {
+
+/** A single file of a truck pack archive, as described by the zip central directory. */
+struct PackEntry {
+    QString path;  // relative to the pack root, i.e. to the instance folder
+    quint32 crc32 = 0;
+    qint64 size = 0;
+    qint64 compressedSize = 0;
+    quint16 method = 0;              // 0 = stored, 8 = deflate
+    quint16 flags = 0;               // general purpose bit flags
+    qint64 localHeaderOffset = -1;   // only known when read from raw central directory bytes
+    qint64 nextHeaderOffset = -1;    // where the next local header (or the central directory) starts
+
+    bool sameContentAs(const PackEntry& other) const { return crc32 == other.crc32 && size == other.size; }
+};
+
+/** Where the central directory of an archive lives, as told by its end of central directory record. */
+struct CentralDirectoryLocation {
+    qint64 offset = 0;
+    qint64 size = 0;
+    qint64 entryCount = 0;
+};
+
+/**
+ * Find the end of central directory record (zip64 aware) in the last bytes of an archive.
+ *
+ * \param tail the last bytes of the archive
+ * \param tailOffset the offset of the first byte of \p tail inside the archive
+ */
+std::optional<CentralDirectoryLocation> locateCentralDirectory(const QByteArray& tail, qint64 tailOffset);
+
+/** Parse raw central directory bytes into entries carrying their full in-archive paths. */
+std::optional<QList<PackEntry>> parseCentralDirectory(const QByteArray& data, const CentralDirectoryLocation& location);
+
+/**
+ * The list of files a truck pack puts into an instance.
+ *
+ * Saved into each truck pack instance, so the next update knows which files it owns and what they contained.
+ */
+struct PackIndex {
+    QString root;  // folder of the archive holding instance.cfg, stripped from all paths
+    QHash<QString, PackEntry> entries;
+
+    bool isEmpty() const { return entries.isEmpty(); }
+
+    /** Build an index from archive entries. Fails if the archive has no instance.cfg (not a MultiMC-style pack). */
+    static std::optional<PackIndex> fromEntries(const QList<PackEntry>& archiveEntries);
+    static std::optional<PackIndex> fromZip(QuaZip* zip);
+
+    static std::optional<PackIndex> load(const QString& path);
+    bool save(const QString& path) const;
+};
+
+/** What needs to happen to bring an instance from one pack version to the next. */
+struct PackDiff {
+    QList<PackEntry> changed;  // entries of the target index to install
+    QStringList removed;       // paths owned by the installed index that the target doesn't have anymore
+    qint64 unchangedCount = 0;
+
+    qint64 changedBytes() const;
+};
+
+/**
+ * Compare the files in \p instanceRoot against \p target.
+ *
+ * Files are considered up to date when the \p installed index says so and the size on disk still matches,
+ * otherwise their CRC32 is computed. Without an installed index, nothing is ever scheduled for removal.
+ * This touches the disk, so run it off the main thread.
+ */
+PackDiff computeDiff(const PackIndex& installed, const PackIndex& target, const QString& instanceRoot);
+
+/** Location of the saved pack index inside an instance folder. */
+QString indexPathFor(const QString& instanceRoot);
+
+/** CRC32 of a file on disk, or nullopt if it can't be read. */
+std::optional<quint32> fileCrc32(const QString& path);
+
+}  // namespace TruckPack
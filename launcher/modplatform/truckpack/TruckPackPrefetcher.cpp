@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TruckPackPrefetcher.h"
+
+#include <quazip/quazip.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+
+#include "Application.h"
+#include "FileSystem.h"
+#include "InstanceList.h"
+#include "MMCZip.h"
+#include "net/ApiDownload.h"
+
+#include "TruckPackIndex.h"
+
+namespace TruckPack {
+
+namespace Prestage {
+namespace {
+QString packPath(const QString& packName)
+{
+    return FS::PathCombine(APPLICATION->metacache()->getBasePath("TruckPackPrestage"), FS::RemoveInvalidFilenameChars(packName));
+}
+
+QString archivePath(const QString& prestage)
+{
+    return FS::PathCombine(prestage, "pack.zip");
+}
+}  // namespace
+
+QString pathFor(const QString& packName, const QString& packVersion)
+{
+    return FS::PathCombine(packPath(packName), FS::RemoveInvalidFilenameChars(packVersion));
+}
+
+QString filesPath(const QString& prestage)
+{
+    return FS::PathCombine(prestage, "files");
+}
+
+QString indexPath(const QString& prestage)
+{
+    return FS::PathCombine(prestage, "index.json");
+}
+
+bool isComplete(const QString& prestage)
+{
+    return QFileInfo(indexPath(prestage)).isFile() && QFileInfo(filesPath(prestage)).isDir();
+}
+}  // namespace Prestage
+
+PrefetchTask::PrefetchTask(QUrl packUrl, QString packName, QString packVersion)
+    : m_packUrl(std::move(packUrl)), m_packName(std::move(packName)), m_packVersion(std::move(packVersion))
+{
+    m_foregroundCheck.setInterval(2000);
+    connect(&m_foregroundCheck, &QTimer::timeout, this, &PrefetchTask::checkForeground);
+}
+
+bool PrefetchTask::abort()
+{
+    m_foregroundCheck.stop();
+    m_paused = false;
+    if (m_job && m_job->isRunning())
+        return m_job->abort();
+    if (m_extractTask && m_extractTask->isRunning())
+        return m_extractTask->abort();
+    return Task::abort();
+}
+
+void PrefetchTask::executeTask()
+{
+    m_prestage = Prestage::pathFor(m_packName, m_packVersion);
+    if (Prestage::isComplete(m_prestage)) {
+        emitSucceeded();
+        return;
+    }
+
+    // older pre-stages of this pack are of no use anymore
+    QDir packDir(QFileInfo(m_prestage).absolutePath());
+    for (auto& other : packDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (other.absoluteFilePath() != QFileInfo(m_prestage).absoluteFilePath())
+            FS::deletePath(other.absoluteFilePath());
+    }
+
+    m_foregroundCheck.start();
+    download();
+}
+
+void PrefetchTask::download()
+{
+    setStatus(tr("Downloading %1 %2 in the background").arg(m_packName, m_packVersion));
+    m_paused = false;
+
+    auto dl = Net::ApiDownload::makeFile(m_packUrl, Prestage::archivePath(m_prestage), Net::Download::Option::Resumable);
+    Net::HostScheduler::instance()->setBandwidthLimit(Net::Priority::Background,
+                                                      APPLICATION->settings()->get("TruckPackPrefetchRate").toLongLong() * 1024);
+
+    m_job.reset(new NetJob(tr("Truck pack prefetch"), APPLICATION->network()));
+    m_job->setPriority(Net::Priority::Background);
+    m_job->setAskRetry(false);
+    m_job->addNetAction(dl);
+
+    connect(m_job.get(), &NetJob::succeeded, this, &PrefetchTask::downloaded);
+    connect(m_job.get(), &NetJob::failed, this, [this](QString reason) {
+        m_foregroundCheck.stop();
+        emitFailed(reason);
+    });
+    connect(m_job.get(), &NetJob::aborted, this, [this] {
+        // paused jobs keep their partial data, and continue from it later
+        if (m_paused) {
+            setStatus(tr("Waiting for other downloads to finish"));
+            return;
+        }
+        emitAborted();
+    });
+    connect(m_job.get(), &NetJob::progress, this, &PrefetchTask::setProgress);
+    m_job->start();
+}
+
+void PrefetchTask::checkForeground()
+{
+    bool busy = Net::HostScheduler::instance()->isOutranked(Net::Priority::Background);
+    if (busy && !m_paused && m_job && m_job->isRunning()) {
+        qDebug() << "PrefetchTask: pausing the prefetch of" << m_packName << "for other downloads";
+        m_paused = true;
+        m_job->abort();
+    } else if (!busy && m_paused) {
+        qDebug() << "PrefetchTask: resuming the prefetch of" << m_packName;
+        download();
+    }
+}
+
+void PrefetchTask::downloaded()
+{
+    m_foregroundCheck.stop();
+    setStatus(tr("Extracting %1 %2").arg(m_packName, m_packVersion));
+
+    auto archive = Prestage::archivePath(m_prestage);
+    auto zip = std::make_shared<QuaZip>(archive);
+    if (!zip->open(QuaZip::mdUnzip)) {
+        emitFailed(tr("Unable to open supplied modpack zip file."));
+        return;
+    }
+    auto index = PackIndex::fromZip(zip.get());
+    if (!index) {
+        // only packs that can be updated in place have any use for pre-extracted files
+        FS::deletePath(m_prestage);
+        emitFailed(tr("This pack can't be updated in place."));
+        return;
+    }
+    m_index = *index;
+
+    auto target = Prestage::filesPath(m_prestage) + ".part";
+    FS::deletePath(target);
+    auto extractTask = makeShared<MMCZip::ExtractZipTask>(zip, QDir(target), m_index.root);
+    connect(extractTask.get(), &Task::succeeded, this, &PrefetchTask::extracted);
+    connect(extractTask.get(), &Task::failed, this, &PrefetchTask::emitFailed);
+    connect(extractTask.get(), &Task::aborted, this, &PrefetchTask::emitAborted);
+    m_extractTask.reset(extractTask);
+    extractTask->start();
+}
+
+void PrefetchTask::extracted()
+{
+    auto files = Prestage::filesPath(m_prestage);
+    FS::deletePath(files);
+    if (!QDir().rename(files + ".part", files)) {
+        emitFailed(tr("Could not move the pre-extracted files into place."));
+        return;
+    }
+
+    if (!m_index.save(Prestage::indexPath(m_prestage))) {
+        emitFailed(tr("Failed to save the pack index."));
+        return;
+    }
+
+    // the extracted files are all an update needs, the archive goes away with the pre-stage otherwise
+    QFile::remove(Prestage::archivePath(m_prestage));
+    qDebug() << "PrefetchTask:" << m_packName << m_packVersion << "is ready in" << m_prestage;
+    emitSucceeded();
+}
+
+Prefetcher::Prefetcher(TruckPackVersionManager* versions, QObject* parent) : QObject(parent), m_versions(versions)
+{
+    connect(m_versions, &TruckPackVersionManager::versionInfoLoaded, this, &Prefetcher::schedule);
+}
+
+void Prefetcher::schedule()
+{
+    if (!APPLICATION->settings()->get("TruckPackPrefetch").toBool() || !m_versions->isLoaded())
+        return;
+
+    auto instances = APPLICATION->instances();
+    QSet<QString> queued;
+    for (auto& info : m_queue)
+        queued.insert(info.packName);
+    // the pre-stage of the pack being fetched is only complete once its task is done
+    if (m_task && m_task->isRunning())
+        queued.insert(m_task->packName());
+    for (int i = 0; i < instances->count(); i++) {
+        auto instance = instances->at(i);
+        if (!instance->isTruckPack())
+            continue;
+        auto info = m_versions->getPackInfo(instance->getTruckPackName());
+        if (info.packUrl.isEmpty() || info.packVersion == instance->getTruckPackVersion() || queued.contains(info.packName))
+            continue;
+        if (Prestage::isComplete(Prestage::pathFor(info.packName, info.packVersion)))
+            continue;
+        queued.insert(info.packName);
+        m_queue.enqueue(info);
+    }
+    startNext();
+}
+
+void Prefetcher::startNext()
+{
+    if ((m_task && m_task->isRunning()) || m_queue.isEmpty())
+        return;
+
+    auto info = m_queue.dequeue();
+    qDebug() << "TruckPack::Prefetcher: pre-staging" << info.packName << info.packVersion;
+    auto task = makeShared<PrefetchTask>(QUrl(info.packUrl), info.packName, info.packVersion);
+    connect(task.get(), &Task::failed, this, [info](QString reason) {
+        qWarning() << "TruckPack::Prefetcher: could not pre-stage" << info.packName << info.packVersion << ":" << reason;
+    });
+    connect(task.get(), &Task::finished, this, &Prefetcher::startNext, Qt::QueuedConnection);
+    m_task = task;
+    task->start();
+}
+
+}  // namespace TruckPack
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QUrl>
+
+#include "TruckPackVersionManager.h"
+#include "net/NetJob.h"
+#include "tasks/Task.h"
+
+#include "TruckPackIndex.h"
+
+namespace TruckPack {
+
+/**
+ * A pack version extracted ahead of time, waiting for an update to pick its files up.
+ *
+ * Lives in '<prestage base>/<pack>/<version>/': 'files/' holds the pack's instance folder, and 'index.json'
+ * describes it. The index is written last, so a pre-stage without one is incomplete.
+ */
+namespace Prestage {
+QString pathFor(const QString& packName, const QString& packVersion);
+QString filesPath(const QString& prestage);
+QString indexPath(const QString& prestage);
+bool isComplete(const QString& prestage);
+}  // namespace Prestage
+
+/** Downloads and extracts a pack version into its pre-stage, in the background. */
+class PrefetchTask : public Task {
+    Q_OBJECT
+   public:
+    PrefetchTask(QUrl packUrl, QString packName, QString packVersion);
+
+    bool canAbort() const override { return true; }
+    bool abort() override;
+
+    QString packName() const { return m_packName; }
+
+   protected:
+    void executeTask() override;
+
+   private:
+    void download();
+    void checkForeground();
+    void downloaded();
+    void extracted();
+
+   private:
+    QUrl m_packUrl;
+    QString m_packName;
+    QString m_packVersion;
+    QString m_prestage;
+    PackIndex m_index;
+
+    NetJob::Ptr m_job;
+    Task::Ptr m_extractTask;
+    QTimer m_foregroundCheck;
+    bool m_paused = false;
+};
+
+/**
+ * Pre-stages new versions of installed truck packs as soon as the pack manifest announces them, so updating
+ * only has to move the pre-extracted files into the instance.
+ *
+ * Opt-in through the "TruckPackPrefetch" setting. Downloads are rate limited ("TruckPackPrefetchRate", in KiB/s)
+ * and pause whenever anything else downloads.
+ */
+class Prefetcher : public QObject {
+    Q_OBJECT
+   public:
+    explicit Prefetcher(TruckPackVersionManager* versions, QObject* parent = nullptr);
+
+   public slots:
+    void schedule();
+
+   private:
+    void startNext();
+
+   private:
+    TruckPackVersionManager* m_versions;
+    QQueue<TruckPackInfo> m_queue;
+    shared_qobject_ptr<PrefetchTask> m_task;
+};
+
+}  // namespace TruckPack
@@ -43,4 +43,11 @@ Download::Ptr ApiDownload::makeFile(QUrl url, QString path, Download::Options op
     return dl;
 }
 
+Download::Ptr ApiDownload::makeFileRange(QUrl url, QString path, qint64 first, qint64 last, QByteArray entityTag, Download::Options options)
+{
+    auto dl = Download::makeFileRange(url, path, first, last, entityTag, options);
+    dl->addHeaderProxy(new ApiHeaderProxy());
+    return dl;
+}
+
 }  // namespace Net
@@ -27,6 +27,12 @@ namespace ApiDownload {
 Download::Ptr makeCached(QUrl url, MetaEntryPtr entry, Download::Options options = Download::Option::NoOptions);
 Download::Ptr makeByteArray(QUrl url, std::shared_ptr<QByteArray> output, Download::Options options = Download::Option::NoOptions);
 Download::Ptr makeFile(QUrl url, QString path, Download::Options options = Download::Option::NoOptions);
+Download::Ptr makeFileRange(QUrl url,
+                            QString path,
+                            qint64 first,
+                            qint64 last,
+                            QByteArray entityTag = {},
+                            Download::Options options = Download::Option::NoOptions);
 };  // namespace ApiDownload
 
 }  // namespace Net
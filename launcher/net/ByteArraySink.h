@@ -87,6 +87,18 @@ class ByteArraySink : public Sink {
 
     auto hasLocalData() -> bool override { return false; }
 
+    auto adopt(Sink& leader) -> Task::State override
+    {
+        auto other = dynamic_cast<ByteArraySink*>(&leader);
+        if (!other || !other->m_output || !m_output)
+            return Task::State::Failed;
+        *m_output = *other->m_output;
+        return Task::State::Succeeded;
+    }
+
+   protected:
+    auto targetKey() const -> QString override { return "memory"; }
+
    private:
     std::shared_ptr<QByteArray> m_output;
 };
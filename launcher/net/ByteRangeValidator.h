@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Validator.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+
+namespace Net {
+/*
+ * Makes sure a request sent with a `Range` header actually got a partial response.
+ *
+ * Servers are free to ignore `Range` and answer with the whole resource, so this also stops the transfer
+ * as soon as more than the requested amount of bytes arrives, instead of buffering a whole pack in memory.
+ */
+class ByteRangeValidator : public Validator {
+   public:
+    ByteRangeValidator(qint64 expectedLength) : m_expectedLength(expectedLength) {}
+    virtual ~ByteRangeValidator() = default;
+
+   public:
+    auto init(QNetworkRequest&) -> bool override
+    {
+        m_received = 0;
+        m_totalSize = -1;
+        return true;
+    }
+
+    auto write(QByteArray& data) -> bool override
+    {
+        m_received += data.size();
+        if (m_expectedLength >= 0 && m_received > m_expectedLength) {
+            qWarning() << "Received more data than the requested range, the server probably ignored it.";
+            return false;
+        }
+        return true;
+    }
+
+    auto abort() -> bool override { return true; }
+
+    auto validate(QNetworkReply& reply) -> bool override
+    {
+        if (reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206) {
+            qWarning() << "Expected a partial response, got HTTP status" << reply.attribute(QNetworkRequest::HttpStatusCodeAttribute);
+            return false;
+        }
+
+        // Content-Range: bytes <first>-<last>/<total or *>
+        static const QRegularExpression content_range(R"(^bytes\s+(\d+)-(\d+)/(\d+|\*)$)");
+        auto match = content_range.match(QString::fromLatin1(reply.rawHeader("Content-Range")).trimmed());
+        if (!match.hasMatch()) {
+            qWarning() << "Partial response without a usable Content-Range header.";
+            return false;
+        }
+        m_firstByte = match.captured(1).toLongLong();
+        if (match.captured(3) != "*")
+            m_totalSize = match.captured(3).toLongLong();
+
+        // weak ETags can't be used with If-Range
+        m_entityTag = reply.rawHeader("ETag");
+        if (m_entityTag.isEmpty() || m_entityTag.startsWith("W/"))
+            m_entityTag = reply.rawHeader("Last-Modified");
+        return true;
+    }
+
+    /** Offset of the first byte of the response body inside the whole resource. */
+    auto firstByte() const -> qint64 { return m_firstByte; }
+    /** Size of the whole resource, or -1 if the server didn't tell. */
+    auto totalSize() const -> qint64 { return m_totalSize; }
+    /** What identifies this version of the resource for `If-Range`: a strong ETag or the Last-Modified date, if any. */
+    auto entityTag() const -> QByteArray { return m_entityTag; }
+
+   private:
+    qint64 m_expectedLength;
+    qint64 m_received = 0;
+    qint64 m_firstByte = 0;
+    qint64 m_totalSize = -1;
+    QByteArray m_entityTag;
+};
+}  // namespace Net
@@ -47,7 +47,7 @@ class ChecksumValidator : public Validator {
         : Net::ChecksumValidator(algorithm, QByteArray::fromHex(expectedHex.toLatin1()))
     {}
     ChecksumValidator(QCryptographicHash::Algorithm algorithm, QByteArray expected = QByteArray())
-        : m_checksum(algorithm), m_expected(expected) {};
+        : m_checksum(algorithm), m_algorithm(algorithm), m_expected(expected) {};
     virtual ~ChecksumValidator() = default;
 
    public:
@@ -78,12 +78,20 @@ class ChecksumValidator : public Validator {
         return true;
     }
 
+    auto flightKey() const -> QString override
+    {
+        return QString("checksum:%1:%2").arg(static_cast<int>(m_algorithm)).arg(QString::fromLatin1(m_expected.toHex()));
+    }
+
+    auto verifiesContent() const -> bool override { return !m_expected.isEmpty(); }
+
     auto hash() -> QByteArray { return m_checksum.result(); }
 
     void setExpected(QByteArray expected) { m_expected = expected; }
 
    private:
     QCryptographicHash m_checksum;
+    QCryptographicHash::Algorithm m_algorithm;
     QByteArray m_expected;
 };
 }  // namespace Net
@@ -58,6 +58,7 @@ auto Download::makeCached(QUrl url, MetaEntryPtr entry, Options options) -> Down
     dl->m_options = options;
     auto md5Node = new ChecksumValidator(QCryptographicHash::Md5);
     auto cachedNode = new MetaCacheSink(entry, md5Node, options.testFlag(Option::MakeEternal));
+    cachedNode->setResumable(options.testFlag(Option::Resumable));
     dl->m_sink.reset(cachedNode);
     return dl;
 }
@@ -79,7 +80,21 @@ auto Download::makeFile(QUrl url, QString path, Options options) -> Download::Pt
     dl->m_url = url;
     dl->setObjectName(QString("FILE:") + url.toString());
     dl->m_options = options;
-    dl->m_sink.reset(new FileSink(path));
+    auto fileNode = new FileSink(path);
+    fileNode->setResumable(options.testFlag(Option::Resumable));
+    dl->m_sink.reset(fileNode);
+    return dl;
+}
+
+auto Download::makeFileRange(QUrl url, QString path, qint64 first, qint64 last, QByteArray entityTag, Options options) -> Download::Ptr
+{
+    auto dl = makeShared<Download>();
+    dl->m_url = url;
+    dl->setObjectName(QString("RANGE:") + url.toString());
+    dl->m_options = options;
+    auto fileNode = new FileSink(path);
+    fileNode->setByteRange(first, last, entityTag);
+    dl->m_sink.reset(fileNode);
     return dl;
 }
 
@@ -56,8 +56,23 @@ class Download : public NetRequest {
 
     static auto makeByteArray(QUrl url, std::shared_ptr<QByteArray> output, Options options = Option::NoOptions) -> Download::Ptr;
     static auto makeFile(QUrl url, QString path, Options options = Option::NoOptions) -> Download::Ptr;
+    // fetch only the bytes [first, last] of the resource into path, resuming partial data of the same entityTag
+    static auto makeFileRange(QUrl url, QString path, qint64 first, qint64 last, QByteArray entityTag = {}, Options options = Option::NoOptions)
+        -> Download::Ptr;
+
+    /**
+     * Other URLs serving exactly the same file, in order of preference. The next one is tried when the current one
+     * fails. Downloads with an expected checksum also race the next mirror against a transfer that stalls or crawls
+     * for hedgeAfter milliseconds, and keep whichever finishes first.
+     */
+    void setMirrors(QList<QUrl> mirrors, int hedgeAfter = 5000)
+    {
+        m_mirrors = std::move(mirrors);
+        m_hedgeAfter = hedgeAfter;
+    }
 
    protected:
     virtual QNetworkReply* getReply(QNetworkRequest&) override;
+    bool canShareTransfer() const override { return true; }
 };
 }  // namespace Net
@@ -35,12 +35,42 @@
 
 #include "FileSink.h"
 
+#include <QRegularExpression>
+
 #include "FileSystem.h"
 
 #include "net/Logging.h"
 
 namespace Net {
 
+namespace {
+/// smaller files are written in a few chunks anyway
+constexpr qint64 PreallocateMinimum = 1024 * 1024;
+
+/// reserves room for the rest of the response, so multi-GB downloads land on disk in one piece
+void preallocate(QNetworkReply& reply, QFileDevice& file)
+{
+    auto status = reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200 && status != 206)
+        return;
+    // the length of a compressed response is not the length of what ends up in the file
+    if (!reply.rawHeader("Content-Encoding").isEmpty())
+        return;
+    bool ok = false;
+    auto length = reply.header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+    if (ok && length >= PreallocateMinimum)
+        FS::preallocate(file, length);
+}
+}  // namespace
+
+void FileSink::setByteRange(qint64 first, qint64 last, QByteArray entityTag)
+{
+    m_resumable = true;
+    m_rangeFirst = first;
+    m_rangeLast = last;
+    m_entityTag = entityTag;
+}
+
 Task::State FileSink::init(QNetworkRequest& request)
 {
     auto result = initCache(request);
@@ -55,6 +85,9 @@ Task::State FileSink::init(QNetworkRequest& request)
     }
 
     m_wroteAnyData = false;
+    if (m_resumable)
+        return initPartial(request);
+
     m_output_file.reset(new PSaveFile(m_filename));
     if (!m_output_file->open(QIODevice::WriteOnly)) {
         qCCritical(taskNetLogC) << "Could not open " + m_filename + " for writing";
@@ -66,8 +99,128 @@ Task::State FileSink::init(QNetworkRequest& request)
     return Task::State::Failed;
 }
 
+Task::State FileSink::initPartial(QNetworkRequest& request)
+{
+    QByteArray keptTag;
+    QFile tagFile(entityTagPath());
+    if (tagFile.open(QIODevice::ReadOnly))
+        keptTag = tagFile.readAll().trimmed();
+    tagFile.close();
+
+    qint64 kept = QFileInfo(partialPath()).size();
+    qint64 wanted = m_rangeLast >= 0 ? m_rangeLast - m_rangeFirst + 1 : -1;
+    // partial data is only good if we can ask the server whether it still has the same file
+    if (kept > 0 && (keptTag.isEmpty() || (!m_entityTag.isEmpty() && keptTag != m_entityTag) || (wanted >= 0 && kept > wanted))) {
+        qCDebug(taskNetLogC) << "Discarding unusable partial download" << partialPath();
+        dropPartial();
+        kept = 0;
+    }
+
+    m_partial_file.reset(new QFile(partialPath()));
+    if (!m_partial_file->open(QIODevice::ReadWrite)) {
+        qCCritical(taskNetLogC) << "Could not open " + partialPath() + " for writing";
+        return Task::State::Failed;
+    }
+    if (!initAllValidators(request))
+        return Task::State::Failed;
+
+    if (wanted >= 0 && kept == wanted) {
+        // a previous attempt got everything already
+        m_partial_file->close();
+        QFile::remove(m_filename);
+        if (!QFile::rename(partialPath(), m_filename))
+            return Task::State::Failed;
+        QFile::remove(entityTagPath());
+        return Task::State::Succeeded;
+    }
+
+    m_requestedFrom = m_rangeFirst + kept;
+    if (m_requestedFrom > 0 || wanted >= 0) {
+        QByteArray range = "bytes=" + QByteArray::number(m_requestedFrom) + '-';
+        if (m_rangeLast >= 0)
+            range += QByteArray::number(m_rangeLast);
+        request.setRawHeader("Range", range);
+        auto tag = m_entityTag.isEmpty() ? keptTag : m_entityTag;
+        if (!tag.isEmpty())
+            request.setRawHeader("If-Range", tag);
+        if (kept > 0)
+            qCDebug(taskNetLogC) << "Resuming" << m_filename << "from byte" << m_requestedFrom;
+    }
+    return Task::State::Running;
+}
+
+Task::State FileSink::headersReceived(QNetworkReply& reply)
+{
+    if (!m_resumable || !m_partial_file) {
+        if (m_output_file)
+            preallocate(reply, *m_output_file);
+        return Task::State::Running;
+    }
+
+    auto status = reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 206) {
+        static const QRegularExpression content_range(R"(^bytes\s+(\d+)-(\d+)/(\d+|\*)$)");
+        auto match = content_range.match(QString::fromLatin1(reply.rawHeader("Content-Range")).trimmed());
+        if (!match.hasMatch() || match.captured(1).toLongLong() != m_requestedFrom) {
+            qCCritical(taskNetLogC) << "Server sent a different range than requested for" << m_filename;
+            dropPartial();
+            return Task::State::Failed;
+        }
+
+        // the validators have to see the whole file, starting with what we already have
+        m_partial_file->seek(0);
+        while (!m_partial_file->atEnd()) {
+            auto chunk = m_partial_file->read(1024 * 1024);
+            if (!writeAllValidators(chunk))
+                return Task::State::Failed;
+        }
+        m_partial_file->seek(m_partial_file->size());
+    } else if (status == 200) {
+        if (m_rangeLast >= 0 || m_rangeFirst > 0) {
+            qCCritical(taskNetLogC) << "Server ignored the requested range for" << m_filename;
+            return Task::State::Failed;
+        }
+        // the file changed (or the server can't do ranges), start over
+        m_partial_file->resize(0);
+        m_partial_file->seek(0);
+    } else if (status == 416) {
+        qCWarning(taskNetLogC) << "Partial download of" << m_filename << "doesn't match the remote file anymore";
+        dropPartial();
+        return Task::State::Failed;
+    } else {
+        return Task::State::Running;
+    }
+
+    preallocate(reply, *m_partial_file);
+
+    // remember what we are downloading, so it can be resumed if the transfer fails
+    auto tag = reply.rawHeader("ETag");
+    if (tag.isEmpty() || tag.startsWith("W/"))
+        tag = reply.rawHeader("Last-Modified");
+    if (!m_entityTag.isEmpty())
+        tag = m_entityTag;
+    QFile tagFile(entityTagPath());
+    if (!tag.isEmpty() && tagFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        tagFile.write(tag);
+    } else {
+        tagFile.remove();
+    }
+    return Task::State::Running;
+}
+
 Task::State FileSink::write(QByteArray& data)
 {
+    if (m_resumable) {
+        if (!writeAllValidators(data) || m_partial_file->write(data) != data.size()) {
+            qCCritical(taskNetLogC) << "Failed writing into " + partialPath();
+            dropPartial();
+            m_wroteAnyData = false;
+            return Task::State::Failed;
+        }
+        m_wroteAnyData = true;
+        return Task::State::Running;
+    }
+
     if (!writeAllValidators(data) || m_output_file->write(data) != data.size()) {
         qCCritical(taskNetLogC) << "Failed writing into " + m_filename;
         m_output_file->cancelWriting();
@@ -85,6 +238,11 @@ Task::State FileSink::abort()
     if (m_output_file) {
         m_output_file->cancelWriting();
     }
+    if (m_partial_file) {
+        // keep what we have, the next attempt continues from there
+        m_partial_file->close();
+        m_partial_file.reset();
+    }
     failAllValidators();
     return Task::State::Failed;
 }
@@ -97,7 +255,14 @@ Task::State FileSink::finalize(QNetworkReply& reply)
     int statusCode = statusCodeV.toInt(&validStatus);
     if (validStatus) {
         // this leaves out 304 Not Modified
-        gotFile = statusCode == 200 || statusCode == 203;
+        gotFile = statusCode == 200 || statusCode == 203 || (m_resumable && statusCode == 206);
+    }
+
+    if (m_resumable) {
+        auto result = finalizePartial(reply, gotFile);
+        if (result != Task::State::Succeeded)
+            return result;
+        return finalizeCache(reply);
     }
 
     // if we wrote any data to the save file, we try to commit the data to the real file.
@@ -122,6 +287,41 @@ Task::State FileSink::finalize(QNetworkReply& reply)
     return finalizeCache(reply);
 }
 
+Task::State FileSink::finalizePartial(QNetworkReply& reply, bool gotFile)
+{
+    if (!gotFile && !m_wroteAnyData) {
+        // the file we already have is still good, the partial data is of no use
+        dropPartial();
+        return Task::State::Succeeded;
+    }
+
+    if (!finalizeAllValidators(reply)) {
+        // whatever we have is bad, don't build on it next time
+        dropPartial();
+        return Task::State::Failed;
+    }
+
+    m_partial_file->close();
+    m_partial_file.reset();
+    QFile::remove(m_filename);
+    if (!QFile::rename(partialPath(), m_filename)) {
+        qCCritical(taskNetLogC) << "Failed to move " << partialPath() << " to " << m_filename;
+        return Task::State::Failed;
+    }
+    QFile::remove(entityTagPath());
+    return Task::State::Succeeded;
+}
+
+void FileSink::dropPartial()
+{
+    if (m_partial_file) {
+        m_partial_file->close();
+        m_partial_file.reset();
+    }
+    QFile::remove(partialPath());
+    QFile::remove(entityTagPath());
+}
+
 Task::State FileSink::initCache(QNetworkRequest&)
 {
     return Task::State::Running;
@@ -137,4 +337,20 @@ bool FileSink::hasLocalData()
     QFileInfo info(m_filename);
     return info.exists() && info.size() != 0;
 }
+
+QString FileSink::targetKey() const
+{
+    auto key = "file:" + QFileInfo(m_filename).absoluteFilePath();
+    if (m_rangeFirst > 0 || m_rangeLast >= 0)
+        key += QString(":%1-%2").arg(m_rangeFirst).arg(m_rangeLast);
+    return key;
+}
+
+Task::State FileSink::adopt(Sink& leader)
+{
+    // the same flight key means the leader wrote the very file we would have
+    if (!dynamic_cast<FileSink*>(&leader) || !QFileInfo(m_filename).isFile())
+        return Task::State::Failed;
+    return Task::State::Succeeded;
+}
 }  // namespace Net
@@ -35,6 +35,8 @@
 
 #pragma once
 
+#include <QFile>
+
 #include "PSaveFile.h"
 #include "Sink.h"
 
@@ -46,19 +48,49 @@ class FileSink : public Sink {
 
    public:
     auto init(QNetworkRequest& request) -> Task::State override;
+    auto headersReceived(QNetworkReply& reply) -> Task::State override;
     auto write(QByteArray& data) -> Task::State override;
     auto abort() -> Task::State override;
     auto finalize(QNetworkReply& reply) -> Task::State override;
 
     auto hasLocalData() -> bool override;
+    auto adopt(Sink& leader) -> Task::State override;
+
+    /*
+     * Keep the data received so far in '<filename>.part' when the transfer fails,
+     * and continue from there next time with a `Range` request. The ETag (or Last-Modified date)
+     * of the response is kept next to it and sent as `If-Range`, so a changed file is fetched from scratch.
+     */
+    void setResumable(bool resumable) { m_resumable = resumable; }
+    /*
+     * Only fetch the bytes [first, last] of the resource (implies resumable).
+     * If \p entityTag isn't empty, it must match the one any kept partial data came from.
+     */
+    void setByteRange(qint64 first, qint64 last, QByteArray entityTag = {});
 
    protected:
+    auto targetKey() const -> QString override;
     virtual auto initCache(QNetworkRequest&) -> Task::State;
     virtual auto finalizeCache(QNetworkReply& reply) -> Task::State;
 
+   private:
+    auto initPartial(QNetworkRequest& request) -> Task::State;
+    auto finalizePartial(QNetworkReply& reply, bool gotFile) -> Task::State;
+    void dropPartial();
+    auto partialPath() const -> QString { return m_filename + ".part"; }
+    auto entityTagPath() const -> QString { return m_filename + ".part.tag"; }
+
    protected:
     QString m_filename;
     bool m_wroteAnyData = false;
     std::unique_ptr<PSaveFile> m_output_file;
+
+   private:
+    bool m_resumable = false;
+    qint64 m_rangeFirst = 0;
+    qint64 m_rangeLast = -1;
+    QByteArray m_entityTag;
+    qint64 m_requestedFrom = 0;
+    std::unique_ptr<QFile> m_partial_file;
 };
 }  // namespace Net
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "HostScheduler.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+
+#include "net/Logging.h"
+
+namespace Net {
+
+namespace {
+// how far HTTP/2 origins may grow past the base window
+constexpr int Http2WindowFactor = 4;
+// windows that shrank are given back their base size once their origin had a break this long
+constexpr qint64 IdleResetMs = 5 * 60 * 1000;
+// throughput changes within this band are noise
+constexpr double RateTolerance = 0.95;
+constexpr double RateDrop = 0.8;
+// how much unused bandwidth a limited priority may save up, in ms of its rate
+constexpr qint64 BurstMs = 250;
+
+int indexOf(Priority priority)
+{
+    return static_cast<int>(priority);
+}
+}  // namespace
+
+HostScheduler::HostScheduler(std::function<qint64()> clock) : QObject(), m_clock(std::move(clock))
+{
+    if (!m_clock) {
+        auto timer = std::make_shared<QElapsedTimer>();
+        timer->start();
+        m_clock = [timer] { return timer->elapsed(); };
+    }
+}
+
+HostScheduler* HostScheduler::instance()
+{
+    // never destroyed, NetJobs may still give slots back while the application shuts down
+    static auto* scheduler = new HostScheduler;
+    return scheduler;
+}
+
+QString HostScheduler::originOf(const QUrl& url)
+{
+    return url.adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment | QUrl::RemoveUserInfo).toString();
+}
+
+void HostScheduler::setBaseWindow(int window)
+{
+    m_baseWindow = std::max(window, 1);
+}
+
+HostScheduler::Host& HostScheduler::host(const QString& origin)
+{
+    auto it = m_hosts.find(origin);
+    if (it == m_hosts.end()) {
+        Host host;
+        host.window = m_baseWindow;
+        it = m_hosts.insert(origin, host);
+    }
+    return *it;
+}
+
+int HostScheduler::ceiling(const Host& host) const
+{
+    return host.http2 ? m_baseWindow * Http2WindowFactor : m_baseWindow;
+}
+
+bool HostScheduler::tryAcquire(const QString& origin, Priority priority)
+{
+    if (priority == Priority::Background && isOutranked(priority))
+        return false;
+    // a trickle, so the rest of the launcher stays usable
+    if (priority == Priority::Interactive && waiting(Priority::Launch) > 0 && m_running[indexOf(priority)] >= 1)
+        return false;
+
+    auto& h = host(origin);
+    auto now = m_clock();
+    if (h.inFlight == 0 && now - h.lastUsed > IdleResetMs)
+        h.window = std::max<double>(h.window, m_baseWindow);
+    // the base window may have changed since
+    h.window = std::min<double>(h.window, ceiling(h));
+
+    if (h.inFlight >= std::max(1, int(h.window)))
+        return false;
+    h.inFlight++;
+    m_running[indexOf(priority)]++;
+    h.lastUsed = now;
+    if (h.epochStart < 0)
+        h.epochStart = now;
+    return true;
+}
+
+bool HostScheduler::isCongestion(const Result& result)
+{
+    if (result.succeeded)
+        return false;
+    if (result.statusCode == 429 || result.statusCode == 503)
+        return true;
+    switch (result.error) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::ServiceUnavailableError:
+        case QNetworkReply::UnknownNetworkError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void HostScheduler::release(const QString& origin, Priority priority, const Result& result)
+{
+    auto& h = host(origin);
+    auto now = m_clock();
+    h.inFlight = std::max(h.inFlight - 1, 0);
+    auto& running = m_running[indexOf(priority)];
+    running = std::max(running - 1, 0);
+    h.lastUsed = now;
+    h.http2 |= result.http2;
+
+    if (isCongestion(result)) {
+        h.window = std::max(h.window / 2, 1.0);
+        h.epochStart = h.inFlight > 0 ? now : -1;
+        h.epochRequests = 0;
+        h.epochBytes = 0;
+        h.lastRate = 0;
+        qCDebug(taskNetLogC) << "Backing off from" << origin << "to" << int(h.window) << "concurrent requests";
+    } else if (result.succeeded) {
+        h.epochRequests++;
+        h.epochBytes += result.bytes;
+        if (h.epochRequests >= int(h.window)) {
+            auto rate = double(h.epochBytes) / std::max<qint64>(now - h.epochStart, 1);
+            if (rate >= h.lastRate * RateTolerance) {
+                h.window = std::min<double>(h.window + 1, ceiling(h));
+            } else if (rate < h.lastRate * RateDrop) {
+                // more requests made it slower, the last step was one too many
+                h.window = std::max(h.window - 1, 1.0);
+            }
+            h.lastRate = rate;
+            h.epochStart = now;
+            h.epochRequests = 0;
+            h.epochBytes = 0;
+        }
+    }
+
+    emit capacityAvailable();
+}
+
+void HostScheduler::setWaiting(const void* job, Priority priority, int count)
+{
+    if (count > 0) {
+        m_waiting.insert(job, { priority, count });
+    } else if (m_waiting.remove(job) && priority != Priority::Background) {
+        // lower priorities may have been held back for it
+        emit capacityAvailable();
+    }
+}
+
+int HostScheduler::waiting(Priority priority) const
+{
+    int count = 0;
+    for (auto& [jobPriority, jobCount] : m_waiting) {
+        if (jobPriority == priority)
+            count += jobCount;
+    }
+    return count;
+}
+
+bool HostScheduler::isOutranked(Priority priority) const
+{
+    for (int i = indexOf(priority) + 1; i < PriorityCount; i++) {
+        if (m_running[i] > 0 || waiting(static_cast<Priority>(i)) > 0)
+            return true;
+    }
+    return false;
+}
+
+void HostScheduler::setBandwidthLimit(Priority priority, qint64 bytesPerSecond)
+{
+    auto& bucket = m_buckets[indexOf(priority)];
+    bucket.rate = std::max<qint64>(bytesPerSecond, 0);
+    bucket.tokens = 0;
+    bucket.refilled = m_clock();
+}
+
+qint64 HostScheduler::bandwidthLimit(Priority priority) const
+{
+    return m_buckets[indexOf(priority)].rate;
+}
+
+qint64 HostScheduler::takeBandwidth(Priority priority, qint64 wanted)
+{
+    auto& bucket = m_buckets[indexOf(priority)];
+    if (bucket.rate <= 0)
+        return wanted;
+
+    auto now = m_clock();
+    bucket.tokens = std::min(bucket.tokens + double(bucket.rate) * (now - bucket.refilled) / 1000, double(bucket.rate) * BurstMs / 1000);
+    bucket.refilled = now;
+
+    auto granted = std::min<qint64>(wanted, qint64(bucket.tokens));
+    bucket.tokens -= granted;
+    return std::max<qint64>(granted, 0);
+}
+
+int HostScheduler::window(const QString& origin) const
+{
+    auto it = m_hosts.constFind(origin);
+    return it == m_hosts.constEnd() ? m_baseWindow : std::max(1, int(it->window));
+}
+
+int HostScheduler::inFlight(const QString& origin) const
+{
+    return m_hosts.value(origin).inFlight;
+}
+
+}  // namespace Net
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QNetworkReply>
+#include <QObject>
+#include <QUrl>
+
+#include <functional>
+
+namespace Net {
+
+/** Which requests go first when several jobs download at once. */
+enum class Priority {
+    /** Work nobody waits for, like pre-staging updates. Only runs while nothing else downloads. */
+    Background,
+    /** The default: things the user asked for, and waits on. */
+    Interactive,
+    /** What a game launch is blocked on, e.g. libraries and assets. Interactive requests slow down for it. */
+    Launch,
+};
+
+/**
+ * Decides how many requests may be in flight to each origin (scheme, host and port) at once, for all NetJobs.
+ *
+ * Every origin gets a congestion window, AIMD-style: it starts at the configured number of concurrent downloads, is
+ * halved when a request fails in a way that points at an overloaded server or link (timeouts, dropped connections,
+ * 429, 503), and grows by one whenever a window's worth of requests finished at least as fast as the previous ones.
+ * For HTTP/1.1 origins the configured number is also the ceiling, so their window only ever shrinks below it and
+ * recovers back to it. Origins that serve over HTTP/2 multiplex everything over one connection, so their window may
+ * grow well past the configured number.
+ *
+ * Requests also have a priority: background requests don't start while anything else waits or runs, and interactive
+ * requests are held to one at a time while launch requests wait. Each priority may have a bandwidth limit, shared by
+ * all of its requests.
+ *
+ * Only to be used from the main thread.
+ */
+class HostScheduler : public QObject {
+    Q_OBJECT
+   public:
+    struct Result {
+        bool succeeded = false;
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        int statusCode = 0;
+        qint64 bytes = 0;
+        bool http2 = false;
+    };
+
+    /** @clock returns milliseconds on a monotonic clock, and only needs to be given by tests. */
+    explicit HostScheduler(std::function<qint64()> clock = {});
+
+    static HostScheduler* instance();
+    static QString originOf(const QUrl& url);
+
+    /** The window new origins start with, and the most HTTP/1.1 origins get. */
+    void setBaseWindow(int window);
+
+    /** Take a slot for a request to @origin, if its window has room and nothing more important is in the way. */
+    bool tryAcquire(const QString& origin, Priority priority = Priority::Interactive);
+    /** Give back the slot of a request that finished, and learn from how it went. */
+    void release(const QString& origin, Priority priority, const Result& result);
+
+    /** Tell how many requests @job has queued that couldn't start yet. 0 once it's done. */
+    void setWaiting(const void* job, Priority priority, int count);
+    /** Whether requests of a higher priority than @priority are waiting or running. */
+    bool isOutranked(Priority priority) const;
+
+    /** Limit all requests of @priority together to this many bytes per second. 0 means no limit. */
+    void setBandwidthLimit(Priority priority, qint64 bytesPerSecond);
+    qint64 bandwidthLimit(Priority priority) const;
+    /** Take up to @wanted bytes out of the budget of @priority, returns how many may be read right now. */
+    qint64 takeBandwidth(Priority priority, qint64 wanted);
+
+    int window(const QString& origin) const;
+    int inFlight(const QString& origin) const;
+
+   signals:
+    /** A slot was given back, queued requests may be able to start now. */
+    void capacityAvailable();
+
+   private:
+    struct Host {
+        double window = 0;
+        int inFlight = 0;
+        bool http2 = false;
+        qint64 lastUsed = 0;
+
+        // the current measurement: the requests that finished since it started
+        qint64 epochStart = -1;
+        int epochRequests = 0;
+        qint64 epochBytes = 0;
+        double lastRate = 0;
+    };
+
+    struct Bucket {
+        qint64 rate = 0;
+        double tokens = 0;
+        qint64 refilled = 0;
+    };
+
+    static constexpr int PriorityCount = 3;
+
+    Host& host(const QString& origin);
+    int ceiling(const Host& host) const;
+    static bool isCongestion(const Result& result);
+    int waiting(Priority priority) const;
+
+   private:
+    std::function<qint64()> m_clock;
+    int m_baseWindow = 6;
+    QHash<QString, Host> m_hosts;
+
+    int m_running[PriorityCount] = {};
+    QHash<const void*, std::pair<Priority, int>> m_waiting;
+    Bucket m_buckets[PriorityCount];
+};
+
+}  // namespace Net
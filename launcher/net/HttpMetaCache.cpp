@@ -38,14 +38,42 @@
 #include "Json.h"
 
 #include <QCryptographicHash>
+#include <QDataStream>
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
 
 #include <QDebug>
 
+#include "PSaveFile.h"
 #include "net/Logging.h"
 
+namespace {
+// the snapshot and the journal share one format: a header, followed by records
+constexpr quint32 IndexMagic = 0x4D434958;  // "MCIX"
+constexpr quint32 IndexVersion = 1;
+
+// last access times only need to be good enough to pick what to evict, so they aren't saved on every use
+constexpr qint64 AccessResolution = 60 * 60 * 1000;
+
+enum RecordType : quint8 { PutRecord = 1, RemoveRecord = 2 };
+
+void writeHeader(QDataStream& out)
+{
+    out.setVersion(QDataStream::Qt_5_12);
+    out << IndexMagic << IndexVersion;
+}
+
+bool readHeader(QDataStream& in)
+{
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    return in.status() == QDataStream::Ok && magic == IndexMagic && version == IndexVersion;
+}
+}  // namespace
+
 auto MetaEntry::getFullPath() -> QString
 {
     // FIXME: make local?
@@ -74,6 +102,7 @@ auto HttpMetaCache::getEntry(QString base, QString resource_path) -> MetaEntryPt
         return {};
     }
 
+    ensureLoaded();
     EntryMap& map = m_entries[base];
     if (map.entry_list.contains(resource_path)) {
         return map.entry_list[resource_path];
@@ -99,12 +128,14 @@ auto HttpMetaCache::resolveEntry(QString base, QString resource_path, QString ex
     if (!finfo.isFile() || !finfo.isReadable()) {
         // if the file doesn't exist, we disown the entry
         selected_base.entry_list.remove(resource_path);
+        markDirty(base, resource_path);
         return staleEntry(base, resource_path);
     }
 
     if (!expected_etag.isEmpty() && expected_etag != entry->m_etag) {
         // if the etag doesn't match expected, we disown the entry
         selected_base.entry_list.remove(resource_path);
+        markDirty(base, resource_path);
         return staleEntry(base, resource_path);
     }
 
@@ -116,12 +147,13 @@ auto HttpMetaCache::resolveEntry(QString base, QString resource_path, QString ex
         QString md5sum = QCryptographicHash::hash(input.readAll(), QCryptographicHash::Md5).toHex().constData();
         if (entry->m_md5sum != md5sum) {
             selected_base.entry_list.remove(resource_path);
+            markDirty(base, resource_path);
             return staleEntry(base, resource_path);
         }
 
         // md5sums matched... keep entry and save the new state to file
         entry->m_local_changed_timestamp = file_last_changed;
-        SaveEventually();
+        markDirty(base, resource_path);
     }
 
     // Get rid of old entries, to prevent cache problems
@@ -130,9 +162,16 @@ auto HttpMetaCache::resolveEntry(QString base, QString resource_path, QString ex
         qCWarning(taskNetLogC) << "[HttpMetaCache]"
                                << "Removing cache entry because of old age!";
         selected_base.entry_list.remove(resource_path);
+        markDirty(base, resource_path);
         return staleEntry(base, resource_path);
     }
 
+    auto now = QDateTime::currentMSecsSinceEpoch();
+    if (now - entry->m_last_access > AccessResolution) {
+        entry->m_last_access = now;
+        markDirty(base, resource_path);
+    }
+
     // entry passed all the checks we cared about.
     entry->m_basePath = getBasePath(base);
     return entry;
@@ -150,8 +189,10 @@ auto HttpMetaCache::updateEntry(MetaEntryPtr stale_entry) -> bool
         return false;
     }
 
+    ensureLoaded();
+    stale_entry->m_last_access = QDateTime::currentMSecsSinceEpoch();
     m_entries[stale_entry->m_baseId].entry_list[stale_entry->m_relativePath] = stale_entry;
-    SaveEventually();
+    markDirty(stale_entry->m_baseId, stale_entry->m_relativePath);
 
     return true;
 }
@@ -162,12 +203,13 @@ auto HttpMetaCache::evictEntry(MetaEntryPtr entry) -> bool
         return false;
 
     entry->m_stale = true;
-    SaveEventually();
+    markDirty(entry->m_baseId, entry->m_relativePath);
     return true;
 }
 
 void HttpMetaCache::evictAll()
 {
+    ensureLoaded();
     for (QString& base : m_entries.keys()) {
         EntryMap& map = m_entries[base];
         qCDebug(taskHttpMetaCacheLogC) << "Evicting base" << base;
@@ -178,6 +220,11 @@ void HttpMetaCache::evictAll()
         map.entry_list.clear();
         FS::deletePath(map.base_path);
     }
+
+    // an empty snapshot says it all, the journal has nothing to add
+    m_dirty.clear();
+    m_needsCompaction = true;
+    SaveEventually();
 }
 
 auto HttpMetaCache::staleEntry(QString base, QString resource_path) -> MetaEntryPtr
@@ -217,6 +264,101 @@ void HttpMetaCache::Load()
     if (m_index_file.isNull())
         return;
 
+    // the index is only read once something asks for an entry, so it stays off the startup path
+    m_loadPending = true;
+}
+
+void HttpMetaCache::ensureLoaded()
+{
+    if (!m_loadPending)
+        return;
+    m_loadPending = false;
+
+    auto snapshot = m_index_file + ".idx";
+    if (!QFileInfo::exists(snapshot) && QFileInfo::exists(m_index_file)) {
+        // written by an older version: convert it, and get rid of it
+        loadLegacyIndex();
+        if (compact())
+            QFile::remove(m_index_file);
+        return;
+    }
+
+    if (loadRecords(snapshot) < 0) {
+        qCWarning(taskHttpMetaCacheLogC) << "Metacache snapshot is damaged, keeping what could be read";
+        m_needsCompaction = true;
+    }
+    auto journalRecords = loadRecords(m_index_file + ".journal");
+    if (journalRecords < 0) {
+        // most likely cut off in the middle of a record. appending after it would lose everything that follows
+        qCWarning(taskHttpMetaCacheLogC) << "Metacache journal is damaged, keeping what could be read";
+        m_needsCompaction = true;
+    } else {
+        m_journalRecords = journalRecords;
+    }
+
+    if (m_needsCompaction)
+        compact();
+}
+
+int HttpMetaCache::loadRecords(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    QDataStream in(&file);
+    if (!readHeader(in))
+        return -1;
+
+    int records = 0;
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        QString base;
+        QString resource_path;
+        in >> type >> base >> resource_path;
+
+        MetaEntryPtr entry;
+        if (type == PutRecord) {
+            entry.reset(new MetaEntry());
+            qint64 local_changed_timestamp = 0;
+            qint64 last_access = 0;
+            qint64 current_age = 0;
+            qint64 max_age = 0;
+            bool eternal = false;
+            in >> entry->m_md5sum >> entry->m_etag >> local_changed_timestamp >> entry->m_remote_changed_timestamp >> eternal >>
+                current_age >> max_age >> last_access;
+            entry->m_local_changed_timestamp = local_changed_timestamp;
+            entry->m_last_access = last_access;
+            entry->m_current_age = current_age;
+            entry->m_max_age = max_age;
+            entry->m_is_eternal = eternal;
+        } else if (type != RemoveRecord) {
+            return -1;
+        }
+        if (in.status() != QDataStream::Ok)
+            return -1;
+        records++;
+
+        if (!m_entries.contains(base))
+            continue;
+        auto& entrymap = m_entries[base];
+        if (!entry) {
+            entrymap.entry_list.remove(resource_path);
+            continue;
+        }
+
+        entry->m_baseId = base;
+        entry->m_basePath = entrymap.base_path;
+        entry->m_relativePath = resource_path;
+        // presumed innocent until closer examination
+        entry->m_stale = false;
+        entrymap.entry_list[resource_path] = entry;
+    }
+    return records;
+}
+
+void HttpMetaCache::loadLegacyIndex()
+{
     QFile index(m_index_file);
     if (!index.open(QIODevice::ReadOnly))
         return;
@@ -257,11 +399,13 @@ void HttpMetaCache::Load()
 
         auto foo = new MetaEntry();
         foo->m_baseId = base;
+        foo->m_basePath = entrymap.base_path;
         foo->m_relativePath = Json::ensureString(element_obj, "path");
         foo->m_md5sum = Json::ensureString(element_obj, "md5sum");
         foo->m_etag = Json::ensureString(element_obj, "etag");
         foo->m_local_changed_timestamp = Json::ensureDouble(element_obj, "last_changed_timestamp");
         foo->m_remote_changed_timestamp = Json::ensureString(element_obj, "remote_changed_timestamp");
+        foo->m_last_access = foo->m_local_changed_timestamp;
 
         foo->makeEternal(Json::ensureBoolean(element_obj, (const QString)QStringLiteral("eternal"), false));
         if (!foo->isEternal()) {
@@ -283,48 +427,147 @@ void HttpMetaCache::SaveEventually()
     saveBatchingTimer.start(30000);
 }
 
+void HttpMetaCache::markDirty(const QString& base, const QString& resource_path)
+{
+    m_dirty.insert(qMakePair(base, resource_path));
+    SaveEventually();
+}
+
+void HttpMetaCache::writeEntry(QDataStream& out, const MetaEntry& entry)
+{
+    out << quint8(PutRecord) << entry.m_baseId << entry.m_relativePath << entry.m_md5sum << entry.m_etag
+        << qint64(entry.m_local_changed_timestamp) << entry.m_remote_changed_timestamp << entry.m_is_eternal
+        << qint64(entry.m_current_age) << qint64(entry.m_max_age) << qint64(entry.m_last_access);
+}
+
 void HttpMetaCache::SaveNow()
 {
-    if (m_index_file.isNull())
+    // nothing was loaded, so nothing could have changed
+    if (m_index_file.isNull() || m_loadPending)
+        return;
+
+    int entries = 0;
+    for (auto& group : m_entries)
+        entries += group.entry_list.size();
+
+    // once the journal holds more than the snapshot would, replaying it costs more than rewriting the snapshot
+    if (m_needsCompaction || m_journalRecords + m_dirty.size() > qMax(1000, entries)) {
+        compact();
+        return;
+    }
+    if (m_dirty.isEmpty())
+        return;
+
+    qCDebug(taskHttpMetaCacheLogC) << "Appending" << m_dirty.size() << "changed metacache entries";
+
+    QFile journal(m_index_file + ".journal");
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(taskHttpMetaCacheLogC) << "Error writing cache journal:" << journal.errorString();
         return;
+    }
+    QDataStream out(&journal);
+    if (journal.size() == 0)
+        writeHeader(out);
+    else
+        out.setVersion(QDataStream::Qt_5_12);
+
+    for (auto& key : m_dirty) {
+        auto entry = m_entries.value(key.first).entry_list.value(key.second);
+        // do not save stale entries. they are dead.
+        if (!entry || entry->m_stale)
+            out << quint8(RemoveRecord) << key.first << key.second;
+        else
+            writeEntry(out, *entry);
+    }
+    m_journalRecords += m_dirty.size();
+    m_dirty.clear();
 
-    qCDebug(taskHttpMetaCacheLogC) << "Saving metacache with" << m_entries.size() << "entries";
+    if (out.status() != QDataStream::Ok || !journal.flush()) {
+        qCWarning(taskHttpMetaCacheLogC) << "Error writing cache journal:" << journal.errorString();
+        m_needsCompaction = true;
+    }
+}
 
-    QJsonObject toplevel;
-    Json::writeString(toplevel, "version", "1");
+bool HttpMetaCache::compact()
+{
+    PSaveFile file(m_index_file + ".idx");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(taskHttpMetaCacheLogC) << "Error writing cache:" << file.errorString();
+        return false;
+    }
 
-    QJsonArray entriesArr;
-    for (auto group : m_entries) {
-        for (auto entry : group.entry_list) {
+    QDataStream out(&file);
+    writeHeader(out);
+    int entries = 0;
+    for (auto& group : m_entries) {
+        for (auto& entry : group.entry_list) {
             // do not save stale entries. they are dead.
-            if (entry->m_stale) {
+            if (entry->m_stale)
                 continue;
-            }
-
-            QJsonObject entryObj;
-            Json::writeString(entryObj, "base", entry->m_baseId);
-            Json::writeString(entryObj, "path", entry->m_relativePath);
-            Json::writeString(entryObj, "md5sum", entry->m_md5sum);
-            Json::writeString(entryObj, "etag", entry->m_etag);
-            entryObj.insert("last_changed_timestamp", QJsonValue(double(entry->m_local_changed_timestamp)));
-            if (!entry->m_remote_changed_timestamp.isEmpty())
-                entryObj.insert("remote_changed_timestamp", QJsonValue(entry->m_remote_changed_timestamp));
-            if (entry->isEternal()) {
-                entryObj.insert("eternal", true);
-            } else {
-                entryObj.insert("current_age", QJsonValue(double(entry->m_current_age)));
-                entryObj.insert("max_age", QJsonValue(double(entry->m_max_age)));
-            }
-            entriesArr.append(entryObj);
+            writeEntry(out, *entry);
+            entries++;
         }
     }
-    toplevel.insert("entries", entriesArr);
 
-    try {
-        Json::write(toplevel, m_index_file);
-    } catch (const Exception& e) {
-        qCWarning(taskHttpMetaCacheLogC) << "Error writing cache:" << e.what();
+    qCDebug(taskHttpMetaCacheLogC) << "Saving metacache with" << entries << "entries";
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(taskHttpMetaCacheLogC) << "Error writing cache:" << file.errorString();
+        return false;
+    }
+
+    // everything in the journal is in the snapshot now. if removing it fails, replaying it again is harmless
+    QFile::remove(m_index_file + ".journal");
+    m_journalRecords = 0;
+    m_dirty.clear();
+    m_needsCompaction = false;
+    return true;
+}
+
+void HttpMetaCache::setQuota(QString base, qint64 bytes)
+{
+    if (m_entries.contains(base))
+        m_entries[base].quota = qMax<qint64>(0, bytes);
+}
+
+auto HttpMetaCache::getQuota(QString base) -> qint64
+{
+    return m_entries.value(base).quota;
+}
+
+auto HttpMetaCache::getBases() -> QStringList
+{
+    return m_entries.keys();
+}
+
+auto HttpMetaCache::getEntries(QString base) -> QList<MetaEntryPtr>
+{
+    if (!m_entries.contains(base))
+        return {};
+
+    ensureLoaded();
+    QList<MetaEntryPtr> entries;
+    for (auto& entry : m_entries[base].entry_list) {
+        if (!entry->m_stale)
+            entries.append(entry);
     }
+    return entries;
+}
+
+auto HttpMetaCache::forgetEntry(MetaEntryPtr entry) -> bool
+{
+    if (!entry || !m_entries.contains(entry->m_baseId))
+        return false;
+
+    ensureLoaded();
+    auto& entry_list = m_entries[entry->m_baseId].entry_list;
+    // the entry may have been replaced by a new download since
+    if (entry_list.value(entry->m_relativePath) != entry)
+        return false;
+
+    entry_list.remove(entry->m_relativePath);
+    markDirty(entry->m_baseId, entry->m_relativePath);
+    return true;
 }
 
 void HttpMetaCache::cleanupOldTruckPackCache(const QString& cachePath)
@@ -352,11 +595,13 @@ void HttpMetaCache::cleanupOldTruckPackCache(const QString& cachePath)
     
     // Remove the entry from the cache map
     // We need to find the entry that matches this full path
+    ensureLoaded();
     for (auto base_it = m_entries.begin(); base_it != m_entries.end(); ++base_it) {
         auto& entry_map = base_it.value();
         for (auto it = entry_map.entry_list.begin(); it != entry_map.entry_list.end(); ++it) {
             if (it.value()->getFullPath() == cachePath) {
                 qDebug() << "HttpMetaCache: Removing cache entry for path:" << it.key();
+                markDirty(base_it.key(), it.key());
                 entry_map.entry_list.erase(it);
                 SaveNow();
                 return;
@@ -35,8 +35,13 @@
 
 #pragma once
 
+#include <QDataStream>
+#include <QHash>
 #include <QMap>
+#include <QPair>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QTimer>
 #include <memory>
 
@@ -76,6 +81,9 @@ class MetaEntry {
 
     bool isExpired(qint64 offset) { return !m_is_eternal && (m_current_age >= m_max_age - offset); }
 
+    /* When the entry was last stored or resolved, in ms since the epoch. Only accurate to about an hour. */
+    auto getLastAccess() -> qint64 { return m_last_access; }
+
    protected:
     QString m_baseId;
     QString m_basePath;
@@ -87,6 +95,7 @@ class MetaEntry {
     QString m_remote_changed_timestamp;  // QString for now, RFC 2822 encoded time
     qint64 m_current_age = 0;
     qint64 m_max_age = 0;
+    qint64 m_last_access = 0;
     bool m_is_eternal = false;
 
     bool m_stale = true;
@@ -94,6 +103,13 @@ class MetaEntry {
 
 using MetaEntryPtr = std::shared_ptr<MetaEntry>;
 
+/**
+ * Remembers what was downloaded where, so requests can be revalidated instead of repeated.
+ *
+ * The index is kept on disk as a binary snapshot ('<index>.idx') and an append-only journal ('<index>.journal')
+ * of the entries that changed since. Saving only appends the changed entries to the journal, and the snapshot
+ * is rewritten once the journal outgrows it. Nothing is read before the first lookup.
+ */
 class HttpMetaCache : public QObject {
     Q_OBJECT
    public:
@@ -122,10 +138,21 @@ class HttpMetaCache : public QObject {
 
     // (re)start a timer that calls SaveNow later.
     void SaveEventually();
+    // read the index when it is first needed
     void Load();
 
     auto getBasePath(QString base) -> QString;
 
+    // disk space the files of a base may take up, in bytes. 0 is unlimited. enforced by MetaCacheGCTask
+    void setQuota(QString base, qint64 bytes);
+    auto getQuota(QString base) -> qint64;
+
+    auto getBases() -> QStringList;
+    // all entries of a base that aren't stale
+    auto getEntries(QString base) -> QList<MetaEntryPtr>;
+    // drop an entry whose file is gone, unless it was replaced in the meantime
+    auto forgetEntry(MetaEntryPtr entry) -> bool;
+
    public slots:
     void SaveNow();
 
@@ -133,12 +160,27 @@ class HttpMetaCache : public QObject {
     // create a new stale entry, given the parameters
     auto staleEntry(QString base, QString resource_path) -> MetaEntryPtr;
 
+    void ensureLoaded();
+    int loadRecords(const QString& path);
+    void loadLegacyIndex();
+    void markDirty(const QString& base, const QString& resource_path);
+    static void writeEntry(QDataStream& out, const MetaEntry& entry);
+    bool compact();
+
     struct EntryMap {
         QString base_path;
-        QMap<QString, MetaEntryPtr> entry_list;
+        QHash<QString, MetaEntryPtr> entry_list;
+        qint64 quota = 0;
     };
 
     QMap<QString, EntryMap> m_entries;
     QString m_index_file;
     QTimer saveBatchingTimer;
+
+    bool m_loadPending = false;
+    // entries that changed since the last save, by base and path
+    QSet<QPair<QString, QString>> m_dirty;
+    // records in the journal, and whether it has to be replaced by a new snapshot
+    int m_journalRecords = 0;
+    bool m_needsCompaction = false;
 };
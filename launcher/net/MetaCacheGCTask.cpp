@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MetaCacheGCTask.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+#include "FileSystem.h"
+#include "settings/INIFile.h"
+
+namespace {
+// entries used this recently may still be written to
+constexpr qint64 RecentlyUsed = 15 * 60 * 1000;
+}  // namespace
+
+MetaCacheGCTask::MetaCacheGCTask(shared_qobject_ptr<HttpMetaCache> cache, QStringList instanceRoots)
+    : m_cache(std::move(cache)), m_instanceRoots(std::move(instanceRoots))
+{
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &MetaCacheGCTask::collectFinished);
+}
+
+bool MetaCacheGCTask::abort()
+{
+    if (m_collecting) {
+        m_canceled = true;
+        // NOTE: emitAborted() happens once the worker actually stops
+        return true;
+    }
+    return Task::abort();
+}
+
+void MetaCacheGCTask::executeTask()
+{
+    setStatus(tr("Cleaning up the download cache"));
+
+    // the metacache isn't thread safe, so the worker gets plain copies of what it needs
+    QList<Base> bases;
+    for (auto& baseId : m_cache->getBases()) {
+        auto quota = m_cache->getQuota(baseId);
+        if (quota <= 0)
+            continue;
+        Base base;
+        base.quota = quota;
+        for (auto& entry : m_cache->getEntries(baseId)) {
+            base.candidates.append({ QFileInfo(entry->getFullPath()).absoluteFilePath(), entry->getLastAccess() });
+            m_entries.append(entry);
+        }
+        bases.append(base);
+    }
+    if (bases.isEmpty()) {
+        emitSucceeded();
+        return;
+    }
+
+    m_collecting = true;
+    m_canceled = false;
+    m_future = QtConcurrent::run(QThreadPool::globalInstance(),
+                                 [this, bases, now = QDateTime::currentMSecsSinceEpoch()] { return collect(bases, now); });
+    m_watcher.setFuture(m_future);
+}
+
+void MetaCacheGCTask::collectFinished()
+{
+    m_collecting = false;
+    auto result = m_future.isCanceled() ? Result{ true, {}, 0 } : m_future.result();
+    // whatever the worker removed is gone from the disk, canceled or not
+    for (auto index : result.removed)
+        m_cache->forgetEntry(m_entries.at(index));
+    m_entries.clear();
+    qDebug() << "MetaCacheGCTask: removed" << result.removed.size() << "cached files, freeing" << result.freedBytes << "bytes";
+    if (result.canceled) {
+        emitAborted();
+        return;
+    }
+    emitSucceeded();
+}
+
+auto MetaCacheGCTask::collect(QList<Base> bases, qint64 now) const -> Result
+{
+    // pooled threads get reused, so the priority has to go back to what it was
+    auto thread = QThread::currentThread();
+    auto priority = thread->priority();
+    if (priority == QThread::InheritPriority)
+        priority = QThread::NormalPriority;
+    thread->setPriority(QThread::IdlePriority);
+
+    QSet<QString> keep;
+    for (auto& root : m_instanceRoots) {
+        INIFile config;
+        if (!config.loadFile(FS::PathCombine(root, "instance.cfg")))
+            continue;
+        auto cachePath = config.get("TruckPackCachePath", "").toString();
+        if (!cachePath.isEmpty())
+            keep.insert(QFileInfo(cachePath).absoluteFilePath());
+    }
+
+    Result result;
+    int offset = 0;
+    for (auto& base : bases) {
+        struct File {
+            int index;
+            qint64 size;
+            qint64 lastAccess;
+        };
+        QList<File> files;
+        qint64 used = 0;
+        for (int i = 0; i < base.candidates.size(); i++) {
+            if (m_canceled) {
+                result.canceled = true;
+                break;
+            }
+            auto& candidate = base.candidates.at(i);
+            QFileInfo info(candidate.path);
+            if (!info.isFile()) {
+                // nothing to free, but the entry is of no use either
+                result.removed.append(offset + i);
+                continue;
+            }
+            used += info.size();
+            if (!keep.contains(candidate.path) && now - candidate.lastAccess > RecentlyUsed)
+                files.append({ offset + i, info.size(), candidate.lastAccess });
+        }
+
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.lastAccess < b.lastAccess; });
+        for (auto& file : files) {
+            if (m_canceled) {
+                result.canceled = true;
+                break;
+            }
+            if (used <= base.quota)
+                break;
+            auto& path = base.candidates.at(file.index - offset).path;
+            if (!QFile::remove(path)) {
+                qWarning() << "MetaCacheGCTask: failed to remove" << path;
+                continue;
+            }
+            used -= file.size;
+            result.freedBytes += file.size;
+            result.removed.append(file.index);
+        }
+        offset += base.candidates.size();
+    }
+
+    thread->setPriority(priority);
+    return result;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+#include "QObjectPtr.h"
+#include "net/HttpMetaCache.h"
+#include "tasks/Task.h"
+
+/**
+ * Brings every metacache base with a quota back under it, by removing the files that were used the longest time ago.
+ *
+ * Files installed instances still refer to ("TruckPackCachePath" in their instance.cfg) are never removed, and
+ * neither are files used in the last few minutes, which may belong to a download that is still going on. Files
+ * not known to the metacache are not counted and not touched.
+ *
+ * The files are looked at and removed on a low priority worker thread.
+ */
+class MetaCacheGCTask : public Task {
+    Q_OBJECT
+   public:
+    MetaCacheGCTask(shared_qobject_ptr<HttpMetaCache> cache, QStringList instanceRoots);
+
+    bool canAbort() const override { return true; }
+    bool abort() override;
+
+   protected:
+    void executeTask() override;
+
+   private:
+    struct Candidate {
+        QString path;
+        qint64 lastAccess = 0;
+    };
+    struct Base {
+        qint64 quota = 0;
+        QList<Candidate> candidates;
+    };
+    struct Result {
+        bool canceled = false;
+        // indices into m_entries whose files are gone
+        QList<int> removed;
+        qint64 freedBytes = 0;
+    };
+
+    Result collect(QList<Base> bases, qint64 now) const;
+    void collectFinished();
+
+   private:
+    shared_qobject_ptr<HttpMetaCache> m_cache;
+    QStringList m_instanceRoots;
+    QList<MetaEntryPtr> m_entries;
+
+    bool m_collecting = false;
+    // set on the GUI thread, polled by the worker
+    std::atomic<bool> m_canceled = false;
+    QFuture<Result> m_future;
+    QFutureWatcher<Result> m_watcher;
+};
@@ -56,6 +56,7 @@ MetaCacheSink::MetaCacheSink(MetaEntryPtr entry, ChecksumValidator* md5sum, bool
 
 Task::State MetaCacheSink::initCache(QNetworkRequest& request)
 {
+    m_requestedUrl = request.url();
     if (!m_entry->isStale()) {
         return Task::State::Succeeded;
     }
@@ -82,10 +83,16 @@ Task::State MetaCacheSink::finalizeCache(QNetworkReply& reply)
         m_entry->setMD5Sum(m_md5Node->hash().toHex().constData());
     }
 
-    m_entry->setETag(reply.rawHeader("ETag").constData());
+    if (reply.request().url() == m_requestedUrl) {
+        m_entry->setETag(reply.rawHeader("ETag").constData());
 
-    if (reply.hasRawHeader("Last-Modified")) {
-        m_entry->setRemoteChangedTimestamp(reply.rawHeader("Last-Modified").constData());
+        if (reply.hasRawHeader("Last-Modified")) {
+            m_entry->setRemoteChangedTimestamp(reply.rawHeader("Last-Modified").constData());
+        }
+    } else {
+        // a mirror racing the request sent the file: its validators mean nothing to the URL this entry is for
+        m_entry->setETag({});
+        m_entry->setRemoteChangedTimestamp({});
     }
 
     m_entry->setLocalChangedTimestamp(output_file_info.lastModified().toUTC().toMSecsSinceEpoch());
@@ -124,11 +131,42 @@ Task::State MetaCacheSink::finalizeCache(QNetworkReply& reply)
     }
 
     m_entry->setStale(false);
-    APPLICATION->metacache()->updateEntry(m_entry);
+    updateEntry();
 
     return Task::State::Succeeded;
 }
 
+Task::State MetaCacheSink::adopt(Sink& leader)
+{
+    auto other = dynamic_cast<MetaCacheSink*>(&leader);
+    if (!other || FileSink::adopt(leader) != Task::State::Succeeded)
+        return Task::State::Failed;
+
+    // both may have resolved their own entry for the file
+    if (other->m_entry != m_entry) {
+        m_entry->setMD5Sum(other->m_entry->getMD5Sum());
+        m_entry->setETag(other->m_entry->getETag());
+        m_entry->setRemoteChangedTimestamp(other->m_entry->getRemoteChangedTimestamp());
+        m_entry->setLocalChangedTimestamp(QFileInfo(m_filename).lastModified().toUTC().toMSecsSinceEpoch());
+        m_entry->makeEternal(other->m_entry->isEternal());
+        m_entry->setMaximumAge(other->m_entry->getMaximumAge());
+        m_entry->setCurrentAge(other->m_entry->getCurrentAge());
+    }
+    if (m_is_eternal)
+        m_entry->makeEternal(true);
+
+    m_entry->setStale(false);
+    updateEntry();
+    return Task::State::Succeeded;
+}
+
+void MetaCacheSink::updateEntry()
+{
+    // outside of the launcher (tests, benchmarks) whoever made the entry keeps track of it
+    if (APPLICATION_DYN)
+        APPLICATION->metacache()->updateEntry(m_entry);
+}
+
 bool MetaCacheSink::hasLocalData()
 {
     QFileInfo info(m_filename);
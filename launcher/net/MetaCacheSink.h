@@ -46,14 +46,20 @@ class MetaCacheSink : public FileSink {
     virtual ~MetaCacheSink() = default;
 
     auto hasLocalData() -> bool override;
+    auto adopt(Sink& leader) -> Task::State override;
 
    protected:
     auto initCache(QNetworkRequest& request) -> Task::State override;
     auto finalizeCache(QNetworkReply& reply) -> Task::State override;
 
+   private:
+    void updateEntry();
+
    private:
     MetaEntryPtr m_entry;
     ChecksumValidator* m_md5Node;
     bool m_is_eternal;
+    // the URL the request was sent to, the validators of replies from anywhere else aren't kept
+    QUrl m_requestedUrl;
 };
 }  // namespace Net
@@ -44,15 +44,41 @@
 #include "ui/dialogs/CustomMessageBox.h"
 #endif
 
+namespace {
+// jobs that didn't ask for a specific limit may run this many times the per-host limit, spread over several hosts
+constexpr int HostFanOut = 4;
+}  // namespace
+
 NetJob::NetJob(QString job_name, shared_qobject_ptr<QNetworkAccessManager> network, int max_concurrent)
     : ConcurrentTask(job_name), m_network(network)
 {
+    auto perHost = 6;
 #if defined(LAUNCHER_APPLICATION)
-    if (APPLICATION_DYN && max_concurrent < 0)
-        max_concurrent = APPLICATION->settings()->get("NumberOfConcurrentDownloads").toInt();
+    if (APPLICATION_DYN)
+        perHost = APPLICATION->settings()->get("NumberOfConcurrentDownloads").toInt();
 #endif
-    if (max_concurrent > 0)
-        setMaxConcurrent(max_concurrent);
+    Net::HostScheduler::instance()->setBaseWindow(perHost);
+    setMaxConcurrent(max_concurrent > 0 ? max_concurrent : perHost * HostFanOut);
+
+    connect(Net::HostScheduler::instance(), &Net::HostScheduler::capacityAvailable, this, &NetJob::executeNextSubTask,
+            Qt::QueuedConnection);
+
+    connect(this, &Task::finished, this, [this] { Net::HostScheduler::instance()->setWaiting(this, m_priority, 0); });
+}
+
+NetJob::~NetJob()
+{
+    auto scheduler = Net::HostScheduler::instance();
+    scheduler->setWaiting(this, m_priority, 0);
+    for (auto& origin : m_origins)
+        scheduler->release(origin, m_priority, {});
+}
+
+void NetJob::executeTask()
+{
+    // lower priorities hold back from the start
+    Net::HostScheduler::instance()->setWaiting(this, m_priority, m_queue.size());
+    ConcurrentTask::executeTask();
 }
 
 auto NetJob::addNetAction(Net::NetRequest::Ptr action) -> bool
@@ -75,7 +101,51 @@ void NetJob::executeNextSubTask()
             m_queue.enqueue(task);
         }
     }
-    ConcurrentTask::executeNextSubTask();
+
+    auto scheduler = Net::HostScheduler::instance();
+    if (!isRunning() || m_queue.isEmpty() || m_doing.count() >= m_total_max_size) {
+        ConcurrentTask::executeNextSubTask();
+        scheduler->setWaiting(this, m_priority, isRunning() ? m_queue.size() : 0);
+        return;
+    }
+
+    // start what the windows of the hosts allow, in order, without letting a busy host hold up the others
+    QSet<QString> full;
+    for (auto it = m_queue.begin(); it != m_queue.end() && m_doing.count() < m_total_max_size;) {
+        auto request = dynamic_cast<Net::NetRequest*>(it->get());
+        auto origin = request ? Net::HostScheduler::originOf(request->url()) : QString();
+        if (!origin.isEmpty() && (full.contains(origin) || !scheduler->tryAcquire(origin, m_priority))) {
+            full.insert(origin);
+            ++it;
+            continue;
+        }
+        auto task = *it;
+        it = m_queue.erase(it);
+        if (request)
+            request->setPriority(m_priority);
+        if (!origin.isEmpty())
+            m_origins.insert(task.get(), origin);
+        startSubTask(task);
+    }
+    scheduler->setWaiting(this, m_priority, m_queue.size());
+}
+
+void NetJob::subTaskFinished(Task::Ptr task, TaskStepState state)
+{
+    auto origin = m_origins.take(task.get());
+    ConcurrentTask::subTaskFinished(task, state);
+    if (origin.isEmpty())
+        return;
+
+    Net::HostScheduler::Result result;
+    result.succeeded = state == TaskStepState::Succeeded;
+    if (auto request = dynamic_cast<Net::NetRequest*>(task.get())) {
+        result.error = request->error();
+        result.statusCode = request->replyStatusCode();
+        result.bytes = request->getProgress();
+        result.http2 = request->wasHttp2();
+    }
+    Net::HostScheduler::instance()->release(origin, m_priority, result);
 }
 
 auto NetJob::size() const -> int
@@ -106,6 +176,7 @@ auto NetJob::abort() -> bool
     for (auto task : m_queue)
         m_failed.insert(task.get(), task);
     m_queue.clear();
+    Net::HostScheduler::instance()->setWaiting(this, m_priority, 0);
 
     // abort active downloads
     auto toKill = m_doing.values();
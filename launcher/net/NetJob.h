@@ -39,6 +39,7 @@
 #include <QtNetwork>
 
 #include <QObject>
+#include "net/HostScheduler.h"
 #include "net/NetRequest.h"
 #include "tasks/ConcurrentTask.h"
 
@@ -53,7 +54,7 @@ class NetJob : public ConcurrentTask {
     using Ptr = shared_qobject_ptr<NetJob>;
 
     explicit NetJob(QString job_name, shared_qobject_ptr<QNetworkAccessManager> network, int max_concurrent = -1);
-    ~NetJob() override = default;
+    ~NetJob() override;
 
     auto size() const -> int;
 
@@ -64,6 +65,10 @@ class NetJob : public ConcurrentTask {
     auto getFailedFiles() -> QList<QString>;
     void setAskRetry(bool askRetry);
 
+    /** Decides which requests go first when several jobs download at once. Interactive by default. */
+    void setPriority(Net::Priority priority) { m_priority = priority; }
+    Net::Priority priority() const { return m_priority; }
+
    public slots:
     // Qt can't handle auto at the start for some reason?
     bool abort() override;
@@ -71,8 +76,10 @@ class NetJob : public ConcurrentTask {
 
    protected slots:
     void executeNextSubTask() override;
+    void subTaskFinished(Task::Ptr task, TaskStepState state) override;
 
    protected:
+    void executeTask() override;
     void updateState() override;
     bool isOnline();
 
@@ -82,4 +89,8 @@ class NetJob : public ConcurrentTask {
     int m_try = 1;
     bool m_ask_retry = true;
     int m_manual_try = 0;
+    Net::Priority m_priority = Net::Priority::Interactive;
+
+    // the origins running requests hold a Net::HostScheduler slot for
+    QHash<Task*, QString> m_origins;
 };
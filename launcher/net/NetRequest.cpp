@@ -41,6 +41,7 @@
 
 #include <QDateTime>
 #include <QFileInfo>
+#include <QHash>
 #include <QNetworkReply>
 #include <QUrl>
 #include <memory>
@@ -55,6 +56,25 @@
 
 namespace Net {
 
+namespace {
+// the requests doing a transfer others may wait for, by flight key. Only touched from the main thread.
+QHash<QString, QPointer<NetRequest>> s_flights;
+
+// transfers slower than this (in bytes per second) get a mirror racing them
+constexpr qint64 HedgeMinimumRate = 64 * 1024;
+}  // namespace
+
+NetRequest::NetRequest() : Task()
+{
+    connect(this, &Task::finished, this, [this] {
+        if (!m_flightKey.isEmpty() && s_flights.value(m_flightKey) == this)
+            s_flights.remove(m_flightKey);
+        m_flightKey.clear();
+        finishTiming();
+    });
+    connect(&m_hedgeTimer, &QTimer::timeout, this, &NetRequest::checkHedge);
+}
+
 void NetRequest::addValidator(Validator* v)
 {
     m_sink->addValidator(v);
@@ -71,6 +91,24 @@ void NetRequest::executeTask()
         return;
     }
 
+    // redirects and mirrors continue the run of the request
+    if (!m_runTimer.isValid()) {
+        m_timing = {};
+        m_timing.started = QDateTime::currentDateTimeUtc();
+        m_timing.attempt = ++m_attempts;
+        m_runTimer.start();
+    }
+
+    // don't fetch what an identical request is fetching right now, the sink would only race with it.
+    // redirects and mirrors keep the key of the original URL, which others may be waiting on
+    if (auto key = m_flightKey.isEmpty() ? flightKey() : QString(); !key.isEmpty()) {
+        if (auto leader = s_flights.value(key); leader && leader != this) {
+            follow(leader);
+            return;
+        }
+        m_flightKey = key;
+    }
+
     QNetworkRequest request(m_url);
     m_state = m_sink->init(request);
     switch (m_state) {
@@ -94,7 +132,7 @@ void NetRequest::executeTask()
     }
 
 #if defined(LAUNCHER_APPLICATION)
-    auto user_agent = APPLICATION->getUserAgent();
+    auto user_agent = APPLICATION_DYN ? APPLICATION->getUserAgent() : BuildConfig.USER_AGENT;
 #else
     auto user_agent = BuildConfig.USER_AGENT;
 #endif
@@ -104,9 +142,23 @@ void NetRequest::executeTask()
         header_proxy->writeHeaders(request);
     }
 
+    auto rateLimit = effectiveRateLimit();
+    if (rateLimit > 0 || m_priority == Priority::Background)
+        request.setPriority(QNetworkRequest::LowPriority);
+    else if (m_priority == Priority::Launch)
+        request.setPriority(QNetworkRequest::HighPriority);
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    // on by default in Qt 6: many requests to the same host then share one connection
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
+
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
 #if defined(LAUNCHER_APPLICATION)
-    request.setTransferTimeout(APPLICATION->settings()->get("RequestTimeout").toInt() * 1000);
+    if (APPLICATION_DYN)
+        request.setTransferTimeout(APPLICATION->settings()->get("RequestTimeout").toInt() * 1000);
+    else
+        request.setTransferTimeout();
 #else
     request.setTransferTimeout();
 #endif
@@ -114,11 +166,40 @@ void NetRequest::executeTask()
 
     m_last_progress_time = m_clock.now();
     m_last_progress_bytes = 0;
+    m_headersProcessed = false;
+    m_request = request;
+    m_bodyBytes = 0;
 
     auto rep = getReply(request);
     if (rep == nullptr)  // it failed
         return;
     m_reply.reset(rep);
+    if (!m_flightKey.isEmpty())
+        s_flights.insert(m_flightKey, this);
+
+    m_replyTimer.start();
+    m_timing.url = m_url.toString();
+    m_timing.host = HostScheduler::originOf(m_url);
+    m_timing.connectStarted = m_timing.encrypted = m_timing.requestSent = m_timing.firstByte = m_timing.finished = -1;
+    connect(rep, &QNetworkReply::metaDataChanged, this, [this] {
+        if (m_timing.firstByte < 0)
+            m_timing.firstByte = m_replyTimer.elapsed();
+    });
+    connect(rep, &QNetworkReply::encrypted, this, [this] { m_timing.encrypted = m_replyTimer.elapsed(); });
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    connect(rep, &QNetworkReply::socketStartedConnecting, this, [this] { m_timing.connectStarted = m_replyTimer.elapsed(); });
+    connect(rep, &QNetworkReply::requestSent, this, [this] { m_timing.requestSent = m_replyTimer.elapsed(); });
+#endif
+
+    if (rateLimit > 0) {
+        // a small read buffer makes the socket stop receiving while we hold back, instead of buffering everything
+        rep->setReadBufferSize(std::max<qint64>(rateLimit / 4, 16 * 1024));
+    }
+    // the limit of the priority may be set while the request runs
+    m_rateStart = m_clock.now();
+    m_rateBytes = 0;
+    m_rateTimer.setSingleShot(true);
+    connect(&m_rateTimer, &QTimer::timeout, this, &NetRequest::downloadReadyRead, Qt::UniqueConnection);
     connect(rep, &QNetworkReply::uploadProgress, this, &NetRequest::onProgress);
     connect(rep, &QNetworkReply::downloadProgress, this, &NetRequest::onProgress);
     connect(rep, &QNetworkReply::finished, this, &NetRequest::downloadFinished);
@@ -129,6 +210,10 @@ void NetRequest::executeTask()
 #endif
     connect(rep, &QNetworkReply::sslErrors, this, &NetRequest::sslErrors);
     connect(rep, &QNetworkReply::readyRead, this, &NetRequest::downloadReadyRead);
+
+    m_hedgeCheckBytes = 0;
+    if (canHedge(request, rateLimit))
+        m_hedgeTimer.start(m_hedgeAfter);
 }
 
 void NetRequest::onProgress(qint64 bytesReceived, qint64 bytesTotal)
@@ -240,6 +325,7 @@ auto NetRequest::handleRedirect() -> bool
     }
 
     m_url = QUrl(redirect.toString());
+    m_timing.redirects++;
     qCDebug(logCat) << getUid().toString() << "Following redirect to " << m_url.toString();
     executeTask();
 
@@ -248,12 +334,23 @@ auto NetRequest::handleRedirect() -> bool
 
 void NetRequest::downloadFinished()
 {
+    m_rateTimer.stop();
+    m_timing.finished = m_replyTimer.elapsed();
+
     // handle HTTP redirection first
     if (handleRedirect()) {
         qCDebug(logCat) << getUid().toString() << "Request redirected:" << m_url.toString();
         return;
     }
 
+    m_hedgeTimer.stop();
+    if (m_state == State::Failed && m_hedge) {
+        qCDebug(logCat) << getUid().toString() << "Request failed, waiting for the mirror:" << m_url.toString();
+        m_waitingForHedge = true;
+        return;
+    }
+    dropHedge();
+
     // if the download failed before this point ...
     if (m_state == State::Succeeded)  // pretend to succeed so we continue processing :)
     {
@@ -264,6 +361,8 @@ void NetRequest::downloadFinished()
         return;
     } else if (m_state == State::Failed) {
         qCDebug(logCat) << getUid().toString() << "Request failed in previous step:" << m_url.toString();
+        if (tryNextMirror())
+            return;
         m_sink->abort();
         emit failed(m_reply->errorString());
         emit finished();
@@ -276,24 +375,43 @@ void NetRequest::downloadFinished()
         return;
     }
 
+    if (!processHeaders()) {
+        if (tryNextMirror())
+            return;
+        m_sink->abort();
+        emit failed("failed to process the response headers");
+        emit finished();
+        return;
+    }
+
     // make sure we got all the remaining data, if any
-    auto data = m_reply->readAll();
-    if (data.size()) {
-        qCDebug(logCat) << getUid().toString() << "Writing extra" << data.size() << "bytes";
+    QElapsedTimer sinkTimer;
+    sinkTimer.start();
+    if (m_reply->bytesAvailable() > 0)
+        qCDebug(logCat) << getUid().toString() << "Writing extra" << m_reply->bytesAvailable() << "bytes";
+    while (m_reply->bytesAvailable() > 0) {
+        auto& data = readChunk(*m_reply, m_reply->bytesAvailable());
+        if (data.isEmpty())
+            break;
+        m_timing.bytes += data.size();
         m_state = m_sink->write(data);
-        if (m_state != State::Succeeded) {
+        if (m_state == State::Failed) {
             qCDebug(logCat) << getUid().toString() << "Request failed to write:" << m_url.toString();
             m_sink->abort();
             emit failed("failed to write in sink");
             emit finished();
             return;
         }
+        m_bodyBytes += data.size();
     }
 
     // otherwise, finalize the whole graph
     m_state = m_sink->finalize(*m_reply.get());
+    m_timing.sinkNsecs += sinkTimer.nsecsElapsed();
     if (m_state != State::Succeeded) {
         qCDebug(logCat) << getUid().toString() << "Request failed to finalize:" << m_url.toString();
+        if (tryNextMirror())
+            return;
         m_sink->abort();
         emit failed("failed to finalize the request");
         emit finished();
@@ -305,23 +423,332 @@ void NetRequest::downloadFinished()
     emit finished();
 }
 
+auto NetRequest::processHeaders() -> bool
+{
+    if (m_headersProcessed)
+        return true;
+    m_headersProcessed = true;
+    m_state = m_sink->headersReceived(*m_reply.get());
+    return m_state == State::Running;
+}
+
+qint64 NetRequest::effectiveRateLimit() const
+{
+    auto shared = HostScheduler::instance()->bandwidthLimit(m_priority);
+    if (m_rateLimit > 0 && shared > 0)
+        return std::min(m_rateLimit, shared);
+    return std::max(m_rateLimit, shared);
+}
+
+auto NetRequest::readAllowed() -> qint64
+{
+    auto scheduler = HostScheduler::instance();
+    auto available = m_reply->bytesAvailable();
+    if (m_rateLimit <= 0 && scheduler->bandwidthLimit(m_priority) <= 0)
+        return available;
+
+    auto allowed = available;
+    qint64 wait = 100;
+    if (m_rateLimit > 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(m_clock.now() - m_rateStart).count();
+        allowed = std::min(allowed, m_rateLimit * elapsed / 1000 - m_rateBytes);
+        if (allowed <= 0)
+            wait = (-allowed * 1000 / m_rateLimit) + 100;
+    }
+    // the budget shared with the other requests of the same priority
+    if (allowed > 0)
+        allowed = scheduler->takeBandwidth(m_priority, allowed);
+    if (allowed < available) {
+        // come back once the budget allows for more
+        m_rateTimer.start(static_cast<int>(std::min<qint64>(wait, 1000)));
+    }
+    return std::max<qint64>(allowed, 0);
+}
+
+auto NetRequest::readChunk(QIODevice& device, qint64 max) -> QByteArray&
+{
+    // a sink that keeps the data (instead of just writing or hashing it) holds a reference to the buffer,
+    // start a new one instead of copying the old contents over
+    if (!m_readBuffer.isDetached())
+        m_readBuffer = QByteArray();
+    if (m_readBuffer.capacity() < ReadChunkSize)
+        m_readBuffer.reserve(ReadChunkSize);
+
+    m_readBuffer.resize(static_cast<int>(std::min(max, ReadChunkSize)));
+    auto got = device.read(m_readBuffer.data(), m_readBuffer.size());
+    m_readBuffer.resize(static_cast<int>(std::max<qint64>(got, 0)));
+    return m_readBuffer;
+}
+
 void NetRequest::downloadReadyRead()
 {
-    if (m_state == State::Running) {
-        auto data = m_reply->readAll();
+    if (!m_reply || m_reply->isFinished())
+        return;
+    if (m_state != State::Running) {
+        qCCritical(logCat) << getUid().toString() << "Cannot write download data! illegal status " << m_status;
+        return;
+    }
+
+    auto allowed = readAllowed();
+    while (allowed > 0 && m_state == State::Running) {
+        auto& data = readChunk(*m_reply, allowed);
+        if (data.isEmpty())
+            return;
+        allowed -= data.size();
+        m_rateBytes += data.size();
+        // the body of a redirect is not what we asked for
+        auto status = replyStatusCode();
+        if (status >= 300 && status < 400)
+            continue;
+        if (!processHeaders()) {
+            qCCritical(logCat) << getUid().toString() << "Failed to process response headers";
+            m_reply->abort();
+            return;
+        }
+        QElapsedTimer sinkTimer;
+        sinkTimer.start();
         m_state = m_sink->write(data);
+        m_timing.sinkNsecs += sinkTimer.nsecsElapsed();
+        m_timing.bytes += data.size();
         if (m_state == State::Failed) {
             qCCritical(logCat) << getUid().toString() << "Failed to process response chunk";
+            // no point in receiving the rest of the response
+            m_reply->abort();
+            return;
         }
-        // qDebug() << "Request" << m_url.toString() << "gained" << data.size() << "bytes";
-    } else {
-        qCCritical(logCat) << getUid().toString() << "Cannot write download data! illegal status " << m_status;
+        m_bodyBytes += data.size();
+    }
+}
+
+auto NetRequest::tryNextMirror() -> bool
+{
+    if (m_state == State::AbortedByUser || m_nextMirror >= m_mirrors.size())
+        return false;
+
+    auto mirror = m_mirrors.at(m_nextMirror++);
+    qCWarning(logCat) << getUid().toString() << "Failed to fetch" << m_url.toString() << "- trying the mirror" << mirror.toString();
+    m_sink->abort();
+    m_url = mirror;
+    m_timing.mirrorSwitches++;
+    executeTask();
+    return true;
+}
+
+bool NetRequest::canHedge(const QNetworkRequest& request, qint64 rateLimit) const
+{
+    // the mirror's data continues where the first reply left off. that only works for the same, whole, known file
+    if (m_nextMirror >= m_mirrors.size() || request.hasRawHeader("Range") || !m_sink->verifiesContent())
+        return false;
+    // nobody waits for these, they don't need to be fast
+    return rateLimit <= 0 && m_priority != Priority::Background;
+}
+
+void NetRequest::checkHedge()
+{
+    if (m_hedge || !m_reply || m_nextMirror >= m_mirrors.size()) {
+        m_hedgeTimer.stop();
+        return;
+    }
+
+    auto rate = (m_bodyBytes - m_hedgeCheckBytes) * 1000 / m_hedgeAfter;
+    m_hedgeCheckBytes = m_bodyBytes;
+    if (rate >= HedgeMinimumRate)
+        return;
+    // nearly done anyway
+    auto length = m_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    if (length > 0 && length - m_bodyBytes <= HedgeMinimumRate * m_hedgeAfter / 1000)
+        return;
+
+    m_hedgeTimer.stop();
+    startHedge();
+}
+
+void NetRequest::startHedge()
+{
+    auto mirror = m_mirrors.at(m_nextMirror++);
+    m_hedgeBuffer.reset(new QTemporaryFile());
+    if (!m_hedgeBuffer->open()) {
+        qCWarning(logCat) << getUid().toString() << "Could not buffer a second transfer:" << m_hedgeBuffer->errorString();
+        m_hedgeBuffer.reset();
+        return;
+    }
+
+    qCDebug(logCat) << getUid().toString() << "Transfer of" << m_url.toString() << "is slow, racing the mirror" << mirror.toString();
+    m_timing.hedged = true;
+    QNetworkRequest request(m_request);
+    request.setUrl(mirror);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    m_hedge.reset(m_network->get(request));
+    connect(m_hedge.get(), &QNetworkReply::readyRead, this, [this] { m_hedgeBuffer->write(m_hedge->readAll()); });
+    connect(m_hedge.get(), &QNetworkReply::finished, this, &NetRequest::hedgeFinished);
+}
+
+void NetRequest::hedgeFinished()
+{
+    auto status = m_hedge->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (m_hedge->error() != QNetworkReply::NoError || status != 200) {
+        qCWarning(logCat) << getUid().toString() << "Mirror" << m_hedge->url().toString() << "failed:" << m_hedge->errorString();
+        dropHedge();
+        if (m_waitingForHedge) {
+            // nothing is running anymore: go on with the failure of the first reply
+            m_waitingForHedge = false;
+            downloadFinished();
+        } else if (m_reply && !m_reply->isFinished() && canHedge(m_request, effectiveRateLimit())) {
+            m_hedgeTimer.start(m_hedgeAfter);
+        }
+        return;
+    }
+
+    // the mirror won: stop the first reply, and hand the sink the part of the file it didn't get yet
+    qCDebug(logCat) << getUid().toString() << "Mirror" << m_hedge->url().toString() << "finished first";
+    m_hedgeBuffer->write(m_hedge->readAll());
+    m_rateTimer.stop();
+    // the sink may have taken the headers of the first reply already. handing it the mirror's as well would start its
+    // file over, so the mirror has to announce the same file instead
+    auto sameFile = !m_headersProcessed || !m_reply || announcesSameFile(*m_reply, *m_hedge);
+    if (m_reply) {
+        disconnect(m_reply.get(), nullptr, this, nullptr);
+        m_reply->abort();
+    }
+    m_url = m_hedge->url();
+    m_reply = std::move(m_hedge);
+    auto buffer = std::move(m_hedgeBuffer);
+    m_waitingForHedge = false;
+    m_state = State::Running;
+
+    if (!sameFile || !processHeaders() || !buffer->flush() || !buffer->seek(m_bodyBytes)) {
+        m_sink->abort();
+        emit failed("the mirror sent a different file");
+        emit finished();
+        return;
+    }
+    QElapsedTimer sinkTimer;
+    sinkTimer.start();
+    m_timing.bytes += buffer->size() - m_bodyBytes;
+    while (!buffer->atEnd()) {
+        auto& chunk = readChunk(*buffer, buffer->bytesAvailable());
+        if (chunk.isEmpty())
+            break;
+        m_state = m_sink->write(chunk);
+        if (m_state == State::Failed) {
+            m_sink->abort();
+            emit failed("failed to write in sink");
+            emit finished();
+            return;
+        }
+        m_bodyBytes += chunk.size();
+    }
+    m_timing.sinkNsecs += sinkTimer.nsecsElapsed();
+    // the checksum decides whether the two really were the same file
+    downloadFinished();
+}
+
+bool NetRequest::announcesSameFile(QNetworkReply& first, QNetworkReply& mirror)
+{
+    // a compressed transfer only announces the size on the wire, leave those to the checksum
+    if (first.hasRawHeader("Content-Encoding") || mirror.hasRawHeader("Content-Encoding"))
+        return true;
+    auto firstLength = first.header(QNetworkRequest::ContentLengthHeader);
+    auto mirrorLength = mirror.header(QNetworkRequest::ContentLengthHeader);
+    return !firstLength.isValid() || !mirrorLength.isValid() || firstLength.toLongLong() == mirrorLength.toLongLong();
+}
+
+void NetRequest::dropHedge()
+{
+    if (m_hedge) {
+        disconnect(m_hedge.get(), nullptr, this, nullptr);
+        m_hedge->abort();
+        m_hedge.reset();
+    }
+    m_hedgeBuffer.reset();
+}
+
+void NetRequest::finishTiming()
+{
+    if (!m_runTimer.isValid())
+        return;
+    // nothing went over the network: cache hits, and requests that took over the result of another one
+    if (!m_timing.host.isEmpty()) {
+        m_timing.total = m_runTimer.elapsed();
+        m_timing.statusCode = replyStatusCode();
+        m_timing.http2 = wasHttp2();
+        m_timing.succeeded = m_state == State::Succeeded;
+        if (!m_timing.succeeded)
+            m_timing.error = errorString();
+        TimingLog::instance()->record(m_timing);
+    }
+    m_runTimer.invalidate();
+}
+
+auto NetRequest::flightKey() const -> QString
+{
+    if (!canShareTransfer() || !m_sink)
+        return {};
+    auto key = m_sink->flightKey();
+    if (key.isEmpty())
+        return {};
+
+    // requests that authenticate differently may not get the same response
+    QNetworkRequest request(m_url);
+    for (auto& header_proxy : m_headerProxies)
+        header_proxy->writeHeaders(request);
+    QStringList parts{ m_url.toString(QUrl::FullyEncoded), key };
+    for (auto& header : request.rawHeaderList())
+        parts << QString::fromLatin1(header + ": " + request.rawHeader(header));
+    return parts.join('\n');
+}
+
+void NetRequest::follow(NetRequest* leader)
+{
+    qCDebug(logCat) << getUid().toString() << "Waiting for" << leader->getUid().toString() << "to fetch" << m_url.toString();
+    setStatus(tr("Waiting for another download of %1").arg(StringUtils::truncateUrlHumanFriendly(m_url, 80)));
+    m_leader = leader;
+    connect(leader, &Task::progress, this, &NetRequest::setProgress);
+    connect(leader, &Task::finished, this, &NetRequest::leaderFinished);
+    connect(leader, &QObject::destroyed, this, &NetRequest::leaderFinished);
+}
+
+void NetRequest::leaderFinished()
+{
+    auto leader = m_leader.data();
+    if (leader)
+        disconnect(leader, nullptr, this, nullptr);
+    m_leader.clear();
+    if (m_state == State::AbortedByUser)
+        return;
+
+    if (leader && leader->wasSuccessful() && m_sink->adopt(*leader->m_sink) == State::Succeeded) {
+        qCDebug(logCat) << getUid().toString() << "Took over the result of" << leader->getUid().toString() << "for" << m_url.toString();
+        m_state = State::Succeeded;
+        emit succeeded();
+        emit finished();
+        return;
     }
+
+    // it didn't work out for the other request, or its result can't be used here: try on our own
+    executeTask();
 }
 
 auto NetRequest::abort() -> bool
 {
     m_state = State::AbortedByUser;
+    m_rateTimer.stop();
+    m_hedgeTimer.stop();
+    dropHedge();
+    if (m_waitingForHedge) {
+        // the first reply is done already, nothing would report the abort
+        m_waitingForHedge = false;
+        emit aborted();
+        emit finished();
+        return true;
+    }
+    if (m_leader) {
+        disconnect(m_leader, nullptr, this, nullptr);
+        m_leader.clear();
+        emit aborted();
+        emit finished();
+        return true;
+    }
     if (m_reply) {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)  // QNetworkReply::errorOccurred added in 5.15
         disconnect(m_reply.get(), &QNetworkReply::errorOccurred, nullptr, nullptr);
@@ -338,6 +765,11 @@ int NetRequest::replyStatusCode() const
     return m_reply ? m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() : -1;
 }
 
+bool NetRequest::wasHttp2() const
+{
+    return m_reply && m_reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+}
+
 QNetworkReply::NetworkError NetRequest::error() const
 {
     return m_reply ? m_reply->error() : QNetworkReply::NoError;
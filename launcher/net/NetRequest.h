@@ -40,11 +40,18 @@
 #pragma once
 
 #include <qloggingcategory.h>
+#include <QElapsedTimer>
 #include <QNetworkReply>
+#include <QPointer>
+#include <QTemporaryFile>
+#include <QTimer>
 #include <QUrl>
 #include <chrono>
+#include <memory>
 
 #include "HeaderProxy.h"
+#include "HostScheduler.h"
+#include "RequestTimings.h"
 #include "Sink.h"
 #include "Validator.h"
 
@@ -56,11 +63,11 @@ namespace Net {
 class NetRequest : public Task {
     Q_OBJECT
    protected:
-    explicit NetRequest() : Task() {}
+    explicit NetRequest();
 
    public:
     using Ptr = shared_qobject_ptr<class NetRequest>;
-    enum class Option { NoOptions = 0, AcceptLocalFiles = 1, MakeEternal = 2 };
+    enum class Option { NoOptions = 0, AcceptLocalFiles = 1, MakeEternal = 2, Resumable = 4 };
     Q_DECLARE_FLAGS(Options, Option)
 
    public:
@@ -71,16 +78,41 @@ class NetRequest : public Task {
 
     void setNetwork(shared_qobject_ptr<QNetworkAccessManager> network) { m_network = network; }
     void addHeaderProxy(Net::HeaderProxy* proxy) { m_headerProxies.push_back(std::shared_ptr<Net::HeaderProxy>(proxy)); }
+    /** Receive at most this many bytes per second, at low priority. 0 means no limit. */
+    void setRateLimit(qint64 bytesPerSecond) { m_rateLimit = bytesPerSecond; }
+    /** Set by the NetJob running the request. Its priority may have a bandwidth limit as well. */
+    void setPriority(Priority priority) { m_priority = priority; }
 
     QUrl url() const;
     void setUrl(QUrl url) { m_url = url; }
     int replyStatusCode() const;
+    /** Whether the last reply came over HTTP/2. */
+    bool wasHttp2() const;
     QNetworkReply::NetworkError error() const;
     QString errorString() const;
 
    private:
     auto handleRedirect() -> bool;
+    qint64 effectiveRateLimit() const;
+    auto flightKey() const -> QString;
+    void follow(NetRequest* leader);
+    void leaderFinished();
+    auto processHeaders() -> bool;
+    auto tryNextMirror() -> bool;
+    bool canHedge(const QNetworkRequest& request, qint64 rateLimit) const;
+    void checkHedge();
+    void startHedge();
+    void hedgeFinished();
+    static bool announcesSameFile(QNetworkReply& first, QNetworkReply& mirror);
+    void dropHedge();
+    void finishTiming();
+    /** How much of the reply may be read right now, within the rate limits. */
+    auto readAllowed() -> qint64;
+    /** Reads up to \p max bytes of \p device into the reused read buffer. */
+    auto readChunk(QIODevice& device, qint64 max) -> QByteArray&;
     virtual QNetworkReply* getReply(QNetworkRequest&) = 0;
+    /** Whether identical requests running at the same time may share one transfer. */
+    virtual bool canShareTransfer() const { return false; }
 
    protected slots:
     void onProgress(qint64 bytesReceived, qint64 bytesTotal);
@@ -105,6 +137,44 @@ class NetRequest : public Task {
 
     /// the network reply
     unique_qobject_ptr<QNetworkReply> m_reply;
+    bool m_headersProcessed = false;
+
+    qint64 m_rateLimit = 0;
+    Priority m_priority = Priority::Interactive;
+    qint64 m_rateBytes = 0;
+    std::chrono::time_point<std::chrono::steady_clock> m_rateStart;
+    QTimer m_rateTimer;
+
+    /// every chunk of the response goes through this buffer, and from there into the sink and its validators
+    static constexpr qint64 ReadChunkSize = 256 * 1024;
+    QByteArray m_readBuffer;
+
+    /// the key this request is transferring for, if others may wait for it
+    QString m_flightKey;
+    /// the identical request this one waits for
+    QPointer<NetRequest> m_leader;
+
+    /// other URLs serving the same file, tried in order (see Download::setMirrors())
+    QList<QUrl> m_mirrors;
+    int m_nextMirror = 0;
+    int m_hedgeAfter = 5000;
+    /// the request as it was sent, so it can go to a mirror as well
+    QNetworkRequest m_request;
+    /// how much of the current reply's body went into the sink
+    qint64 m_bodyBytes = 0;
+    qint64 m_hedgeCheckBytes = 0;
+    QTimer m_hedgeTimer;
+    /// the same file from a mirror, buffered until it either wins or loses the race
+    unique_qobject_ptr<QNetworkReply> m_hedge;
+    std::unique_ptr<QTemporaryFile> m_hedgeBuffer;
+    /// the first reply failed while the mirror is still going
+    bool m_waitingForHedge = false;
+
+    /// where the current run of the request spends its time, see TimingLog
+    RequestTiming m_timing;
+    QElapsedTimer m_runTimer;
+    QElapsedTimer m_replyTimer;
+    int m_attempts = 0;
 
     /// source URL
     QUrl m_url;
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RequestTimings.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+#include "FileSystem.h"
+
+namespace Net {
+
+const QVector<qint64> TimingLog::DurationBuckets = { 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+const QVector<qint64> TimingLog::ThroughputBuckets = { 64, 256, 1024, 4096, 16384 };
+
+namespace {
+int bucketOf(const QVector<qint64>& bounds, qint64 value)
+{
+    return std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+}
+
+QJsonObject histogramJson(const QVector<qint64>& bounds, const QVector<int>& counts)
+{
+    QJsonObject histogram;
+    for (int i = 0; i < counts.size(); i++) {
+        auto label = i < bounds.size() ? "<" + QString::number(bounds.at(i)) : ">=" + QString::number(bounds.last());
+        histogram.insert(label, counts.at(i));
+    }
+    return histogram;
+}
+
+QString csvField(QString value)
+{
+    if (value.contains(',') || value.contains('"') || value.contains('\n'))
+        return '"' + value.replace('"', "\"\"") + '"';
+    return value;
+}
+}  // namespace
+
+TimingLog::TimingLog(int maxRecords) : m_maxRecords(maxRecords) {}
+
+TimingLog* TimingLog::instance()
+{
+    // never destroyed, requests may still finish while the application shuts down
+    static auto* log = new TimingLog;
+    return log;
+}
+
+void TimingLog::record(const RequestTiming& timing)
+{
+    QMutexLocker locker(&m_lock);
+    m_records.append(timing);
+    while (m_records.size() > m_maxRecords)
+        m_records.removeFirst();
+
+    auto& stats = m_hosts[timing.host];
+    if (stats.requests == 0) {
+        stats.firstByte.fill(0, DurationBuckets.size() + 1);
+        stats.total.fill(0, DurationBuckets.size() + 1);
+        stats.throughput.fill(0, ThroughputBuckets.size() + 1);
+    }
+    stats.requests++;
+    if (!timing.succeeded)
+        stats.failures++;
+    stats.bytes += timing.bytes;
+    stats.sinkNsecs += timing.sinkNsecs;
+    if (timing.firstByte >= 0)
+        stats.firstByte[bucketOf(DurationBuckets, timing.firstByte)]++;
+    stats.total[bucketOf(DurationBuckets, timing.total)]++;
+    // the time to first byte says more about tiny transfers than their throughput does
+    if (timing.succeeded && timing.bytes >= 64 * 1024 && timing.finished > timing.firstByte && timing.firstByte >= 0) {
+        auto kibPerSecond = timing.bytes * 1000 / 1024 / (timing.finished - timing.firstByte);
+        stats.throughput[bucketOf(ThroughputBuckets, kibPerSecond)]++;
+    }
+}
+
+void TimingLog::clear()
+{
+    QMutexLocker locker(&m_lock);
+    m_records.clear();
+    m_hosts.clear();
+}
+
+QList<RequestTiming> TimingLog::records() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_records;
+}
+
+QHash<QString, TimingLog::HostStats> TimingLog::hosts() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_hosts;
+}
+
+QJsonObject TimingLog::toJson() const
+{
+    QMutexLocker locker(&m_lock);
+
+    QJsonObject hosts;
+    for (auto it = m_hosts.constBegin(); it != m_hosts.constEnd(); ++it) {
+        auto& stats = it.value();
+        QJsonObject host;
+        host.insert("requests", stats.requests);
+        host.insert("failures", stats.failures);
+        host.insert("bytes", double(stats.bytes));
+        host.insert("sink_ms", double(stats.sinkNsecs / 1000000));
+        host.insert("first_byte_ms", histogramJson(DurationBuckets, stats.firstByte));
+        host.insert("total_ms", histogramJson(DurationBuckets, stats.total));
+        host.insert("throughput_kib_s", histogramJson(ThroughputBuckets, stats.throughput));
+        hosts.insert(it.key(), host);
+    }
+
+    QJsonArray records;
+    for (auto& timing : m_records) {
+        QJsonObject record;
+        record.insert("url", timing.url);
+        record.insert("host", timing.host);
+        record.insert("started", timing.started.toString(Qt::ISODateWithMs));
+        record.insert("attempt", timing.attempt);
+        record.insert("connect_started_ms", double(timing.connectStarted));
+        record.insert("encrypted_ms", double(timing.encrypted));
+        record.insert("request_sent_ms", double(timing.requestSent));
+        record.insert("first_byte_ms", double(timing.firstByte));
+        record.insert("finished_ms", double(timing.finished));
+        record.insert("total_ms", double(timing.total));
+        record.insert("sink_ms", timing.sinkNsecs / 1000000.0);
+        record.insert("bytes", double(timing.bytes));
+        record.insert("status", timing.statusCode);
+        record.insert("http2", timing.http2);
+        record.insert("succeeded", timing.succeeded);
+        record.insert("error", timing.error);
+        record.insert("redirects", timing.redirects);
+        record.insert("mirror_switches", timing.mirrorSwitches);
+        record.insert("hedged", timing.hedged);
+        records.append(record);
+    }
+
+    QJsonObject root;
+    root.insert("hosts", hosts);
+    root.insert("requests", records);
+    return root;
+}
+
+QByteArray TimingLog::toCsv() const
+{
+    QMutexLocker locker(&m_lock);
+
+    QStringList lines;
+    lines << "url,host,started,attempt,connect_started_ms,encrypted_ms,request_sent_ms,first_byte_ms,finished_ms,total_ms,sink_ms,"
+             "bytes,status,http2,succeeded,error,redirects,mirror_switches,hedged";
+    for (auto& timing : m_records) {
+        QStringList fields{ csvField(timing.url),
+                            csvField(timing.host),
+                            timing.started.toString(Qt::ISODateWithMs),
+                            QString::number(timing.attempt),
+                            QString::number(timing.connectStarted),
+                            QString::number(timing.encrypted),
+                            QString::number(timing.requestSent),
+                            QString::number(timing.firstByte),
+                            QString::number(timing.finished),
+                            QString::number(timing.total),
+                            QString::number(timing.sinkNsecs / 1000000.0, 'f', 3),
+                            QString::number(timing.bytes),
+                            QString::number(timing.statusCode),
+                            timing.http2 ? "1" : "0",
+                            timing.succeeded ? "1" : "0",
+                            csvField(timing.error),
+                            QString::number(timing.redirects),
+                            QString::number(timing.mirrorSwitches),
+                            timing.hedged ? "1" : "0" };
+        lines << fields.join(',');
+    }
+    return lines.join('\n').toUtf8() + '\n';
+}
+
+bool TimingLog::exportTo(const QString& path) const
+{
+    auto data = path.endsWith(".csv", Qt::CaseInsensitive) ? toCsv() : QJsonDocument(toJson()).toJson();
+    try {
+        FS::write(path, data);
+    } catch (const FS::FileSystemException& e) {
+        qWarning() << "Net::TimingLog: could not export request timings to" << path << ":" << e.cause();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace Net
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace Net {
+
+/**
+ * Where one run of a request spent its time. Runs start when a request (or a retry of it) starts, and include the
+ * redirects and mirrors it went through. Cache hits and requests that waited for an identical one aren't recorded.
+ *
+ * The phases are in milliseconds since the last reply was sent, -1 if they didn't happen or Qt can't tell. Qt doesn't
+ * expose DNS lookups: connectStarted includes them, and is only known with Qt 6.3 and up. Without it, a reused
+ * connection and an unknown one look the same.
+ */
+struct RequestTiming {
+    QString url;
+    QString host;
+    QDateTime started;
+    int attempt = 1;
+
+    qint64 connectStarted = -1;
+    qint64 encrypted = -1;
+    qint64 requestSent = -1;
+    qint64 firstByte = -1;
+    qint64 finished = -1;
+    /** Everything, from the start of the run. */
+    qint64 total = 0;
+    /** Time spent in the sink: writing to disk, hashing, extracting. */
+    qint64 sinkNsecs = 0;
+
+    qint64 bytes = 0;
+    int statusCode = 0;
+    bool http2 = false;
+    bool succeeded = false;
+    QString error;
+
+    int redirects = 0;
+    int mirrorSwitches = 0;
+    bool hedged = false;
+};
+
+/**
+ * Collects the timings of all requests, and sums them up per host.
+ *
+ * Keeps the last few thousand records; the per-host histograms cover every request since the launcher started. The
+ * JSON export has both, the CSV export one line per record.
+ */
+class TimingLog {
+   public:
+    /** Upper bounds of the histogram buckets, the last bucket takes everything above. */
+    static const QVector<qint64> DurationBuckets;    // ms
+    static const QVector<qint64> ThroughputBuckets;  // KiB/s
+
+    struct HostStats {
+        int requests = 0;
+        int failures = 0;
+        qint64 bytes = 0;
+        qint64 sinkNsecs = 0;
+        QVector<int> firstByte;
+        QVector<int> total;
+        QVector<int> throughput;
+    };
+
+    explicit TimingLog(int maxRecords = 5000);
+
+    static TimingLog* instance();
+
+    void record(const RequestTiming& timing);
+    void clear();
+
+    QList<RequestTiming> records() const;
+    QHash<QString, HostStats> hosts() const;
+
+    QJsonObject toJson() const;
+    QByteArray toCsv() const;
+    /** Write the JSON or, for file names ending in ".csv", the CSV export. */
+    bool exportTo(const QString& path) const;
+
+   private:
+    mutable QMutex m_lock;
+    int m_maxRecords;
+    QList<RequestTiming> m_records;
+    QHash<QString, HostStats> m_hosts;
+};
+
+}  // namespace Net
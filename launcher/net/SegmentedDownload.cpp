@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SegmentedDownload.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+
+#include "Application.h"
+#include "FileSystem.h"
+#include "PSaveFile.h"
+#include "net/ApiDownload.h"
+#include "net/ChecksumValidator.h"
+#include "net/RawHeaderProxy.h"
+
+namespace Net {
+
+/** Maximum time to hold a cache entry
+ *  = 1 week in seconds
+ */
+#define MAX_TIME_TO_EXPIRE 1 * 7 * 24 * 60 * 60
+
+SegmentedDownload::SegmentedDownload(QUrl url, MetaEntryPtr entry, int segments, shared_qobject_ptr<QNetworkAccessManager> network)
+    : m_url(std::move(url)), m_entry(std::move(entry)), m_segments(segments), m_network(std::move(network))
+{
+    connect(&m_stitchWatcher, &QFutureWatcher<StitchResult>::finished, this, &SegmentedDownload::stitchFinished);
+}
+
+void SegmentedDownload::setExpectedChecksum(QCryptographicHash::Algorithm algorithm, QByteArray expected)
+{
+    m_expectedAlgorithm = algorithm;
+    m_expected = std::move(expected);
+}
+
+bool SegmentedDownload::abort()
+{
+    if (m_stitching) {
+        m_stitchCanceled = true;
+        // NOTE: emitAborted() happens once the worker actually stops
+        return true;
+    }
+    if (m_job)
+        return m_job->abort();
+    return Task::abort();
+}
+
+void SegmentedDownload::executeTask()
+{
+    setStatus(tr("Downloading %1").arg(m_url.toString()));
+    if (m_segments <= 1) {
+        downloadSingle();
+        return;
+    }
+    probe();
+}
+
+void SegmentedDownload::runJob(NetJob::Ptr job)
+{
+    m_job = job;
+    connect(job.get(), &NetJob::progress, this, &SegmentedDownload::setProgress);
+    connect(job.get(), &NetJob::stepProgress, this, &SegmentedDownload::propagateStepProgress);
+    connect(job.get(), &NetJob::aborted, this, &SegmentedDownload::emitAborted);
+    job->start();
+}
+
+void SegmentedDownload::probe()
+{
+    // ask for the first byte only, which tells us the size and version of the file, and whether ranges work at all
+    m_probeRequest = ApiDownload::makeByteArray(m_url, std::make_shared<QByteArray>());
+    m_probeRequest->addHeaderProxy(new RawHeaderProxy({ { "Range", "bytes=0-0" } }));
+    m_probeValidator = new ByteRangeValidator(1);
+    m_probeRequest->addValidator(m_probeValidator);
+
+    auto job = makeShared<NetJob>(tr("Download size check"), m_network);
+    job->setAskRetry(false);
+    job->addNetAction(m_probeRequest);
+
+    connect(job.get(), &NetJob::succeeded, this, [this] {
+        m_totalSize = m_probeValidator->totalSize();
+        m_entityTag = m_probeValidator->entityTag();
+        if (m_totalSize < m_minimumSegmentSize * 2 || m_entityTag.isEmpty()) {
+            // without a validator we couldn't tell if the segments all come from the same file
+            downloadSingle();
+            return;
+        }
+
+        QFileInfo current(m_entry->getFullPath());
+        bool upToDate = current.isFile() && current.size() == m_totalSize &&
+                        (m_entry->getETag().toLatin1() == m_entityTag || m_entry->getRemoteChangedTimestamp().toLatin1() == m_entityTag);
+        if (upToDate) {
+            qDebug() << "SegmentedDownload:" << m_url << "is already cached";
+            emitSucceeded();
+            return;
+        }
+        downloadSegments();
+    });
+    connect(job.get(), &NetJob::failed, this, [this](QString reason) {
+        qDebug() << "SegmentedDownload: no range support for" << m_url << "(" << reason << "), downloading in one piece";
+        downloadSingle();
+    });
+    runJob(job);
+}
+
+void SegmentedDownload::downloadSingle()
+{
+    auto job = makeShared<NetJob>(tr("Download %1").arg(m_url.toString()), m_network);
+    auto dl = ApiDownload::makeCached(m_url, m_entry, Download::Option::Resumable);
+    if (m_expectedAlgorithm)
+        dl->addValidator(new ChecksumValidator(*m_expectedAlgorithm, m_expected));
+    if (m_streamValidator)
+        dl->addValidator(m_streamValidator.release());
+    job->addNetAction(dl);
+
+    connect(job.get(), &NetJob::succeeded, this, &SegmentedDownload::emitSucceeded);
+    connect(job.get(), &NetJob::failed, this, &SegmentedDownload::emitFailed);
+    runJob(job);
+}
+
+QString SegmentedDownload::segmentPath(int index) const
+{
+    return m_entry->getFullPath() + ".seg" + QString::number(index);
+}
+
+QString SegmentedDownload::segmentsTagPath() const
+{
+    return m_entry->getFullPath() + ".segments.tag";
+}
+
+void SegmentedDownload::removeSegments()
+{
+    for (int i = 0; i < m_segments; i++) {
+        auto path = segmentPath(i);
+        QFile::remove(path);
+        QFile::remove(path + ".part");
+        QFile::remove(path + ".part.tag");
+    }
+    QFile::remove(segmentsTagPath());
+}
+
+void SegmentedDownload::downloadSegments()
+{
+    // segments left over from another version of the file are useless, and so are ones split differently
+    QByteArray layout = m_entityTag + '\n' + QByteArray::number(m_totalSize) + '/' + QByteArray::number(m_segments);
+    QFile tagFile(segmentsTagPath());
+    QByteArray keptLayout;
+    if (tagFile.open(QIODevice::ReadOnly))
+        keptLayout = tagFile.readAll();
+    tagFile.close();
+    if (keptLayout != layout) {
+        removeSegments();
+        if (!FS::ensureFilePathExists(segmentsTagPath()) || !tagFile.open(QIODevice::WriteOnly) || tagFile.write(layout) != layout.size()) {
+            emitFailed(tr("Could not write to %1").arg(segmentsTagPath()));
+            return;
+        }
+        tagFile.close();
+    }
+
+    auto job = makeShared<NetJob>(tr("Download %1").arg(m_url.toString()), m_network, m_segments);
+    qint64 segmentSize = m_totalSize / m_segments;
+    for (int i = 0; i < m_segments; i++) {
+        qint64 first = i * segmentSize;
+        qint64 last = i == m_segments - 1 ? m_totalSize - 1 : first + segmentSize - 1;
+        auto dl = ApiDownload::makeFileRange(m_url, segmentPath(i), first, last, m_entityTag);
+        if (i == 0 && m_streamValidator)
+            dl->addValidator(m_streamValidator.release());
+        job->addNetAction(dl);
+    }
+    qDebug() << "SegmentedDownload: fetching" << m_url << "in" << m_segments << "segments of" << segmentSize << "bytes";
+
+    connect(job.get(), &NetJob::succeeded, this, &SegmentedDownload::stitch);
+    connect(job.get(), &NetJob::failed, this, &SegmentedDownload::emitFailed);
+    runJob(job);
+}
+
+void SegmentedDownload::stitch()
+{
+    m_job.reset();
+    setStatus(tr("Verifying %1").arg(m_url.toString()));
+
+    m_stitching = true;
+    m_stitchCanceled = false;
+    m_stitchFuture = QtConcurrent::run(QThreadPool::globalInstance(), [this]() -> StitchResult {
+        PSaveFile output(m_entry->getFullPath());
+        if (!output.open(QIODevice::WriteOnly))
+            return { false, tr("Could not open %1 for writing").arg(m_entry->getFullPath()), {} };
+
+        QCryptographicHash md5(QCryptographicHash::Md5);
+        std::optional<QCryptographicHash> expected;
+        if (m_expectedAlgorithm)
+            expected.emplace(*m_expectedAlgorithm);
+
+        qint64 written = 0;
+        QByteArray buffer;
+        for (int i = 0; i < m_segments; i++) {
+            QFile segment(segmentPath(i));
+            if (!segment.open(QIODevice::ReadOnly))
+                return { false, tr("Could not read %1").arg(segment.fileName()), {} };
+            while (!segment.atEnd()) {
+                if (m_stitchCanceled) {
+                    output.cancelWriting();
+                    return { true, {}, {} };
+                }
+                buffer = segment.read(1024 * 1024);
+                md5.addData(buffer);
+                if (expected)
+                    expected->addData(buffer);
+                if (output.write(buffer) != buffer.size())
+                    return { false, tr("Could not write to %1").arg(m_entry->getFullPath()), {} };
+                written += buffer.size();
+            }
+        }
+
+        if (written != m_totalSize)
+            return { false, tr("The downloaded segments are %1 bytes, expected %2").arg(written).arg(m_totalSize), {} };
+        if (expected && expected->result() != m_expected) {
+            output.cancelWriting();
+            return { false, tr("Checksum mismatch for %1").arg(m_url.toString()), {} };
+        }
+        if (!output.commit())
+            return { false, tr("Could not write to %1").arg(m_entry->getFullPath()), {} };
+        return { false, {}, md5.result().toHex() };
+    });
+    m_stitchWatcher.setFuture(m_stitchFuture);
+}
+
+void SegmentedDownload::stitchFinished()
+{
+    m_stitching = false;
+    // a worker that got to commit the output is done, whether it was canceled late or not
+    auto result = m_stitchFuture.isCanceled() ? StitchResult{ true, {}, {} } : m_stitchFuture.result();
+    if (result.canceled) {
+        // the output was never committed, the segments stay around to be stitched next time
+        emitAborted();
+        return;
+    }
+    if (!result.error.isEmpty()) {
+        // the segments are bad or don't fit together, don't resume from them
+        removeSegments();
+        emitFailed(result.error);
+        return;
+    }
+    updateCacheEntry(result.md5);
+    emitSucceeded();
+}
+
+void SegmentedDownload::updateCacheEntry(const QString& md5)
+{
+    m_entry->setMD5Sum(md5);
+    // the probe picked the ETag when it's a strong one, and Last-Modified otherwise
+    if (m_entityTag.startsWith('"')) {
+        m_entry->setETag(QString::fromLatin1(m_entityTag));
+    } else {
+        m_entry->setETag({});
+        m_entry->setRemoteChangedTimestamp(QString::fromLatin1(m_entityTag));
+    }
+    m_entry->setLocalChangedTimestamp(QFileInfo(m_entry->getFullPath()).lastModified().toUTC().toMSecsSinceEpoch());
+    m_entry->setMaximumAge(MAX_TIME_TO_EXPIRE);
+    m_entry->setCurrentAge(0);
+    m_entry->setStale(false);
+    APPLICATION->metacache()->updateEntry(m_entry);
+
+    removeSegments();
+}
+
+}  // namespace Net
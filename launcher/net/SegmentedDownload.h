@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ *  Prism Launcher - Minecraft Launcher
+ *  Copyright (c) 2024
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCryptographicHash>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QNetworkAccessManager>
+#include <QUrl>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "HttpMetaCache.h"
+#include "QObjectPtr.h"
+#include "net/ByteRangeValidator.h"
+#include "net/Download.h"
+#include "net/NetJob.h"
+#include "net/Validator.h"
+#include "tasks/Task.h"
+
+namespace Net {
+
+/*
+ * Downloads a large file into a cache entry as several byte ranges in parallel, and stitches them together.
+ *
+ * Each segment is resumable on its own and tied to the ETag (or Last-Modified date) the server reported
+ * when the download started, so segments of different versions of the file never get mixed.
+ * Small files and servers without range support get a single resumable download instead.
+ */
+class SegmentedDownload : public Task {
+    Q_OBJECT
+   public:
+    using Ptr = shared_qobject_ptr<SegmentedDownload>;
+
+    SegmentedDownload(QUrl url, MetaEntryPtr entry, int segments, shared_qobject_ptr<QNetworkAccessManager> network);
+    ~SegmentedDownload() override = default;
+
+    /** Files smaller than this are downloaded in one piece. */
+    void setMinimumSegmentSize(qint64 size) { m_minimumSegmentSize = size; }
+    /** Verify the stitched file against this checksum. */
+    void setExpectedChecksum(QCryptographicHash::Algorithm algorithm, QByteArray expected);
+    /**
+     * Gets the bytes of the file in order, while they arrive: attached to the single download, or to the first segment.
+     * Takes ownership.
+     */
+    void setStreamValidator(Validator* validator) { m_streamValidator.reset(validator); }
+
+    bool canAbort() const override { return true; }
+    bool abort() override;
+
+   protected:
+    void executeTask() override;
+
+   private:
+    void probe();
+    void downloadSingle();
+    void downloadSegments();
+    void stitch();
+    void stitchFinished();
+    void updateCacheEntry(const QString& md5);
+
+    QString segmentPath(int index) const;
+    QString segmentsTagPath() const;
+    void removeSegments();
+
+    void runJob(NetJob::Ptr job);
+
+   private:
+    QUrl m_url;
+    MetaEntryPtr m_entry;
+    int m_segments;
+    qint64 m_minimumSegmentSize = 32 * 1024 * 1024;
+    shared_qobject_ptr<QNetworkAccessManager> m_network;
+
+    std::optional<QCryptographicHash::Algorithm> m_expectedAlgorithm;
+    QByteArray m_expected;
+    std::unique_ptr<Validator> m_streamValidator;
+
+    qint64 m_totalSize = -1;
+    QByteArray m_entityTag;
+    ByteRangeValidator* m_probeValidator = nullptr;
+    Download::Ptr m_probeRequest;
+
+    NetJob::Ptr m_job;
+
+    struct StitchResult {
+        bool canceled = false;
+        QString error;
+        // of the stitched file
+        QString md5;
+    };
+    bool m_stitching = false;
+    // set on the GUI thread, polled by the stitch worker
+    std::atomic<bool> m_stitchCanceled = false;
+    QFuture<StitchResult> m_stitchFuture;
+    QFutureWatcher<StitchResult> m_stitchWatcher;
+};
+
+}  // namespace Net
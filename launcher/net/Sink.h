@@ -50,8 +50,42 @@ class Sink {
     virtual auto abort() -> Task::State = 0;
     virtual auto finalize(QNetworkReply& reply) -> Task::State = 0;
 
+    // called once the response headers are known, before the first write()
+    virtual auto headersReceived(QNetworkReply&) -> Task::State { return Task::State::Running; }
+
     virtual auto hasLocalData() -> bool = 0;
 
+    /**
+     * Requests for the same URL, with the same headers and flight key, share one transfer: while one of them runs,
+     * the others wait for it and then adopt() its result. Empty if this sink can't share a transfer.
+     */
+    auto flightKey() const -> QString
+    {
+        auto key = targetKey();
+        if (key.isEmpty())
+            return {};
+        for (auto& validator : validators) {
+            auto part = validator->flightKey();
+            if (part.isEmpty())
+                return {};
+            key += '|' + part;
+        }
+        return key;
+    }
+
+    /** Whether a validator pins down the exact content, so the data may come from anywhere serving the same file. */
+    auto verifiesContent() const -> bool
+    {
+        for (auto& validator : validators) {
+            if (validator->verifiesContent())
+                return true;
+        }
+        return false;
+    }
+
+    /** Take over the result of the transfer another request with the same flight key did. */
+    virtual auto adopt(Sink&) -> Task::State { return Task::State::Failed; }
+
     void addValidator(Validator* validator)
     {
         if (validator) {
@@ -60,6 +94,9 @@ class Sink {
     }
 
    protected:
+    /** What the sink writes to, the base of flightKey(). */
+    virtual auto targetKey() const -> QString { return {}; }
+
     bool initAllValidators(QNetworkRequest& request)
     {
         for (auto& validator : validators) {
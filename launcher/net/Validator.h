@@ -47,5 +47,14 @@ class Validator {
     virtual bool write(QByteArray& data) = 0;
     virtual bool abort() = 0;
     virtual bool validate(QNetworkReply& reply) = 0;
+
+    /**
+     * What makes two validators of this kind check the same thing, for requests that share a transfer (see
+     * Sink::flightKey()). Empty for validators that have to see the data themselves.
+     */
+    virtual QString flightKey() const { return {}; }
+
+    /** Whether only one exact content passes validation, e.g. a known checksum. */
+    virtual bool verifiesContent() const { return false; }
 };
 }  // namespace Net
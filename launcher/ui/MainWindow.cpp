@@ -1464,6 +1464,28 @@ void MainWindow::on_actionKillInstance_triggered()
     }
 }
 
+void MainWindow::on_actionRollbackInstance_triggered()
+{
+    if (!m_selectedInstance || m_selectedInstance->isRunning())
+        return;
+
+    auto response = CustomMessageBox::selectable(this, tr("Roll back update"),
+                                                 tr("\"%1\" will go back to the version it had before its last update.\n"
+                                                    "Anything that changed in it since then will be lost.\n\n"
+                                                    "Are you sure?")
+                                                     .arg(m_selectedInstance->name()),
+                                                 QMessageBox::Warning, QMessageBox::Yes | QMessageBox::No, QMessageBox::No)
+                        ->exec();
+    if (response != QMessageBox::Yes)
+        return;
+
+    if (!APPLICATION->instances()->rollbackInstance(m_selectedInstance->id())) {
+        QMessageBox::critical(this, tr("Roll back update"), tr("The previous version could not be restored."));
+        return;
+    }
+    refreshCurrentInstance();
+}
+
 void MainWindow::on_actionCreateInstanceShortcut_triggered()
 {
     if (!m_selectedInstance)
@@ -1641,6 +1663,8 @@ void MainWindow::instanceChanged(const QModelIndex& current, [[maybe_unused]] co
 
         ui->actionKillInstance->setEnabled(m_selectedInstance->isRunning());
         ui->actionExportInstance->setEnabled(m_selectedInstance->canExport());
+        ui->actionRollbackInstance->setVisible(APPLICATION->instances()->hasRollback(id));
+        ui->actionRollbackInstance->setEnabled(!m_selectedInstance->isRunning());
         renameButton->setText(m_selectedInstance->name());
         m_statusLeft->setText(m_selectedInstance->getStatusbarDescription());
         updateStatusCenter();
@@ -1745,6 +1769,7 @@ void MainWindow::setInstanceActionsEnabled(bool enabled)
     ui->actionDeleteInstance->setEnabled(enabled);
     ui->actionCopyInstance->setEnabled(enabled);
     ui->actionCreateInstanceShortcut->setEnabled(enabled);
+    ui->actionRollbackInstance->setEnabled(enabled);
 }
 
 void MainWindow::refreshCurrentInstance()
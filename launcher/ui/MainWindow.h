@@ -165,6 +165,8 @@ class MainWindow : public QMainWindow {
 
     void on_actionCreateInstanceShortcut_triggered();
 
+    void on_actionRollbackInstance_triggered();
+
     void taskEnd();
 
     /**
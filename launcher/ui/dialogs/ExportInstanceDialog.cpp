@@ -73,6 +73,8 @@ ExportInstanceDialog::ExportInstanceDialog(InstancePtr instance, QWidget* parent
     proxyModel->ignoreFilesWithName().append({ ".DS_Store", "thumbs.db", "Thumbs.db" });
     proxyModel->ignoreFilesWithPath().insert(
         { FS::PathCombine(prefix, ".cache"), FS::PathCombine(prefix, ".fabric"), FS::PathCombine(prefix, ".quilt") });
+    // what the mod lists remember about their mods (see ModDetailsCache), rebuilt wherever the instance ends up
+    proxyModel->ignoreFilesWithPath().insert({ "mods.cache", "coremods.cache", "nilmods.cache" });
     loadPackIgnore();
 
     ui->treeView->setModel(proxyModel);
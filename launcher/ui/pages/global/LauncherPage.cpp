@@ -49,6 +49,7 @@
 #include "Application.h"
 #include "BuildConfig.h"
 #include "DesktopServices.h"
+#include "modplatform/truckpack/TruckPackPrefetcher.h"
 #include "settings/SettingsObject.h"
 #include "ui/themes/ITheme.h"
 #include "ui/themes/ThemeManager.h"
@@ -210,6 +211,9 @@ void LauncherPage::applySettings()
     s->set("NumberOfConcurrentDownloads", ui->numberOfConcurrentDownloadsSpinBox->value());
     s->set("NumberOfManualRetries", ui->numberOfManualRetriesSpinBox->value());
     s->set("RequestTimeout", ui->timeoutSecondsSpinBox->value());
+    s->set("DownloadSegments", ui->downloadSegmentsSpinBox->value());
+    s->set("TruckPackPrefetchRate", ui->truckPackPrefetchRateSpinBox->value());
+    s->set("TruckPackManifestPollInterval", ui->truckPackPollIntervalSpinBox->value());
 
     // Console settings
     s->set("ShowConsole", ui->showConsoleCheck->isChecked());
@@ -249,6 +253,9 @@ void LauncherPage::applySettings()
     s->set("ModMetadataDisabled", ui->metadataDisableBtn->isChecked());
     s->set("ModDependenciesDisabled", ui->dependenciesDisableBtn->isChecked());
     s->set("SkipModpackUpdatePrompt", ui->skipModpackUpdatePromptBtn->isChecked());
+    s->set("TruckPackPrefetch", ui->prefetchTruckPackUpdatesBtn->isChecked());
+    if (ui->prefetchTruckPackUpdatesBtn->isChecked())
+        APPLICATION->truckPackPrefetcher()->schedule();
 }
 void LauncherPage::loadSettings()
 {
@@ -266,6 +273,9 @@ void LauncherPage::loadSettings()
     ui->numberOfConcurrentDownloadsSpinBox->setValue(s->get("NumberOfConcurrentDownloads").toInt());
     ui->numberOfManualRetriesSpinBox->setValue(s->get("NumberOfManualRetries").toInt());
     ui->timeoutSecondsSpinBox->setValue(s->get("RequestTimeout").toInt());
+    ui->downloadSegmentsSpinBox->setValue(s->get("DownloadSegments").toInt());
+    ui->truckPackPrefetchRateSpinBox->setValue(s->get("TruckPackPrefetchRate").toInt());
+    ui->truckPackPollIntervalSpinBox->setValue(s->get("TruckPackManifestPollInterval").toInt());
 
     // Console settings
     ui->showConsoleCheck->setChecked(s->get("ShowConsole").toBool());
@@ -310,6 +320,7 @@ void LauncherPage::loadSettings()
     ui->metadataWarningLabel->setHidden(!ui->metadataDisableBtn->isChecked());
     ui->dependenciesDisableBtn->setChecked(s->get("ModDependenciesDisabled").toBool());
     ui->skipModpackUpdatePromptBtn->setChecked(s->get("SkipModpackUpdatePrompt").toBool());
+    ui->prefetchTruckPackUpdatesBtn->setChecked(s->get("TruckPackPrefetch").toBool());
 }
 
 void LauncherPage::refreshFontPreview()
@@ -45,6 +45,7 @@
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QMenu>
+#include <QScrollBar>
 #include <algorithm>
 
 ExternalResourcesPage::ExternalResourcesPage(BaseInstance* instance, std::shared_ptr<ResourceFolderModel> model, QWidget* parent)
@@ -90,6 +91,10 @@ ExternalResourcesPage::ExternalResourcesPage(BaseInstance* instance, std::shared
     connect(model.get(), &ResourceFolderModel::updateFinished, this, updateExtra);
     connect(model.get(), &ResourceFolderModel::parseFinished, this, updateExtra);
 
+    // whatever is on screen gets parsed first
+    connect(model.get(), &ResourceFolderModel::updateFinished, this, &ExternalResourcesPage::prioritizeVisibleItems);
+    connect(ui->treeView->verticalScrollBar(), &QScrollBar::valueChanged, this, &ExternalResourcesPage::prioritizeVisibleItems);
+
     connect(ui->filterEdit, &QLineEdit::textChanged, this, &ExternalResourcesPage::filterTextChanged);
 
     auto viewHeader = ui->treeView->header();
@@ -127,6 +132,18 @@ void ExternalResourcesPage::ShowHeaderContextMenu(const QPoint& pos)
     menu->deleteLater();
 }
 
+void ExternalResourcesPage::prioritizeVisibleItems()
+{
+    auto view = ui->treeView;
+    QModelIndexList visible;
+    for (auto index = view->indexAt(QPoint(0, 0)); index.isValid(); index = view->indexBelow(index)) {
+        if (view->visualRect(index).top() > view->viewport()->height())
+            break;
+        visible.append(m_filterModel->mapToSource(index));
+    }
+    m_model->prioritizeParsing(visible);
+}
+
 void ExternalResourcesPage::openedImpl()
 {
     m_model->startWatching();
@@ -8,6 +8,22 @@
 
 #include "MurmurHash2.h"
 
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MURMUR2_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is picked at runtime, which needs per-function target attributes
+#if defined(MURMUR2_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define MURMUR2_AVX2
+#include <immintrin.h>
+#endif
+
 namespace Murmur2 {
 
 // 'm' and 'r' are mixing constants generated offline.
@@ -15,6 +31,133 @@ namespace Murmur2 {
 const uint32_t m = 0x5bd1e995;
 const int r = 24;
 
+namespace {
+
+// How much of the input is stripped into the staging buffer at a time
+constexpr std::size_t BlockSize = 64 * KiB;
+
+inline bool isWhitespace(char c)
+{
+    return c == 9 || c == 10 || c == 13 || c == 32;
+}
+
+inline std::size_t popcount(uint32_t mask)
+{
+    return std::bitset<32>(mask).count();
+}
+
+// Copy the bytes of a chunk whose whitespace is marked in 'mask' to 'out', returns how many were copied.
+// Every byte is written and only non-whitespace advances, so there are no unpredictable branches.
+inline std::size_t stripChunk(const char* in, std::size_t width, uint32_t mask, char* out)
+{
+    if (mask == 0) {
+        std::memcpy(out, in, width);
+        return width;
+    }
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < width; i++) {
+        out[n] = in[i];
+        n += ((mask >> i) & 1) ^ 1;
+    }
+    return n;
+}
+
+std::size_t countScalar(const char* data, std::size_t size)
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size; i++)
+        n += !isWhitespace(data[i]);
+    return n;
+}
+
+std::size_t stripScalar(const char* in, std::size_t size, char* out)
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        out[n] = in[i];
+        n += !isWhitespace(in[i]);
+    }
+    return n;
+}
+
+#ifdef MURMUR2_SSE2
+inline uint32_t whitespaceMask(__m128i v)
+{
+    auto ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(9)), _mm_cmpeq_epi8(v, _mm_set1_epi8(10))),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(13)), _mm_cmpeq_epi8(v, _mm_set1_epi8(32))));
+    return static_cast<uint32_t>(_mm_movemask_epi8(ws));
+}
+
+std::size_t countSse2(const char* data, std::size_t size)
+{
+    std::size_t whitespace = 0;
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+        whitespace += popcount(whitespaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))));
+    return i - whitespace + countScalar(data + i, size - i);
+}
+
+std::size_t stripSse2(const char* in, std::size_t size, char* out)
+{
+    std::size_t n = 0;
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+        n += stripChunk(in + i, 16, whitespaceMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))), out + n);
+    return n + stripScalar(in + i, size - i, out + n);
+}
+#endif
+
+#ifdef MURMUR2_AVX2
+__attribute__((target("avx2"))) inline uint32_t whitespaceMask(__m256i v)
+{
+    auto ws = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(9)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(10))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(13)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(32))));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+}
+
+__attribute__((target("avx2"))) std::size_t countAvx2(const char* data, std::size_t size)
+{
+    std::size_t whitespace = 0;
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+        whitespace += popcount(whitespaceMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+    return i - whitespace + countSse2(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) std::size_t stripAvx2(const char* in, std::size_t size, char* out)
+{
+    std::size_t n = 0;
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+        n += stripChunk(in + i, 32, whitespaceMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))), out + n);
+    return n + stripSse2(in + i, size - i, out + n);
+}
+#endif
+
+struct Kernel {
+    std::size_t (*count)(const char* data, std::size_t size);
+    std::size_t (*strip)(const char* in, std::size_t size, char* out);
+};
+
+const Kernel& kernel()
+{
+    static const Kernel best = [] {
+#ifdef MURMUR2_AVX2
+        if (__builtin_cpu_supports("avx2"))
+            return Kernel{ countAvx2, stripAvx2 };
+#endif
+#ifdef MURMUR2_SSE2
+        return Kernel{ countSse2, stripSse2 };
+#else
+        return Kernel{ countScalar, stripScalar };
+#endif
+    }();
+    return best;
+}
+
+}  // namespace
+
 uint32_t hash(Reader* file_stream, std::size_t buffer_size, std::function<bool(char)> filter_out)
 {
     auto* buffer = new char[buffer_size];
@@ -64,11 +207,51 @@ uint32_t hash(Reader* file_stream, std::size_t buffer_size, std::function<bool(c
     return info.h;
 }
 
+std::size_t countNonWhitespace(const char* data, std::size_t size)
+{
+    return kernel().count(data, size);
+}
+
+uint32_t hashWithoutWhitespace(const char* data, std::size_t size)
+{
+    const auto& k = kernel();
+
+    // The seed depends on the filtered length, so that is counted first. Unlike hash(), this doesn't read the
+    // data again: it's all in memory already.
+    auto len = static_cast<uint32_t>(k.count(data, size));
+
+    // This forces a seed of 1.
+    IncrementalHashInfo info{ (uint32_t)1 ^ len, len };
+
+    // Whitespace is stripped one block at a time, bytes that don't make up a full word carry over to the next one
+    std::vector<unsigned char> staging(BlockSize + 4);
+    auto* buffer = staging.data();
+    std::size_t pending = 0;
+    for (std::size_t offset = 0; offset < size; offset += BlockSize) {
+        auto n = std::min(BlockSize, size - offset);
+        pending += k.strip(data + offset, n, reinterpret_cast<char*>(buffer) + pending);
+
+        auto words = pending / 4;
+        for (std::size_t i = 0; i < words; i++)
+            FourBytes_MurmurHash2(buffer + 4 * i, info);
+
+        auto rest = pending % 4;
+        std::memmove(buffer, buffer + 4 * words, rest);
+        pending = rest;
+    }
+
+    // Do one last bit shuffle in the hash
+    FourBytes_MurmurHash2(buffer, info);
+
+    return info.h;
+}
+
 void FourBytes_MurmurHash2(const unsigned char* data, IncrementalHashInfo& prev)
 {
     if (prev.len >= 4) {
         // Not the final mix
-        uint32_t k = *reinterpret_cast<const uint32_t*>(data);
+        uint32_t k;
+        std::memcpy(&k, data, sizeof(k));
 
         k *= m;
         k ^= k >> r;
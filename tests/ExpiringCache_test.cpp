@@ -0,0 +1,66 @@
+#include <QTest>
+
+#include <modplatform/helpers/ExpiringCache.h>
+
+using ModPlatform::ExpiringCache;
+
+class ExpiringCacheTest : public QObject {
+    Q_OBJECT
+
+    qint64 m_now = 1000000;
+
+   private slots:
+    void test_lookup()
+    {
+        ExpiringCache<QString> cache(60, [this] { return m_now; });
+        QVERIFY(!cache.get("a").has_value());
+
+        cache.insert("a", "first");
+        QCOMPARE(cache.get("a"), std::optional<QString>("first"));
+        QVERIFY(!cache.get("b").has_value());
+
+        cache.insert("a", "second");
+        QCOMPARE(cache.get("a"), std::optional<QString>("second"));
+    }
+
+    void test_expiry()
+    {
+        ExpiringCache<int> cache(60, [this] { return m_now; });
+        cache.insert("a", 1);
+        m_now += 30 * 1000;
+        cache.insert("b", 2);
+
+        // still there right at the end of its lifetime
+        m_now += 30 * 1000;
+        QCOMPARE(cache.get("a"), std::optional<int>(1));
+
+        m_now += 1;
+        QVERIFY(!cache.get("a").has_value());
+        QCOMPARE(cache.get("b"), std::optional<int>(2));
+
+        m_now += 30 * 1000;
+        QVERIFY(!cache.get("b").has_value());
+    }
+
+    void test_insertRenews()
+    {
+        ExpiringCache<int> cache(60, [this] { return m_now; });
+        cache.insert("a", 1);
+        m_now += 50 * 1000;
+        cache.insert("a", 2);
+        m_now += 50 * 1000;
+        QCOMPARE(cache.get("a"), std::optional<int>(2));
+    }
+
+    void test_clear()
+    {
+        ExpiringCache<int> cache(60, [this] { return m_now; });
+        cache.insert("a", 1);
+        cache.clear();
+        QVERIFY(!cache.get("a").has_value());
+    }
+};
+
+QTEST_GUILESS_MAIN(ExpiringCacheTest)
+
+#include "ExpiringCache_test.moc"
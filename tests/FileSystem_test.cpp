@@ -758,6 +758,23 @@ class FileSystemTest : public QObject {
         QCOMPARE(FS::pathTruncate("C:\\bar\\foo.txt", 1), QDir::toNativeSeparators("C:\\bar"));
 #endif
     }
+
+    void test_preallocate()
+    {
+        QTemporaryDir tempDir;
+        QFile file(FS::PathCombine(tempDir.path(), "big.bin"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QVERIFY(file.write(QByteArray(1000, 'a')) == 1000);
+        QVERIFY(file.flush());
+        if (!FS::preallocate(file, 16 * 1024 * 1024))
+            QSKIP("Preallocation is not supported here");
+
+        // the reserved space is not part of the file
+        QCOMPARE(file.size(), 1000);
+        QVERIFY(file.write(QByteArray(5000, 'b')) == 5000);
+        file.close();
+        QCOMPARE(QFileInfo(file.fileName()).size(), 6000);
+    }
 };
 
 QTEST_GUILESS_MAIN(FileSystemTest)
@@ -0,0 +1,91 @@
+#include <QJsonDocument>
+#include <QTest>
+
+#include <modplatform/flame/FlameCheckUpdate.h>
+
+using ModPlatform::ModLoaderType;
+
+class FlameCheckUpdateTest : public QObject {
+    Q_OBJECT
+
+    // a project of the bulk projects response, cut down to what the checker reads
+    FlameCheckUpdate::ProjectInfo project(const QByteArray& latestFilesIndexes)
+    {
+        auto doc = QJsonDocument::fromJson(R"({ "id": 1234, "name": "Some Mod", "slug": "some-mod",
+                                                "links": { "websiteUrl": "https://www.curseforge.com/minecraft/mc-mods/some-mod" },
+                                                "latestFilesIndexes": )" +
+                                           latestFilesIndexes + " }");
+        return FlameCheckUpdate::loadProjectInfo(doc.object());
+    }
+
+    std::optional<int> latest(const FlameCheckUpdate::ProjectInfo& info,
+                              const QString& gameVersion,
+                              QList<ModLoaderType> instanceLoaders,
+                              ModPlatform::ModLoaderTypes modLoaders = {})
+    {
+        return FlameCheckUpdate::latestFileId(info, gameVersion, instanceLoaders, modLoaders);
+    }
+
+   private slots:
+    void test_loadProjectInfo()
+    {
+        auto info = project(R"([ { "gameVersion": "1.20.1", "fileId": 100, "modLoader": 1 },
+                                 { "gameVersion": "1.20.1", "fileId": 110, "modLoader": 4 },
+                                 { "gameVersion": "1.20.1", "fileId": 105, "modLoader": 6 },
+                                 { "gameVersion": "1.20.1", "fileId": 90, "modLoader": null } ])");
+        QCOMPARE(info.project_id, QString("1234"));
+        QCOMPARE(info.website_url, QString("https://www.curseforge.com/minecraft/mc-mods/some-mod"));
+        QCOMPARE(info.latest_files.size(), 4);
+        QCOMPARE(info.latest_files[0].loader, ModPlatform::Forge);
+        QCOMPARE(info.latest_files[1].loader, ModPlatform::Fabric);
+        QCOMPARE(info.latest_files[2].loader, ModPlatform::NeoForge);
+        QCOMPARE(info.latest_files[3].loader, ModLoaderType(0));
+        QCOMPARE(info.latest_files[1].file_id, 110);
+        QCOMPARE(info.latest_files[1].game_version, QString("1.20.1"));
+    }
+
+    void test_latestFileId()
+    {
+        auto info = project(R"([ { "gameVersion": "1.20.1", "fileId": 100, "modLoader": 1 },
+                                 { "gameVersion": "1.20.1", "fileId": 120, "modLoader": 1 },
+                                 { "gameVersion": "1.20.1", "fileId": 110, "modLoader": 4 },
+                                 { "gameVersion": "1.19.2", "fileId": 130, "modLoader": 4 } ])");
+
+        // the highest file ID for the game version and loader is the newest file
+        QCOMPARE(latest(info, "1.20.1", { ModPlatform::Forge }), std::optional<int>(120));
+        QCOMPARE(latest(info, "1.20.1", { ModPlatform::Fabric }), std::optional<int>(110));
+        QCOMPARE(latest(info, "1.19.2", { ModPlatform::Fabric }), std::optional<int>(130));
+        // the instance's loaders come first, the mod's own loaders after them
+        QCOMPARE(latest(info, "1.20.1", { ModPlatform::Fabric, ModPlatform::Forge }), std::optional<int>(110));
+        QCOMPARE(latest(info, "1.20.1", { ModPlatform::Quilt }, ModPlatform::Fabric), std::optional<int>(110));
+
+        // nothing fits, the full version list has to be looked through
+        QVERIFY(!latest(info, "1.20.1", { ModPlatform::Quilt }).has_value());
+        QVERIFY(!latest(info, "1.18.2", { ModPlatform::Forge }).has_value());
+        QVERIFY(!latest(project("[]"), "1.20.1", { ModPlatform::Forge }).has_value());
+    }
+
+    void test_latestFileIdWithoutLoader()
+    {
+        // files that don't name a loader fit any instance
+        auto untagged = project(R"([ { "gameVersion": "1.20.1", "fileId": 200 } ])");
+        QCOMPARE(latest(untagged, "1.20.1", { ModPlatform::Forge }), std::optional<int>(200));
+
+        // one loader and untagged files: the newer of the two
+        auto two = project(R"([ { "gameVersion": "1.20.1", "fileId": 220, "modLoader": null },
+                                { "gameVersion": "1.20.1", "fileId": 210, "modLoader": 4 } ])");
+        QCOMPARE(latest(two, "1.20.1", { ModPlatform::Fabric }), std::optional<int>(220));
+        QCOMPARE(latest(two, "1.20.1", { ModPlatform::Forge }), std::optional<int>(220));
+
+        // with more loaders around, the tagged file wins even if it is older
+        auto three = project(R"([ { "gameVersion": "1.20.1", "fileId": 230, "modLoader": 0 },
+                                  { "gameVersion": "1.20.1", "fileId": 210, "modLoader": 4 },
+                                  { "gameVersion": "1.20.1", "fileId": 215, "modLoader": 1 } ])");
+        QCOMPARE(latest(three, "1.20.1", { ModPlatform::Fabric }), std::optional<int>(210));
+        QCOMPARE(latest(three, "1.20.1", { ModPlatform::Quilt }), std::optional<int>(230));
+    }
+};
+
+QTEST_GUILESS_MAIN(FlameCheckUpdateTest)
+
+#include "FlameCheckUpdate_test.moc"
@@ -0,0 +1,75 @@
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <modplatform/helpers/HashCache.h>
+
+using Hashing::Algorithm;
+using Hashing::HashCache;
+
+class HashCacheTest : public QObject {
+    Q_OBJECT
+
+    void writeFile(const QString& path, const QByteArray& data)
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QCOMPARE(file.write(data), qint64(data.size()));
+    }
+
+   private slots:
+    void test_storeAndLookup()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "mod.jar");
+        writeFile(path, "some mod");
+
+        HashCache cache{ QString() };
+        QVERIFY(!cache.lookup(path, Algorithm::Sha1).has_value());
+
+        cache.store(path, HashCache::stampOf(path), Algorithm::Sha1, "abc");
+        cache.store(path, HashCache::stampOf(path), Algorithm::Murmur2, "123");
+        QCOMPARE(cache.lookup(path, Algorithm::Sha1).value_or(""), QString("abc"));
+        QCOMPARE(cache.lookup(path, Algorithm::Murmur2).value_or(""), QString("123"));
+        QVERIFY(!cache.lookup(path, Algorithm::Sha512).has_value());
+    }
+
+    void test_newVersion()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "mod.jar");
+        writeFile(path, "some mod");
+
+        HashCache cache{ QString() };
+        cache.store(path, HashCache::stampOf(path), Algorithm::Sha1, "abc");
+        writeFile(path, "some other mod");
+        cache.store(path, HashCache::stampOf(path), Algorithm::Murmur2, "123");
+
+        // the digests of the previous version don't carry over
+        QVERIFY(!cache.lookup(path, Algorithm::Sha1).has_value());
+        QCOMPARE(cache.lookup(path, Algorithm::Murmur2).value_or(""), QString("123"));
+    }
+
+    void test_persistence()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "mod.jar");
+        auto index = FS::PathCombine(dir.path(), "hashcache");
+        writeFile(path, "some mod");
+
+        {
+            HashCache cache(index);
+            cache.store(path, HashCache::stampOf(path), Algorithm::Sha512, "abc");
+        }
+
+        HashCache cache(index);
+        cache.load();
+        QCOMPARE(cache.size(), 1);
+        QCOMPARE(cache.lookup(path, Algorithm::Sha512).value_or(""), QString("abc"));
+    }
+};
+
+QTEST_GUILESS_MAIN(HashCacheTest)
+
+#include "HashCache_test.moc"
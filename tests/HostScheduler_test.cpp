@@ -0,0 +1,190 @@
+#include <QSignalSpy>
+#include <QTest>
+
+#include <net/HostScheduler.h>
+
+using Net::HostScheduler;
+using Net::Priority;
+
+class HostSchedulerTest : public QObject {
+    Q_OBJECT
+
+    qint64 m_now = 0;
+
+    HostScheduler::Result success(qint64 bytes, bool http2 = false)
+    {
+        HostScheduler::Result result;
+        result.succeeded = true;
+        result.bytes = bytes;
+        result.http2 = http2;
+        return result;
+    }
+
+    // run a window's worth of requests that take @ms each, all at once
+    void runWindow(HostScheduler& scheduler, const QString& origin, qint64 ms, qint64 bytes, bool http2 = false)
+    {
+        int started = 0;
+        while (scheduler.tryAcquire(origin))
+            started++;
+        m_now += ms;
+        for (int i = 0; i < started; i++)
+            scheduler.release(origin, Priority::Interactive, success(bytes, http2));
+    }
+
+   private slots:
+    void test_origin()
+    {
+        QCOMPARE(HostScheduler::originOf(QUrl("https://user@cdn.example.com:8443/a/b.jar?x=1")), QString("https://cdn.example.com:8443"));
+        QCOMPARE(HostScheduler::originOf(QUrl("https://cdn.example.com/c.jar")), QString("https://cdn.example.com"));
+    }
+
+    void test_capsInFlight()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        scheduler.setBaseWindow(3);
+        QString a("https://a.example.com");
+        QString b("https://b.example.com");
+
+        for (int i = 0; i < 3; i++)
+            QVERIFY(scheduler.tryAcquire(a));
+        QVERIFY(!scheduler.tryAcquire(a));
+        // other hosts don't wait for a busy one
+        QVERIFY(scheduler.tryAcquire(b));
+
+        QSignalSpy spy(&scheduler, &HostScheduler::capacityAvailable);
+        scheduler.release(a, Priority::Interactive, success(100));
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(scheduler.tryAcquire(a));
+        QCOMPARE(scheduler.inFlight(a), 3);
+    }
+
+    void test_backsOffOnCongestion()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        scheduler.setBaseWindow(8);
+        QString origin("https://cdn.example.com");
+        for (int i = 0; i < 8; i++)
+            QVERIFY(scheduler.tryAcquire(origin));
+
+        HostScheduler::Result notFound;
+        notFound.error = QNetworkReply::ContentNotFoundError;
+        notFound.statusCode = 404;
+        scheduler.release(origin, Priority::Interactive, notFound);
+        QCOMPARE(scheduler.window(origin), 8);
+
+        HostScheduler::Result tooMany;
+        tooMany.error = QNetworkReply::UnknownContentError;
+        tooMany.statusCode = 429;
+        scheduler.release(origin, Priority::Interactive, tooMany);
+        QCOMPARE(scheduler.window(origin), 4);
+
+        HostScheduler::Result timeout;
+        timeout.error = QNetworkReply::TimeoutError;
+        scheduler.release(origin, Priority::Interactive, timeout);
+        QCOMPARE(scheduler.window(origin), 2);
+
+        // 5 are still running, nothing more may start until they drop below the window
+        QVERIFY(!scheduler.tryAcquire(origin));
+    }
+
+    void test_growsWithThroughput()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        scheduler.setBaseWindow(4);
+        QString origin("https://cdn.example.com");
+
+        // halve the window, then let it recover: more requests at the same latency means more throughput
+        for (int i = 0; i < 4; i++)
+            QVERIFY(scheduler.tryAcquire(origin));
+        HostScheduler::Result closed;
+        closed.error = QNetworkReply::RemoteHostClosedError;
+        scheduler.release(origin, Priority::Interactive, closed);
+        for (int i = 0; i < 3; i++)
+            scheduler.release(origin, Priority::Interactive, {});
+        QCOMPARE(scheduler.window(origin), 2);
+
+        runWindow(scheduler, origin, 100, 1000);
+        QCOMPARE(scheduler.window(origin), 3);
+        runWindow(scheduler, origin, 100, 1000);
+        QCOMPARE(scheduler.window(origin), 4);
+
+        // HTTP/1.1 origins stop at the base window
+        runWindow(scheduler, origin, 100, 1000);
+        runWindow(scheduler, origin, 100, 1000);
+        QCOMPARE(scheduler.window(origin), 4);
+
+        // HTTP/2 origins may go further
+        for (int i = 0; i < 4; i++)
+            runWindow(scheduler, origin, 100, 1000, true);
+        QVERIFY(scheduler.window(origin) > 4);
+    }
+
+    void test_shrinksWhenSlower()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        scheduler.setBaseWindow(4);
+        QString origin("https://cdn.example.com");
+
+        runWindow(scheduler, origin, 100, 1000, true);
+        QCOMPARE(scheduler.window(origin), 5);
+        // the link is saturated: five requests take much longer than four did
+        runWindow(scheduler, origin, 400, 1000, true);
+        QCOMPARE(scheduler.window(origin), 4);
+    }
+
+    void test_priorities()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        scheduler.setBaseWindow(6);
+        QString cdn("https://cdn.example.com");
+        QString libraries("https://libraries.example.com");
+        int launchJob, interactiveJob;
+
+        QVERIFY(scheduler.tryAcquire(cdn, Priority::Background));
+        QVERIFY(!scheduler.isOutranked(Priority::Background));
+
+        // anything else going on holds background requests back
+        QVERIFY(scheduler.tryAcquire(cdn, Priority::Interactive));
+        QVERIFY(scheduler.isOutranked(Priority::Background));
+        QVERIFY(!scheduler.tryAcquire(cdn, Priority::Background));
+        scheduler.release(cdn, Priority::Interactive, success(10));
+        QVERIFY(!scheduler.isOutranked(Priority::Background));
+
+        scheduler.setWaiting(&interactiveJob, Priority::Interactive, 3);
+        QVERIFY(scheduler.isOutranked(Priority::Background));
+        QVERIFY(!scheduler.tryAcquire(cdn, Priority::Background));
+        QSignalSpy spy(&scheduler, &HostScheduler::capacityAvailable);
+        scheduler.setWaiting(&interactiveJob, Priority::Interactive, 0);
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(scheduler.tryAcquire(cdn, Priority::Background));
+
+        // while a launch waits, interactive requests go one at a time, even to other hosts
+        scheduler.setWaiting(&launchJob, Priority::Launch, 100);
+        QVERIFY(scheduler.isOutranked(Priority::Interactive));
+        QVERIFY(scheduler.tryAcquire(cdn, Priority::Interactive));
+        QVERIFY(!scheduler.tryAcquire(cdn, Priority::Interactive));
+        QVERIFY(scheduler.tryAcquire(libraries, Priority::Launch));
+        scheduler.setWaiting(&launchJob, Priority::Launch, 0);
+        QVERIFY(scheduler.tryAcquire(cdn, Priority::Interactive));
+    }
+
+    void test_bandwidthLimit()
+    {
+        HostScheduler scheduler([this] { return m_now; });
+        QCOMPARE(scheduler.takeBandwidth(Priority::Interactive, 1 << 20), qint64(1 << 20));
+
+        scheduler.setBandwidthLimit(Priority::Background, 10000);
+        QCOMPARE(scheduler.bandwidthLimit(Priority::Background), qint64(10000));
+        QCOMPARE(scheduler.takeBandwidth(Priority::Background, 5000), qint64(0));
+        m_now += 100;
+        QCOMPARE(scheduler.takeBandwidth(Priority::Background, 5000), qint64(1000));
+        QCOMPARE(scheduler.takeBandwidth(Priority::Background, 5000), qint64(0));
+        // unused budget is only saved up for a short while
+        m_now += 10000;
+        QCOMPARE(scheduler.takeBandwidth(Priority::Background, 1 << 20), qint64(2500));
+    }
+};
+
+QTEST_GUILESS_MAIN(HostSchedulerTest)
+
+#include "HostScheduler_test.moc"
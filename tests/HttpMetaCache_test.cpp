@@ -0,0 +1,140 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <net/HttpMetaCache.h>
+
+class HttpMetaCacheTest : public QObject {
+    Q_OBJECT
+
+    void addEntry(HttpMetaCache& cache, const QString& path, const QString& etag)
+    {
+        auto entry = cache.resolveEntry("test", path);
+        QVERIFY(entry->isStale());
+        entry->setETag(etag);
+        entry->setMD5Sum("d41d8cd98f00b204e9800998ecf8427e");
+        entry->setLocalChangedTimestamp(1234);
+        entry->makeEternal(true);
+        entry->setStale(false);
+        QVERIFY(cache.updateEntry(entry));
+    }
+
+    void open(HttpMetaCache& cache, const QString& dir)
+    {
+        cache.addBase("test", FS::PathCombine(dir, "files"));
+        cache.Load();
+    }
+
+   private slots:
+    void test_roundTrip()
+    {
+        QTemporaryDir dir;
+        auto index = FS::PathCombine(dir.path(), "metacache");
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            addEntry(cache, "a.jar", "\"one\"");
+            addEntry(cache, "b.jar", "\"two\"");
+        }
+
+        HttpMetaCache cache(index);
+        open(cache, dir.path());
+        auto entry = cache.getEntry("test", "a.jar");
+        QVERIFY(entry);
+        QVERIFY(!entry->isStale());
+        QCOMPARE(entry->getETag(), QString("\"one\""));
+        QCOMPARE(entry->getMD5Sum(), QString("d41d8cd98f00b204e9800998ecf8427e"));
+        QVERIFY(entry->isEternal());
+        QVERIFY(cache.getEntry("test", "b.jar"));
+    }
+
+    void test_journalReplay()
+    {
+        QTemporaryDir dir;
+        auto index = FS::PathCombine(dir.path(), "metacache");
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            addEntry(cache, "a.jar", "\"one\"");
+            addEntry(cache, "b.jar", "\"two\"");
+        }
+        {
+            // the second session only appends what changed
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            QVERIFY(cache.evictEntry(cache.getEntry("test", "a.jar")));
+            addEntry(cache, "b.jar", "\"three\"");
+        }
+        QVERIFY(QFileInfo(index + ".journal").size() > 0);
+
+        HttpMetaCache cache(index);
+        open(cache, dir.path());
+        QVERIFY(!cache.getEntry("test", "a.jar"));
+        QCOMPARE(cache.getEntry("test", "b.jar")->getETag(), QString("\"three\""));
+    }
+
+    void test_damagedJournal()
+    {
+        QTemporaryDir dir;
+        auto index = FS::PathCombine(dir.path(), "metacache");
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            addEntry(cache, "a.jar", "\"one\"");
+        }
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            addEntry(cache, "b.jar", "\"two\"");
+        }
+
+        // a crash in the middle of appending a record
+        QFile journal(index + ".journal");
+        QVERIFY(journal.open(QIODevice::Append));
+        journal.write("\x01\x00\x00", 3);
+        journal.close();
+
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            QVERIFY(cache.getEntry("test", "a.jar"));
+            QVERIFY(cache.getEntry("test", "b.jar"));
+            addEntry(cache, "c.jar", "\"three\"");
+        }
+
+        HttpMetaCache cache(index);
+        open(cache, dir.path());
+        QVERIFY(cache.getEntry("test", "a.jar"));
+        QVERIFY(cache.getEntry("test", "b.jar"));
+        QVERIFY(cache.getEntry("test", "c.jar"));
+    }
+
+    void test_legacyIndex()
+    {
+        QTemporaryDir dir;
+        auto index = FS::PathCombine(dir.path(), "metacache");
+        QFile legacy(index);
+        QVERIFY(legacy.open(QIODevice::WriteOnly));
+        legacy.write(R"({"version": "1", "entries": [{"base": "test", "path": "a.jar", "md5sum": "abc", "etag": "\"one\"",
+                         "last_changed_timestamp": 1234, "eternal": true}]})");
+        legacy.close();
+
+        {
+            HttpMetaCache cache(index);
+            open(cache, dir.path());
+            auto entry = cache.getEntry("test", "a.jar");
+            QVERIFY(entry);
+            QCOMPARE(entry->getETag(), QString("\"one\""));
+        }
+        QVERIFY(!QFileInfo::exists(index));
+        QVERIFY(QFileInfo::exists(index + ".idx"));
+
+        HttpMetaCache cache(index);
+        open(cache, dir.path());
+        QVERIFY(cache.getEntry("test", "a.jar"));
+    }
+};
+
+QTEST_GUILESS_MAIN(HttpMetaCacheTest)
+
+#include "HttpMetaCache_test.moc"
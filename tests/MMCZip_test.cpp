@@ -0,0 +1,132 @@
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+
+#include <FileSystem.h>
+#include <MMCZip.h>
+
+class MMCZipTest : public QObject {
+    Q_OBJECT
+
+    QHash<QString, QByteArray> m_contents;
+    QStringList m_order;
+
+    // random data doesn't compress, so the archive is big enough to be extracted on several threads
+    bool makeArchive(const QString& path, const QStringList& extraNames = {})
+    {
+        QuaZip zip(path);
+        if (!zip.open(QuaZip::mdCreate))
+            return false;
+
+        m_contents.clear();
+        m_order.clear();
+        QStringList names;
+        for (int i = 0; i < 24; i++)
+            names.append(QString("pack/.minecraft/mods/mod%1.jar").arg(i));
+        names.append("pack/instance.cfg");
+        names.append(extraNames);
+
+        for (auto& name : names) {
+            QByteArray data(256 * 1024, Qt::Uninitialized);
+            QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(data.data()), data.size() / sizeof(quint32));
+            QuaZipFile file(&zip);
+            if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo(name)))
+                return false;
+            file.write(data);
+            file.close();
+            m_contents[name] = data;
+            m_order.append(name);
+        }
+        zip.close();
+        return true;
+    }
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+   private slots:
+    void test_extractSubDir()
+    {
+        QTemporaryDir dir;
+        auto archive = FS::PathCombine(dir.path(), "pack.zip");
+        QVERIFY(makeArchive(archive));
+        auto target = FS::PathCombine(dir.path(), "out");
+
+        QuaZip zip(archive);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        auto extracted = MMCZip::extractSubDir(&zip, "pack/", target);
+        QVERIFY(extracted);
+        QCOMPARE(extracted->size(), m_order.size());
+
+        // archive order, whichever thread extracted what
+        for (int i = 0; i < m_order.size(); i++) {
+            auto expected = FS::PathCombine(target, m_order[i].mid(QString("pack/").size()));
+            QCOMPARE(extracted->at(i), expected);
+            QCOMPARE(readFile(expected), m_contents[m_order[i]]);
+        }
+    }
+
+    void test_skip()
+    {
+        QTemporaryDir dir;
+        auto archive = FS::PathCombine(dir.path(), "pack.zip");
+        QVERIFY(makeArchive(archive));
+        auto target = FS::PathCombine(dir.path(), "out");
+
+        QuaZip zip(archive);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        int progressCalls = 0;
+        MMCZip::ParallelExtractor extract(&zip, "pack/", target);
+        extract.skip([](const QString& name, const QuaZipFileInfo64&, const QString&) { return name.endsWith("mod3.jar"); });
+        extract.progress([&progressCalls](const QString&, int, int) { progressCalls++; });
+        QVERIFY(extract());
+
+        QCOMPARE(extract.extracted().size(), m_order.size());
+        QCOMPARE(progressCalls, m_order.size() - 1);
+        QVERIFY(!QFileInfo::exists(FS::PathCombine(target, ".minecraft/mods/mod3.jar")));
+        QCOMPARE(readFile(FS::PathCombine(target, ".minecraft/mods/mod4.jar")), m_contents["pack/.minecraft/mods/mod4.jar"]);
+    }
+
+    void test_outsideOfTarget()
+    {
+        QTemporaryDir dir;
+        auto archive = FS::PathCombine(dir.path(), "pack.zip");
+        QVERIFY(makeArchive(archive, { "pack/../../escaped.txt" }));
+        auto target = FS::PathCombine(dir.path(), "out");
+
+        QuaZip zip(archive);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        QVERIFY(!MMCZip::extractSubDir(&zip, "pack/", target));
+
+        // the archive is checked before anything is written
+        QVERIFY(!QFileInfo::exists(FS::PathCombine(target, ".minecraft/mods/mod0.jar")));
+        QVERIFY(!QFileInfo::exists(FS::PathCombine(dir.path(), "escaped.txt")));
+    }
+
+    void test_cancel()
+    {
+        QTemporaryDir dir;
+        auto archive = FS::PathCombine(dir.path(), "pack.zip");
+        QVERIFY(makeArchive(archive));
+
+        QuaZip zip(archive);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        MMCZip::ParallelExtractor extract(&zip, "pack/", FS::PathCombine(dir.path(), "out"));
+        extract.cancelWhen([] { return true; });
+        QVERIFY(!extract());
+        QVERIFY(extract.wasCanceled());
+        QVERIFY(extract.extracted().isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(MMCZipTest)
+
+#include "MMCZip_test.moc"
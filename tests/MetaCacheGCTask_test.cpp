@@ -0,0 +1,82 @@
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <net/HttpMetaCache.h>
+#include <net/MetaCacheGCTask.h>
+
+class MetaCacheGCTaskTest : public QObject {
+    Q_OBJECT
+
+    void writeFile(const QString& path, const QByteArray& data)
+    {
+        QVERIFY(FS::ensureFilePathExists(path));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+   private slots:
+    void test_quota()
+    {
+        QTemporaryDir dir;
+        auto files = FS::PathCombine(dir.path(), "files");
+        for (auto name : { "a.zip", "b.zip", "c.zip" })
+            writeFile(FS::PathCombine(files, name), QByteArray(600, 'x'));
+
+        // an old index, so none of the entries count as recently used
+        auto index = FS::PathCombine(dir.path(), "metacache");
+        writeFile(index, R"({"version": "1", "entries": [
+            {"base": "test", "path": "a.zip", "md5sum": "", "etag": "", "last_changed_timestamp": 1000, "eternal": true},
+            {"base": "test", "path": "b.zip", "md5sum": "", "etag": "", "last_changed_timestamp": 2000, "eternal": true},
+            {"base": "test", "path": "c.zip", "md5sum": "", "etag": "", "last_changed_timestamp": 3000, "eternal": true}]})");
+
+        // the least recently used file belongs to an instance
+        auto instance = FS::PathCombine(dir.path(), "instance");
+        writeFile(FS::PathCombine(instance, "instance.cfg"), "TruckPackCachePath=" + FS::PathCombine(files, "a.zip").toUtf8() + "\n");
+
+        shared_qobject_ptr<HttpMetaCache> cache(new HttpMetaCache(index));
+        cache->addBase("test", files);
+        cache->Load();
+        cache->setQuota("test", 1300);
+
+        MetaCacheGCTask task(cache, { instance });
+        QSignalSpy spy(&task, &Task::finished);
+        task.start();
+        QVERIFY(spy.wait());
+        QVERIFY(task.wasSuccessful());
+
+        QVERIFY(QFileInfo::exists(FS::PathCombine(files, "a.zip")));
+        QVERIFY(!QFileInfo::exists(FS::PathCombine(files, "b.zip")));
+        QVERIFY(QFileInfo::exists(FS::PathCombine(files, "c.zip")));
+        QVERIFY(cache->getEntry("test", "a.zip"));
+        QVERIFY(!cache->getEntry("test", "b.zip"));
+        QVERIFY(cache->getEntry("test", "c.zip"));
+    }
+
+    void test_noQuota()
+    {
+        QTemporaryDir dir;
+        auto files = FS::PathCombine(dir.path(), "files");
+        writeFile(FS::PathCombine(files, "a.zip"), QByteArray(600, 'x'));
+
+        shared_qobject_ptr<HttpMetaCache> cache(new HttpMetaCache(FS::PathCombine(dir.path(), "metacache")));
+        cache->addBase("test", files);
+        cache->Load();
+        auto entry = cache->resolveEntry("test", "a.zip");
+        entry->setStale(false);
+        QVERIFY(cache->updateEntry(entry));
+
+        MetaCacheGCTask task(cache, {});
+        QSignalSpy spy(&task, &Task::finished);
+        task.start();
+        QVERIFY(spy.count() || spy.wait());
+        QVERIFY(task.wasSuccessful());
+        QVERIFY(QFileInfo::exists(FS::PathCombine(files, "a.zip")));
+    }
+};
+
+QTEST_GUILESS_MAIN(MetaCacheGCTaskTest)
+
+#include "MetaCacheGCTask_test.moc"
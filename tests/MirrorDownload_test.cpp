@@ -0,0 +1,183 @@
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <net/ChecksumValidator.h>
+#include <net/Download.h>
+
+/** Stands in for the servers of a download, with a few ways of misbehaving. */
+class StandInServer : public QTcpServer {
+    Q_OBJECT
+   public:
+    explicit StandInServer(QByteArray body) : m_body(std::move(body))
+    {
+        listen(QHostAddress::LocalHost);
+        connect(this, &QTcpServer::newConnection, this, [this] {
+            while (auto socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] { respond(socket); });
+            }
+        });
+    }
+
+    QUrl url(const QString& path) const { return QUrl(QString("http://127.0.0.1:%1%2").arg(serverPort()).arg(path)); }
+
+   private:
+    void respond(QTcpSocket* socket)
+    {
+        auto& request = m_requests[socket];
+        request += socket->readAll();
+        if (!request.contains("\r\n\r\n"))
+            return;
+        auto path = request.split(' ').value(1);
+
+        if (path == "/missing") {
+            socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+        auto body = m_body;
+        if (path == "/other")
+            body.fill('y');
+        else if (path == "/short")
+            body.chop(body.size() / 2);
+        socket->write("HTTP/1.1 200 OK\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n");
+        if (path == "/stall") {
+            // the start of the file, and then nothing
+            socket->write(body.left(1000));
+            return;
+        }
+        socket->write(body);
+        socket->disconnectFromHost();
+    }
+
+   private:
+    QByteArray m_body;
+    QHash<QTcpSocket*, QByteArray> m_requests;
+};
+
+class MirrorDownloadTest : public QObject {
+    Q_OBJECT
+
+    QByteArray makeBody()
+    {
+        QByteArray body;
+        for (int i = 0; body.size() < 256 * 1024; i++)
+            body += QByteArray::number(i) + '\n';
+        return body;
+    }
+
+    Net::Download::Ptr makeDownload(QUrl url, const QString& path, const QByteArray& body)
+    {
+        auto dl = Net::Download::makeFile(url, path);
+        dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, QCryptographicHash::hash(body, QCryptographicHash::Sha1)));
+        auto network = makeShared<QNetworkAccessManager>();
+        network->setProxy(QNetworkProxy::NoProxy);
+        dl->setNetwork(network);
+        return dl;
+    }
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+   private slots:
+    void test_fallback()
+    {
+        auto body = makeBody();
+        StandInServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        auto dl = makeDownload(server.url("/missing"), path, body);
+        dl->setMirrors({ server.url("/file") });
+        QSignalSpy spy(dl.get(), &Task::finished);
+        dl->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(dl->wasSuccessful());
+        QCOMPARE(readFile(path), body);
+    }
+
+    void test_hedge()
+    {
+        auto body = makeBody();
+        StandInServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        auto dl = makeDownload(server.url("/stall"), path, body);
+        dl->setMirrors({ server.url("/file") }, 300);
+        QSignalSpy spy(dl.get(), &Task::finished);
+        dl->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(dl->wasSuccessful());
+        QCOMPARE(readFile(path), body);
+    }
+
+    void test_hedgeWithDifferentFile()
+    {
+        auto body = makeBody();
+        StandInServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        // the mirror wins the race, but its file doesn't pass the checksum
+        auto dl = makeDownload(server.url("/stall"), path, body);
+        dl->setMirrors({ server.url("/other") }, 300);
+        QSignalSpy spy(dl.get(), &Task::finished);
+        dl->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(!dl->wasSuccessful());
+        QVERIFY(!QFileInfo::exists(path));
+    }
+
+    void test_hedgeWithDifferentSize()
+    {
+        auto body = makeBody();
+        StandInServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        // the first reply announced the size already, a mirror announcing another one can't have the same file
+        auto dl = makeDownload(server.url("/stall"), path, body);
+        dl->setMirrors({ server.url("/short") }, 300);
+        QSignalSpy spy(dl.get(), &Task::finished);
+        dl->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(!dl->wasSuccessful());
+        QVERIFY(!QFileInfo::exists(path));
+    }
+
+    void test_noHedgeWithoutChecksum()
+    {
+        auto body = makeBody();
+        StandInServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        // without a checksum, nothing says the mirror's data continues the first reply
+        auto dl = Net::Download::makeFile(server.url("/stall"), path);
+        auto network = makeShared<QNetworkAccessManager>();
+        network->setProxy(QNetworkProxy::NoProxy);
+        dl->setNetwork(network);
+        dl->setMirrors({ server.url("/file") }, 300);
+        QSignalSpy spy(dl.get(), &Task::finished);
+        dl->start();
+        QVERIFY(!spy.wait(1500));
+        dl->abort();
+        QVERIFY(spy.count() || spy.wait(5000));
+    }
+};
+
+QTEST_GUILESS_MAIN(MirrorDownloadTest)
+
+#include "MirrorDownload_test.moc"
@@ -0,0 +1,72 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <minecraft/mod/ModDetailsCache.h>
+
+class ModDetailsCacheTest : public QObject {
+    Q_OBJECT
+
+    ModDetails makeDetails()
+    {
+        ModDetails details;
+        details.mod_id = "truckmod";
+        details.name = "Truck Mod";
+        details.version = "1.2.3";
+        details.authors = QStringList{ "someone", "someone else" };
+        details.licenses.append(ModLicense("MIT"));
+        details.icon_file = "assets/truckmod/icon.png";
+        return details;
+    }
+
+    QImage makeIcon()
+    {
+        QImage icon(64, 64, QImage::Format_ARGB32);
+        icon.fill(Qt::red);
+        return icon;
+    }
+
+   private slots:
+    void test_details()
+    {
+        QTemporaryDir dir;
+        auto index = FS::PathCombine(dir.path(), "mods.cache");
+        auto jar = FS::PathCombine(dir.path(), "truckmod.jar");
+        FS::write(jar, "first");
+        {
+            ModDetailsCache cache(index);
+            cache.load();
+            cache.store(QFileInfo(jar), makeDetails(), makeIcon());
+        }
+
+        ModDetailsCache cache(index);
+        cache.load();
+        auto entry = cache.lookup(QFileInfo(jar));
+        QVERIFY(entry);
+        QCOMPARE(entry->details.name, QString("Truck Mod"));
+        QCOMPARE(entry->details.version, QString("1.2.3"));
+        QCOMPARE(entry->details.authors.size(), 2);
+        QCOMPARE(entry->details.icon_file, QString("assets/truckmod/icon.png"));
+        QCOMPARE(entry->details.licenses.size(), 1);
+        QCOMPARE(entry->details.licenses.first().id, QString("MIT"));
+        QCOMPARE(entry->icon.pixelColor(10, 10), QColor(Qt::red));
+    }
+
+    void test_noIcon()
+    {
+        QTemporaryDir dir;
+        auto jar = FS::PathCombine(dir.path(), "truckmod.jar");
+        FS::write(jar, "first");
+        ModDetailsCache cache{ QString() };
+        cache.store(QFileInfo(jar), makeDetails(), {});
+
+        auto entry = cache.lookup(QFileInfo(jar));
+        QVERIFY(entry);
+        QCOMPARE(entry->details.mod_id, QString("truckmod"));
+        QVERIFY(entry->icon.isNull());
+    }
+};
+
+QTEST_GUILESS_MAIN(ModDetailsCacheTest)
+
+#include "ModDetailsCache_test.moc"
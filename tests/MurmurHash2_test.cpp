@@ -0,0 +1,129 @@
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <MurmurHash2.h>
+
+#include <cstring>
+
+namespace {
+bool isWhitespace(char c)
+{
+    return c == 9 || c == 10 || c == 13 || c == 32;
+}
+
+class ByteArrayReader : public Murmur2::Reader {
+   public:
+    explicit ByteArrayReader(const QByteArray& data) : m_data(data) {}
+    int read(char* s, int n) override
+    {
+        int count = std::min<qsizetype>(n, m_data.size() - m_pos);
+        memcpy(s, m_data.constData() + m_pos, count);
+        m_pos += count;
+        return count;
+    }
+    bool eof() override { return m_pos >= m_data.size(); }
+    void goToBeginning() override { m_pos = 0; }
+
+   private:
+    const QByteArray& m_data;
+    qsizetype m_pos = 0;
+};
+
+// what CurseForge fingerprints were computed with before there was a dedicated kernel
+uint32_t reference(const QByteArray& data)
+{
+    ByteArrayReader reader(data);
+    return Murmur2::hash(&reader, 4 * KiB, isWhitespace);
+}
+
+QByteArray randomData(qsizetype size, int whitespacePercent)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    auto rng = QRandomGenerator::global();
+    for (auto& c : data) {
+        c = char(rng->bounded(256));
+        if (int(rng->bounded(100)) < whitespacePercent)
+            c = " \t\r\n"[rng->bounded(4)];
+    }
+    return data;
+}
+}  // namespace
+
+class MurmurHash2Test : public QObject {
+    Q_OBJECT
+
+   private slots:
+    void test_knownFingerprint()
+    {
+        QByteArray data("Hello world\n\tfoo bar\r\n");
+        QCOMPARE(Murmur2::countNonWhitespace(data.constData(), data.size()), std::size_t(16));
+        QCOMPARE(Murmur2::hashWithoutWhitespace(data.constData(), data.size()), 3832668685u);
+        QCOMPARE(reference(data), 3832668685u);
+    }
+
+    void test_matchesReference_data()
+    {
+        QTest::addColumn<QByteArray>("data");
+        QTest::newRow("empty") << QByteArray();
+        QTest::newRow("only whitespace") << QByteArray(100, ' ');
+        for (int size = 1; size < 80; size++)
+            QTest::addRow("%d bytes", size) << randomData(size, 20);
+        QTest::newRow("binary") << randomData(300 * 1024 + 3, 0);
+        QTest::newRow("text") << randomData(300 * 1024 + 1, 30);
+        QTest::newRow("mostly whitespace") << randomData(200 * 1024 + 2, 90);
+    }
+
+    void test_matchesReference()
+    {
+        QFETCH(QByteArray, data);
+        QCOMPARE(Murmur2::hashWithoutWhitespace(data.constData(), data.size()), reference(data));
+    }
+
+    // Run with MURMUR2_BENCHMARK_DIR pointing to a folder of mod jars to measure real files,
+    // e.g. `MURMUR2_BENCHMARK_DIR=~/.minecraft/mods ctest -R MurmurHash2 -V`
+    void benchmark_data()
+    {
+        QTest::addColumn<QByteArray>("data");
+        QTest::addColumn<bool>("legacy");
+
+        QList<std::pair<QString, QByteArray>> inputs;
+        auto dir = qEnvironmentVariable("MURMUR2_BENCHMARK_DIR");
+        if (!dir.isEmpty()) {
+            for (auto& jar : QDir(dir).entryInfoList({ "*.jar" }, QDir::Files)) {
+                QFile file(jar.absoluteFilePath());
+                if (file.open(QIODevice::ReadOnly))
+                    inputs.append({ jar.fileName(), file.readAll() });
+            }
+        }
+        if (inputs.isEmpty())
+            inputs.append({ "random 16 MiB", randomData(16 * 1024 * 1024, 0) });
+
+        for (auto& [name, data] : inputs) {
+            QTest::addRow("%s (legacy)", qPrintable(name)) << data << true;
+            QTest::addRow("%s", qPrintable(name)) << data << false;
+        }
+    }
+
+    void benchmark()
+    {
+        QFETCH(QByteArray, data);
+        QFETCH(bool, legacy);
+        uint32_t result = 0;
+        if (legacy) {
+            QBENCHMARK {
+                result = reference(data);
+            }
+        } else {
+            QBENCHMARK {
+                result = Murmur2::hashWithoutWhitespace(data.constData(), data.size());
+            }
+        }
+        QCOMPARE(result, reference(data));
+    }
+};
+
+QTEST_GUILESS_MAIN(MurmurHash2Test)
+
+#include "MurmurHash2_test.moc"
@@ -0,0 +1,471 @@
+/*
+ * Measures the download stack (NetJob, NetRequest and the sinks) against a local server, instead of real CDNs.
+ *
+ * Not a test, run it by hand:
+ *   NetBenchmark --scenario mods --concurrency 1,6,24 --sink cache
+ *   NetBenchmark --scenario pack --bandwidth 20480 --latency 50
+ *
+ * The server runs on its own thread and serves synthetic files: 'mods' are 2000 files of 50 KiB, the 'pack' is a
+ * single 2 GiB file (--files and --size change that). It can add latency to every response, limit the bandwidth
+ * of every connection and fail a share of the responses. Every run reports files/s, MiB/s, the CPU time of the
+ * client side and the peak memory use of the process.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <FileSystem.h>
+#include <net/Download.h>
+#include <net/HostScheduler.h>
+#include <net/HttpMetaCache.h>
+#include <net/NetJob.h>
+#include <net/RequestTimings.h>
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+// after windows.h
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_WIN)
+double seconds(const FILETIME& time)
+{
+    ULARGE_INTEGER ticks;
+    ticks.LowPart = time.dwLowDateTime;
+    ticks.HighPart = time.dwHighDateTime;
+    return ticks.QuadPart / 1e7;
+}
+#endif
+
+/** CPU time of the whole process so far, in seconds. */
+double processCpuTime()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+/** CPU time of the calling thread so far, in seconds. */
+double threadCpuTime()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    return seconds(kernel) + seconds(user);
+#else
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+#endif
+}
+
+/** Start measuring the peak memory use anew, where the platform allows for it. Elsewhere it is the peak of the process. */
+void resetPeakMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly))
+        clearRefs.write("5");
+#endif
+}
+
+/** The peak resident memory, in MiB. */
+double peakMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+    for (auto& line : status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong() / 1024.0;
+    }
+    return 0;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+}  // namespace
+
+struct ServerOptions {
+    /// before every response, in milliseconds
+    int latency = 0;
+    /// of every connection, in bytes per second. 0 means no limit
+    qint64 bandwidth = 0;
+    /// share of the responses that fail: half of them with a 503, the others break off halfway through the body
+    double failureRate = 0;
+};
+
+/** Serves files made up on the fly, with HTTP/1.1 keep-alive. */
+class SyntheticServer : public QTcpServer {
+    Q_OBJECT
+   public:
+    SyntheticServer(QHash<QString, qint64> files, ServerOptions options) : m_files(std::move(files)), m_options(options)
+    {
+        // every file is the same pattern, starting at a different place in it
+        m_pattern.resize(ChunkSize + 256);
+        for (int i = 0; i < m_pattern.size(); i++)
+            m_pattern[i] = static_cast<char>(i % 256);
+
+        connect(this, &QTcpServer::newConnection, this, [this] {
+            while (auto socket = nextPendingConnection()) {
+                m_connections.insert(socket, {});
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] { readRequest(socket); });
+                connect(socket, &QTcpSocket::bytesWritten, this, [this, socket] { pump(socket); });
+                connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+                    m_connections.remove(socket);
+                    socket->deleteLater();
+                });
+            }
+        });
+    }
+
+   private:
+    static constexpr qint64 ChunkSize = 64 * 1024;
+
+    struct Connection {
+        QByteArray request;
+        bool busy = false;
+        bool throttled = false;
+        int offset = 0;
+        qint64 length = 0;
+        qint64 sent = 0;
+        /// where the body breaks off, -1 if it doesn't
+        qint64 breakAt = -1;
+        QElapsedTimer started;
+    };
+
+    void readRequest(QTcpSocket* socket)
+    {
+        auto& connection = m_connections[socket];
+        connection.request += socket->readAll();
+        auto end = connection.request.indexOf("\r\n\r\n");
+        if (connection.busy || end < 0)
+            return;
+
+        auto path = QString::fromLatin1(connection.request.left(end).split(' ').value(1));
+        connection.request.remove(0, end + 4);
+        connection.busy = true;
+        QTimer::singleShot(m_options.latency, socket, [this, socket, path] { respond(socket, path); });
+    }
+
+    void respond(QTcpSocket* socket, const QString& path)
+    {
+        if (!m_connections.contains(socket))
+            return;
+        auto& connection = m_connections[socket];
+        auto roll = m_options.failureRate > 0 ? QRandomGenerator::global()->generateDouble() : 1.0;
+        if (!m_files.contains(path) || roll < m_options.failureRate / 2) {
+            socket->write(m_files.contains(path) ? "HTTP/1.1 503 Service Unavailable\r\n" : "HTTP/1.1 404 Not Found\r\n");
+            socket->write("Content-Length: 0\r\n\r\n");
+            finishResponse(socket);
+            return;
+        }
+
+        connection.offset = qHash(path) % 256;
+        connection.length = m_files[path];
+        connection.sent = 0;
+        connection.breakAt = roll < m_options.failureRate ? connection.length / 2 : -1;
+        connection.started.start();
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " +
+                      QByteArray::number(connection.length) + "\r\n\r\n");
+        if (connection.length == 0)
+            finishResponse(socket);
+        else
+            pump(socket);
+    }
+
+    void pump(QTcpSocket* socket)
+    {
+        auto it = m_connections.find(socket);
+        if (it == m_connections.end())
+            return;
+        auto& connection = *it;
+
+        // only keep a few chunks in flight, like a server that streams from disk would
+        while (connection.busy && connection.sent < connection.length && socket->bytesToWrite() < 4 * ChunkSize) {
+            auto chunk = std::min(ChunkSize, connection.length - connection.sent);
+            if (connection.breakAt >= 0)
+                chunk = std::min(chunk, connection.breakAt - connection.sent);
+            if (m_options.bandwidth > 0) {
+                auto allowed = m_options.bandwidth * connection.started.elapsed() / 1000 - connection.sent;
+                if (allowed <= 0) {
+                    if (!connection.throttled) {
+                        connection.throttled = true;
+                        QTimer::singleShot(10, socket, [this, socket] {
+                            if (m_connections.contains(socket))
+                                m_connections[socket].throttled = false;
+                            pump(socket);
+                        });
+                    }
+                    return;
+                }
+                chunk = std::min(chunk, allowed);
+            }
+
+            socket->write(m_pattern.constData() + (connection.sent + connection.offset) % 256, chunk);
+            connection.sent += chunk;
+            if (connection.sent == connection.breakAt) {
+                socket->abort();
+                return;
+            }
+            if (connection.sent == connection.length) {
+                finishResponse(socket);
+                return;
+            }
+        }
+    }
+
+    void finishResponse(QTcpSocket* socket)
+    {
+        auto& connection = m_connections[socket];
+        connection.busy = false;
+        // the next request may have come in already
+        if (connection.request.contains("\r\n\r\n"))
+            QTimer::singleShot(0, socket, [this, socket] { readRequest(socket); });
+    }
+
+   private:
+    QHash<QString, qint64> m_files;
+    ServerOptions m_options;
+    QByteArray m_pattern;
+    QHash<QTcpSocket*, Connection> m_connections;
+};
+
+/** Runs a SyntheticServer on its own thread, so serving the files doesn't count towards the client's time. */
+class ServerThread {
+   public:
+    ServerThread(const QHash<QString, qint64>& files, const ServerOptions& options)
+    {
+        m_server = new SyntheticServer(files, options);
+        m_server->moveToThread(&m_thread);
+        QObject::connect(&m_thread, &QThread::finished, m_server, &QObject::deleteLater);
+        m_thread.start();
+        QMetaObject::invokeMethod(m_server, [this] { m_server->listen(QHostAddress::LocalHost); }, Qt::BlockingQueuedConnection);
+        m_origin = QString("http://127.0.0.1:%1").arg(m_server->serverPort());
+    }
+    ~ServerThread()
+    {
+        m_thread.quit();
+        m_thread.wait();
+    }
+
+    QUrl url(const QString& path) const { return QUrl(m_origin + path); }
+
+    double cpuTime()
+    {
+        double time = 0;
+        QMetaObject::invokeMethod(m_server, [&time] { time = threadCpuTime(); }, Qt::BlockingQueuedConnection);
+        return time;
+    }
+
+   private:
+    QThread m_thread;
+    SyntheticServer* m_server;
+    QString m_origin;
+};
+
+struct Scenario {
+    QString name;
+    int files = 0;
+    qint64 size = 0;
+    QString sink;
+};
+
+struct Result {
+    int failed = 0;
+    int attempts = 0;
+    double seconds = 0;
+    double cpu = 0;
+    double peakMemory = 0;
+};
+
+Result run(const Scenario& scenario, int concurrency, const ServerOptions& options)
+{
+    QHash<QString, qint64> files;
+    for (int i = 0; i < scenario.files; i++)
+        files.insert(QString("/%1/%2.bin").arg(scenario.name).arg(i), scenario.size);
+    // a new server for every run, so nothing the host scheduler learned carries over
+    ServerThread server(files, options);
+
+    QTemporaryDir dir;
+    HttpMetaCache cache(FS::PathCombine(dir.path(), "metacache"));
+    cache.addBase("bench", FS::PathCombine(dir.path(), "cache"));
+    cache.Load();
+
+    auto network = makeShared<QNetworkAccessManager>();
+    network->setProxy(QNetworkProxy::NoProxy);
+    Net::TimingLog::instance()->clear();
+    resetPeakMemory();
+
+    QElapsedTimer timer;
+    timer.start();
+    auto cpuBefore = processCpuTime() - server.cpuTime();
+
+    auto job = makeShared<NetJob>("Benchmark", network, concurrency);
+    Net::HostScheduler::instance()->setBaseWindow(concurrency);
+    job->setAskRetry(false);
+    QList<MetaEntryPtr> entries;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        auto url = server.url(it.key());
+        if (scenario.sink == "cache") {
+            auto entry = cache.resolveEntry("bench", it.key().mid(1));
+            entries.append(entry);
+            job->addNetAction(Net::Download::makeCached(url, entry));
+        } else if (scenario.sink == "memory") {
+            job->addNetAction(Net::Download::makeByteArray(url, std::make_shared<QByteArray>()));
+        } else {
+            job->addNetAction(Net::Download::makeFile(url, FS::PathCombine(dir.path(), "files", it.key().mid(1))));
+        }
+    }
+
+    QEventLoop loop;
+    QObject::connect(job.get(), &Task::finished, &loop, &QEventLoop::quit);
+    job->start();
+    loop.exec();
+    // the launcher's metacache keeps the entries of its downloads itself
+    for (auto& entry : entries)
+        cache.updateEntry(entry);
+
+    Result result;
+    result.cpu = processCpuTime() - server.cpuTime() - cpuBefore;
+    result.seconds = timer.elapsed() / 1000.0;
+    result.peakMemory = peakMemory();
+    result.failed = job->getFailedActions().size();
+    result.attempts = Net::TimingLog::instance()->records().size();
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the download stack against a local server.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "scenario", "'mods' (2000 files of 50 KiB) or 'pack' (one file of 2 GiB).", "name", "mods" },
+        { "files", "How many files to download, instead of what the scenario says.", "count" },
+        { "size", "Size of every file in KiB, instead of what the scenario says.", "KiB" },
+        { "sink", "Where the downloads go: 'file', 'cache' (the metacache) or 'memory'.", "sink", "file" },
+        { "concurrency", "Comma-separated concurrency limits to run with.", "list", "1,6,24" },
+        { "runs", "How many times to run every configuration.", "count", "1" },
+        { "latency", "Delay before every response, in milliseconds.", "ms", "0" },
+        { "bandwidth", "Bandwidth of every connection in KiB/s, 0 for no limit.", "KiB/s", "0" },
+        { "failures", "Share of the responses that fail, in percent.", "percent", "0" },
+        { "timings", "Export the timings of the requests of the last run to this file (.json or .csv).", "file" },
+    });
+    parser.process(app);
+
+    Scenario scenario;
+    scenario.name = parser.value("scenario");
+    if (scenario.name == "mods") {
+        scenario.files = 2000;
+        scenario.size = 50 * 1024;
+    } else if (scenario.name == "pack") {
+        scenario.files = 1;
+        scenario.size = 2048ll * 1024 * 1024;
+    } else {
+        qCritical() << "Unknown scenario" << scenario.name;
+        return 1;
+    }
+    if (parser.isSet("files"))
+        scenario.files = parser.value("files").toInt();
+    if (parser.isSet("size"))
+        scenario.size = parser.value("size").toLongLong() * 1024;
+    scenario.sink = parser.value("sink");
+    if (scenario.sink != "file" && scenario.sink != "cache" && scenario.sink != "memory") {
+        qCritical() << "Unknown sink" << scenario.sink;
+        return 1;
+    }
+    if (scenario.sink == "memory" && scenario.size > 256 * 1024 * 1024) {
+        qCritical() << "Files this big don't fit into memory, use another sink";
+        return 1;
+    }
+
+    ServerOptions options;
+    options.latency = parser.value("latency").toInt();
+    options.bandwidth = parser.value("bandwidth").toLongLong() * 1024;
+    options.failureRate = parser.value("failures").toDouble() / 100;
+
+    QTextStream out(stdout);
+    out << QString("%1 x %2 KiB into %3, latency %4 ms, bandwidth %5 KiB/s, failures %6%\n")
+               .arg(scenario.files)
+               .arg(scenario.size / 1024)
+               .arg(scenario.sink)
+               .arg(options.latency)
+               .arg(options.bandwidth / 1024)
+               .arg(options.failureRate * 100);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg("concurrency", 11)
+               .arg("seconds", 9)
+               .arg("files/s", 9)
+               .arg("MiB/s", 9)
+               .arg("CPU s", 9)
+               .arg("peak MiB", 9)
+               .arg("attempts", 9)
+               .arg("failed", 7);
+    out.flush();
+
+    auto megabytes = scenario.files * scenario.size / (1024.0 * 1024.0);
+    for (auto& value : parser.value("concurrency").split(',', Qt::SkipEmptyParts)) {
+        auto concurrency = value.toInt();
+        if (concurrency <= 0)
+            continue;
+        for (int i = 0; i < parser.value("runs").toInt(); i++) {
+            auto result = run(scenario, concurrency, options);
+            out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                       .arg(concurrency, 11)
+                       .arg(result.seconds, 9, 'f', 2)
+                       .arg(scenario.files / result.seconds, 9, 'f', 1)
+                       .arg(megabytes / result.seconds, 9, 'f', 1)
+                       .arg(result.cpu, 9, 'f', 2)
+                       .arg(result.peakMemory, 9, 'f', 1)
+                       .arg(result.attempts, 9)
+                       .arg(result.failed, 7);
+            out.flush();
+        }
+    }
+
+    if (parser.isSet("timings") && !Net::TimingLog::instance()->exportTo(parser.value("timings")))
+        return 1;
+    return 0;
+}
+
+#include "NetBenchmark.moc"
@@ -0,0 +1,195 @@
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimer>
+
+#include <FileSystem.h>
+#include <net/Download.h>
+
+/** Serves one file under a few paths, and counts how often each of them was asked for. */
+class CountingServer : public QTcpServer {
+    Q_OBJECT
+   public:
+    explicit CountingServer(QByteArray body) : m_body(std::move(body))
+    {
+        listen(QHostAddress::LocalHost);
+        connect(this, &QTcpServer::newConnection, this, [this] {
+            while (auto socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] { respond(socket); });
+            }
+        });
+    }
+
+    QUrl url(const QString& path) const { return QUrl(QString("http://127.0.0.1:%1%2").arg(serverPort()).arg(path)); }
+    int requests(const QString& path) const { return m_counts.value(path.toUtf8()); }
+
+   private:
+    void respond(QTcpSocket* socket)
+    {
+        auto& request = m_requests[socket];
+        request += socket->readAll();
+        if (!request.contains("\r\n\r\n"))
+            return;
+        auto path = request.split(' ').value(1);
+        auto count = ++m_counts[path];
+
+        if (path == "/moved") {
+            socket->write("HTTP/1.1 302 Found\r\nLocation: /slow\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+        // fails the first time only
+        if (path == "/flaky" && count == 1) {
+            socket->write("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+        socket->write("HTTP/1.1 200 OK\r\nContent-Length: " + QByteArray::number(m_body.size()) + "\r\nConnection: close\r\n\r\n");
+        if (path != "/slow") {
+            socket->write(m_body);
+            socket->disconnectFromHost();
+            return;
+        }
+        // long enough for the other requests to line up behind this one
+        socket->write(m_body.left(1000));
+        QTimer::singleShot(500, socket, [this, socket = QPointer<QTcpSocket>(socket)] {
+            if (!socket)
+                return;
+            socket->write(m_body.mid(1000));
+            socket->disconnectFromHost();
+        });
+    }
+
+   private:
+    QByteArray m_body;
+    QHash<QTcpSocket*, QByteArray> m_requests;
+    QHash<QByteArray, int> m_counts;
+};
+
+class RequestCoalescingTest : public QObject {
+    Q_OBJECT
+
+    QByteArray makeBody()
+    {
+        QByteArray body;
+        for (int i = 0; body.size() < 64 * 1024; i++)
+            body += QByteArray::number(i) + '\n';
+        return body;
+    }
+
+    Net::Download::Ptr makeDownload(QUrl url, const QString& path)
+    {
+        auto dl = Net::Download::makeFile(url, path);
+        dl->setNetwork(m_network);
+        return dl;
+    }
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+    shared_qobject_ptr<QNetworkAccessManager> m_network;
+
+   private slots:
+    void initTestCase()
+    {
+        m_network = makeShared<QNetworkAccessManager>();
+        m_network->setProxy(QNetworkProxy::NoProxy);
+    }
+
+    void test_follower()
+    {
+        auto body = makeBody();
+        CountingServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        auto leader = makeDownload(server.url("/slow"), path);
+        auto follower = makeDownload(server.url("/slow"), path);
+        QSignalSpy spy(follower.get(), &Task::finished);
+        leader->start();
+        follower->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(leader->wasSuccessful());
+        QVERIFY(follower->wasSuccessful());
+        QCOMPARE(server.requests("/slow"), 1);
+        QCOMPARE(readFile(path), body);
+    }
+
+    void test_leaderFailed()
+    {
+        auto body = makeBody();
+        CountingServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        auto leader = makeDownload(server.url("/flaky"), path);
+        auto follower = makeDownload(server.url("/flaky"), path);
+        QSignalSpy spy(follower.get(), &Task::finished);
+        leader->start();
+        follower->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(!leader->wasSuccessful());
+        // there was nothing to take over, so the follower asked again
+        QVERIFY(follower->wasSuccessful());
+        QCOMPARE(server.requests("/flaky"), 2);
+        QCOMPARE(readFile(path), body);
+    }
+
+    void test_leaderAborted()
+    {
+        auto body = makeBody();
+        CountingServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        auto leader = makeDownload(server.url("/slow"), path);
+        auto follower = makeDownload(server.url("/slow"), path);
+        QSignalSpy spy(follower.get(), &Task::finished);
+        leader->start();
+        follower->start();
+        QTRY_COMPARE_WITH_TIMEOUT(server.requests("/slow"), 1, 10000);
+        leader->abort();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(follower->wasSuccessful());
+        QCOMPARE(server.requests("/slow"), 2);
+        QCOMPARE(readFile(path), body);
+    }
+
+    void test_redirectKeepsKey()
+    {
+        auto body = makeBody();
+        CountingServer server(body);
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "file");
+
+        // the leader is on the redirected URL already, but still known by the one it was asked for
+        auto leader = makeDownload(server.url("/moved"), path);
+        QSignalSpy leaderSpy(leader.get(), &Task::finished);
+        leader->start();
+        QTRY_COMPARE_WITH_TIMEOUT(server.requests("/slow"), 1, 10000);
+        QVERIFY(leaderSpy.isEmpty());
+
+        auto follower = makeDownload(server.url("/moved"), path);
+        QSignalSpy spy(follower.get(), &Task::finished);
+        follower->start();
+        QVERIFY(spy.wait(10000));
+        QVERIFY(follower->wasSuccessful());
+        QCOMPARE(server.requests("/moved"), 1);
+        QCOMPARE(server.requests("/slow"), 1);
+        QCOMPARE(readFile(path), body);
+    }
+};
+
+QTEST_GUILESS_MAIN(RequestCoalescingTest)
+
+#include "RequestCoalescing_test.moc"
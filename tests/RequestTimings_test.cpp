@@ -0,0 +1,95 @@
+#include <QJsonArray>
+#include <QTest>
+
+#include <net/RequestTimings.h>
+
+using Net::RequestTiming;
+using Net::TimingLog;
+
+class RequestTimingsTest : public QObject {
+    Q_OBJECT
+
+    RequestTiming makeTiming(const QString& host, qint64 firstByte, qint64 total, qint64 bytes, bool succeeded = true)
+    {
+        RequestTiming timing;
+        timing.url = host + "/file";
+        timing.host = host;
+        timing.started = QDateTime::currentDateTimeUtc();
+        timing.firstByte = firstByte;
+        timing.finished = total;
+        timing.total = total;
+        timing.bytes = bytes;
+        timing.statusCode = succeeded ? 200 : 503;
+        timing.succeeded = succeeded;
+        return timing;
+    }
+
+   private slots:
+    void test_histograms()
+    {
+        TimingLog log;
+        log.record(makeTiming("https://a.example", 20, 120, 1024));
+        log.record(makeTiming("https://a.example", 300, 1300, 1024 * 1024));
+        log.record(makeTiming("https://b.example", 20000, 20000, 0, false));
+
+        auto hosts = log.hosts();
+        QCOMPARE(hosts.size(), 2);
+
+        auto a = hosts["https://a.example"];
+        QCOMPARE(a.requests, 2);
+        QCOMPARE(a.failures, 0);
+        QCOMPARE(a.bytes, qint64(1024 + 1024 * 1024));
+        QCOMPARE(a.firstByte[0], 1);  // < 50 ms
+        QCOMPARE(a.firstByte[3], 1);  // < 500 ms
+        QCOMPARE(a.total[2], 1);      // < 250 ms
+        QCOMPARE(a.total[5], 1);      // < 2500 ms
+        // 1 MiB in one second, the small file is too small to tell
+        QCOMPARE(a.throughput[2], 0);
+        QCOMPARE(a.throughput[3], 1);  // < 4096 KiB/s
+
+        auto b = hosts["https://b.example"];
+        QCOMPARE(b.failures, 1);
+        QCOMPARE(b.total.last(), 1);
+    }
+
+    void test_recordLimit()
+    {
+        TimingLog log(2);
+        for (int i = 0; i < 5; i++)
+            log.record(makeTiming("https://a.example", i, 100, 10));
+        QCOMPARE(log.records().size(), 2);
+        QCOMPARE(log.records().first().firstByte, qint64(3));
+        // the histograms still count everything
+        QCOMPARE(log.hosts()["https://a.example"].requests, 5);
+    }
+
+    void test_json()
+    {
+        TimingLog log;
+        log.record(makeTiming("https://a.example", 20, 120, 1024));
+        auto json = log.toJson();
+        QCOMPARE(json["requests"].toArray().size(), 1);
+        auto host = json["hosts"].toObject()["https://a.example"].toObject();
+        QCOMPARE(host["requests"].toInt(), 1);
+        QCOMPARE(host["first_byte_ms"].toObject()["<50"].toInt(), 1);
+        QCOMPARE(host["total_ms"].toObject()[">=10000"].toInt(), 0);
+    }
+
+    void test_csv()
+    {
+        TimingLog log;
+        auto timing = makeTiming("https://a.example", 20, 120, 1024, false);
+        timing.error = "Error transferring, \"server\" said no";
+        log.record(timing);
+
+        auto lines = log.toCsv().trimmed().split('\n');
+        QCOMPARE(lines.size(), 2);
+        QVERIFY(lines[0].startsWith("url,host,"));
+        QCOMPARE(lines[0].count(','), lines[1].count(',') - 1);  // the error has one quoted comma
+        QVERIFY(lines[1].contains("\"Error transferring, \"\"server\"\" said no\""));
+    }
+};
+
+QTEST_GUILESS_MAIN(RequestTimingsTest)
+
+#include "RequestTimings_test.moc"
@@ -33,11 +33,15 @@
  *      limitations under the License.
  */
 
+#include <QSignalSpy>
 #include <QTemporaryDir>
 #include <QTest>
 #include <QTimer>
 #include "BaseInstance.h"
 
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+
 #include <FileSystem.h>
 
 #include <minecraft/mod/ModFolderModel.h>
@@ -64,6 +68,20 @@
 class ResourceFolderModelTest : public QObject {
     Q_OBJECT
 
+    bool makeFabricMod(const QString& path, const QString& id, const QString& version = "1.0")
+    {
+        QuaZip zip(path);
+        if (!zip.open(QuaZip::mdCreate))
+            return false;
+        QuaZipFile file(&zip);
+        if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo("fabric.mod.json")))
+            return false;
+        file.write(QString(R"({ "schemaVersion": 1, "id": "%1", "version": "%2" })").arg(id, version).toUtf8());
+        file.close();
+        zip.close();
+        return true;
+    }
+
    private slots:
     // test for GH-1178 - install a folder with files to a mod list
     void test_1178()
@@ -193,6 +211,76 @@ class ResourceFolderModelTest : public QObject {
         model.stopWatching();
     }
 
+    void test_parseInBatches()
+    {
+        QTemporaryDir tmp;
+        constexpr int mod_count = 40;
+        for (int i = 0; i < mod_count; i++)
+            QVERIFY(makeFabricMod(FS::PathCombine(tmp.path(), QString("mod%1.jar").arg(i)), QString("mod%1").arg(i)));
+
+        ModFolderModel model(tmp.path(), nullptr);
+        QSignalSpy changes(&model, &ResourceFolderModel::dataChanged);
+
+        {
+            EXEC_UPDATE_TASK(model.update(), QVERIFY)
+        }
+        QCOMPARE(model.size(), mod_count);
+
+        // the last rows jump the queue, and nothing gets lost on the way
+        model.prioritizeParsing({ model.index(mod_count - 1), model.index(mod_count - 2) });
+        QTRY_VERIFY_WITH_TIMEOUT(!model.hasPendingParseTasks(), 10000);
+
+        for (auto mod : model.allMods()) {
+            QVERIFY(mod->isResolved());
+            QCOMPARE(mod->details().mod_id, mod->fileinfo().completeBaseName());
+        }
+        // results come in batches, not one row at a time
+        QVERIFY(changes.size() < mod_count);
+    }
+
+    void test_incrementalUpdate()
+    {
+        QTemporaryDir tmp;
+        constexpr int mod_count = 10;
+        for (int i = 0; i < mod_count; i++)
+            QVERIFY(makeFabricMod(FS::PathCombine(tmp.path(), QString("mod%1.jar").arg(i)), QString("mod%1").arg(i)));
+
+        ModFolderModel model(tmp.path(), nullptr);
+        {
+            EXEC_UPDATE_TASK(model.update(), QVERIFY)
+        }
+        QTRY_VERIFY_WITH_TIMEOUT(!model.hasPendingParseTasks(), 10000);
+        QCOMPARE(model.size(), mod_count);
+
+        QHash<QString, Mod*> before;
+        for (auto mod : model.allMods())
+            before.insert(mod->internal_id(), mod);
+
+        // one new mod, and one that got replaced by a different version
+        QVERIFY(makeFabricMod(FS::PathCombine(tmp.path(), "new.jar"), "new"));
+        QVERIFY(QFile::remove(FS::PathCombine(tmp.path(), "mod3.jar")));
+        QVERIFY(makeFabricMod(FS::PathCombine(tmp.path(), "mod3.jar"), "mod3", "2.0.0-updated"));
+
+        QSignalSpy inserted(&model, &ResourceFolderModel::rowsInserted);
+        QSignalSpy removed(&model, &ResourceFolderModel::rowsRemoved);
+        {
+            EXEC_UPDATE_TASK(model.update(), QVERIFY)
+        }
+        QTRY_VERIFY_WITH_TIMEOUT(!model.hasPendingParseTasks(), 10000);
+        QCOMPARE(model.size(), mod_count + 1);
+        QCOMPARE(inserted.size(), 1);
+        QCOMPARE(removed.size(), 0);
+
+        // untouched mods are the very same objects, only the touched ones got loaded again
+        for (auto mod : model.allMods()) {
+            auto id = mod->internal_id();
+            if (id != "new.jar" && id != "mod3.jar")
+                QCOMPARE(before.value(id), mod);
+            QVERIFY(mod->isResolved());
+        }
+        QCOMPARE(model.find("mod3.jar")->details().version, QString("2.0.0-updated"));
+    }
+
     void test_enable_disable()
     {
         QString folder_resource = QFINDTESTDATA("testdata/ResourceFolderModel/test_folder");
@@ -0,0 +1,65 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <net/ByteArraySink.h>
+#include <net/ChecksumValidator.h>
+#include <net/FileSink.h>
+
+class SinkFlightKeyTest : public QObject {
+    Q_OBJECT
+
+   private slots:
+    void test_fileSink()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "lib.jar");
+        Net::FileSink first(path);
+        Net::FileSink second(path);
+        Net::FileSink other(FS::PathCombine(dir.path(), "other.jar"));
+        QVERIFY(!first.flightKey().isEmpty());
+        QCOMPARE(first.flightKey(), second.flightKey());
+        QVERIFY(first.flightKey() != other.flightKey());
+
+        Net::FileSink range(path);
+        range.setByteRange(0, 99);
+        QVERIFY(first.flightKey() != range.flightKey());
+
+        // nothing to take over until the other request wrote the file
+        QCOMPARE(second.adopt(first), Task::State::Failed);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("jar");
+        file.close();
+        QCOMPARE(second.adopt(first), Task::State::Succeeded);
+    }
+
+    void test_validators()
+    {
+        Net::FileSink plain("a.jar");
+        Net::FileSink checked("a.jar");
+        checked.addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, QString("0123456789abcdef0123456789abcdef01234567")));
+        Net::FileSink otherChecksum("a.jar");
+        otherChecksum.addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, QString("76543210fedcba9876543210fedcba9876543210")));
+        QVERIFY(plain.flightKey() != checked.flightKey());
+        QVERIFY(checked.flightKey() != otherChecksum.flightKey());
+    }
+
+    void test_byteArraySink()
+    {
+        auto leaderData = std::make_shared<QByteArray>("{\"id\": 1}");
+        auto followerData = std::make_shared<QByteArray>();
+        Net::ByteArraySink leader(leaderData);
+        Net::ByteArraySink follower(followerData);
+        QCOMPARE(leader.flightKey(), follower.flightKey());
+        QCOMPARE(follower.adopt(leader), Task::State::Succeeded);
+        QCOMPARE(*followerData, *leaderData);
+
+        Net::FileSink file("a.json");
+        QCOMPARE(follower.adopt(file), Task::State::Failed);
+    }
+};
+
+QTEST_GUILESS_MAIN(SinkFlightKeyTest)
+
+#include "SinkFlightKey_test.moc"
@@ -0,0 +1,157 @@
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <StampedFileCache.h>
+
+/** Keeps a line of text per file. */
+class NoteCache : public StampedFileCache {
+   public:
+    NoteCache(QString cacheFile, Keying keying = Keying::FileName, QString format = "1")
+        : StampedFileCache(std::move(cacheFile), keying, 0x4E4F5445, std::move(format))
+    {}
+
+    QString lookup(const QString& path) { return QString::fromUtf8(lookupPayload(QFileInfo(path)).value_or("-")); }
+    void store(const QString& path, const QString& note) { storePayload(QFileInfo(path), note.toUtf8()); }
+    void store(const QString& path, const Stamp& stamp, const QString& note)
+    {
+        updatePayload(QFileInfo(path), stamp, [&note](QByteArray& payload) { payload = note.toUtf8(); });
+    }
+};
+
+class StampedFileCacheTest : public QObject {
+    Q_OBJECT
+
+   private slots:
+    void test_changedFile()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "truck.jar");
+        FS::write(path, "first");
+        NoteCache cache{ QString() };
+        QCOMPARE(cache.lookup(path), QString("-"));
+
+        cache.store(path, "red truck");
+        QCOMPARE(cache.lookup(path), QString("red truck"));
+
+        // the entry of an outdated version is gone for good
+        FS::write(path, "something else");
+        QCOMPARE(cache.lookup(path), QString("-"));
+        QCOMPARE(cache.size(), 0);
+
+        QFile::remove(path);
+        QCOMPARE(cache.lookup(path), QString("-"));
+    }
+
+    void test_replacedFile()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "truck.jar");
+        FS::write(path, "first");
+        NoteCache cache{ QString() };
+        cache.store(path, "red truck");
+
+        // same size and time, but another file
+        auto moved = path + ".old";
+        QVERIFY(QFile::rename(path, moved));
+        QVERIFY(QFile::copy(moved, path));
+        auto stamp = StampedFileCache::stampOf(QFileInfo(path));
+        if (stamp.inode == 0 || stamp.inode == StampedFileCache::stampOf(QFileInfo(moved)).inode)
+            QSKIP("The file system doesn't tell the two files apart");
+        QCOMPARE(cache.lookup(path), QString("-"));
+    }
+
+    void test_staleStamp()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "truck.jar");
+        FS::write(path, "first");
+        auto stamp = StampedFileCache::stampOf(QFileInfo(path));
+        FS::write(path, "changed while it was read");
+
+        NoteCache cache{ QString() };
+        cache.store(path, stamp, "red truck");
+        QCOMPARE(cache.lookup(path), QString("-"));
+    }
+
+    void test_folders()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "truck");
+        QVERIFY(QDir().mkpath(path));
+        NoteCache cache{ QString() };
+        cache.store(path, "red truck");
+        QCOMPARE(cache.size(), 0);
+    }
+
+    void test_keying()
+    {
+        QTemporaryDir dir;
+        auto path = FS::PathCombine(dir.path(), "truck.jar");
+        FS::write(path, "first");
+        NoteCache byName{ QString() };
+        NoteCache byPath(QString(), StampedFileCache::Keying::AbsolutePath);
+        byName.store(path, "red truck");
+        byPath.store(path, "red truck");
+
+        QVERIFY(QFile::rename(path, path + ".disabled"));
+        QCOMPARE(byName.lookup(path + ".disabled"), QString("red truck"));
+        QCOMPARE(byPath.lookup(path + ".disabled"), QString("-"));
+    }
+
+    void test_retain()
+    {
+        QTemporaryDir dir;
+        auto truck = FS::PathCombine(dir.path(), "truck.jar");
+        auto trailer = FS::PathCombine(dir.path(), "trailer.jar");
+        FS::write(truck, "first");
+        FS::write(trailer, "second");
+        NoteCache cache{ QString() };
+        cache.store(truck, "red truck");
+        cache.store(trailer, "blue trailer");
+
+        cache.retain({ "truck.jar.disabled" });
+        QCOMPARE(cache.size(), 1);
+        QCOMPARE(cache.lookup(truck), QString("red truck"));
+    }
+
+    void test_persistence()
+    {
+        QTemporaryDir dir;
+        auto file = FS::PathCombine(dir.path(), "notes");
+        auto path = FS::PathCombine(dir.path(), "truck.jar");
+        FS::write(path, "first");
+        {
+            NoteCache cache(file);
+            cache.load();
+            cache.store(path, "red truck");
+        }
+
+        NoteCache cache(file);
+        cache.load();
+        QCOMPARE(cache.size(), 1);
+        QCOMPARE(cache.lookup(path), QString("red truck"));
+
+        // payloads written another way mean nothing
+        NoteCache other(file, StampedFileCache::Keying::FileName, "2");
+        other.load();
+        QCOMPARE(other.size(), 0);
+    }
+
+    void test_damaged()
+    {
+        QTemporaryDir dir;
+        auto file = FS::PathCombine(dir.path(), "notes");
+        FS::write(file, "not a cache at all");
+
+        NoteCache cache(file);
+        cache.load();
+        QCOMPARE(cache.size(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(StampedFileCacheTest)
+
+#include "StampedFileCache_test.moc"
@@ -0,0 +1,103 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <quazip/quazip.h>
+
+#include <FileSystem.h>
+#include <StreamingUnzip.h>
+
+class StreamingUnzipTest : public QObject {
+    Q_OBJECT
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+    // feed the archive in small pieces, like a download would
+    void feed(StreamingUnzip& unzip, const QByteArray& data, int chunkSize = 1000)
+    {
+        unzip.restart();
+        for (int i = 0; i < data.size(); i += chunkSize)
+            unzip.feed(data.mid(i, chunkSize));
+    }
+
+    void compareWithZip(const QString& zipPath, const QString& outputDir, const QHash<QString, StreamingUnzip::Entry>& entries)
+    {
+        QuaZip zip(zipPath);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        int files = 0;
+        for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
+            QuaZipFileInfo64 info;
+            QVERIFY(zip.getCurrentFileInfo(&info));
+            if (info.name.endsWith('/'))
+                continue;
+            files++;
+            QVERIFY2(entries.contains(info.name), qPrintable(info.name));
+            QCOMPARE(entries[info.name].crc32, info.crc);
+            QCOMPARE(entries[info.name].size, qint64(info.uncompressedSize));
+            QCOMPARE(QFileInfo(FS::PathCombine(outputDir, info.name)).size(), qint64(info.uncompressedSize));
+        }
+        QCOMPARE(entries.size(), files);
+    }
+
+   private slots:
+    void test_regularArchive()
+    {
+        auto path = QFINDTESTDATA("testdata/TruckPackIndex/pack.zip");
+        QTemporaryDir output;
+        StreamingUnzip unzip(output.path());
+        feed(unzip, readFile(path));
+        compareWithZip(path, output.path(), unzip.entries());
+    }
+
+    void test_dataDescriptors()
+    {
+        auto path = QFINDTESTDATA("testdata/StreamingUnzip/descriptors.zip");
+        QTemporaryDir output;
+        StreamingUnzip unzip(output.path());
+        feed(unzip, readFile(path), 777);
+        compareWithZip(path, output.path(), unzip.entries());
+    }
+
+    void test_restart()
+    {
+        auto path = QFINDTESTDATA("testdata/StreamingUnzip/descriptors.zip");
+        auto data = readFile(path);
+        QTemporaryDir output;
+        StreamingUnzip unzip(output.path());
+
+        // a transfer that broke off in the middle, then started over
+        feed(unzip, data.left(data.size() / 2));
+        feed(unzip, data);
+        compareWithZip(path, output.path(), unzip.entries());
+    }
+
+    void test_truncated()
+    {
+        auto data = readFile(QFINDTESTDATA("testdata/StreamingUnzip/descriptors.zip"));
+        QTemporaryDir output;
+        StreamingUnzip unzip(output.path());
+        feed(unzip, data.left(data.size() / 2));
+
+        // the small config comes first, the big jar is cut off and must not be reported
+        auto entries = unzip.entries();
+        QVERIFY(entries.contains("pack/instance.cfg"));
+        QVERIFY(!entries.contains("pack/.minecraft/mods/big.jar"));
+    }
+
+    void test_garbage()
+    {
+        QTemporaryDir output;
+        StreamingUnzip unzip(output.path());
+        feed(unzip, QByteArray(4096, 'x'));
+        QVERIFY(unzip.entries().isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(StreamingUnzipTest)
+
+#include "StreamingUnzip_test.moc"
@@ -0,0 +1,107 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+
+#include <FileSystem.h>
+#include <minecraft/mod/ResourcePack.h>
+#include <minecraft/mod/ThumbnailCache.h>
+#include <minecraft/mod/tasks/LocalResourcePackParseTask.h>
+
+class ThumbnailCacheTest : public QObject {
+    Q_OBJECT
+
+    QImage makeImage(Qt::GlobalColor color, int size = 64)
+    {
+        QImage image(size, size, QImage::Format_ARGB32);
+        image.fill(color);
+        return image;
+    }
+
+    QString makePack(const QString& dir, const QImage& icon)
+    {
+        auto path = FS::PathCombine(dir, "pack.zip");
+        QuaZip zip(path);
+        if (!zip.open(QuaZip::mdCreate))
+            return {};
+        QuaZipFile file(&zip);
+        file.open(QIODevice::WriteOnly, QuaZipNewInfo("pack.mcmeta"));
+        file.write(R"({ "pack": { "pack_format": 15, "description": "Truck textures" } })");
+        file.close();
+        file.open(QIODevice::WriteOnly, QuaZipNewInfo("pack.png"));
+        icon.save(&file, "PNG");
+        file.close();
+        zip.close();
+        return path;
+    }
+
+   private slots:
+    void test_thumbnail()
+    {
+        QTemporaryDir dir;
+        auto file = FS::PathCombine(dir.path(), "packs.thumbs");
+        auto pack = FS::PathCombine(dir.path(), "truckpack.zip");
+        FS::write(pack, "first");
+        {
+            ThumbnailCache cache(file);
+            cache.load();
+            cache.store(QFileInfo(pack), makeImage(Qt::red));
+        }
+
+        ThumbnailCache cache(file);
+        cache.load();
+        auto thumbnail = cache.lookup(QFileInfo(pack));
+        QVERIFY(thumbnail);
+        QCOMPARE(thumbnail->size(), QSize(64, 64));
+        QCOMPARE(thumbnail->pixelColor(10, 10), QColor(Qt::red));
+    }
+
+    void test_noIcon()
+    {
+        QTemporaryDir dir;
+        auto pack = FS::PathCombine(dir.path(), "truckpack.zip");
+        FS::write(pack, "first");
+        ThumbnailCache cache{ QString() };
+        cache.store(QFileInfo(pack), {});
+
+        // knowing there is no icon is worth keeping too
+        auto thumbnail = cache.lookup(QFileInfo(pack));
+        QVERIFY(thumbnail);
+        QVERIFY(thumbnail->isNull());
+    }
+
+    void test_parseTask()
+    {
+        QTemporaryDir dir;
+        auto path = makePack(dir.path(), makeImage(Qt::red, 128));
+        QVERIFY(!path.isEmpty());
+        auto cache = std::make_shared<ThumbnailCache>(FS::PathCombine(dir.path(), "packs.thumbs"));
+
+        // the first parse reads the pack.png, and keeps a scaled down copy of it
+        {
+            ResourcePack pack(QFileInfo{ path });
+            LocalResourcePackParseTask task(0, pack, cache);
+            task.start();
+            QCOMPARE(pack.description(), QString("Truck textures"));
+            QCOMPARE(pack.imageThumbnail().size(), QSize(64, 64));
+            auto thumbnail = cache->lookup(QFileInfo(path));
+            QVERIFY(thumbnail);
+            QCOMPARE(thumbnail->pixelColor(10, 10), QColor(Qt::red));
+        }
+
+        // the next one takes the thumbnail from the cache instead
+        cache->store(QFileInfo(path), makeImage(Qt::blue));
+        {
+            ResourcePack pack(QFileInfo{ path });
+            LocalResourcePackParseTask task(0, pack, cache);
+            task.start();
+            QCOMPARE(pack.description(), QString("Truck textures"));
+            QCOMPARE(pack.imageThumbnail().pixelColor(10, 10), QColor(Qt::blue));
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(ThumbnailCacheTest)
+
+#include "ThumbnailCache_test.moc"
@@ -0,0 +1,113 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <FileSystem.h>
+#include <modplatform/truckpack/TruckPackFileStore.h>
+
+class TruckPackFileStoreTest : public QObject {
+    Q_OBJECT
+
+    void writeFile(const QString& path, const QByteArray& data)
+    {
+        FS::ensureFilePathExists(path);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    QByteArray readFile(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+   private slots:
+    void test_shareable()
+    {
+        QVERIFY(TruckPack::FileStore::isShareable(".minecraft/mods/truck.jar"));
+        QVERIFY(TruckPack::FileStore::isShareable(".minecraft/resourcepacks/Trucks.ZIP"));
+        QVERIFY(!TruckPack::FileStore::isShareable(".minecraft/config/truck.toml"));
+        QVERIFY(!TruckPack::FileStore::isShareable("instance.cfg"));
+    }
+
+    void test_adoptDeduplicates()
+    {
+        QTemporaryDir root;
+        TruckPack::FileStore store(FS::PathCombine(root.path(), "store"));
+
+        auto first = FS::PathCombine(root.path(), "a", "mods", "truck.jar");
+        auto second = FS::PathCombine(root.path(), "b", "mods", "truck.jar");
+        writeFile(first, "vroom");
+        writeFile(second, "vroom");
+
+        auto firstHash = store.adopt(first, first);
+        auto secondHash = store.adopt(second, second);
+        if (!firstHash)
+            QSKIP("This filesystem supports neither reflinks nor hard links");
+        QVERIFY(secondHash.has_value());
+        QCOMPARE(*firstHash, *secondHash);
+        QVERIFY(QFileInfo::exists(store.objectPath(*firstHash)));
+        QCOMPARE(readFile(first), QByteArray("vroom"));
+        QCOMPARE(readFile(second), QByteArray("vroom"));
+    }
+
+    void test_adoptMovesIntoTarget()
+    {
+        QTemporaryDir root;
+        TruckPack::FileStore store(FS::PathCombine(root.path(), "store"));
+
+        auto staged = FS::PathCombine(root.path(), "staging", "mods", "truck.jar");
+        auto target = FS::PathCombine(root.path(), "instance", "mods", "truck.jar");
+        writeFile(staged, "new truck");
+        writeFile(target, "old truck");
+
+        store.adopt(staged, target);
+        QVERIFY(!QFileInfo::exists(staged));
+        QCOMPARE(readFile(target), QByteArray("new truck"));
+    }
+
+    void test_collectGarbage()
+    {
+        QTemporaryDir root;
+        TruckPack::FileStore store(FS::PathCombine(root.path(), "store"));
+
+        auto kept = FS::PathCombine(root.path(), "kept");
+        auto gone = FS::PathCombine(root.path(), "gone");
+        writeFile(FS::PathCombine(kept, "mods", "shared.jar"), "shared");
+        writeFile(FS::PathCombine(gone, "mods", "shared.jar"), "shared");
+        writeFile(FS::PathCombine(gone, "mods", "only.jar"), "only in the deleted instance");
+
+        for (auto instance : { kept, gone }) {
+            TruckPack::StoreRefs refs;
+            for (auto path : { QString("mods/shared.jar"), QString("mods/only.jar") }) {
+                auto file = FS::PathCombine(instance, path);
+                if (!QFileInfo::exists(file))
+                    continue;
+                auto hash = store.adopt(file, file);
+                if (!hash)
+                    QSKIP("This filesystem supports neither reflinks nor hard links");
+                refs.files.insert(path, *hash);
+            }
+            QVERIFY(refs.save(instance));
+        }
+
+        auto shared = TruckPack::StoreRefs::load(kept).files.value("mods/shared.jar");
+        auto only = TruckPack::StoreRefs::load(gone).files.value("mods/only.jar");
+        QVERIFY(!shared.isEmpty());
+        QVERIFY(!only.isEmpty());
+
+        QCOMPARE(store.collectGarbage({ kept, gone }), 0);
+
+        // the second instance got deleted
+        QCOMPARE(store.collectGarbage({ kept }), 1);
+        QVERIFY(QFileInfo::exists(store.objectPath(shared)));
+        QVERIFY(!QFileInfo::exists(store.objectPath(only)));
+        QCOMPARE(readFile(FS::PathCombine(kept, "mods", "shared.jar")), QByteArray("shared"));
+    }
+};
+
+QTEST_GUILESS_MAIN(TruckPackFileStoreTest)
+
+#include "TruckPackFileStore_test.moc"
@@ -0,0 +1,146 @@
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <quazip/quazip.h>
+
+#include <FileSystem.h>
+#include <modplatform/truckpack/TruckPackIndex.h>
+
+class TruckPackIndexTest : public QObject {
+    Q_OBJECT
+
+    QString packPath() { return QFINDTESTDATA("testdata/TruckPackIndex/pack.zip"); }
+
+    QByteArray readPack()
+    {
+        QFile file(packPath());
+        if (!file.open(QIODevice::ReadOnly))
+            return {};
+        return file.readAll();
+    }
+
+    void writeFile(const QString& path, const QByteArray& data)
+    {
+        FS::ensureFilePathExists(path);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+   private slots:
+    void test_centralDirectoryMatchesQuaZip()
+    {
+        auto data = readPack();
+        QVERIFY(!data.isEmpty());
+
+        // pretend we only fetched the last few bytes, like the range request does
+        qint64 tailOffset = data.size() / 2;
+        auto location = TruckPack::locateCentralDirectory(data.mid(tailOffset), tailOffset);
+        QVERIFY(location.has_value());
+        QCOMPARE(location->entryCount, qint64(5));
+
+        auto entries = TruckPack::parseCentralDirectory(data.mid(location->offset, location->size), *location);
+        QVERIFY(entries.has_value());
+        auto fromRaw = TruckPack::PackIndex::fromEntries(*entries);
+        QVERIFY(fromRaw.has_value());
+
+        QuaZip zip(packPath());
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        auto fromZip = TruckPack::PackIndex::fromZip(&zip);
+        QVERIFY(fromZip.has_value());
+
+        QCOMPARE(fromRaw->root, QString("Truck Pack/"));
+        QCOMPARE(fromRaw->root, fromZip->root);
+        QCOMPARE(fromRaw->entries.size(), 4);
+        auto rawPaths = fromRaw->entries.keys();
+        auto zipPaths = fromZip->entries.keys();
+        rawPaths.sort();
+        zipPaths.sort();
+        QCOMPARE(rawPaths, zipPaths);
+        for (auto& entry : fromRaw->entries) {
+            auto other = fromZip->entries.value(entry.path);
+            QVERIFY(entry.sameContentAs(other));
+            QCOMPARE(entry.compressedSize, other.compressedSize);
+            QVERIFY(entry.localHeaderOffset >= 0);
+            QVERIFY(entry.nextHeaderOffset > entry.localHeaderOffset);
+            QVERIFY(entry.nextHeaderOffset <= location->offset);
+        }
+    }
+
+    void test_rejectsNonInstancePacks()
+    {
+        TruckPack::PackEntry entry;
+        entry.path = "overrides/mods/truck.jar";
+        QVERIFY(!TruckPack::PackIndex::fromEntries({ entry }).has_value());
+    }
+
+    void test_rejectsEscapingPaths()
+    {
+        TruckPack::PackEntry config;
+        config.path = "instance.cfg";
+        TruckPack::PackEntry evil;
+        evil.path = ".minecraft/../../evil.jar";
+        QVERIFY(!TruckPack::PackIndex::fromEntries({ config, evil }).has_value());
+    }
+
+    void test_saveLoadRoundTrip()
+    {
+        QuaZip zip(packPath());
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        auto index = TruckPack::PackIndex::fromZip(&zip);
+        QVERIFY(index.has_value());
+
+        QTemporaryDir tempDir;
+        auto path = TruckPack::indexPathFor(tempDir.path());
+        QVERIFY(index->save(path));
+
+        auto loaded = TruckPack::PackIndex::load(path);
+        QVERIFY(loaded.has_value());
+        QCOMPARE(loaded->root, index->root);
+        QCOMPARE(loaded->entries.size(), index->entries.size());
+        for (auto& entry : index->entries)
+            QVERIFY(loaded->entries.value(entry.path).sameContentAs(entry));
+    }
+
+    void test_diff()
+    {
+        QuaZip zip(packPath());
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        auto target = TruckPack::PackIndex::fromZip(&zip);
+        QVERIFY(target.has_value());
+
+        QTemporaryDir instance;
+        // unchanged, but unknown to the installed index: needs a CRC check
+        writeFile(FS::PathCombine(instance.path(), ".minecraft/options.txt"), "fov:0.5\n");
+        // same size, different content
+        writeFile(FS::PathCombine(instance.path(), "mmc-pack.json"), QByteArray(target->entries["mmc-pack.json"].size, ' '));
+        // owned by the old pack version only
+        writeFile(FS::PathCombine(instance.path(), ".minecraft/mods/old.jar"), "old");
+        // not owned by any pack version
+        writeFile(FS::PathCombine(instance.path(), ".minecraft/mods/user.jar"), "mine");
+
+        TruckPack::PackIndex installed;
+        installed.root = target->root;
+        TruckPack::PackEntry old;
+        old.path = ".minecraft/mods/old.jar";
+        old.size = 3;
+        installed.entries.insert(old.path, old);
+        TruckPack::PackEntry gone;
+        gone.path = ".minecraft/mods/deleted-by-user.jar";
+        installed.entries.insert(gone.path, gone);
+
+        auto diff = TruckPack::computeDiff(installed, *target, instance.path());
+
+        QStringList changed;
+        for (auto& entry : diff.changed)
+            changed.append(entry.path);
+        changed.sort();
+        QCOMPARE(changed, QStringList({ ".minecraft/mods/truck.jar", "instance.cfg", "mmc-pack.json" }));
+        QCOMPARE(diff.unchangedCount, qint64(1));
+        QCOMPARE(diff.removed, QStringList({ ".minecraft/mods/old.jar" }));
+    }
+};
+
+QTEST_GUILESS_MAIN(TruckPackIndexTest)
+
+#include "TruckPackIndex_test.moc"
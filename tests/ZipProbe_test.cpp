@@ -0,0 +1,130 @@
+#include <QBuffer>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+
+#include <FileSystem.h>
+#include <minecraft/mod/Mod.h>
+#include <minecraft/mod/tasks/LocalModParseTask.h>
+#include <minecraft/mod/tasks/ZipProbe.h>
+
+class ZipProbeTest : public QObject {
+    Q_OBJECT
+
+    QTemporaryDir m_dir;
+
+    QString makeArchive(const QString& fileName, const QList<QPair<QString, QByteArray>>& entries)
+    {
+        auto path = FS::PathCombine(m_dir.path(), fileName);
+        QuaZip zip(path);
+        if (!zip.open(QuaZip::mdCreate))
+            return {};
+        for (auto& [name, data] : entries) {
+            QuaZipFile file(&zip);
+            if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo(name)))
+                return {};
+            file.write(data);
+            file.close();
+        }
+        zip.close();
+        return path;
+    }
+
+    QByteArray png()
+    {
+        QImage image(128, 128, QImage::Format_ARGB32);
+        image.fill(Qt::red);
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        return data;
+    }
+
+   private slots:
+    void test_index()
+    {
+        auto path = makeArchive("pack.zip", { { "pack.mcmeta", "{}" },
+                                              { "assets/", {} },
+                                              { "assets/minecraft/lang/en_us.json", "{}" },
+                                              { "readme.txt", "hello" } });
+        QVERIFY(!path.isEmpty());
+
+        QStringList prefetched;
+        ZipProbe zip(path);
+        QVERIFY(zip.open([&prefetched](const QString& name) {
+            prefetched.append(name);
+            return name == "pack.mcmeta";
+        }));
+
+        // directories are not entries, and the filter only ever sees entries
+        QCOMPARE(prefetched, QStringList({ "pack.mcmeta", "assets/minecraft/lang/en_us.json", "readme.txt" }));
+        QVERIFY(zip.contains("pack.mcmeta"));
+        QVERIFY(!zip.contains("assets/"));
+        QVERIFY(!zip.contains("pack.png"));
+        QVERIFY(zip.hasDirectory("assets"));
+        QVERIFY(!zip.hasDirectory("minecraft"));
+        QCOMPARE(zip.find([](const QString& name) { return name.endsWith(".json"); }), QString("assets/minecraft/lang/en_us.json"));
+
+        QCOMPARE(zip.read("pack.mcmeta").value_or(QByteArray()), QByteArray("{}"));
+        // not prefetched, read on demand
+        QCOMPARE(zip.read("readme.txt").value_or(QByteArray()), QByteArray("hello"));
+        QVERIFY(!zip.read("pack.png"));
+    }
+
+    void test_notAZip()
+    {
+        auto path = FS::PathCombine(m_dir.path(), "broken.jar");
+        FS::write(path, QByteArray(4096, 'x'));
+        ZipProbe zip(path);
+        QVERIFY(!zip.open());
+    }
+
+    void test_modMetadataPrecedence()
+    {
+        auto path = makeArchive("mod.jar", { { "fabric.mod.json", R"({ "schemaVersion": 1, "id": "fabricmod", "icon": "icon.png" })" },
+                                             { "mcmod.info", R"([{ "modid": "forgemod", "name": "Forge Mod" }])" },
+                                             { "icon.png", png() } });
+        QVERIFY(!path.isEmpty());
+
+        // mcmod.info is looked for before fabric.mod.json, no matter where it is in the archive
+        Mod mod{ QFileInfo(path) };
+        QVERIFY(ModUtils::processZIP(mod));
+        QCOMPARE(mod.details().mod_id, QString("forgemod"));
+    }
+
+    void test_modIcon()
+    {
+        auto path = makeArchive("fabric.jar", { { "icon.png", png() },
+                                                { "fabric.mod.json", R"({ "schemaVersion": 1, "id": "fabricmod", "icon": "icon.png" })" } });
+        QVERIFY(!path.isEmpty());
+
+        Mod basic{ QFileInfo(path) };
+        QVERIFY(ModUtils::processZIP(basic, ModUtils::ProcessingLevel::BasicInfoOnly));
+        QCOMPARE(basic.details().mod_id, QString("fabricmod"));
+        QVERIFY(basic.iconThumbnail().isNull());
+
+        Mod full{ QFileInfo(path) };
+        QVERIFY(ModUtils::processZIP(full));
+        QCOMPARE(full.iconThumbnail().size(), QSize(64, 64));
+    }
+
+    void test_nilMod()
+    {
+        auto path = makeArchive("nil.jar", { { "nilloader.nilmod.css", "@nilmod { name: NilLoader; }" },
+                                             { "META-INF/nil/mappings.json", "{}" },
+                                             { "example.nilmod.css", "@nilmod { name: Example; }" } });
+        QVERIFY(!path.isEmpty());
+
+        Mod mod{ QFileInfo(path) };
+        QVERIFY(ModUtils::processZIP(mod));
+        QCOMPARE(mod.details().mod_id, QString("example"));
+    }
+};
+
+QTEST_GUILESS_MAIN(ZipProbeTest)
+
+#include "ZipProbe_test.moc"